@@ -0,0 +1,282 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      bench_common.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Shared options, histogram and JSON output for the PCOM benchmarks.
+ ****************************************************************************/
+/** @defgroup  PCOM_BENCH
+ * @brief     Helpers used by bench_pingpong, bench_stream and bench_fanin.
+ * @details   The latency histogram is log-linear like HdrHistogram: values
+ *            below 128 ns are exact, larger ones fall in buckets 1/128 of
+ *            their power of two wide, so every recorded value is reported
+ *            within 0.8 %. Results go to stdout as one JSON object, progress
+ *            and errors to stderr.
+ *
+ * @pre       pcom.h, Linux
+ * @bug       -
+ * @warning   Benchmark code, not part of libpcom.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // CPU_SET and sched_setaffinity, has no effect after a system header
+#endif
+#include <sched.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "pcom.h"
+
+/* ---- Options ----------------------------------------------------------- */
+
+typedef struct {
+    const char* name;      // Connection name
+    const char* label;     // Free text copied to the JSON, e.g. a release
+    int type;              // PCOM_OPEN_STREAM or PCOM_OPEN_SEQPACKET
+    long count;            // Measured messages (per size, per client)
+    long warmup;           // Unmeasured messages first
+    size_t size;           // Message size
+    const char* sizes;     // Comma separated sizes (bench_stream)
+    int clients;           // Client processes (bench_fanin)
+    int cpu_server;        // CPU to pin the server to, -1 for none
+    int cpu_client;        // CPU to pin the (first) client to, -1 for none
+    int epoll;             // Force the epoll loop backend (bench_fanin)
+} bench_opts_t;
+
+static inline void
+bench_usage(const char* prog, const char* extra)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -n, --name NAME        connection name (default @pcom_bench)\n"
+            "  -t, --type TYPE        stream or seqpacket (default stream)\n"
+            "  -c, --count N          measured messages\n"
+            "  -w, --warmup N         warm-up messages, not measured\n"
+            "  -s, --size BYTES       message size\n"
+            "  -S, --server-cpu CPU   pin the server to a CPU\n"
+            "  -C, --client-cpu CPU   pin the client (first client) to a CPU\n"
+            "  -l, --label TEXT       label copied to the JSON output\n"
+            "%s", prog, extra);
+}
+
+static inline int
+bench_parse(int argc, char** argv, bench_opts_t* p_o, const char* extra)
+{
+    static const struct option longopts[] = {
+        { "name", required_argument, NULL, 'n' },   { "type", required_argument, NULL, 't' },
+        { "count", required_argument, NULL, 'c' },  { "warmup", required_argument, NULL, 'w' },
+        { "size", required_argument, NULL, 's' },   { "sizes", required_argument, NULL, 'z' },
+        { "clients", required_argument, NULL, 'k' }, { "server-cpu", required_argument, NULL, 'S' },
+        { "client-cpu", required_argument, NULL, 'C' }, { "label", required_argument, NULL, 'l' },
+        { "epoll", no_argument, NULL, 'e' },        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:t:c:w:s:z:k:S:C:l:eh", longopts, NULL)) != -1) {
+        switch (opt) {
+            case 'n': p_o->name = optarg; break;
+            case 't':
+                if (strcmp(optarg, "stream") == 0) p_o->type = PCOM_OPEN_STREAM;
+                else if (strcmp(optarg, "seqpacket") == 0) p_o->type = PCOM_OPEN_SEQPACKET;
+                else return -1;
+                break;
+            case 'c': p_o->count = atol(optarg); break;
+            case 'w': p_o->warmup = atol(optarg); break;
+            case 's': p_o->size = (size_t)atol(optarg); break;
+            case 'z': p_o->sizes = optarg; break;
+            case 'k': p_o->clients = atoi(optarg); break;
+            case 'S': p_o->cpu_server = atoi(optarg); break;
+            case 'C': p_o->cpu_client = atoi(optarg); break;
+            case 'l': p_o->label = optarg; break;
+            case 'e': p_o->epoll = 1; break;
+            default:
+                bench_usage(argv[0], extra);
+                return -1;
+        }
+    }
+    if (p_o->count <= 0 || p_o->warmup < 0 || p_o->size == 0) {
+        bench_usage(argv[0], extra);
+        return -1;
+    }
+    return 0;
+}
+
+/* ---- Helpers ----------------------------------------------------------- */
+
+static inline uint64_t
+bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/** Pin the calling process to a CPU, no-op for cpu < 0 */
+static inline void
+bench_pin(int cpu)
+{
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) perror("sched_setaffinity");
+}
+
+/** One message: whole buffer on streams, one packet on seqpacket */
+static inline int
+bench_send(int fd, int type, const void* buf, size_t len)
+{
+    if (type == PCOM_OPEN_STREAM) return pcom_send_all(fd, buf, len) == (int64_t)len ? 0 : -1;
+    return pcom_client_send(fd, buf, len) == (int)len ? 0 : -1;
+}
+
+static inline int
+bench_recv(int fd, int type, void* buf, size_t len)
+{
+    if (type == PCOM_OPEN_STREAM) return pcom_recv_exact(fd, buf, len) == (int64_t)len ? 0 : -1;
+    return pcom_client_recv(fd, buf, len) == (int)len ? 0 : -1;
+}
+
+static inline void
+bench_die(const char* what, int err)
+{
+    char text[256];
+    pcom_error_text(err, text, sizeof(text));
+    fprintf(stderr, "%s: %s\n", what, text);
+    exit(1);
+}
+
+static inline void
+bench_json_head(const char* bench, const bench_opts_t* p_o)
+{
+    printf("{\n  \"benchmark\": \"%s\",\n  \"label\": \"", bench);
+    for (const char* p = p_o->label ? p_o->label : ""; *p; ++p) {
+        if (*p == '"' || *p == '\\') putchar('\\');
+        if ((unsigned char)*p >= ' ') putchar(*p);
+    }
+    printf("\",\n  \"pcom_version\": \"%x\",\n"
+           "  \"type\": \"%s\",\n  \"count\": %ld,\n  \"warmup\": %ld,\n"
+           "  \"server_cpu\": %d,\n  \"client_cpu\": %d,\n",
+           pcom_version(),
+           p_o->type == PCOM_OPEN_STREAM ? "stream" : "seqpacket",
+           p_o->count, p_o->warmup, p_o->cpu_server, p_o->cpu_client);
+}
+
+/* ---- Latency histogram ------------------------------------------------- */
+
+#define BENCH_HIST_SUB_BITS (7)
+#define BENCH_HIST_SUB      (1 << BENCH_HIST_SUB_BITS)
+#define BENCH_HIST_BUCKETS  (BENCH_HIST_SUB * (64 - BENCH_HIST_SUB_BITS + 1))
+
+typedef struct {
+    uint64_t counts[BENCH_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} bench_hist_t;
+
+static inline void
+bench_hist_init(bench_hist_t* p_h)
+{
+    memset(p_h, 0, sizeof(*p_h));
+    p_h->min = UINT64_MAX;
+}
+
+static inline int
+bench_hist_index(uint64_t v)
+{
+    if (v < BENCH_HIST_SUB) return (int)v;
+    int shift = 63 - __builtin_clzll(v) - BENCH_HIST_SUB_BITS;
+    return BENCH_HIST_SUB + shift * BENCH_HIST_SUB + (int)((v >> shift) - BENCH_HIST_SUB);
+}
+
+/** Highest value that falls into the same bucket */
+static inline uint64_t
+bench_hist_value(int index)
+{
+    if (index < BENCH_HIST_SUB) return (uint64_t)index;
+    int shift = (index - BENCH_HIST_SUB) / BENCH_HIST_SUB;
+    uint64_t m = (uint64_t)((index - BENCH_HIST_SUB) % BENCH_HIST_SUB + BENCH_HIST_SUB);
+    return ((m + 1) << shift) - 1;
+}
+
+static inline void
+bench_hist_record(bench_hist_t* p_h, uint64_t v)
+{
+    p_h->counts[bench_hist_index(v)]++;
+    p_h->total++;
+    p_h->sum += (double)v;
+    if (v < p_h->min) p_h->min = v;
+    if (v > p_h->max) p_h->max = v;
+}
+
+static inline uint64_t
+bench_hist_percentile(const bench_hist_t* p_h, double percentile)
+{
+    uint64_t target = (uint64_t)ceil(percentile / 100.0 * (double)p_h->total);
+    uint64_t seen = 0;
+    if (target == 0) target = 1;
+    for (int i = 0; i < BENCH_HIST_BUCKETS; ++i) {
+        seen += p_h->counts[i];
+        if (seen >= target) {
+            uint64_t v = bench_hist_value(i);
+            return v < p_h->max ? v : p_h->max;
+        }
+    }
+    return p_h->max;
+}
+
+/** Summary and HdrHistogram style percentile distribution as JSON members */
+static inline void
+bench_hist_json(const bench_hist_t* p_h, const char* indent)
+{
+    static const double summary[] = { 50, 90, 99, 99.9, 99.99, 99.999 };
+    const int ticks = 5;  // Per halving of the remaining distance to 100 %
+
+    printf("%s\"samples\": %llu,\n", indent, (unsigned long long)p_h->total);
+    printf("%s\"min_ns\": %llu,\n", indent, (unsigned long long)(p_h->total ? p_h->min : 0));
+    printf("%s\"mean_ns\": %.1f,\n", indent, p_h->total ? p_h->sum / (double)p_h->total : 0.0);
+    for (size_t i = 0; i < sizeof(summary) / sizeof(summary[0]); ++i) {
+        char key[32];
+        snprintf(key, sizeof(key), "p%g_ns", summary[i]);
+        for (char* p = key; *p; ++p) if (*p == '.') *p = '_';
+        printf("%s\"%s\": %llu,\n", indent, key, (unsigned long long)bench_hist_percentile(p_h, summary[i]));
+    }
+    printf("%s\"max_ns\": %llu,\n", indent, (unsigned long long)p_h->max);
+
+    printf("%s\"distribution\": [", indent);
+    for (int half = 0; half < 40; ++half) {
+        double step = pow(0.5, half);
+        for (int t = 0; t < ticks; ++t) {
+            double pct = 100.0 * (1.0 - step * (1.0 - (double)t / ticks));
+            uint64_t target = (uint64_t)ceil(pct / 100.0 * (double)p_h->total);
+            printf("%s\n%s  { \"percentile\": %.6f, \"value_ns\": %llu }", (half || t) ? "," : "",
+                   indent, pct, (unsigned long long)bench_hist_percentile(p_h, pct));
+            if (target >= p_h->total) goto done;
+        }
+    }
+done:
+    printf(",\n%s  { \"percentile\": 100.0, \"value_ns\": %llu }\n%s]", indent,
+           (unsigned long long)p_h->max, indent);
+}
+
+#endif // BENCH_COMMON_H
@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      bench_fanin.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     PCOM fan-in, N client processes streaming into one pcom_loop server.
+ ****************************************************************************/
+#include "bench_common.h"
+#include "pcom_loop.h"
+
+#define MAX_CLIENTS (1024)
+#define EVENTS      (64)
+
+static void
+client(int index, const bench_opts_t* p_o)
+{
+    char go;
+
+    if (p_o->cpu_client >= 0) bench_pin(p_o->cpu_client + index);
+    int fd = pcom_client_open_ex(p_o->name, p_o->type);
+    if (fd < 0) bench_die("client open", fd);
+    char* buf = calloc(1, p_o->size);
+    for (long i = 0; i < p_o->warmup; ++i)
+        if (bench_send(fd, p_o->type, buf, p_o->size) < 0) bench_die("warm-up", -1);
+    if (bench_recv(fd, p_o->type, &go, 1) < 0) bench_die("start", -1);
+    for (long i = 0; i < p_o->count; ++i)
+        if (bench_send(fd, p_o->type, buf, p_o->size) < 0) bench_die("send", -1);
+    pcom_client_close(fd);
+    free(buf);
+    exit(0);
+}
+
+int
+main(int argc, char** argv)
+{
+    bench_opts_t o = { "@pcom_bench", NULL, PCOM_OPEN_STREAM, 100000, 1000, 1024, NULL, 4, -1, -1, 0 };
+    static int fds[MAX_CLIENTS];
+    static pid_t pids[MAX_CLIENTS];
+    static double done_at[MAX_CLIENTS];
+    pcom_event_t ev[EVENTS];
+    pcom_loop_t* p_loop;
+    char go = 1;
+
+    if (bench_parse(argc, argv, &o, "  -k, --clients N        client processes\n"
+                                   "  -e, --epoll            force the epoll loop backend\n") < 0) return 2;
+    if (o.clients < 1 || o.clients > MAX_CLIENTS) return 2;
+    if (o.type != PCOM_OPEN_STREAM && o.size > PCOM_LOOP_BUF_SIZE) {
+        fprintf(stderr, "seqpacket messages must fit PCOM_LOOP_BUF_SIZE (%d)\n", PCOM_LOOP_BUF_SIZE);
+        return 2;
+    }
+
+    int sfd = pcom_server_open_ex(o.name, o.type);
+    if (sfd < 0) bench_die("server open", sfd);
+    for (int i = 0; i < o.clients; ++i)
+        if ((pids[i] = fork()) == 0) client(i, &o);
+
+    // Connect everyone and drain the warm-up before the clock starts
+    bench_pin(o.cpu_server);
+    char* buf = malloc(o.size);
+    for (int i = 0; i < o.clients; ++i) {
+        if ((fds[i] = pcom_server_accept(sfd)) < 0) bench_die("accept", fds[i]);
+        for (long n = 0; n < o.warmup; ++n)
+            if (bench_recv(fds[i], o.type, buf, o.size) < 0) bench_die("warm-up", -1);
+    }
+    free(buf);
+
+    int result = pcom_loop_create(&p_loop, -1, o.epoll ? PCOM_LOOP_EPOLL : PCOM_LOOP_DEFAULT);
+    if (result < 0) bench_die("loop", result);
+    for (int i = 0; i < o.clients; ++i)
+        if ((result = pcom_loop_add(p_loop, fds[i])) < 0) bench_die("loop add", result);
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < o.clients; ++i) bench_send(fds[i], o.type, &go, 1);
+
+    unsigned long long bytes = 0;
+    int open = o.clients;
+    while (open > 0) {
+        int n = pcom_loop_wait(p_loop, ev, EVENTS, -1);
+        if (n < 0) bench_die("loop wait", n);
+        for (int e = 0; e < n; ++e) {
+            if (ev[e].type != PCOM_EVENT_RECV) continue;
+            if (ev[e].result > 0) {
+                bytes += (unsigned long long)ev[e].result;
+                pcom_loop_release(p_loop, &ev[e]);
+                continue;
+            }
+            pcom_loop_release(p_loop, &ev[e]);
+            for (int i = 0; i < o.clients; ++i) {
+                if (fds[i] != ev[e].handle) continue;
+                done_at[i] = (double)(bench_now_ns() - start) / 1e9;
+                pcom_loop_remove(p_loop, fds[i]);
+                pcom_client_close(fds[i]);
+                fds[i] = -1;
+                --open;
+            }
+        }
+    }
+    double secs = (double)(bench_now_ns() - start) / 1e9;
+    int backend = pcom_loop_backend(p_loop);
+    pcom_loop_destroy(p_loop);
+    for (int i = 0; i < o.clients; ++i) waitpid(pids[i], NULL, 0);
+    pcom_server_close(sfd);
+
+    double msgs = (double)o.count * o.clients / secs;
+    double mib = (double)bytes / secs / (1024.0 * 1024.0);
+    fprintf(stderr, "fanin %d clients x %zu bytes: %.0f msg/s, %.1f MiB/s\n", o.clients, o.size, msgs, mib);
+    bench_json_head("fanin", &o);
+    printf("  \"backend\": \"%s\",\n  \"clients\": %d,\n  \"size\": %zu,\n  \"bytes\": %llu,\n"
+           "  \"seconds\": %.6f,\n  \"msgs_per_sec\": %.1f,\n  \"mib_per_sec\": %.1f,\n  \"client_seconds\": [",
+           backend == PCOM_LOOP_BACKEND_URING ? "io_uring" : "epoll", o.clients, o.size, bytes,
+           secs, msgs, mib);
+    for (int i = 0; i < o.clients; ++i) printf("%s%.6f", i ? ", " : "", done_at[i]);
+    printf("]\n}\n");
+    return bytes == (unsigned long long)o.count * o.clients * o.size ? 0 : 1;
+}
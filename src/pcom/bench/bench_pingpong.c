@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      bench_pingpong.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     PCOM round trip latency, client and echo server in two processes.
+ ****************************************************************************/
+#include "bench_common.h"
+
+static void
+serve(int sfd, const bench_opts_t* p_o)
+{
+    bench_pin(p_o->cpu_server);
+    int fd = pcom_server_accept(sfd);
+    if (fd < 0) bench_die("accept", fd);
+    char* buf = malloc(p_o->size);
+    while (bench_recv(fd, p_o->type, buf, p_o->size) == 0)
+        if (bench_send(fd, p_o->type, buf, p_o->size) < 0) break;
+    free(buf);
+    pcom_client_close(fd);
+    exit(0);
+}
+
+int
+main(int argc, char** argv)
+{
+    bench_opts_t o = { "@pcom_bench", NULL, PCOM_OPEN_STREAM, 100000, 10000, 64, NULL, 1, -1, -1, 0 };
+    static bench_hist_t hist;
+
+    if (bench_parse(argc, argv, &o, "") < 0) return 2;
+
+    int sfd = pcom_server_open_ex(o.name, o.type);
+    if (sfd < 0) bench_die("server open", sfd);
+    pid_t pid = fork();
+    if (pid == 0) serve(sfd, &o);
+
+    bench_pin(o.cpu_client);
+    int fd = pcom_client_open_ex(o.name, o.type);
+    if (fd < 0) bench_die("client open", fd);
+    char* buf = calloc(1, o.size);
+
+    for (long i = 0; i < o.warmup; ++i) {
+        if (bench_send(fd, o.type, buf, o.size) < 0 || bench_recv(fd, o.type, buf, o.size) < 0)
+            bench_die("warm-up", -1);
+    }
+
+    bench_hist_init(&hist);
+    uint64_t start = bench_now_ns();
+    for (long i = 0; i < o.count; ++i) {
+        uint64_t t0 = bench_now_ns();
+        if (bench_send(fd, o.type, buf, o.size) < 0 || bench_recv(fd, o.type, buf, o.size) < 0)
+            bench_die("round trip", -1);
+        bench_hist_record(&hist, bench_now_ns() - t0);
+    }
+    double secs = (double)(bench_now_ns() - start) / 1e9;
+
+    pcom_client_close(fd);
+    waitpid(pid, NULL, 0);
+    pcom_server_close(sfd);
+    free(buf);
+
+    fprintf(stderr, "pingpong %zu bytes: p50 %llu ns, p99 %llu ns, max %llu ns, %.0f round trips/s\n",
+            o.size, (unsigned long long)bench_hist_percentile(&hist, 50),
+            (unsigned long long)bench_hist_percentile(&hist, 99), (unsigned long long)hist.max,
+            (double)o.count / secs);
+    bench_json_head("pingpong", &o);
+    printf("  \"size\": %zu,\n  \"round_trips_per_sec\": %.1f,\n  \"latency\": {\n", o.size, (double)o.count / secs);
+    bench_hist_json(&hist, "    ");
+    printf("\n  }\n}\n");
+    return 0;
+}
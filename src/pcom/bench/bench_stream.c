@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      bench_stream.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     PCOM one way throughput over a range of message sizes.
+ ****************************************************************************/
+#include "bench_common.h"
+
+#define MAX_SIZES (32)
+
+/* Run header: message size and count, size 0 ends the session */
+typedef struct {
+    uint64_t size;
+    uint64_t count;
+} run_t;
+
+static void
+serve(int sfd, const bench_opts_t* p_o)
+{
+    run_t run;
+    char ack = 1;
+
+    bench_pin(p_o->cpu_server);
+    int fd = pcom_server_accept(sfd);
+    if (fd < 0) bench_die("accept", fd);
+    while (bench_recv(fd, p_o->type, &run, sizeof(run)) == 0 && run.size) {
+        char* buf = malloc(run.size);
+        for (uint64_t i = 0; i < run.count; ++i)
+            if (bench_recv(fd, p_o->type, buf, run.size) < 0) bench_die("receive", -1);
+        free(buf);
+        if (bench_send(fd, p_o->type, &ack, 1) < 0) break;
+    }
+    pcom_client_close(fd);
+    exit(0);
+}
+
+/* Send count messages and wait until the server has read them all */
+static double
+run_size(int fd, const bench_opts_t* p_o, size_t size, long count, char* buf)
+{
+    run_t run = { size, (uint64_t)count };
+    char ack;
+
+    uint64_t start = bench_now_ns();
+    if (bench_send(fd, p_o->type, &run, sizeof(run)) < 0) bench_die("send", -1);
+    for (long i = 0; i < count; ++i)
+        if (bench_send(fd, p_o->type, buf, size) < 0) bench_die("send", -1);
+    if (bench_recv(fd, p_o->type, &ack, 1) < 0) bench_die("ack", -1);
+    return (double)(bench_now_ns() - start) / 1e9;
+}
+
+int
+main(int argc, char** argv)
+{
+    bench_opts_t o = { "@pcom_bench", NULL, PCOM_OPEN_STREAM, 100000, 1000, 1,
+                       "64,256,1024,4096,16384,65536", 1, -1, -1, 0 };
+    size_t sizes[MAX_SIZES], max_size = 0;
+    int n = 0;
+
+    if (bench_parse(argc, argv, &o, "  -z, --sizes LIST       comma separated message sizes\n") < 0) return 2;
+    for (char* p = (char*)o.sizes; *p && n < MAX_SIZES; ++n) {
+        sizes[n] = strtoul(p, &p, 10);
+        if (!sizes[n]) return 2;
+        if (sizes[n] > max_size) max_size = sizes[n];
+        if (*p == ',') ++p;
+    }
+
+    int sfd = pcom_server_open_ex(o.name, o.type);
+    if (sfd < 0) bench_die("server open", sfd);
+    pid_t pid = fork();
+    if (pid == 0) serve(sfd, &o);
+
+    bench_pin(o.cpu_client);
+    int fd = pcom_client_open_ex(o.name, o.type);
+    if (fd < 0) bench_die("client open", fd);
+    char* buf = calloc(1, max_size);
+
+    bench_json_head("stream", &o);
+    printf("  \"results\": [");
+    for (int i = 0; i < n; ++i) {
+        if (o.warmup) run_size(fd, &o, sizes[i], o.warmup, buf);
+        double secs = run_size(fd, &o, sizes[i], o.count, buf);
+        double msgs = (double)o.count / secs;
+        double mib = msgs * (double)sizes[i] / (1024.0 * 1024.0);
+        fprintf(stderr, "stream %7zu bytes: %12.0f msg/s %10.1f MiB/s\n", sizes[i], msgs, mib);
+        printf("%s\n    { \"size\": %zu, \"seconds\": %.6f, \"msgs_per_sec\": %.1f, \"mib_per_sec\": %.1f }",
+               i ? "," : "", sizes[i], secs, msgs, mib);
+    }
+    printf("\n  ]\n}\n");
+
+    run_t end = { 0, 0 };
+    bench_send(fd, o.type, &end, sizeof(end));
+    pcom_client_close(fd);
+    waitpid(pid, NULL, 0);
+    pcom_server_close(sfd);
+    free(buf);
+    return 0;
+}
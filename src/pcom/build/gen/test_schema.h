@@ -0,0 +1,170 @@
+/* Generated by tools/pcom_schema.py from test_schema.pcs, do not edit. */
+#ifndef TEST_SCHEMA_H
+#define TEST_SCHEMA_H
+
+#include <stdint.h>
+#include <string.h>
+#include "pcom_schema.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---- Order ------------------------------------------------------------- */
+
+#define TEST_ORDER_ID         (1)
+#define TEST_ORDER_FIXED_SIZE (72)
+
+static const uint32_t test_order_opt_size_[] = { 4, 0, 2 };
+static const uint32_t test_order_ref_off_[] = { 52, 60 };
+static const pcom_schema_desc_t test_order_desc = {
+    TEST_ORDER_ID, PCOM_SCHEMA_CRC, TEST_ORDER_FIXED_SIZE,
+    3, test_order_opt_size_, 2, test_order_ref_off_
+};
+
+/** Check a received Order message, returns its size or a negative error code */
+static inline int64_t
+test_order_verify(const void* buf, size_t len) { return pcom_schema_verify(buf, len, &test_order_desc); }
+
+/** Start building a message of type Order in buf */
+static inline void
+test_order_begin(pcom_schema_builder_t* p_b, void* buf, size_t cap) { pcom_schema_begin(p_b, buf, cap, &test_order_desc); }
+
+/** Complete the Order message, returns its size or a negative error code */
+static inline int64_t
+test_order_finish(pcom_schema_builder_t* p_b) { return pcom_schema_finish(p_b); }
+
+static inline uint64_t
+test_order_id(const void* msg) { return (uint64_t)pcom_schema_get_u64(msg, 16); }
+
+static inline void
+test_order_set_id(pcom_schema_builder_t* p_b, uint64_t v) { pcom_schema_put_u64(p_b->buf, 16, (v)); }
+
+static inline int32_t
+test_order_qty(const void* msg) { return (int32_t)pcom_schema_get_u32(msg, 24); }
+
+static inline void
+test_order_set_qty(pcom_schema_builder_t* p_b, int32_t v) { pcom_schema_put_u32(p_b->buf, 24, (uint32_t)(v)); }
+
+static inline double
+test_order_price(const void* msg) { return (double)pcom_schema_get_f64(msg, 32); }
+
+static inline void
+test_order_set_price(pcom_schema_builder_t* p_b, double v) { pcom_schema_put_f64(p_b->buf, 32, (v)); }
+
+#define TEST_ORDER_SYMBOL_LEN (8)
+static inline const char*
+test_order_symbol(const void* msg) { return (const char*)msg + 40; }
+
+/** Copy up to 8 bytes, the rest is zero filled */
+static inline void
+test_order_set_symbol(pcom_schema_builder_t* p_b, const void* data, size_t len) {
+    if (len > 8) len = 8;
+    memcpy(p_b->buf + 40, data, len);
+    memset(p_b->buf + 40 + len, 0, 8 - len);
+}
+
+static inline int
+test_order_urgent(const void* msg) { return (int)(pcom_schema_get_u8(msg, 48) != 0); }
+
+static inline void
+test_order_set_urgent(pcom_schema_builder_t* p_b, int v) { pcom_schema_put_u8(p_b->buf, 48, (uint8_t)(v != 0)); }
+
+static inline const char*
+test_order_note(const void* msg, uint32_t* p_len) { return (const char*)pcom_schema_ref(msg, 52, p_len); }
+
+static inline void
+test_order_set_note(pcom_schema_builder_t* p_b, const void* data, size_t len) { pcom_schema_put_ref(p_b, 52, data, len); }
+
+static inline const uint8_t*
+test_order_blob(const void* msg, uint32_t* p_len) { return (const uint8_t*)pcom_schema_ref(msg, 60, p_len); }
+
+static inline void
+test_order_set_blob(pcom_schema_builder_t* p_b, const void* data, size_t len) { pcom_schema_put_ref(p_b, 60, data, len); }
+
+static inline int
+test_order_has_expire(const void* msg) { return pcom_schema_opt(msg, 0) != 0; }
+
+static inline uint32_t
+test_order_expire(const void* msg, uint32_t dflt) {
+    uint32_t at = pcom_schema_opt(msg, 0);
+    return at ? (uint32_t)pcom_schema_get_u32(msg, at) : dflt;
+}
+
+static inline void
+test_order_set_expire(pcom_schema_builder_t* p_b, uint32_t v) {
+    uint8_t le[4];
+    pcom_schema_put_u32(le, 0, (v));
+    pcom_schema_put_opt(p_b, 0, le, sizeof(le));
+}
+
+static inline int
+test_order_has_trader(const void* msg) { return pcom_schema_opt(msg, 1) != 0; }
+
+static inline const char*
+test_order_trader(const void* msg, uint32_t* p_len) { return (const char*)pcom_schema_opt_ref(msg, 1, p_len); }
+
+static inline void
+test_order_set_trader(pcom_schema_builder_t* p_b, const void* data, size_t len) { pcom_schema_put_opt(p_b, 1, data, len); }
+
+static inline int
+test_order_has_venue(const void* msg) { return pcom_schema_opt(msg, 2) != 0; }
+
+static inline int16_t
+test_order_venue(const void* msg, int16_t dflt) {
+    uint32_t at = pcom_schema_opt(msg, 2);
+    return at ? (int16_t)pcom_schema_get_u16(msg, at) : dflt;
+}
+
+static inline void
+test_order_set_venue(pcom_schema_builder_t* p_b, int16_t v) {
+    uint8_t le[2];
+    pcom_schema_put_u16(le, 0, (uint16_t)(v));
+    pcom_schema_put_opt(p_b, 2, le, sizeof(le));
+}
+
+/* ---- Ping -------------------------------------------------------------- */
+
+#define TEST_PING_ID         (2)
+#define TEST_PING_FIXED_SIZE (24)
+
+static const pcom_schema_desc_t test_ping_desc = {
+    TEST_PING_ID, 0, TEST_PING_FIXED_SIZE,
+    0, NULL, 0, NULL
+};
+
+/** Check a received Ping message, returns its size or a negative error code */
+static inline int64_t
+test_ping_verify(const void* buf, size_t len) { return pcom_schema_verify(buf, len, &test_ping_desc); }
+
+/** Start building a message of type Ping in buf */
+static inline void
+test_ping_begin(pcom_schema_builder_t* p_b, void* buf, size_t cap) { pcom_schema_begin(p_b, buf, cap, &test_ping_desc); }
+
+/** Complete the Ping message, returns its size or a negative error code */
+static inline int64_t
+test_ping_finish(pcom_schema_builder_t* p_b) { return pcom_schema_finish(p_b); }
+
+static inline uint32_t
+test_ping_seq(const void* msg) { return (uint32_t)pcom_schema_get_u32(msg, 16); }
+
+static inline void
+test_ping_set_seq(pcom_schema_builder_t* p_b, uint32_t v) { pcom_schema_put_u32(p_b->buf, 16, (v)); }
+
+#define TEST_PING_COOKIE_LEN (4)
+static inline const uint8_t*
+test_ping_cookie(const void* msg) { return (const uint8_t*)msg + 20; }
+
+/** Copy up to 4 bytes, the rest is zero filled */
+static inline void
+test_ping_set_cookie(pcom_schema_builder_t* p_b, const void* data, size_t len) {
+    if (len > 4) len = 4;
+    memcpy(p_b->buf + 20, data, len);
+    memset(p_b->buf + 20 + len, 0, 4 - len);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_SCHEMA_H
@@ -0,0 +1,144 @@
+/* Generated by tools/pcom_schema.py from test_schema.pcs, do not edit. */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+
+#include "test_schema.h"
+
+namespace test {
+
+/// @brief Read only view of Order messages in a receive buffer.
+class order_view {
+public:
+    /// @brief Constructor. Wraps a message that was verified or built locally.
+    explicit order_view(const void* msg) noexcept : _msg(static_cast<const std::byte*>(msg)) {}
+
+    /// @brief Verifies buf, empty if it does not hold a valid message.
+    static std::optional<order_view> verify(std::span<const std::byte> buf) noexcept {
+        if (test_order_verify(buf.data(), buf.size()) < 0) return std::nullopt;
+        return order_view(buf.data());
+    }
+
+    /// @brief The whole message.
+    std::span<const std::byte> data() const noexcept { return { _msg, pcom_schema_size(_msg) }; }
+
+    uint64_t id() const noexcept { return static_cast<uint64_t>(test_order_id(_msg)); }
+    int32_t qty() const noexcept { return static_cast<int32_t>(test_order_qty(_msg)); }
+    double price() const noexcept { return static_cast<double>(test_order_price(_msg)); }
+    /// @brief Up to the first NUL, at most 8 chars.
+    std::string_view symbol() const noexcept {
+        const char* p = test_order_symbol(_msg);
+        return { p, strnlen(p, 8) };
+    }
+    bool urgent() const noexcept { return static_cast<bool>(test_order_urgent(_msg)); }
+    std::string_view note() const noexcept {
+        uint32_t len;
+        const char* p = test_order_note(_msg, &len);
+        return p ? std::string_view{ p, len } : std::string_view{};
+    }
+    std::span<const std::byte> blob() const noexcept {
+        uint32_t len;
+        const uint8_t* p = test_order_blob(_msg, &len);
+        return p ? std::span<const std::byte>{ reinterpret_cast<const std::byte*>(p), len } : std::span<const std::byte>{};
+    }
+    std::optional<uint32_t> expire() const noexcept {
+        if (!test_order_has_expire(_msg)) return std::nullopt;
+        return static_cast<uint32_t>(test_order_expire(_msg, uint32_t{}));
+    }
+    std::optional<std::string_view> trader() const noexcept {
+        uint32_t len;
+        const char* p = test_order_trader(_msg, &len);
+        if (!p) return std::nullopt;
+        return std::string_view{ p, len };
+    }
+    std::optional<int16_t> venue() const noexcept {
+        if (!test_order_has_venue(_msg)) return std::nullopt;
+        return static_cast<int16_t>(test_order_venue(_msg, int16_t{}));
+    }
+
+private:
+    const std::byte* _msg;
+};
+
+/// @brief Writes Order messages into a caller supplied buffer.
+class order_builder {
+public:
+    /// @brief Constructor.
+    /// @param buf output buffer, 8 byte aligned
+    explicit order_builder(std::span<std::byte> buf) noexcept { test_order_begin(&_b, buf.data(), buf.size()); }
+
+    order_builder& id(uint64_t v) noexcept { test_order_set_id(&_b, static_cast<uint64_t>(v)); return *this; }
+    order_builder& qty(int32_t v) noexcept { test_order_set_qty(&_b, static_cast<int32_t>(v)); return *this; }
+    order_builder& price(double v) noexcept { test_order_set_price(&_b, static_cast<double>(v)); return *this; }
+    order_builder& symbol(std::string_view s) noexcept { test_order_set_symbol(&_b, s.data(), s.size()); return *this; }
+    order_builder& urgent(bool v) noexcept { test_order_set_urgent(&_b, static_cast<int>(v)); return *this; }
+    order_builder& note(std::string_view d) noexcept { test_order_set_note(&_b, d.data(), d.size()); return *this; }
+    order_builder& blob(std::span<const std::byte> d) noexcept { test_order_set_blob(&_b, d.data(), d.size()); return *this; }
+    order_builder& expire(uint32_t v) noexcept { test_order_set_expire(&_b, static_cast<uint32_t>(v)); return *this; }
+    order_builder& trader(std::string_view d) noexcept { test_order_set_trader(&_b, d.data(), d.size()); return *this; }
+    order_builder& venue(int16_t v) noexcept { test_order_set_venue(&_b, static_cast<int16_t>(v)); return *this; }
+
+    /// @brief Completes the message.
+    /// @return the message in the buffer
+    std::span<const std::byte> finish() {
+        int64_t size = test_order_finish(&_b);
+        if (size < 0) throw std::system_error(static_cast<int>(-size), std::generic_category(), "order_builder");
+        return { reinterpret_cast<const std::byte*>(_b.buf), static_cast<size_t>(size) };
+    }
+
+private:
+    pcom_schema_builder_t _b;
+};
+
+/// @brief Read only view of Ping messages in a receive buffer.
+class ping_view {
+public:
+    /// @brief Constructor. Wraps a message that was verified or built locally.
+    explicit ping_view(const void* msg) noexcept : _msg(static_cast<const std::byte*>(msg)) {}
+
+    /// @brief Verifies buf, empty if it does not hold a valid message.
+    static std::optional<ping_view> verify(std::span<const std::byte> buf) noexcept {
+        if (test_ping_verify(buf.data(), buf.size()) < 0) return std::nullopt;
+        return ping_view(buf.data());
+    }
+
+    /// @brief The whole message.
+    std::span<const std::byte> data() const noexcept { return { _msg, pcom_schema_size(_msg) }; }
+
+    uint32_t seq() const noexcept { return static_cast<uint32_t>(test_ping_seq(_msg)); }
+    std::span<const std::byte, 4> cookie() const noexcept {
+        return std::span<const std::byte, 4>(reinterpret_cast<const std::byte*>(test_ping_cookie(_msg)), 4);
+    }
+
+private:
+    const std::byte* _msg;
+};
+
+/// @brief Writes Ping messages into a caller supplied buffer.
+class ping_builder {
+public:
+    /// @brief Constructor.
+    /// @param buf output buffer, 8 byte aligned
+    explicit ping_builder(std::span<std::byte> buf) noexcept { test_ping_begin(&_b, buf.data(), buf.size()); }
+
+    ping_builder& seq(uint32_t v) noexcept { test_ping_set_seq(&_b, static_cast<uint32_t>(v)); return *this; }
+    ping_builder& cookie(std::span<const std::byte> d) noexcept { test_ping_set_cookie(&_b, d.data(), d.size()); return *this; }
+
+    /// @brief Completes the message.
+    /// @return the message in the buffer
+    std::span<const std::byte> finish() {
+        int64_t size = test_ping_finish(&_b);
+        if (size < 0) throw std::system_error(static_cast<int>(-size), std::generic_category(), "ping_builder");
+        return { reinterpret_cast<const std::byte*>(_b.buf), static_cast<size_t>(size) };
+    }
+
+private:
+    pcom_schema_builder_t _b;
+};
+
+} // namespace test
@@ -27,18 +27,30 @@
 #include <errno.h>
 #include <pwd.h>
 #include <grp.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/uio.h>
 
 #elif defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
 #include <sddl.h>
 #include <lm.h>
 #include <string.h>
+#include <limits.h>
 
 #endif
 
 #include <stdio.h>
 
 #include "pcom.h"
+#include "pcom_stats.h"
+#include "pcom_trace.h"
+#include "pcom_tcp.h"
+#include "pcom_coalesce.h"
 
 /* ---- Private definintions and functions -------------------------------- */
 
@@ -47,16 +59,323 @@
 static inline int 
 pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
 
-#define FULL_NAME_MAX (107) // Max length of struct sockaddr_un.sun_path
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0)
+#endif
 
-/** Convert server name to full path or pipe name */
+/** Wait on a non-blocking handle that returned EAGAIN */
+static int
+wait_ready(int handle, short events) {
+    struct pollfd pfd = { .fd = handle, .events = events };
+    while (poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR) return pcom_errno_from(errno);
+    }
+    return 0;
+}
+
+/** Map PCOM_OPEN_* flags to a socket type */
+static int
+sock_type_from(int flags) {
+    switch (flags & PCOM_OPEN_TYPE_MASK) {
+        case PCOM_OPEN_STREAM:    return SOCK_STREAM;
+        case PCOM_OPEN_SEQPACKET: return SOCK_SEQPACKET;
+        case PCOM_OPEN_DGRAM:     return SOCK_DGRAM;
+        default:                  return -EINVAL;
+    }
+}
+
+#define PCOM_DEFAULT_SOCKET_DIR "/var/tmp"
+
+/** Directory for plain connection names. Empty until set by pcom_set_socket_dir() */
+static char socket_dir[PATH_MAX] = { 0 };
+
+/** Socket address built from a connection name */
+typedef struct {
+    struct sockaddr_un addr;
+    socklen_t len;
+    int dir_fd;            // Directory opened for over-long paths, -1 if unused
+    const char* p_unlink;  // Path to unlink (relative to dir_fd), NULL if abstract
+} endpoint_t;
+
+/** Socket directory from pcom_set_socket_dir(), PCOM_SOCKET_DIR or default */
+static const char*
+get_socket_dir(void) {
+    if (socket_dir[0]) return socket_dir;
+    const char* p_env = getenv("PCOM_SOCKET_DIR");
+    return (p_env && p_env[0]) ? p_env : PCOM_DEFAULT_SOCKET_DIR;
+}
+
+/** Convert server name to full path. Absolute names are used as is. */
 static int 
 build_full_name(const char* name, char* out, size_t outlen) {
-    if (snprintf(out, outlen, "/var/tmp/%s.sock", name) < (int)outlen) return 0;
+    int n = (name[0] == '/') ? snprintf(out, outlen, "%s", name)
+                             : snprintf(out, outlen, "%s/%s.sock", get_socket_dir(), name);
+    if (n >= 0 && n < (int)outlen) return 0;
     out[0] = 0;
     return -ENAMETOOLONG;
 }
 
+static void
+endpoint_close(endpoint_t* p_ep) {
+    if (p_ep->dir_fd >= 0) close(p_ep->dir_fd);
+    p_ep->dir_fd = -1;
+}
+
+/** Build the socket address for a connection name */
+static int
+build_endpoint(const char* name, int flags, endpoint_t* p_ep) {
+    char path[PATH_MAX];
+    size_t max = sizeof(p_ep->addr.sun_path);
+
+    memset(p_ep, 0, sizeof(*p_ep));
+    p_ep->dir_fd = -1;
+    p_ep->addr.sun_family = AF_UNIX;
+
+    if (name[0] == '@' || (flags & PCOM_OPEN_ABSTRACT)) {
+#if defined(__linux__)
+        // Abstract namespace: leading NUL, no inode and nothing to unlink
+        const char* p_name = (name[0] == '@') ? name + 1 : name;
+        size_t len = strlen(p_name);
+        if (len + 1 > max) return -ENAMETOOLONG;
+        memcpy(p_ep->addr.sun_path + 1, p_name, len);
+        p_ep->len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + len);
+        return 0;
+#else
+        return -EAFNOSUPPORT;
+#endif
+    }
+
+    int result = build_full_name(name, path, sizeof(path));
+    if (result) return result;
+
+    size_t len = strlen(path);
+    p_ep->len = sizeof(p_ep->addr);
+    if (len < max) {
+        memcpy(p_ep->addr.sun_path, path, len + 1);
+        p_ep->p_unlink = p_ep->addr.sun_path;
+        return 0;
+    }
+
+#if defined(__linux__)
+    // Too long for sun_path. Open the directory and reach the socket
+    // through /proc/self/fd/<dir>/<file>, which bind and connect resolve.
+    char* p_slash = strrchr(path, '/');
+    if (!p_slash) return -ENAMETOOLONG;
+    *p_slash = '\0';
+    p_ep->dir_fd = open(path[0] ? path : "/", O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (p_ep->dir_fd < 0) return pcom_errno_from(errno);
+
+    int n = snprintf(p_ep->addr.sun_path, max, "/proc/self/fd/%d/%s", p_ep->dir_fd, p_slash + 1);
+    if (n < 0 || n >= (int)max) { endpoint_close(p_ep); return -ENAMETOOLONG; }
+    p_ep->p_unlink = strrchr(p_ep->addr.sun_path, '/') + 1;
+    return 0;
+#else
+    return -ENAMETOOLONG;
+#endif
+}
+
+
+/* ---- Credential cache -------------------------------------------------- */
+
+#define CRED_USER_SLOTS  (64)   // Cached users, direct mapped by uid (power of 2)
+#define CRED_GROUP_SLOTS (256)  // Cached groups, direct mapped by gid (power of 2)
+#define CRED_NAME_LEN    (128)  // Longer group names are looked up every time
+#define CRED_LOOKUP_BUF  (4096) // Initial buffer for getpwuid_r/getgrgid_r
+
+typedef struct {
+    int valid;
+    uid_t uid;
+    gid_t gid;                            // Primary gid the group list is for
+    time_t expires;
+    char name[PCOM_USER_NAME_LEN];
+    int ngroups;                          // -1 until a group list is cached
+    gid_t groups[PCOM_MAX_GROUP_COUNT];
+} cred_user_t;
+
+typedef struct {
+    int valid;
+    gid_t gid;
+    time_t expires;
+    char name[CRED_NAME_LEN];
+} cred_group_t;
+
+static pthread_rwlock_t cred_lock = PTHREAD_RWLOCK_INITIALIZER;
+static cred_user_t cred_users[CRED_USER_SLOTS];
+static cred_group_t cred_groups[CRED_GROUP_SLOTS];
+static int cred_ttl = PCOM_CRED_CACHE_TTL;
+
+/** Coarse monotonic seconds, only used for cache expiry */
+static time_t
+cred_now(void) {
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC_COARSE)
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return ts.tv_sec;
+}
+
+/** Reentrant uid to user name lookup */
+static int
+cred_lookup_user(uid_t uid, char* p_name, size_t name_len) {
+    struct passwd pw, *p_pw = NULL;
+    char stack_buf[CRED_LOOKUP_BUF];
+    char* p_buf = stack_buf;
+    size_t buf_len = sizeof(stack_buf);
+    int result;
+
+    while ((result = getpwuid_r(uid, &pw, p_buf, buf_len, &p_pw)) == ERANGE) {
+        if (p_buf != stack_buf) free(p_buf);
+        buf_len *= 2;
+        if (!(p_buf = malloc(buf_len))) return -ENOMEM;
+    }
+    if (!result && !p_pw) result = ENOENT;
+    if (!result) {
+        strncpy(p_name, p_pw->pw_name, name_len - 1);
+        p_name[name_len - 1] = '\0';
+    }
+    if (p_buf != stack_buf) free(p_buf);
+    return result ? pcom_errno_from(result) : 0;
+}
+
+/** Reentrant gid to group name lookup */
+static int
+cred_lookup_group(gid_t gid, char* p_name, size_t name_len) {
+    struct group gr, *p_gr = NULL;
+    char stack_buf[CRED_LOOKUP_BUF];
+    char* p_buf = stack_buf;
+    size_t buf_len = sizeof(stack_buf);
+    int result;
+
+    while ((result = getgrgid_r(gid, &gr, p_buf, buf_len, &p_gr)) == ERANGE) {
+        if (p_buf != stack_buf) free(p_buf);
+        buf_len *= 2;
+        if (!(p_buf = malloc(buf_len))) return -ENOMEM;
+    }
+    if (!result && !p_gr) result = ENOENT;
+    if (!result) {
+        if (strlen(p_gr->gr_name) >= name_len) result = ENAMETOOLONG;
+        else strcpy(p_name, p_gr->gr_name);
+    }
+    if (p_buf != stack_buf) free(p_buf);
+    return result ? pcom_errno_from(result) : 0;
+}
+
+/** Get user name, and the group list if p_groups is set, through the cache */
+static int
+cred_get_user(uid_t uid, gid_t gid, char* p_name, size_t name_len,
+              gid_t* p_groups, int* p_ngroups) {
+    cred_user_t* p_slot = &cred_users[uid & (CRED_USER_SLOTS - 1)];
+    time_t now = cred_now();
+    int hit = 0;
+
+    pthread_rwlock_rdlock(&cred_lock);
+    if (p_slot->valid && p_slot->uid == uid && p_slot->expires > now &&
+        (!p_groups || (p_slot->ngroups >= 0 && p_slot->gid == gid))) {
+        strncpy(p_name, p_slot->name, name_len - 1);
+        p_name[name_len - 1] = '\0';
+        if (p_groups) {
+            memcpy(p_groups, p_slot->groups, p_slot->ngroups * sizeof(gid_t));
+            *p_ngroups = p_slot->ngroups;
+        }
+        hit = 1;
+    }
+    pthread_rwlock_unlock(&cred_lock);
+    if (hit) return 0;
+
+    // Miss: resolve outside the lock, NSS may be slow
+    int result = cred_lookup_user(uid, p_name, name_len);
+    if (result) return result;
+
+    int ngroups = -1;
+    if (p_groups) {
+        ngroups = PCOM_MAX_GROUP_COUNT;
+        if (getgrouplist(p_name, gid, p_groups, &ngroups) == -1) return pcom_errno_from(EOVERFLOW);
+        *p_ngroups = ngroups;
+    }
+
+    if (cred_ttl > 0) {
+        pthread_rwlock_wrlock(&cred_lock);
+        p_slot->ngroups = ngroups;
+        p_slot->gid = gid;
+        if (ngroups > 0) memcpy(p_slot->groups, p_groups, ngroups * sizeof(gid_t));
+        p_slot->valid = 1;
+        p_slot->uid = uid;
+        p_slot->expires = now + cred_ttl;
+        strncpy(p_slot->name, p_name, sizeof(p_slot->name) - 1);
+        p_slot->name[sizeof(p_slot->name) - 1] = '\0';
+        pthread_rwlock_unlock(&cred_lock);
+    }
+    return 0;
+}
+
+/** Get group name through the cache */
+static int
+cred_get_group(gid_t gid, char* p_name, size_t name_len) {
+    cred_group_t* p_slot = &cred_groups[gid & (CRED_GROUP_SLOTS - 1)];
+    time_t now = cred_now();
+    int hit = 0;
+
+    pthread_rwlock_rdlock(&cred_lock);
+    if (p_slot->valid && p_slot->gid == gid && p_slot->expires > now &&
+        strlen(p_slot->name) < name_len) {
+        strcpy(p_name, p_slot->name);
+        hit = 1;
+    }
+    pthread_rwlock_unlock(&cred_lock);
+    if (hit) return 0;
+
+    char name[PCOM_GROUP_NAME_BUFFER_LEN];
+    int result = cred_lookup_group(gid, name, sizeof(name));
+    if (result) return result;
+    if (strlen(name) >= name_len) return pcom_errno_from(EOVERFLOW);
+    strcpy(p_name, name);
+
+    if (cred_ttl > 0 && strlen(name) < CRED_NAME_LEN) {
+        pthread_rwlock_wrlock(&cred_lock);
+        p_slot->valid = 1;
+        p_slot->gid = gid;
+        p_slot->expires = now + cred_ttl;
+        strcpy(p_slot->name, name);
+        pthread_rwlock_unlock(&cred_lock);
+    }
+    return 0;
+}
+
+/** Get the peer's groups other than primary from the kernel. Returns count,
+ *  -EOVERFLOW if there are more than max, or negative error. */
+static int
+cred_peer_groups(int client_handle, gid_t primary, gid_t* p_groups, int max) {
+#if defined(SO_PEERGROUPS)
+    gid_t stack_groups[PCOM_MAX_GROUP_COUNT];
+    gid_t* p_all = stack_groups;
+    socklen_t len = sizeof(stack_groups);
+    int result;
+
+    // More groups than fit: ask again with the size the kernel reports
+    while (getsockopt(client_handle, SOL_SOCKET, SO_PEERGROUPS, p_all, &len) < 0) {
+        result = errno;
+        if (p_all != stack_groups) free(p_all);
+        if (result != ERANGE) return pcom_errno_from(result);
+        if (!(p_all = malloc(len))) return -ENOMEM;
+    }
+
+    int n = 0;
+    result = 0;
+    for (size_t i = 0; i < len / sizeof(gid_t) && !result; ++i) {
+        if (p_all[i] == primary) continue;
+        if (n == max) result = pcom_errno_from(EOVERFLOW);
+        else p_groups[n++] = p_all[i];
+    }
+    if (p_all != stack_groups) free(p_all);
+    return result ? result : n;
+#else
+    (void)client_handle; (void)primary; (void)p_groups; (void)max;
+    return -ENOPROTOOPT;
+#endif
+}
+
 #elif defined(_WIN32) || defined(_WIN64)
 
 static inline int 
@@ -69,10 +388,13 @@ pcom_errno_from(DWORD err) { return (err > 0) ? -((int)err) : -1; }
  * This static full_name buffer holds the current pipe name. 
  */
 static char full_name[FULL_NAME_MAX]  = { 0 };
+static int server_flags = PCOM_OPEN_STREAM;
 
 /** Convert server name to full path or pipe name */
 static int 
 build_full_name(const char* name, char* out, size_t outlen) {
+    // Pipe names never touch a file system, '@' names are plain pipes
+    if (name[0] == '@') ++name;
     if (snprintf(out, outlen, "\\\\.\\pipe\\%s", name) < (int)outlen) return 0;
     out[0] = 0;
     return -ERROR_FILENAME_EXCED_RANGE;
@@ -146,35 +468,90 @@ pcom_error_text(int error_code, char* p_text_buf, size_t buf_len)
 #endif
 }
 
+int
+pcom_set_socket_dir(const char* dir)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (!dir) { socket_dir[0] = '\0'; return 0; }
+    if (dir[0] != '/') return -EINVAL;
+    if (strlen(dir) >= sizeof(socket_dir)) return -ENAMETOOLONG;
+    strcpy(socket_dir, dir);
+    return 0;
+
+#elif defined(_WIN32) || defined(_WIN64)
+
+    // Named pipes live in their own namespace
+    (void)dir;
+    return pcom_errno_from(ERROR_NOT_SUPPORTED);
+
+#else
+    (void)dir;
+    return -1;
+#endif
+}
+
+void
+pcom_cred_cache_set_ttl(int seconds)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    pthread_rwlock_wrlock(&cred_lock);
+    cred_ttl = seconds > 0 ? seconds : 0;
+    pthread_rwlock_unlock(&cred_lock);
+    if (!cred_ttl) pcom_cred_cache_invalidate();
+#else
+    (void)seconds;
+#endif
+}
+
+void
+pcom_cred_cache_invalidate(void)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    pthread_rwlock_wrlock(&cred_lock);
+    for (int i = 0; i < CRED_USER_SLOTS; ++i) cred_users[i].valid = 0;
+    for (int i = 0; i < CRED_GROUP_SLOTS; ++i) cred_groups[i].valid = 0;
+    pthread_rwlock_unlock(&cred_lock);
+#endif
+}
+
 int
 pcom_server_open(const char* name) 
+{
+    return pcom_server_open_ex(name, PCOM_OPEN_STREAM);
+}
+
+int
+pcom_server_open_ex(const char* name, int flags) 
 {
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
     int result;
     int server_handle = -1;    
-    char full_name[FULL_NAME_MAX];
+    endpoint_t ep;
+    int type = sock_type_from(flags);
 
-    // Build the full connection name
-    result = build_full_name(name, full_name, sizeof(full_name));
+    if (type < 0) return type;
+    if (pcom_tcp_is_name(name)) return pcom_tcp_server_open(name, flags);
+
+    // Build the socket address from the connection name
+    result = build_endpoint(name, flags, &ep);
 
     if (result) return result;
 
-    // Remove if already exists
-    unlink(full_name);  
-    
-    // Create the socket address structure
-    struct sockaddr_un addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, full_name, sizeof(addr.sun_path) - 1);
+    // Remove if already exists. Abstract names have no inode.
+    if (ep.p_unlink) unlinkat(ep.dir_fd >= 0 ? ep.dir_fd : AT_FDCWD, ep.p_unlink, 0);
 
     // Create the socket
-    server_handle = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (server_handle < 0) return pcom_errno_from(errno);
+    server_handle = socket(AF_UNIX, type, 0);
+    if (server_handle < 0) { result = errno; endpoint_close(&ep); return pcom_errno_from(result); }
     
     // Bind socket to address
-    if (bind(server_handle, (struct sockaddr*)&addr, sizeof(addr)) < 0) 
-        { result = errno; close(server_handle); return pcom_errno_from(result); }
+    result = bind(server_handle, (struct sockaddr*)&ep.addr, ep.len) < 0 ? errno : 0;
+    endpoint_close(&ep);
+    if (result) { close(server_handle); return pcom_errno_from(result); }
+
+    // Datagram servers receive directly on the bound socket
+    if (type == SOCK_DGRAM) return server_handle;
 
     // Set socket to listen for incoming connections    
     if (listen(server_handle, 5) < 0) 
@@ -184,6 +561,11 @@ pcom_server_open(const char* name)
 
 #elif defined(_WIN32) || defined(_WIN64)   
 
+    int type = flags & PCOM_OPEN_TYPE_MASK;
+    if (type != PCOM_OPEN_STREAM && type != PCOM_OPEN_SEQPACKET)
+        return pcom_errno_from(ERROR_NOT_SUPPORTED);
+    server_flags = flags;
+
     // Build the full connection name
     return build_full_name(name, full_name, sizeof(full_name));
 #else
@@ -197,11 +579,21 @@ pcom_server_accept(int server_handle)
     int client_handle = -1;
 
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
-        
-    // Accept a client connection
-    client_handle = accept(server_handle, NULL, NULL);
-    if (client_handle < 0) return pcom_errno_from(errno);
-    
+
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+
+    // Accept a client connection, TCP servers also on their UNIX listener
+    int local_handle = pcom_tcp_local_handle(server_handle);
+    if (local_handle >= 0) {
+        client_handle = pcom_tcp_accept(server_handle, local_handle);
+    } else {
+        client_handle = accept(server_handle, NULL, NULL);
+        if (client_handle < 0) client_handle = pcom_errno_from(errno);
+    }
+    pcom_stats_call(PCOM_STATS_ACCEPT, server_handle, t0, client_handle);
+    pcom_trace_end(tr, PCOM_TRACE_ACCEPT, server_handle, client_handle, 0);
+
 #elif defined(_WIN32) || defined(_WIN64)
 
     DWORD err;
@@ -209,11 +601,15 @@ pcom_server_accept(int server_handle)
     // The Server handle is just a success code from pcom_server_open()
     if (server_handle != 0) return pcom_errno_from(INVALID_HANDLE_VALUE);
 
+    // Message mode pipes keep message boundaries like SOCK_SEQPACKET
+    DWORD pipe_type = ((server_flags & PCOM_OPEN_TYPE_MASK) == PCOM_OPEN_SEQPACKET) ?
+                      (PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE) : PIPE_TYPE_BYTE;
+
     // Create the named pipe
     HANDLE hPipe = CreateNamedPipeA( 
         full_name,
         PIPE_ACCESS_DUPLEX,
-        PIPE_TYPE_BYTE | PIPE_WAIT,
+        pipe_type | PIPE_WAIT,
         PIPE_UNLIMITED_INSTANCES,
         4096, 4096,
         0,
@@ -232,8 +628,9 @@ pcom_server_accept(int server_handle)
     return client_handle;
 }
 
-int 
-pcom_server_check_user(int client_handle, pcom_user_info_t* p_info) 
+/** pcom_server_check_user() without the instrumentation */
+static int
+check_user(int client_handle, pcom_user_info_t* p_info)
 {
 
     /* Failed attempt info */
@@ -252,26 +649,41 @@ pcom_server_check_user(int client_handle, pcom_user_info_t* p_info)
         return pcom_errno_from(result);
     }
 
-    // Lookup username
-    struct passwd* p_pw = getpwuid(credentials.uid);
-    if (!p_pw) {
-        result = errno;
-        perror("getpwuid() failed");
-        return pcom_errno_from(result);
+    // TCP peers have no kernel credentials, Linux reports no pid and uid -1
+    if (credentials.pid == 0 && credentials.uid == (uid_t)-1) return -ENOTSUP;
+
+    // Lookup username, cached by uid
+    result = cred_get_user(credentials.uid, credentials.gid,
+                           p_info->username, sizeof(p_info->username), NULL, NULL);
+    if (result) {
+        strcpy(p_info->username, "unknown");
+        perror("getpwuid_r() failed");
+        return result;
     }
-    strncpy(p_info->username, p_pw->pw_name, sizeof(p_info->username) - 1);
 
     // Check if root (admin)
     p_info->is_admin = (credentials.uid == 0) ? 1 : 0;
 
     // --- Get all group memberships ---
     gid_t groups[PCOM_MAX_GROUP_COUNT];
-    int ngroups = PCOM_MAX_GROUP_COUNT;
-
-    if (getgrouplist(p_pw->pw_name, credentials.gid, groups, &ngroups) == -1) {
-        result = errno;
-        perror("getgrouplist() failed");
-        return pcom_errno_from(result);
+    int ngroups;
+
+    // The kernel knows the peer's groups, no NSS needed. Primary group first.
+    groups[0] = credentials.gid;
+    ngroups = cred_peer_groups(client_handle, credentials.gid, groups + 1, PCOM_MAX_GROUP_COUNT - 1);
+    if (ngroups >= 0) {
+        ++ngroups;
+    } else if (ngroups == pcom_errno_from(EOVERFLOW)) {
+        // More than group_list holds, not a partial answer
+        return ngroups;
+    } else {
+        // No SO_PEERGROUPS, fall back to the cached group database
+        result = cred_get_user(credentials.uid, credentials.gid, p_info->username,
+                               sizeof(p_info->username), groups, &ngroups);
+        if (result) {
+            perror("getgrouplist() failed");
+            return result;
+        }
     }
 
     // Populate the buffer with group names
@@ -280,18 +692,16 @@ pcom_server_check_user(int client_handle, pcom_user_info_t* p_info)
     size_t buf_len = sizeof(p_info->group_name_buffer);
 
     for (int i = 0; i < ngroups; ++i) {
-        struct group* p_grp = getgrgid(groups[i]);
-        if (p_grp) {
-            size_t name_len = strlen(p_grp->gr_name) + 1;
-            if (name_len < buf_len) {
-                strncpy(p_buf, p_grp->gr_name, buf_len);
-                p_info->group_list[p_info->group_count++] = p_buf;
-                p_buf += name_len;
-                buf_len -= name_len;
-            } else {
-                perror ("Group list overflow");
-                return pcom_errno_from(EOVERFLOW);
-            }
+        result = cred_get_group(groups[i], p_buf, buf_len);
+        if (result == pcom_errno_from(EOVERFLOW)) {
+            perror ("Group list overflow");
+            return result;
+        }
+        if (!result) {
+            size_t name_len = strlen(p_buf) + 1;
+            p_info->group_list[p_info->group_count++] = p_buf;
+            p_buf += name_len;
+            buf_len -= name_len;
         }
     }
 
@@ -393,7 +803,16 @@ pcom_server_check_user(int client_handle, pcom_user_info_t* p_info)
     return 0;
 }
 
-
+int 
+pcom_server_check_user(int client_handle, pcom_user_info_t* p_info) 
+{
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+    int result = check_user(client_handle, p_info);
+    pcom_stats_call(PCOM_STATS_CHECK_USER, client_handle, t0, result);
+    pcom_trace_end(tr, PCOM_TRACE_CHECK_USER, client_handle, result, 0);
+    return result;
+}
 
 int 
 pcom_server_send(int client_handle, const void* buf, size_t len) 
@@ -401,17 +820,33 @@ pcom_server_send(int client_handle, const void* buf, size_t len)
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
 
     ssize_t result;
-    // Send data to the client
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+
+    // Send data to the client, capped so the count fits the return type
+    if (len > INT_MAX) len = INT_MAX;
+    if (pcom_coalesce_on(client_handle)) {
+        pcom_iovec_t iov = { buf, len };
+        unsigned syscalls = 0;
+        result = pcom_coalesce_send(client_handle, &iov, 1, &syscalls);
+        pcom_stats_io(PCOM_STATS_SEND, client_handle, t0, result, result >= 0, syscalls, 0, 0);
+        pcom_trace_end(tr, PCOM_TRACE_SEND, client_handle, result, len);
+        return (int)result;
+    }
     result = write(client_handle, buf, len);
-    if (result < 0) return pcom_errno_from(errno);
-    
-    return result;
+    if (result < 0) result = pcom_errno_from(errno);
+    pcom_stats_io(PCOM_STATS_SEND, client_handle, t0, result, result >= 0, 1,
+                  result == -EAGAIN || result == -EWOULDBLOCK, result >= 0 && (size_t)result < len);
+    pcom_trace_end(tr, PCOM_TRACE_SEND, client_handle, result, len);
+
+    return (int)result;
 
 #elif defined(_WIN32) || defined(_WIN64)
 
     DWORD written;
     
     // Send data to the client
+    if (len > INT_MAX) len = INT_MAX;
     if (!WriteFile((HANDLE)(intptr_t)client_handle, buf, (DWORD)len, &written, NULL))
         return pcom_errno_from(GetLastError());
 
@@ -429,9 +864,16 @@ pcom_server_recv(int client_handle, void* buf, size_t len)
 {
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
 
-    // Receive data from the client
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+
+    // Receive data from the client, capped so the count fits the return type
+    if (len > INT_MAX) len = INT_MAX;
     ssize_t result = read(client_handle, buf, len);
-    if (result < 0) return pcom_errno_from(errno);
+    if (result < 0) result = pcom_errno_from(errno);
+    pcom_stats_io(PCOM_STATS_RECV, client_handle, t0, result, result > 0, 1,
+                  result == -EAGAIN || result == -EWOULDBLOCK, 0);
+    pcom_trace_end(tr, PCOM_TRACE_RECV, client_handle, result, len);
 
     return (int)result;
 
@@ -440,6 +882,7 @@ pcom_server_recv(int client_handle, void* buf, size_t len)
     DWORD read;
     
     // Receive data from the client
+    if (len > INT_MAX) len = INT_MAX;
     if (!ReadFile((HANDLE)(intptr_t)client_handle, buf, (DWORD)len, &read, NULL))
         return pcom_errno_from(GetLastError());
 
@@ -458,6 +901,7 @@ pcom_server_close(int server_handle)
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
 
     // Close the server handle
+    pcom_tcp_server_close(server_handle);
     close(server_handle);
 
 #elif defined(_WIN32) || defined(_WIN64)
@@ -471,31 +915,64 @@ pcom_server_close(int server_handle)
 int
 pcom_client_open(const char* name) 
 {
-    int client_handle = -1, result;
-    char full_name[FULL_NAME_MAX];
+    return pcom_client_open_ex(name, PCOM_OPEN_STREAM);
+}
 
-    // Build the full connection name
-    result = build_full_name(name, full_name, sizeof(full_name));
-    if (result) return result;
+int
+pcom_client_open_ex(const char* name, int flags) 
+{
+    int client_handle = -1, result;
 
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
 
-    // Create the socket address structure
-    struct sockaddr_un addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, full_name, sizeof(addr.sun_path) - 1);    
+    endpoint_t ep;
+    int type = sock_type_from(flags);
+    if (type < 0) return type;
+
+    if (pcom_tcp_is_name(name)) {
+        client_handle = pcom_tcp_client_open(name, flags);
+        if (client_handle >= 0) pcom_stats_conn_clear(client_handle);
+        return client_handle;
+    }
+
+    // Build the socket address from the connection name
+    result = build_endpoint(name, flags, &ep);
+    if (result) return result;
     
     // Create the socket
-    client_handle = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (client_handle < 0) return pcom_errno_from(errno);
+    client_handle = socket(AF_UNIX, type, 0);
+    if (client_handle < 0) { result = errno; endpoint_close(&ep); return pcom_errno_from(result); }
+
+#if defined(__linux__)
+    // Datagram clients need an address of their own to get replies.
+    // Binding only the family autobinds a unique abstract address.
+    if (type == SOCK_DGRAM) {
+        struct sockaddr_un self;
+        memset(&self, 0, sizeof(self));
+        self.sun_family = AF_UNIX;
+        if (bind(client_handle, (struct sockaddr*)&self, sizeof(sa_family_t)) < 0)
+            { result = errno; endpoint_close(&ep); close(client_handle); return pcom_errno_from(result); }
+    }
+#endif
 
     // Connect to the server
-    if (connect(client_handle, (struct sockaddr*)&addr, sizeof(addr)) < 0)
-        { result = errno; close(client_handle); pcom_errno_from(result); }
+    result = connect(client_handle, (struct sockaddr*)&ep.addr, ep.len) < 0 ? errno : 0;
+    endpoint_close(&ep);
+    if (result) { close(client_handle); return pcom_errno_from(result); }
+    pcom_stats_conn_clear(client_handle);
 
 #elif defined(_WIN32) || defined(_WIN64)
     
+    char full_name[FULL_NAME_MAX];
+
+    // Build the full connection name
+    result = build_full_name(name, full_name, sizeof(full_name));
+    if (result) return result;
+
+    int type = flags & PCOM_OPEN_TYPE_MASK;
+    if (type != PCOM_OPEN_STREAM && type != PCOM_OPEN_SEQPACKET)
+        return pcom_errno_from(ERROR_NOT_SUPPORTED);
+
     // Create the named pipe
     HANDLE hPipe = CreateFileA(
         full_name,
@@ -506,7 +983,16 @@ pcom_client_open(const char* name)
         0,
         NULL
     );
-    if (hPipe == INVALID_HANDLE_VALUE) pcom_errno_from(GetLastError());
+    if (hPipe == INVALID_HANDLE_VALUE) return pcom_errno_from(GetLastError());
+
+    if (type == PCOM_OPEN_SEQPACKET) {
+        DWORD mode = PIPE_READMODE_MESSAGE;
+        if (!SetNamedPipeHandleState(hPipe, &mode, NULL, NULL)) {
+            DWORD err = GetLastError();
+            CloseHandle(hPipe);
+            return pcom_errno_from(err);
+        }
+    }
 
     client_handle = (int)(intptr_t)hPipe;
 
@@ -536,7 +1022,8 @@ pcom_client_close(int client_handle)
 {
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
 
-    // Close the client
+    // Close the client, writing out what it has buffered
+    pcom_coalesce_close(client_handle);
     close(client_handle);
 
 #elif defined(_WIN32) || defined(_WIN64)
@@ -546,3 +1033,326 @@ pcom_client_close(int client_handle)
 
 #endif
 }
+
+int
+pcom_set_bufsize(int handle, int sndbuf, int rcvbuf)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (sndbuf < 0 || rcvbuf < 0) return -1;
+    if (sndbuf && setsockopt(handle, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)) < 0)
+        return pcom_errno_from(errno);
+    if (rcvbuf && setsockopt(handle, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0)
+        return pcom_errno_from(errno);
+    return 0;
+
+#else
+
+    (void)handle; (void)sndbuf; (void)rcvbuf;
+    return -1;
+
+#endif
+}
+
+int
+pcom_set_nonblocking(int handle, int nonblocking)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    int flags = fcntl(handle, F_GETFL);
+    if (flags < 0) return pcom_errno_from(errno);
+    flags = nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    if (fcntl(handle, F_SETFL, flags) < 0) return pcom_errno_from(errno);
+    return 0;
+
+#else
+
+    (void)handle; (void)nonblocking;
+    return -1;
+
+#endif
+}
+
+int64_t
+pcom_send_all(int handle, const void* buf, size_t len)
+{
+    pcom_iovec_t iov = { buf, len };
+    return pcom_sendv(handle, &iov, 1);
+}
+
+int64_t
+pcom_recv_exact(int handle, void* buf, size_t len)
+{
+    char* p = buf;
+    size_t got = 0;
+
+    if (!buf && len) return -1;
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+    unsigned syscalls = 0, eagain = 0, partial = 0;
+    int64_t error = 0;
+
+    while (got < len) {
+        ssize_t result = read(handle, p + got, len - got);
+        ++syscalls;
+        if (result == 0) break;
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) { error = pcom_errno_from(errno); break; }
+            ++eagain;
+            result = wait_ready(handle, POLLIN);
+            if (result < 0) { error = result; break; }
+            continue;
+        }
+        got += (size_t)result;
+        if (got < len) ++partial;
+    }
+    pcom_stats_io(PCOM_STATS_RECV, handle, t0, error ? error : (int64_t)got, !error && got > 0,
+                  syscalls, eagain, partial);
+    pcom_trace_end(tr, PCOM_TRACE_RECV, handle, error ? error : (int64_t)got, len);
+    if (error) return error;
+
+#elif defined(_WIN32) || defined(_WIN64)
+
+    while (got < len) {
+        DWORD chunk = (len - got > INT_MAX) ? INT_MAX : (DWORD)(len - got);
+        DWORD read;
+        if (!ReadFile((HANDLE)(intptr_t)handle, p + got, chunk, &read, NULL)) {
+            DWORD err = GetLastError();
+            if (err == ERROR_BROKEN_PIPE) break;
+            return pcom_errno_from(err);
+        }
+        if (read == 0) break;
+        got += read;
+    }
+
+#else
+
+    return -1;
+
+#endif
+
+    return (int64_t)got;
+}
+
+int64_t
+pcom_sendv(int handle, const pcom_iovec_t* iov, int count)
+{
+    int64_t total = 0;
+    int first = 0;       // First buffer not fully sent
+    size_t skip = 0;     // Bytes of it already sent
+
+    if (!iov || count < 0) return -1;
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    struct iovec vec[PCOM_IOV_MAX];
+    struct msghdr msg;
+    int is_socket = 1;
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+    unsigned syscalls = 0, eagain = 0, partial = 0;
+
+    // Queued whole on coalescing handles, the loop is skipped
+    if (pcom_coalesce_on(handle)) {
+        total = pcom_coalesce_send(handle, iov, count, &syscalls);
+        first = count;
+    }
+
+    while (first < count) {
+        int n = 0;
+        size_t want = 0;
+        for (int i = first; i < count && n < PCOM_IOV_MAX; ++i) {
+            size_t off = (i == first) ? skip : 0;
+            if (iov[i].len == off) continue;
+            vec[n].iov_base = (char*)iov[i].base + off;
+            vec[n].iov_len = iov[i].len - off;
+            want += vec[n].iov_len;
+            ++n;
+        }
+        if (n == 0) break;
+
+        // sendmsg() for MSG_NOSIGNAL, writev() for pipes and other files
+        ssize_t result;
+        if (is_socket) {
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = vec;
+            msg.msg_iovlen = n;
+            result = sendmsg(handle, &msg, MSG_NOSIGNAL);
+            ++syscalls;
+            if (result < 0 && errno == ENOTSOCK) {
+                is_socket = 0;
+                continue;
+            }
+        } else {
+            result = writev(handle, vec, n);
+            ++syscalls;
+        }
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) { total = pcom_errno_from(errno); break; }
+            ++eagain;
+            result = wait_ready(handle, POLLOUT);
+            if (result < 0) { total = result; break; }
+            continue;
+        }
+
+        if ((size_t)result < want) ++partial;
+        total += result;
+        size_t left = (size_t)result;
+        while (first < count && left >= iov[first].len - skip) {
+            left -= iov[first].len - skip;
+            ++first;
+            skip = 0;
+        }
+        skip += left;
+    }
+    pcom_stats_io(PCOM_STATS_SEND, handle, t0, total, total > 0, syscalls, eagain, partial);
+    pcom_trace_end(tr, PCOM_TRACE_SEND, handle, total, 0);
+
+#elif defined(_WIN32) || defined(_WIN64)
+
+    // Pipes have no gather write, send the pieces in order
+    for (; first < count; ++first) {
+        const char* p = iov[first].base;
+        size_t len = iov[first].len;
+        while (len > 0) {
+            DWORD chunk = (len > INT_MAX) ? INT_MAX : (DWORD)len;
+            DWORD written;
+            if (!WriteFile((HANDLE)(intptr_t)handle, p, chunk, &written, NULL))
+                return pcom_errno_from(GetLastError());
+            p += written;
+            len -= written;
+            total += written;
+        }
+    }
+    (void)skip;
+
+#else
+
+    return -1;
+
+#endif
+
+    return total;
+}
+
+int
+pcom_send_batch(int handle, const pcom_msg_t* msgs, int count)
+{
+    if (!msgs || count < 0) return -1;
+    if (count > PCOM_BATCH_MAX) count = PCOM_BATCH_MAX;
+
+#if defined(__linux__)
+
+    // Keep the order with what a coalescing handle has buffered
+    if (pcom_coalesce_on(handle)) {
+        int64_t flushed = pcom_flush(handle);
+        if (flushed < 0) return (int)flushed;
+    }
+
+    struct mmsghdr vec[PCOM_BATCH_MAX];
+    struct iovec iov[PCOM_BATCH_MAX];
+
+    memset(vec, 0, sizeof(vec[0]) * count);
+    for (int i = 0; i < count; ++i) {
+        iov[i].iov_base = msgs[i].buf;
+        iov[i].iov_len = msgs[i].len;
+        vec[i].msg_hdr.msg_iov = &iov[i];
+        vec[i].msg_hdr.msg_iovlen = 1;
+        if (msgs[i].peer && msgs[i].peer->len) {
+            vec[i].msg_hdr.msg_name = (void*)msgs[i].peer->addr;
+            vec[i].msg_hdr.msg_namelen = (socklen_t)msgs[i].peer->len;
+        }
+    }
+
+    // One syscall for the whole batch
+    int result;
+    unsigned syscalls = 0;
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+    do { result = sendmmsg(handle, vec, (unsigned)count, MSG_NOSIGNAL); ++syscalls; }
+    while (result < 0 && errno == EINTR);
+    if (result < 0) result = pcom_errno_from(errno);
+
+    int64_t bytes = 0;
+    for (int i = 0; i < result; ++i) bytes += (int64_t)vec[i].msg_len;
+    pcom_stats_io(PCOM_STATS_SEND, handle, t0, result < 0 ? result : bytes, result > 0 ? result : 0,
+                  syscalls, result == -EAGAIN || result == -EWOULDBLOCK, result >= 0 && result < count);
+    pcom_trace_end(tr, PCOM_TRACE_SEND, handle, result < 0 ? result : bytes, 0);
+
+    return result;
+
+#else
+
+    // No sendmmsg(), one send per message
+    for (int i = 0; i < count; ++i) {
+        if (msgs[i].peer && msgs[i].peer->len) return i ? i : -1;
+        int result = pcom_server_send(handle, msgs[i].buf, msgs[i].len);
+        if (result < 0) return i ? i : result;
+    }
+    return count;
+
+#endif
+}
+
+int
+pcom_recv_batch(int handle, pcom_msg_t* msgs, int count)
+{
+    if (!msgs || count < 0) return -1;
+    if (count > PCOM_BATCH_MAX) count = PCOM_BATCH_MAX;
+
+#if defined(__linux__)
+
+    struct mmsghdr vec[PCOM_BATCH_MAX];
+    struct iovec iov[PCOM_BATCH_MAX];
+
+    memset(vec, 0, sizeof(vec[0]) * count);
+    for (int i = 0; i < count; ++i) {
+        iov[i].iov_base = msgs[i].buf;
+        iov[i].iov_len = msgs[i].len;
+        vec[i].msg_hdr.msg_iov = &iov[i];
+        vec[i].msg_hdr.msg_iovlen = 1;
+        if (msgs[i].peer) {
+            vec[i].msg_hdr.msg_name = msgs[i].peer->addr;
+            vec[i].msg_hdr.msg_namelen = sizeof(msgs[i].peer->addr);
+        }
+    }
+
+    // Wait for the first message, then take whatever else is queued
+    int result;
+    unsigned syscalls = 0;
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+    do { result = recvmmsg(handle, vec, (unsigned)count, MSG_WAITFORONE, NULL); ++syscalls; }
+    while (result < 0 && errno == EINTR);
+    if (result < 0) result = pcom_errno_from(errno);
+
+    int64_t bytes = 0;
+    for (int i = 0; i < result; ++i) {
+        msgs[i].msg_len = vec[i].msg_len;
+        msgs[i].flags = (vec[i].msg_hdr.msg_flags & MSG_TRUNC) ? PCOM_MSG_TRUNC : 0;
+        if (msgs[i].peer) msgs[i].peer->len = vec[i].msg_hdr.msg_namelen;
+        bytes += (int64_t)vec[i].msg_len;
+    }
+    pcom_stats_io(PCOM_STATS_RECV, handle, t0, result < 0 ? result : bytes, result > 0 ? result : 0,
+                  syscalls, result == -EAGAIN || result == -EWOULDBLOCK, 0);
+    pcom_trace_end(tr, PCOM_TRACE_RECV, handle, result < 0 ? result : bytes, 0);
+    return result;
+
+#else
+
+    // No recvmmsg(), one blocking receive
+    if (count == 0) return 0;
+    int result = pcom_server_recv(handle, msgs[0].buf, msgs[0].len);
+    if (result < 0) return result;
+    msgs[0].msg_len = (size_t)result;
+    msgs[0].flags = 0;
+    if (msgs[0].peer) msgs[0].peer->len = 0;
+    return 1;
+
+#endif
+}
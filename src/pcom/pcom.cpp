@@ -0,0 +1,407 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom.cpp
+ * @author    phstream
+ * @copyright 2025, phstream
+ * @license   MIT
+ * @date      19 Oct 2026
+ ****************************************************************************/
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+
+#include "pcom.hpp"
+
+namespace crow {
+namespace pcom {
+
+namespace {
+
+/// @brief Largest length a single int returning PCOM call can report.
+size_t clamp_len(size_t len) {
+    return std::min(len, static_cast<size_t>(INT_MAX));
+}
+
+/// @brief Throws for negative PCOM results, returns the others.
+template <class T>
+T check(T result, const char* what) {
+    if (result < 0) throw error(static_cast<int>(result), what);
+    return result;
+}
+
+} // namespace
+
+/* ---- error -------------------------------------------------------------- */
+
+error::error(int result, const std::string& what)
+    : std::system_error(std::error_code(result < 0 ? -result : result, std::generic_category()), what) {
+}
+
+/* ---- connection --------------------------------------------------------- */
+
+connection::connection(int handle) noexcept : _handle(handle) {
+}
+
+connection::connection(const std::string& name, int flags) {
+    _handle = check(pcom_client_open_ex(name.c_str(), flags), "pcom_client_open");
+}
+
+connection::connection(connection&& other) noexcept
+    : _handle(std::exchange(other._handle, -1)), _reactor(std::exchange(other._reactor, nullptr)) {
+}
+
+connection& connection::operator=(connection&& other) noexcept {
+    if (this != &other) {
+        close();
+        _handle = std::exchange(other._handle, -1);
+        _reactor = std::exchange(other._reactor, nullptr);
+    }
+    return *this;
+}
+
+connection::~connection() {
+    close();
+}
+
+size_t connection::send(std::span<const std::byte> data) {
+    return static_cast<size_t>(check(pcom_client_send(_handle, data.data(), clamp_len(data.size())), "pcom_client_send"));
+}
+
+void connection::send_all(std::span<const std::byte> data) {
+    check(pcom_send_all(_handle, data.data(), data.size()), "pcom_send_all");
+}
+
+void connection::send_all(std::string_view str) {
+    send_all(std::as_bytes(std::span<const char>(str.data(), str.size())));
+}
+
+size_t connection::recv(std::span<std::byte> buf) {
+    return static_cast<size_t>(check(pcom_client_recv(_handle, buf.data(), clamp_len(buf.size())), "pcom_client_recv"));
+}
+
+size_t connection::recv_exact(std::span<std::byte> buf) {
+    return static_cast<size_t>(check(pcom_recv_exact(_handle, buf.data(), buf.size()), "pcom_recv_exact"));
+}
+
+void connection::close() noexcept {
+    if (_handle < 0) return;
+    if (_reactor) _reactor->detach(_handle);
+    pcom_client_close(_handle);
+    _handle = -1;
+    _reactor = nullptr;
+}
+
+int connection::release() noexcept {
+    if (_reactor) _reactor->detach(_handle);
+    _reactor = nullptr;
+    return std::exchange(_handle, -1);
+}
+
+/* ---- server ------------------------------------------------------------- */
+
+server::server(const std::string& name, int flags) {
+    _handle = check(pcom_server_open_ex(name.c_str(), flags), "pcom_server_open");
+}
+
+server::server(server&& other) noexcept : _handle(std::exchange(other._handle, -1)) {
+}
+
+server& server::operator=(server&& other) noexcept {
+    if (this != &other) {
+        close();
+        _handle = std::exchange(other._handle, -1);
+    }
+    return *this;
+}
+
+server::~server() {
+    close();
+}
+
+connection server::accept() {
+    return connection(check(pcom_server_accept(_handle), "pcom_server_accept"));
+}
+
+user_info server::check_user(const connection& conn) {
+    pcom_user_info_t info;
+    user_info user;
+
+    check(pcom_server_check_user(conn.handle(), &info), "pcom_server_check_user");
+    user.name = info.username;
+    user.admin = info.is_admin != 0;
+    for (int i = 0; i < info.group_count; ++i) user.groups.emplace_back(info.group_list[i]);
+    return user;
+}
+
+void server::close() noexcept {
+    if (_handle < 0) return;
+    pcom_server_close(_handle);
+    _handle = -1;
+}
+
+/* ---- reactor ------------------------------------------------------------ */
+
+/// @brief Coroutine type of run_task(), started by the reactor and freed
+///        when it finishes.
+struct reactor::detached {
+    struct promise_type {
+        reactor* r = nullptr;
+
+        template <class... Args>
+        promise_type(reactor* owner, Args&&...) noexcept : r(owner) {}
+        ~promise_type() {
+            r->_tasks.erase(std::coroutine_handle<promise_type>::from_promise(*this).address());
+        }
+
+        detached get_return_object() noexcept {
+            return { std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept {
+            if (!r->_error) r->_error = std::current_exception();
+        }
+    };
+
+    std::coroutine_handle<promise_type> coro;
+};
+
+reactor::detached reactor::run_task(reactor*, task<void> t) {
+    co_await t;
+}
+
+reactor::reactor(int flags) {
+    check(pcom_loop_create(&_loop, -1, flags), "pcom_loop_create");
+}
+
+reactor::reactor(const server& srv, int flags) {
+    check(pcom_loop_create(&_loop, srv.handle(), flags), "pcom_loop_create");
+}
+
+reactor::~reactor() {
+    // Unfinished tasks go first, their connections detach from the loop
+    std::vector<void*> frames(_tasks.begin(), _tasks.end());
+    for (void* frame : frames) {
+        if (_tasks.count(frame)) std::coroutine_handle<>::from_address(frame).destroy();
+    }
+    for (auto coro : _posted) coro.destroy();
+    for (int handle : _accepted) {
+        if (handle >= 0) pcom_client_close(handle);
+    }
+    pcom_loop_destroy(_loop);
+}
+
+void reactor::spawn(task<void> t) {
+    detached d = run_task(this, std::move(t));
+    {
+        std::lock_guard<std::mutex> lock(_posted_lock);
+        _posted.push_back(d.coro);
+    }
+    pcom_loop_wake(_loop);
+}
+
+void reactor::stop() {
+    _stopped.store(true, std::memory_order_release);
+    pcom_loop_wake(_loop);
+}
+
+int reactor::backend() const noexcept {
+    return pcom_loop_backend(_loop);
+}
+
+void reactor::run_ready() {
+    std::vector<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard<std::mutex> lock(_posted_lock);
+        ready.swap(_posted);
+    }
+    for (auto coro : ready) {
+        // The frame is owned from here on, see detached::promise_type
+        _tasks.insert(coro.address());
+        coro.resume();
+    }
+    while (!_ready.empty()) {
+        ready.clear();
+        ready.swap(_ready);
+        for (auto coro : ready) coro.resume();
+    }
+}
+
+void reactor::run() {
+    pcom_event_t events[64];
+
+    for (;;) {
+        run_ready();
+        if (_error) std::rethrow_exception(std::exchange(_error, nullptr));
+        if (_stopped.exchange(false, std::memory_order_acquire)) break;
+
+        int count = pcom_loop_wait(_loop, events, 64, -1);
+        if (count == -EINTR) continue;
+        check(count, "pcom_loop_wait");
+        for (int i = 0; i < count; ++i) dispatch(events[i]);
+    }
+}
+
+reactor::conn_state& reactor::attach(connection& conn) {
+    if (conn._reactor == this) return _conns[conn._handle];
+    if (conn._handle < 0) throw error(-EBADF, "pcom_loop_add");
+    if (conn._reactor) throw error(-EINVAL, "pcom_loop_add");
+
+    check(pcom_loop_add(_loop, conn._handle), "pcom_loop_add");
+    conn._reactor = this;
+    return _conns[conn._handle];
+}
+
+void reactor::detach(int handle) noexcept {
+    auto it = _conns.find(handle);
+    if (it == _conns.end()) return;
+
+    pcom_loop_remove(_loop, handle);
+    if (recv_op* p_op = it->second.waiter) {
+        // Woken on the next turn, not from inside close()
+        p_op->_result = -ECANCELED;
+        _ready.push_back(p_op->_waiter);
+    }
+    _conns.erase(it);
+}
+
+void reactor::dispatch(const pcom_event_t& ev) {
+    switch (ev.type) {
+    case PCOM_EVENT_ACCEPT:
+        if (_acceptor) {
+            accept_op* p_op = std::exchange(_acceptor, nullptr);
+            p_op->_result = (ev.result < 0) ? ev.result : ev.handle;
+            p_op->_waiter.resume();
+        } else {
+            _accepted.push_back((ev.result < 0) ? ev.result : ev.handle);
+        }
+        break;
+
+    case PCOM_EVENT_RECV: {
+        auto it = _conns.find(ev.handle);
+        if (it == _conns.end()) {
+            pcom_loop_release(_loop, &ev);
+            break;
+        }
+        conn_state& st = it->second;
+        recv_op* p_op = std::exchange(st.waiter, nullptr);
+        if (ev.result > 0) {
+            auto data = static_cast<const std::byte*>(ev.data);
+            size_t len = static_cast<size_t>(ev.result);
+            size_t used = 0;
+            if (p_op) {
+                // A waiting receive has no pending data, copy straight in
+                used = std::min(len, p_op->_buf.size());
+                std::memcpy(p_op->_buf.data(), data, used);
+                p_op->_result = static_cast<int>(used);
+            }
+            st.pending.insert(st.pending.end(), data + used, data + len);
+        } else {
+            st.status = ev.result;
+            if (p_op) p_op->_result = ev.result;
+        }
+        pcom_loop_release(_loop, &ev);
+        if (p_op) p_op->_waiter.resume();
+        break;
+    }
+
+    case PCOM_EVENT_SEND: {
+        auto p_op = static_cast<send_op*>(ev.user);
+        p_op->_result = ev.result;
+        p_op->_waiter.resume();
+        break;
+    }
+
+    default:
+        pcom_loop_release(_loop, &ev);
+        break;
+    }
+}
+
+bool reactor::accept_op::await_ready() {
+    if (_r->_acceptor) {
+        _result = -EBUSY;
+        return true;
+    }
+    if (_r->_accepted.empty()) return false;
+    _result = _r->_accepted.front();
+    _r->_accepted.erase(_r->_accepted.begin());
+    return true;
+}
+
+void reactor::accept_op::await_suspend(std::coroutine_handle<> h) {
+    _waiter = h;
+    _r->_acceptor = this;
+}
+
+connection reactor::accept_op::await_resume() {
+    return connection(check(_result, "pcom_server_accept"));
+}
+
+bool reactor::send_op::await_ready() {
+    return _data.empty();
+}
+
+bool reactor::send_op::await_suspend(std::coroutine_handle<> h) {
+    _waiter = h;
+    _r->attach(*_conn);
+    _result = pcom_loop_send(_r->_loop, _conn->_handle, _data.data(), _data.size(), this);
+    return _result >= 0;
+}
+
+void reactor::send_op::await_resume() {
+    check(_result, "pcom_loop_send");
+}
+
+bool reactor::recv_op::await_ready() {
+    conn_state& st = _r->attach(*_conn);
+    if (st.waiter) {
+        _result = -EBUSY;
+        return true;
+    }
+    if (st.pending_off < st.pending.size()) {
+        size_t len = std::min(st.pending.size() - st.pending_off, _buf.size());
+        std::memcpy(_buf.data(), st.pending.data() + st.pending_off, len);
+        st.pending_off += len;
+        if (st.pending_off == st.pending.size()) {
+            st.pending.clear();
+            st.pending_off = 0;
+        }
+        _result = static_cast<int>(len);
+        return true;
+    }
+    if (st.status <= 0 || _buf.empty()) {
+        _result = (st.status < 0) ? st.status : 0;
+        return true;
+    }
+    return false;
+}
+
+void reactor::recv_op::await_suspend(std::coroutine_handle<> h) {
+    _waiter = h;
+    _r->_conns[_conn->_handle].waiter = this;
+}
+
+size_t reactor::recv_op::await_resume() {
+    return static_cast<size_t>(check(_result, "pcom_loop_recv"));
+}
+
+task<size_t> reactor::recv_exact(connection& conn, std::span<std::byte> buf) {
+    size_t got = 0;
+    while (got < buf.size()) {
+        size_t n = co_await recv(conn, buf.subspan(got));
+        if (n == 0) break;
+        got += n;
+    }
+    co_return got;
+}
+
+} // namespace pcom
+} // namespace crow
@@ -18,6 +18,13 @@
  *            UNIX domain sockets (Linux/macOS) or Named Pipes (Windows). 
  *            Can be statically linked or compiled as a shared library (.so/.dll).
  *
+ *            Connection names on Linux/macOS:
+ *            - "name"       -> <socket dir>/name.sock, see pcom_set_socket_dir()
+ *            - "/path/x"    -> used as is
+ *            - "@name"      -> Linux abstract namespace, no file system inode
+ *            - "tcp://h:p"  -> TCP to host h port p, see pcom_tcp.h
+ *            Paths longer than sun_path are reached through /proc/self/fd on Linux.
+ *
  * @pre       common/lib_defs.h
  * @bug       -
  * @warning   -
@@ -28,6 +35,7 @@
 #define PCOM_H
 
 #include <stddef.h>  // for size_t
+#include <stdint.h>  // for int64_t
 
 #include "../common/lib_defs.h"
 
@@ -38,6 +46,20 @@ extern "C" {
 #define PCOM_USER_NAME_LEN (256)
 #define PCOM_MAX_GROUP_COUNT (32)
 #define PCOM_GROUP_NAME_BUFFER_LEN (1024)
+#define PCOM_CRED_CACHE_TTL (60)     // Default credential cache TTL in seconds
+#define PCOM_BATCH_MAX (64)          // Max messages per batch syscall
+#define PCOM_PEER_ADDR_LEN (128)
+#define PCOM_IOV_MAX (64)            // Max buffers per vectored syscall
+
+/* Flags for pcom_server_open_ex() and pcom_client_open_ex() */
+#define PCOM_OPEN_STREAM    (0)      // Byte stream (default)
+#define PCOM_OPEN_SEQPACKET (1)      // Connected, message boundaries kept
+#define PCOM_OPEN_DGRAM     (2)      // Connectionless datagrams (not on Windows)
+#define PCOM_OPEN_TYPE_MASK (0x0F)
+#define PCOM_OPEN_ABSTRACT  (1 << 4) // Linux abstract namespace, same as '@' prefix
+
+/* Flags in pcom_msg_t.flags */
+#define PCOM_MSG_TRUNC      (1 << 0) // Received message did not fit the buffer
 
 typedef struct {
     int is_admin;                                  // 1 if admin, 0 if not
@@ -47,6 +69,27 @@ typedef struct {
     char group_name_buffer[PCOM_GROUP_NAME_BUFFER_LEN]; // Flat buffer for names
 } pcom_user_info_t;
 
+/** Sender or destination address of a datagram */
+typedef struct {
+    size_t len;                                    // Address length, 0 if none
+    unsigned char addr[PCOM_PEER_ADDR_LEN];        // Platform socket address
+} pcom_peer_t;
+
+/** One buffer of a vectored send */
+typedef struct {
+    const void* base;    // Data
+    size_t len;          // Length of the data
+} pcom_iovec_t;
+
+/** One message in a batch send or receive */
+typedef struct {
+    void* buf;           // Message data
+    size_t len;          // Send: message length. Receive: buffer size
+    size_t msg_len;      // Receive: received message length
+    int flags;           // Receive: PCOM_MSG_* flags
+    pcom_peer_t* peer;   // Datagram peer, NULL on connected handles
+} pcom_msg_t;
+
 /* ---- Common functions -------------------------------------------------- */
 /**
  * @brief      Get the version of the PCOM library
@@ -68,6 +111,19 @@ pcom_version(void);
 LIB_EXPORT int
 pcom_error_text(int error_code, char* p_text_buf, size_t buf_len);
 
+/**
+ * @brief      Set the directory used for plain connection names.
+ * @param      dir  Absolute directory path, or NULL for the default.
+ * @return     0 on success, negative error code on failure.
+ * @details    The default is $PCOM_SOCKET_DIR if set, otherwise /var/tmp.
+ *             Point it at a tmpfs such as /run to keep socket creation and
+ *             connect off slow storage. Set it before opening endpoints,
+ *             it is not synchronized with concurrent opens.
+ *             Not supported on Windows, pipe names have no directory.
+ */
+LIB_EXPORT int
+pcom_set_socket_dir(const char* dir);
+
 /* ---- Server functions -------------------------------------------------- */
 /**
  * @brief      Open a PCOM server for IPC communication.
@@ -79,6 +135,20 @@ pcom_error_text(int error_code, char* p_text_buf, size_t buf_len);
 LIB_EXPORT int
 pcom_server_open(const char* name);
 
+/**
+ * @brief      Open a PCOM server with a selected socket type.
+ * @param      name   The name of the connection.
+ * @param      flags  PCOM_OPEN_STREAM, PCOM_OPEN_SEQPACKET or PCOM_OPEN_DGRAM.
+ * @return     Server handle or negative error code.
+ * @details    SEQPACKET servers accept clients like stream servers, but each
+ *             send and receive moves exactly one message. DGRAM servers do not
+ *             accept; the server handle itself receives with pcom_recv_batch()
+ *             and replies to the reported peer with pcom_send_batch().
+ *             On Windows SEQPACKET selects message mode pipes.
+ */
+LIB_EXPORT int
+pcom_server_open_ex(const char* name, int flags);
+
 /**
  * @brief      Accept a client connection on the server.
  * @param      server_handle  The server handle obtained from pcom_server_open().
@@ -94,18 +164,40 @@ pcom_server_accept(int server_handle);
  * @brief Checks the user information of the connected client.
  * @param client_handle  The socket or pipe handle of the client.
  * @param info           Pointer to a pcom_user_info_t struct that will be filled.
- * @return 0 on success, negative error code on failure.
+ * @return 0 on success, -EOVERFLOW if the client is in more than
+ *         PCOM_MAX_GROUP_COUNT groups, negative error code on failure.
+ * @details On Linux the peer's groups come from the kernel (SO_PEERGROUPS)
+ *          and user and group names from a uid/gid keyed cache, so repeated
+ *          checks do not hit NSS. Misses use the reentrant getpwuid_r() and
+ *          getgrgid_r(). Safe to call from several threads.
  */
 LIB_EXPORT int
 pcom_server_check_user(int client_handle, pcom_user_info_t *info);
 
+/**
+ * @brief      Set how long resolved user and group names are cached.
+ * @param      seconds  Time to live, 0 disables and clears the cache.
+ *                      Default is PCOM_CRED_CACHE_TTL.
+ */
+LIB_EXPORT void
+pcom_cred_cache_set_ttl(int seconds);
+
+/**
+ * @brief      Drop all cached user and group names.
+ * @details    Call after changing users or groups for the change to be seen
+ *             before the cache TTL runs out.
+ */
+LIB_EXPORT void
+pcom_cred_cache_invalidate(void);
+
 /**
  * @brief      Send data to the client
  * @param      client_handle  The client file handle
  * @param      buf            The buffer to send
  * @param      len            The length of the buffer
  * @return     Number of bytes written, negative error code on failure.
- * @details    This function sends data to the client.
+ * @details    This function sends data to the client. One write, at most
+ *             INT_MAX bytes, may be short. See pcom_send_all().
  */
 LIB_EXPORT int
 pcom_server_send(int client_handle, const void* buf, size_t len); 
@@ -116,7 +208,8 @@ pcom_server_send(int client_handle, const void* buf, size_t len);
  * @param      buf            The buffer to receive data into
  * @param      len            The length of the buffer
  * @return     Number of bytes read, negative error code on failure.
- * @details    This function receives data from the client.
+ * @details    This function receives data from the client. One read, at
+ *             most INT_MAX bytes. See pcom_recv_exact().
  */
 LIB_EXPORT int 
 pcom_server_recv(int client_handle, void* buf, size_t len);
@@ -142,6 +235,17 @@ pcom_server_close(int server_handle);
 LIB_EXPORT int
 pcom_client_open(const char* name);
 
+/**
+ * @brief      Open IPC client with a selected socket type.
+ * @param      name   The connection name
+ * @param      flags  Must match the socket type the server was opened with.
+ * @return     Client handle or negative error code.
+ * @details    DGRAM clients are connected to the server address and, on Linux,
+ *             bound to an autobind address so the server can reply.
+ */
+LIB_EXPORT int
+pcom_client_open_ex(const char* name, int flags);
+
 /**
  * @brief      Send data to the server
  * @param      client_handle  The client handle
@@ -172,6 +276,104 @@ pcom_client_recv(int client_handle, void* buf, size_t len);
 LIB_EXPORT void
 pcom_client_close(int client_handle);
 
+/**
+ * @brief      Set the kernel buffer sizes of a connection.
+ * @param      handle  Client or accepted handle.
+ * @param      sndbuf  SO_SNDBUF in bytes, 0 to leave it.
+ * @param      rcvbuf  SO_RCVBUF in bytes, 0 to leave it.
+ * @return     0 on success, negative error code on failure.
+ * @details    Smaller buffers bound how much data sits in the kernel between
+ *             a fast sender and a slow reader. Linux doubles the values for
+ *             bookkeeping. Not supported on Windows, where pipe buffer sizes
+ *             are fixed when the pipe is created.
+ */
+LIB_EXPORT int
+pcom_set_bufsize(int handle, int sndbuf, int rcvbuf);
+
+/**
+ * @brief      Switch a handle between blocking and non-blocking mode.
+ * @param      handle       Server, client or accepted handle.
+ * @param      nonblocking  1 for non-blocking, 0 for blocking.
+ * @return     0 on success, negative error code on failure.
+ * @details    On a non-blocking handle pcom_server_accept() and the send and
+ *             receive calls return -EAGAIN instead of waiting, so the handle
+ *             can be driven by an event loop such as select, epoll or
+ *             asyncio. The handle is a file descriptor on Linux and UNIX.
+ *             Not supported on Windows.
+ */
+LIB_EXPORT int
+pcom_set_nonblocking(int handle, int nonblocking);
+
+/* ---- Full transfer functions ------------------------------------------ */
+
+/**
+ * @brief      Send a whole buffer.
+ * @param      handle  Client handle.
+ * @param      buf     The buffer to send.
+ * @param      len     The length of the buffer, may exceed 2 GB.
+ * @return     len on success, negative error code on failure.
+ * @details    Repeats short writes, retries on EINTR and waits for the
+ *             handle to become writable on EAGAIN, so it also works on
+ *             non-blocking handles. Never raises SIGPIPE.
+ */
+LIB_EXPORT int64_t
+pcom_send_all(int handle, const void* buf, size_t len);
+
+/**
+ * @brief      Receive exactly len bytes.
+ * @param      handle  Client handle.
+ * @param      buf     The buffer to receive into.
+ * @param      len     Number of bytes wanted, may exceed 2 GB.
+ * @return     len on success, fewer if the peer closed first (0 at EOF),
+ *             negative error code on failure.
+ * @details    Repeats short reads, retries on EINTR and waits for data on
+ *             EAGAIN.
+ */
+LIB_EXPORT int64_t
+pcom_recv_exact(int handle, void* buf, size_t len);
+
+/**
+ * @brief      Send several buffers as one gathered write.
+ * @param      handle  Client handle.
+ * @param      iov     Buffers, sent back to back.
+ * @param      count   Number of buffers.
+ * @return     Total bytes sent on success, negative error code on failure.
+ * @details    Header and body go out in one syscall (sendmsg() with up to
+ *             PCOM_IOV_MAX buffers per call). Short writes are resumed like
+ *             pcom_send_all().
+ */
+LIB_EXPORT int64_t
+pcom_sendv(int handle, const pcom_iovec_t* iov, int count);
+
+/* ---- Message functions ------------------------------------------------- */
+
+/**
+ * @brief      Send several messages with one syscall.
+ * @param      handle  Client handle, or a DGRAM server handle.
+ * @param      msgs    Messages to send. peer selects the destination on
+ *                     unconnected DGRAM handles and is NULL otherwise.
+ * @param      count   Number of messages, at most PCOM_BATCH_MAX per call.
+ * @return     Number of messages sent, negative error code on failure.
+ * @details    Uses sendmmsg() on Linux. On SEQPACKET and DGRAM handles every
+ *             entry is one message at the receiver. Fewer than count messages
+ *             may be sent, call again with the rest.
+ */
+LIB_EXPORT int
+pcom_send_batch(int handle, const pcom_msg_t* msgs, int count);
+
+/**
+ * @brief      Receive several messages with one syscall.
+ * @param      handle  Client handle, or a DGRAM server handle.
+ * @param      msgs    Receive buffers. msg_len, flags and peer (if not NULL)
+ *                     are filled in for each received message.
+ * @param      count   Number of buffers, at most PCOM_BATCH_MAX per call.
+ * @return     Number of messages received, negative error code on failure.
+ * @details    Uses recvmmsg() on Linux. Blocks until one message is available,
+ *             then returns it along with any others already queued.
+ */
+LIB_EXPORT int
+pcom_recv_batch(int handle, pcom_msg_t* msgs, int count);
+
 #ifdef __cplusplus
 }
 #endif
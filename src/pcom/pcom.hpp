@@ -0,0 +1,400 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom.hpp
+ * @author    phstream
+ * @copyright 2025, phstream
+ * @license   MIT
+ * @date      19 Oct 2026
+ ****************************************************************************/
+/** @defgroup  PCOM_CPP PCOM C++ wrapper
+ * @brief     RAII handles and C++20 coroutines over the PCOM C API.
+ * @details   connection and server own their handle and close it when they
+ *            go out of scope; they can be moved but not copied. The blocking
+ *            calls take std::span buffers and throw crow::pcom::error.
+ *
+ *            reactor drives coroutines from a pcom_loop (io_uring, or epoll
+ *            as fallback): co_await accept(), send() and recv() suspend the
+ *            calling task until the loop completes them, so one thread runs
+ *            thousands of sessions. Run one reactor per thread and hand
+ *            accepted connections to the others with spawn(), which may be
+ *            called from any thread.
+ *
+ * @pre       C++20, pcom.h, pcom_loop.h
+ * @bug       -
+ * @warning   The reactor is Linux only. A connection used with a reactor
+ *            belongs to it, must be used and closed on its thread and must
+ *            not outlive it. Do not close a connection while another task
+ *            awaits a send on it.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "pcom.h"
+#include "pcom_loop.h"
+
+namespace crow {
+namespace pcom {
+
+class reactor;
+
+/// @brief Error from a PCOM call, code() holds the errno value.
+class error : public std::system_error {
+public:
+    /// @brief Constructor.
+    /// @param result negative PCOM error code
+    /// @param what description of the failed call
+    error(int result, const std::string& what);
+};
+
+/// @brief Connected client of a server, closed on destruction.
+class connection {
+public:
+    /// @brief Constructor. Creates an empty connection.
+    connection() noexcept = default;
+
+    /// @brief Constructor. Takes ownership of an open handle.
+    /// @param handle PCOM client handle
+    explicit connection(int handle) noexcept;
+
+    /// @brief Constructor. Connects to a server.
+    /// @param name connection name
+    /// @param flags PCOM_OPEN_* socket type (default: stream)
+    explicit connection(const std::string& name, int flags = PCOM_OPEN_STREAM);
+
+    connection(connection&& other) noexcept;
+    connection& operator=(connection&& other) noexcept;
+    connection(const connection&) = delete;
+    connection& operator=(const connection&) = delete;
+    ~connection();
+
+    /// @brief Sends once, may send less than all of data.
+    /// @return bytes sent
+    size_t send(std::span<const std::byte> data);
+
+    /// @brief Sends all of data.
+    void send_all(std::span<const std::byte> data);
+
+    /// @brief Sends all of a string's contents.
+    void send_all(std::string_view str);
+
+    /// @brief Receives once.
+    /// @return bytes received, 0 when the peer closed
+    size_t recv(std::span<std::byte> buf);
+
+    /// @brief Receives until buf is full or the peer closed.
+    /// @return bytes received
+    size_t recv_exact(std::span<std::byte> buf);
+
+    /// @brief Closes the handle. Safe to call on an empty connection.
+    void close() noexcept;
+
+    /// @brief Gives up ownership of the handle.
+    /// @return the handle, -1 if empty
+    int release() noexcept;
+
+    /// @brief The PCOM handle, -1 if empty.
+    int handle() const noexcept { return _handle; }
+
+    /// @brief True if a handle is held.
+    explicit operator bool() const noexcept { return _handle >= 0; }
+
+private:
+    friend class reactor;
+
+    /// @brief Handle owned.
+    int _handle = -1;
+
+    /// @brief Reactor the handle is registered with, if any.
+    reactor* _reactor = nullptr;
+};
+
+/// @brief Credentials of a connected client.
+struct user_info {
+    std::string name;
+    bool admin = false;
+    std::vector<std::string> groups;
+};
+
+/// @brief Listening server, closed on destruction.
+class server {
+public:
+    /// @brief Constructor. Opens a server.
+    /// @param name connection name
+    /// @param flags PCOM_OPEN_* socket type (default: stream)
+    explicit server(const std::string& name, int flags = PCOM_OPEN_STREAM);
+
+    server(server&& other) noexcept;
+    server& operator=(server&& other) noexcept;
+    server(const server&) = delete;
+    server& operator=(const server&) = delete;
+    ~server();
+
+    /// @brief Waits for a client.
+    /// @return the accepted connection
+    connection accept();
+
+    /// @brief Looks up the credentials of a connected client.
+    static user_info check_user(const connection& conn);
+
+    /// @brief Closes the server. Safe to call twice.
+    void close() noexcept;
+
+    /// @brief The PCOM handle, -1 if closed.
+    int handle() const noexcept { return _handle; }
+
+private:
+    /// @brief Handle owned.
+    int _handle = -1;
+};
+
+/* ---- Coroutines --------------------------------------------------------- */
+
+template <class T = void>
+class task;
+
+namespace detail {
+
+/// @brief Resumes the awaiting coroutine when a task finishes.
+struct final_awaiter {
+    bool await_ready() const noexcept { return false; }
+    template <class P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+        auto next = h.promise().continuation;
+        return next ? next : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+/// @brief Promise parts shared by all task types.
+struct promise_base {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <class T>
+struct promise : promise_base {
+    T value{};
+    task<T> get_return_object() noexcept;
+    void return_value(T v) { value = std::move(v); }
+    T result() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(value);
+    }
+};
+
+template <>
+struct promise<void> : promise_base {
+    task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void result() const {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+} // namespace detail
+
+/// @brief Lazily started coroutine, runs when awaited or spawned.
+template <class T>
+class [[nodiscard]] task {
+public:
+    using promise_type = detail::promise<T>;
+
+    task(task&& other) noexcept : _coro(std::exchange(other._coro, {})) {}
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (_coro) _coro.destroy();
+            _coro = std::exchange(other._coro, {});
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() { if (_coro) _coro.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        _coro.promise().continuation = awaiting;
+        return _coro;
+    }
+    T await_resume() { return _coro.promise().result(); }
+
+private:
+    friend promise_type;
+    explicit task(std::coroutine_handle<promise_type> coro) noexcept : _coro(coro) {}
+
+    /// @brief Coroutine frame owned.
+    std::coroutine_handle<promise_type> _coro;
+};
+
+namespace detail {
+
+template <class T>
+task<T> promise<T>::get_return_object() noexcept {
+    return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+}
+
+inline task<void> promise<void>::get_return_object() noexcept {
+    return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+/// @brief Runs coroutines on a pcom_loop from one thread.
+class reactor {
+public:
+    /// @brief Constructor. Creates a reactor without a server.
+    /// @param flags PCOM_LOOP_DEFAULT or PCOM_LOOP_EPOLL
+    explicit reactor(int flags = PCOM_LOOP_DEFAULT);
+
+    /// @brief Constructor. Creates a reactor that accepts on a server.
+    /// @param srv server to accept on, must outlive the reactor
+    /// @param flags PCOM_LOOP_DEFAULT or PCOM_LOOP_EPOLL
+    explicit reactor(const server& srv, int flags = PCOM_LOOP_DEFAULT);
+
+    reactor(const reactor&) = delete;
+    reactor& operator=(const reactor&) = delete;
+    ~reactor();
+
+    /// @brief Starts a task on this reactor, from any thread.
+    void spawn(task<void> t);
+
+    /// @brief Runs tasks until stop(). Rethrows the first exception a spawned
+    ///        task let escape.
+    void run();
+
+    /// @brief Makes run() return, from any thread.
+    void stop();
+
+    /// @brief Backend in use, PCOM_LOOP_BACKEND_URING or _EPOLL.
+    int backend() const noexcept;
+
+    /// @brief Awaitable accept, needs a reactor created with a server.
+    struct accept_op {
+        explicit accept_op(reactor* r) noexcept : _r(r) {}
+        reactor* _r;
+        int _result = 0;
+        std::coroutine_handle<> _waiter;
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        connection await_resume();
+    };
+
+    /// @brief Awaitable send of a whole buffer.
+    struct send_op {
+        send_op(reactor* r, connection* conn, std::span<const std::byte> data) noexcept
+            : _r(r), _conn(conn), _data(data) {}
+        reactor* _r;
+        connection* _conn;
+        std::span<const std::byte> _data;
+        int _result = 0;
+        std::coroutine_handle<> _waiter;
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> h);
+        void await_resume();
+    };
+
+    /// @brief Awaitable receive, completes with what is available.
+    struct recv_op {
+        recv_op(reactor* r, connection* conn, std::span<std::byte> buf) noexcept
+            : _r(r), _conn(conn), _buf(buf) {}
+        reactor* _r;
+        connection* _conn;
+        std::span<std::byte> _buf;
+        int _result = 0;
+        std::coroutine_handle<> _waiter;
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        size_t await_resume();
+    };
+
+    /// @brief co_await: next accepted client.
+    accept_op accept() { return accept_op(this); }
+
+    /// @brief co_await: sends all of data. data must stay valid until then.
+    send_op send(connection& conn, std::span<const std::byte> data) { return send_op(this, &conn, data); }
+
+    /// @brief co_await: receives into buf, 0 when the peer closed.
+    recv_op recv(connection& conn, std::span<std::byte> buf) { return recv_op(this, &conn, buf); }
+
+    /// @brief co_await: receives until buf is full or the peer closed.
+    /// @return bytes received
+    task<size_t> recv_exact(connection& conn, std::span<std::byte> buf);
+
+private:
+    friend class connection;
+    struct detached;
+
+    /// @brief Receive state of a registered handle.
+    struct conn_state {
+        std::vector<std::byte> pending;   // Received, not yet read
+        size_t pending_off = 0;
+        int status = 1;                   // 1 open, 0 EOF, negative error
+        recv_op* waiter = nullptr;
+    };
+
+    /// @brief Registers a connection's handle with the loop.
+    conn_state& attach(connection& conn);
+
+    /// @brief Unregisters a handle, called when a connection closes.
+    void detach(int handle) noexcept;
+
+    /// @brief Hands out an event to the waiting operation.
+    void dispatch(const pcom_event_t& ev);
+
+    /// @brief Resumes coroutines posted by spawn() or woken by a close.
+    void run_ready();
+
+    /// @brief Frame that owns a spawned task until it finishes.
+    static detached run_task(reactor* r, task<void> t);
+
+    /// @brief Loop owned.
+    pcom_loop_t* _loop = nullptr;
+
+    /// @brief Registered handles.
+    std::unordered_map<int, conn_state> _conns;
+
+    /// @brief Accepted handles nobody waited for yet, or errors.
+    std::vector<int> _accepted;
+
+    /// @brief Accept waiting for a client.
+    accept_op* _acceptor = nullptr;
+
+    /// @brief Coroutines to start, filled from any thread.
+    std::vector<std::coroutine_handle<>> _posted;
+    std::mutex _posted_lock;
+
+    /// @brief Coroutines to resume on this thread.
+    std::vector<std::coroutine_handle<>> _ready;
+
+    /// @brief Frames of spawned tasks still running.
+    std::unordered_set<void*> _tasks;
+
+    std::atomic<bool> _stopped{ false };
+    std::exception_ptr _error;
+};
+
+} // namespace pcom
+} // namespace crow
@@ -15,7 +15,12 @@
 ## @defgroup  PCOM
 ## @brief     Inter-Process Communication Client/Server Python wrapper.
 ## @details   Uses libpcom.so for low level communication. Has a python to
-##            C interface for the PCOM library.
+##            C interface for the PCOM library. Calls go through ctypes.CDLL,
+##            which releases the GIL while the C function runs, so blocking
+##            sends and receives do not stall other Python threads.
+##            send() takes any contiguous buffer (bytes, bytearray,
+##            memoryview, mmap, numpy arrays) without copying it, and
+##            recv_into() receives straight into a writable one.
 ##
 ## @todo      -
 ## @pre       Needs libpcom.so (or libpcom.dll) to be installed in the same directory.
@@ -24,6 +29,8 @@
 ## @ingroup   Communication
 # #############################################################################
 import ctypes
+import errno
+import threading
 
 # Load the shared library
 lib = ctypes.CDLL('./libpcom.so') # Adjust the path or library type as needed
@@ -33,6 +40,18 @@ PCOM_USER_NAME_LEN = 256
 PCOM_MAX_GROUP_COUNT = 32
 PCOM_GROUP_NAME_BUFFER_LEN = 1024
 
+# Socket type flags for pcom_server_open_ex and pcom_client_open_ex
+PCOM_OPEN_STREAM = 0
+PCOM_OPEN_SEQPACKET = 1
+PCOM_OPEN_DGRAM = 2
+
+# Operations and flags for the pcom_stats_* functions. Must match pcom_stats.h
+PCOM_STATS_OPS_NAMES = ("accept", "check_user", "send", "recv")
+PCOM_STATS_BUCKETS = 40
+PCOM_STATS_COUNT = 1
+PCOM_STATS_TIME = 2
+PCOM_STATS_ALL = 3
+
 # Define the pcom_user_info_t structure in Python
 class PcomUserInfo(ctypes.Structure):
     _fields_ = [
@@ -43,6 +62,44 @@ class PcomUserInfo(ctypes.Structure):
         ("group_name_buffer", ctypes.c_char * PCOM_GROUP_NAME_BUFFER_LEN)   
     ]
 
+# Define the pcom_stats_hist_t, pcom_stats_op_t, pcom_stats_t and
+# pcom_conn_stats_t structures in Python
+class PcomStatsHist(ctypes.Structure):
+    _fields_ = [
+        ("count", ctypes.c_ulonglong),
+        ("sum_ns", ctypes.c_ulonglong),
+        ("max_ns", ctypes.c_ulonglong),
+        ("buckets", ctypes.c_ulonglong * PCOM_STATS_BUCKETS)
+    ]
+
+class PcomStatsOp(ctypes.Structure):
+    _fields_ = [
+        ("calls", ctypes.c_ulonglong),
+        ("errors", ctypes.c_ulonglong),
+        ("messages", ctypes.c_ulonglong),
+        ("bytes", ctypes.c_ulonglong),
+        ("syscalls", ctypes.c_ulonglong),
+        ("partial", ctypes.c_ulonglong),
+        ("eagain", ctypes.c_ulonglong),
+        ("latency", PcomStatsHist)
+    ]
+
+class PcomStats(ctypes.Structure):
+    _fields_ = [
+        ("op", PcomStatsOp * len(PCOM_STATS_OPS_NAMES)),
+        ("threads", ctypes.c_ulonglong)
+    ]
+
+class PcomConnStats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_ulonglong) for name in
+                ("bytes_out", "bytes_in", "msgs_out", "msgs_in", "syscalls",
+                 "partial", "eagain", "errors", "accepts")]
+
+class PcomTcpOpts(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_int) for name in
+                ("nodelay", "busy_poll_us", "keepalive_idle", "keepalive_intvl",
+                 "keepalive_count", "prefer_local")]
+
 # Define the function signature for pcom_init
 # int pcom_version(void)
 lib.pcom_version.argtypes = []
@@ -57,6 +114,11 @@ lib.pcom_error_text.restype = ctypes.c_int
 # int pcom_server_open(const char* name)
 lib.pcom_server_open.argtypes = [ctypes.c_char_p]
 lib.pcom_server_open.restype = ctypes.c_int
+
+# Define the function signature for pcom_server_open_ex
+# int pcom_server_open_ex(const char* name, int flags)
+lib.pcom_server_open_ex.argtypes = [ctypes.c_char_p, ctypes.c_int]
+lib.pcom_server_open_ex.restype = ctypes.c_int
                                 
 # Define the function signature for pcom_server_accept
 # int pcom_server_accept(int server_handle)
@@ -68,6 +130,16 @@ lib.pcom_server_accept.restype = ctypes.c_int
 lib.pcom_server_check_user.argtypes = [ctypes.c_int, ctypes.POINTER(PcomUserInfo)]
 lib.pcom_server_check_user.restype = ctypes.c_int
 
+# Define the function signature for pcom_cred_cache_set_ttl
+# void pcom_cred_cache_set_ttl(int seconds)
+lib.pcom_cred_cache_set_ttl.argtypes = [ctypes.c_int]
+lib.pcom_cred_cache_set_ttl.restype = None
+
+# Define the function signature for pcom_cred_cache_invalidate
+# void pcom_cred_cache_invalidate(void)
+lib.pcom_cred_cache_invalidate.argtypes = []
+lib.pcom_cred_cache_invalidate.restype = None
+
 # Define the function signature for pcom_server_send
 # int pcom_server_send(int client_handle, const void* buf, size_t len)
 lib.pcom_server_send.argtypes = [ctypes.c_int, ctypes.c_void_p, ctypes.c_size_t]
@@ -88,6 +160,11 @@ lib.pcom_server_close.restype = None
 lib.pcom_client_open.argtypes = [ctypes.c_char_p]
 lib.pcom_client_open.restype = ctypes.c_int
 
+# Define the function signature for pcom_client_open_ex
+# int pcom_client_open_ex(const char* name, int flags)
+lib.pcom_client_open_ex.argtypes = [ctypes.c_char_p, ctypes.c_int]
+lib.pcom_client_open_ex.restype = ctypes.c_int
+
 # Define the function signature for pcom_client_send
 # int pcom_client_send(int client_handle, const void* buf, size_t len)
 lib.pcom_client_send.argtypes = [ctypes.c_int, ctypes.c_void_p, ctypes.c_size_t]
@@ -103,6 +180,104 @@ lib.pcom_client_recv.restype = ctypes.c_int
 lib.pcom_client_close.argtypes = [ctypes.c_int]
 lib.pcom_client_close.restype = None
 
+# Define the function signature for pcom_set_nonblocking
+# int pcom_set_nonblocking(int handle, int nonblocking)
+lib.pcom_set_nonblocking.argtypes = [ctypes.c_int, ctypes.c_int]
+lib.pcom_set_nonblocking.restype = ctypes.c_int
+
+# Define the function signature for pcom_send_all
+# int64_t pcom_send_all(int handle, const void* buf, size_t len)
+lib.pcom_send_all.argtypes = [ctypes.c_int, ctypes.c_void_p, ctypes.c_size_t]
+lib.pcom_send_all.restype = ctypes.c_int64
+
+# Define the function signature for pcom_recv_exact
+# int64_t pcom_recv_exact(int handle, void* buf, size_t len)
+lib.pcom_recv_exact.argtypes = [ctypes.c_int, ctypes.c_void_p, ctypes.c_size_t]
+lib.pcom_recv_exact.restype = ctypes.c_int64
+
+# Define the function signature for pcom_stats_enable
+# void pcom_stats_enable(int flags)
+lib.pcom_stats_enable.argtypes = [ctypes.c_int]
+lib.pcom_stats_enable.restype = None
+
+# Define the function signature for pcom_stats_get
+# int pcom_stats_get(pcom_stats_t* p_stats)
+lib.pcom_stats_get.argtypes = [ctypes.POINTER(PcomStats)]
+lib.pcom_stats_get.restype = ctypes.c_int
+
+# Define the function signature for pcom_stats_conn
+# int pcom_stats_conn(int handle, pcom_conn_stats_t* p_stats)
+lib.pcom_stats_conn.argtypes = [ctypes.c_int, ctypes.POINTER(PcomConnStats)]
+lib.pcom_stats_conn.restype = ctypes.c_int
+
+# Define the function signature for pcom_stats_reset
+# void pcom_stats_reset(void)
+lib.pcom_stats_reset.argtypes = []
+lib.pcom_stats_reset.restype = None
+
+# Define the function signature for pcom_tcp_set_opts
+# int pcom_tcp_set_opts(const pcom_tcp_opts_t* p_opts)
+lib.pcom_tcp_set_opts.argtypes = [ctypes.POINTER(PcomTcpOpts)]
+lib.pcom_tcp_set_opts.restype = ctypes.c_int
+
+# Define the function signature for pcom_tcp_get_opts
+# void pcom_tcp_get_opts(pcom_tcp_opts_t* p_opts)
+lib.pcom_tcp_get_opts.argtypes = [ctypes.POINTER(PcomTcpOpts)]
+lib.pcom_tcp_get_opts.restype = None
+
+# Define the function signature for pcom_tcp_port
+# int pcom_tcp_port(int handle)
+lib.pcom_tcp_port.argtypes = [ctypes.c_int]
+lib.pcom_tcp_port.restype = ctypes.c_int
+
+# Define the function signature for pcom_tcp_local_handle
+# int pcom_tcp_local_handle(int server_handle)
+lib.pcom_tcp_local_handle.argtypes = [ctypes.c_int]
+lib.pcom_tcp_local_handle.restype = ctypes.c_int
+
+
+# Py_buffer and the buffer protocol calls, for zero copy access to any
+# contiguous Python buffer. ctypes only maps writable buffers by itself.
+class _PyBuffer(ctypes.Structure):
+    _fields_ = [
+        ("buf", ctypes.c_void_p),
+        ("obj", ctypes.py_object),
+        ("len", ctypes.c_ssize_t),
+        ("itemsize", ctypes.c_ssize_t),
+        ("readonly", ctypes.c_int),
+        ("ndim", ctypes.c_int),
+        ("format", ctypes.c_char_p),
+        ("shape", ctypes.POINTER(ctypes.c_ssize_t)),
+        ("strides", ctypes.POINTER(ctypes.c_ssize_t)),
+        ("suboffsets", ctypes.POINTER(ctypes.c_ssize_t)),
+        ("internal", ctypes.c_void_p)
+    ]
+
+_PyBUF_SIMPLE = 0
+_PyBUF_WRITABLE = 1
+
+ctypes.pythonapi.PyObject_GetBuffer.argtypes = [ctypes.py_object, ctypes.POINTER(_PyBuffer), ctypes.c_int]
+ctypes.pythonapi.PyObject_GetBuffer.restype = ctypes.c_int
+ctypes.pythonapi.PyBuffer_Release.argtypes = [ctypes.POINTER(_PyBuffer)]
+ctypes.pythonapi.PyBuffer_Release.restype = None
+
+class _Buffer:
+    """ Pins a contiguous buffer and exposes its address and length.
+        Use as a context manager, the buffer is released on exit. """
+    def __init__(self, data, writable: bool = False):
+        self.view = _PyBuffer()
+        flags = _PyBUF_WRITABLE if writable else _PyBUF_SIMPLE
+        # Raises TypeError/BufferError for objects that are not contiguous
+        # buffers or not writable
+        ctypes.pythonapi.PyObject_GetBuffer(data, ctypes.byref(self.view), flags)
+
+    def __enter__(self):
+        return self.view.buf, self.view.len
+
+    def __exit__(self, *exc):
+        ctypes.pythonapi.PyBuffer_Release(ctypes.byref(self.view))
+        return False
+
 
 class PcomException(Exception):
     """ Exception class for PCOM errors.
@@ -138,12 +313,85 @@ class Pcom_Common:
         error_str = Pcom_Common._get_error(error_code)
         raise PcomException(f"{error_text}: PCOM Error Code {error_code}, {error_str}", error_text, error_code, error_str)
 
+    def _recv_buffer(self, length: int) -> memoryview:
+        """ Receive buffer of this handle for the calling thread, grown on
+            demand and reused by recv(), so only the bytes that arrived are
+            copied out. One per thread, the GIL is released while receiving. """
+        local = self.__dict__.get("_rx_local")
+        if local is None:
+            local = self.__dict__.setdefault("_rx_local", threading.local())
+        view = getattr(local, "view", None)
+        if view is None or len(view) < length:
+            view = local.view = memoryview(bytearray(length))
+        return view
+
+
+def pcom_stats(reset: bool = False) -> dict:
+    """ Snapshot of the process wide counters and latency histograms.
+        Returns {"threads": n, "accept": {...}, "check_user": {...}, "send": {...},
+        "recv": {...}}. Each operation has its counters and a "latency" dict with
+        count, sum_ns, max_ns and buckets, where buckets[i] counts calls that took
+        2^i to 2^(i+1) ns. Reset restarts the totals after the snapshot. """
+    stats = PcomStats()
+    result = lib.pcom_stats_get(ctypes.byref(stats))
+    if result < 0:
+        Pcom_Common._raise_error("Failed to get PCOM stats", result)
+    if reset:
+        lib.pcom_stats_reset()
+
+    snapshot = {"threads": stats.threads}
+    for name, op in zip(PCOM_STATS_OPS_NAMES, stats.op):
+        entry = {field: getattr(op, field) for field, _ in PcomStatsOp._fields_ if field != "latency"}
+        entry["latency"] = {
+            "count": op.latency.count,
+            "sum_ns": op.latency.sum_ns,
+            "max_ns": op.latency.max_ns,
+            "buckets": list(op.latency.buckets)
+        }
+        snapshot[name] = entry
+    return snapshot
+
+def pcom_conn_stats(handle: int) -> dict:
+    """ Counters of one connection or server handle """
+    stats = PcomConnStats()
+    result = lib.pcom_stats_conn(handle, ctypes.byref(stats))
+    if result < 0:
+        Pcom_Common._raise_error(f"Failed to get PCOM stats of handle {handle}", result)
+    return {field: getattr(stats, field) for field, _ in PcomConnStats._fields_}
+
+def pcom_check_user(handle: int, error_text: str = "Failed to get user info") -> dict:
+    """ Credentials of the client on a connected handle as a dict with
+        "user", "admin" and "groups". Peers without credentials, as over
+        TCP, get an empty user without admin rights or groups. """
+    # Create a PcomUserInfo structure to hold user information
+    info = PcomUserInfo()
+    
+    # Query the client for user information
+    result = lib.pcom_server_check_user(handle, ctypes.byref(info))
+    if result == -errno.ENOTSUP:
+        return {"user": "", "admin": False, "groups": []}
+    if result < 0:
+        Pcom_Common._raise_error(error_text, result)
+    
+    #Assemble a dictionary with user credentials and return it
+    return {
+        "user": info.username.decode('utf-8').rstrip('\0'),
+        "admin": bool(info.is_admin),
+        "groups": [
+            info.group_list[i].decode()
+            for i in range(info.group_count)
+            if info.group_list[i]
+        ]
+    }
+
 
 class PcomClient(Pcom_Common):
     """ PCOM Client class for sending and receiving data """
-    def __init__(self, name: str, handle: int = None, credentials: dict = None):
+    def __init__(self, name: str, handle: int = None, credentials: dict = None,
+                 flags: int = PCOM_OPEN_STREAM):
         """ Initialize the PCOM client with connection name.
-            Optional handle and credentials is for server transfer to new connection. """
+            Optional handle and credentials is for server transfer to new connection.
+            Flags selects the socket type (PCOM_OPEN_*) for new connections. """
         # Check the version of the PCOM library is correct
         self._check_version()
         
@@ -154,7 +402,7 @@ class PcomClient(Pcom_Common):
         # Otherwise, use the provided handle
         if handle is None:
             c_name = self.name.encode('utf-8')
-            handle = self.client_handle = lib.pcom_client_open(c_name)
+            handle = self.client_handle = lib.pcom_client_open_ex(c_name, flags)
             if handle < 0:
                 self._raise_error("fFailed to open client as '{self.name}'", handle)
         self.client_handle = handle
@@ -165,25 +413,56 @@ class PcomClient(Pcom_Common):
             credentials = {"user": "", "admin": False, "groups": []}
         self.credentials = credentials
 
-    def send(self, data: bytes):
-        """ Send data to the server """
-        # Send data buffer over connection
-        result = lib.pcom_client_send(self.client_handle, data, len(data))
+    def send(self, data):
+        """ Send all of data to the server. data is any contiguous buffer,
+            it is not copied. """
+        # Send the whole data buffer over connection
+        with _Buffer(data) as (address, length):
+            result = lib.pcom_send_all(self.client_handle, address, length)
         if result < 0:
             self._raise_error(f"Failed to send data as client '{self.name}'", result)
 
-    def recv(self, length: int) -> bytes:
-        """ Receive data from the server """
-        # Create a receive buffer for incomming data
-        buffer = ctypes.create_string_buffer(length)
+    def recv_into(self, buffer, nbytes: int = 0) -> int:
+        """ Receive into a writable buffer (bytearray, memoryview, ...),
+            at most nbytes or the whole buffer if 0. Returns the number of
+            bytes received, 0 when the server closed. """
+        with _Buffer(buffer, writable=True) as (address, length):
+            if nbytes < 0 or nbytes > length:
+                raise ValueError("nbytes larger than the buffer")
+            result = lib.pcom_client_recv(self.client_handle, address, nbytes or length)
+        if result < 0:
+            self._raise_error(f"Failed to receive data as client '{self.name}'", result)
+        return result
 
-        # Receive data buffer over connection
-        result = lib.pcom_client_recv(self.client_handle, buffer, length)
+    def recv_exact_into(self, buffer, nbytes: int = 0) -> int:
+        """ Receive exactly nbytes (or the whole buffer if 0) into a writable
+            buffer, fewer only if the server closed. Returns the count. """
+        with _Buffer(buffer, writable=True) as (address, length):
+            if nbytes < 0 or nbytes > length:
+                raise ValueError("nbytes larger than the buffer")
+            result = lib.pcom_recv_exact(self.client_handle, address, nbytes or length)
         if result < 0:
             self._raise_error(f"Failed to receive data as client '{self.name}'", result)
-        
-        # Return the received data as bytes
-        return buffer.raw
+        return result
+
+    def recv(self, length: int) -> bytes:
+        """ Receive up to length bytes from the server, b"" when it closed """
+        # Receive into the reused buffer, copy out only what arrived
+        if length <= 0:
+            return b""
+        view = self._recv_buffer(length)
+        return bytes(view[:self.recv_into(view, length)])
+
+    def recv_exact(self, length: int) -> bytes:
+        """ Receive exactly length bytes, fewer only if the server closed """
+        if length <= 0:
+            return b""
+        view = self._recv_buffer(length)
+        return bytes(view[:self.recv_exact_into(view, length)])
+
+    def stats(self) -> dict:
+        """ Counters of this connection """
+        return pcom_conn_stats(self.client_handle)
 
     def close(self):
         """ Close the client connection """
@@ -194,8 +473,8 @@ class PcomClient(Pcom_Common):
 class PcomServer(Pcom_Common):
     """ PCOM Server class for accepting client connections """
 
-    def __init__(self, name: str):
-        """ Initialize the PCOM server with connection name """
+    def __init__(self, name: str, flags: int = PCOM_OPEN_STREAM):
+        """ Initialize the PCOM server with connection name and socket type """
 
         # Check the version of the PCOM library is correct
         self._check_version()
@@ -205,31 +484,13 @@ class PcomServer(Pcom_Common):
         
         # Open the server connection
         c_name = self.name.encode('utf-8')
-        self.server_handle = lib.pcom_server_open(c_name)
+        self.server_handle = lib.pcom_server_open_ex(c_name, flags)
         if self.server_handle < 0:
             self._raise_error(f"Failed to open server '{self.name}'", self.server_handle)
      
     def _get_credentials(self, handle) -> dict:
         """ Query the client for user credentials """
-
-        # Create a PcomUserInfo structure to hold user information
-        info = PcomUserInfo()
-        
-        # Query the client for user information
-        result = lib.pcom_server_check_user(handle, ctypes.byref(info))
-        if result < 0:
-            self._raise_error(f"Server '{self.name}' failed to get user info", result)
-        
-        #Assemble a dictionary with user credentials and return it
-        return {
-            "user": info.username.decode('utf-8').rstrip('\0'),
-            "admin": bool(info.is_admin),
-            "groups": [
-                info.group_list[i].decode()
-                for i in range(info.group_count)
-                if info.group_list[i]
-            ]
-        }
+        return pcom_check_user(handle, f"Server '{self.name}' failed to get user info")
 
     def accept(self):
         """ Accept and handle incoming client connections"""
@@ -240,32 +501,42 @@ class PcomServer(Pcom_Common):
             self._raise_error(f"Server '{self.name}' Failed to accept client", self.server_handle)
         
         # Create a client object to handle further communication
-        return PcomClient(self.name, client_handle, self._get_credentials(client_handle))
+        try:
+            credentials = self._get_credentials(client_handle)
+        except PcomException:
+            lib.pcom_client_close(client_handle)
+            raise
+        return PcomClient(self.name, client_handle, credentials)
 
-    def send(self, data: bytes):
-        """ Send data to the client """
+    def send(self, data):
+        """ Send data on the server handle, data is any contiguous buffer """
 
         # Send data buffer over connection
-        result = lib.pcom_server_send(self.server_handle, data, len(data))
+        with _Buffer(data) as (address, length):
+            result = lib.pcom_server_send(self.server_handle, address, length)
         if result < 0:
             self._raise_error(f"Server '{self.name}' Failed to send data", result)
 
         return result
-    
-    def recv(self, length: int) -> bytes:
-        """ Receive data from the client """
-        
-        # Create a receive buffer for incomming data
-        buffer = ctypes.create_string_buffer(length)
-        
-        # Wait and receive data from connection
-        result = lib.pcom_server_recv(self.server_handle, buffer, length)
+
+    def recv_into(self, buffer, nbytes: int = 0) -> int:
+        """ Receive on the server handle into a writable buffer, at most
+            nbytes or the whole buffer if 0. Returns the number of bytes. """
+        with _Buffer(buffer, writable=True) as (address, length):
+            if nbytes < 0 or nbytes > length:
+                raise ValueError("nbytes larger than the buffer")
+            result = lib.pcom_server_recv(self.server_handle, address, nbytes or length)
         if result < 0:
             self._raise_error(f"Server '{self.name}' Failed to receive data", result)
-        
-        # Return the received data as bytes
-        return buffer.raw
-    
+        return result
+
+    def recv(self, length: int) -> bytes:
+        """ Receive up to length bytes on the server handle """
+        if length <= 0:
+            return b""
+        view = self._recv_buffer(length)
+        return bytes(view[:self.recv_into(view, length)])
+
     def close(self):
         """ Close the server """
         lib.pcom_server_close(self.server_handle)
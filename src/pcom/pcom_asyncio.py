@@ -0,0 +1,381 @@
+#!/usr/bin/env python3
+# #############################################################################
+## \\  __
+## \ \(o >
+## \/ ) |
+##  // /
+##   || CROW - Communicatio Retis Omni Via
+##
+## @file      pcom_asyncio.py
+## @author    phstream
+## @copyright -
+## @date      19 Oct 2026
+## @version   1.0
+##
+## @defgroup  PCOM_ASYNCIO
+## @brief     asyncio streams over PCOM handles.
+## @details   Handles are switched to non-blocking mode and driven by the
+##            running event loop's selector: a call is tried directly and
+##            only when it returns EAGAIN does the task wait for the handle
+##            to become ready. No executor threads are involved, so one
+##            process serves many peers from one thread.
+##
+##            recv_msg() and send_msg() exchange pcom_frame messages (8 byte
+##            header, see pcom_frame.h) and interoperate with pcom_frame_send()
+##            and pcom_frame_recv() on the C side.
+##
+## @todo      -
+## @pre       pcom.py and libpcom.so. Linux or UNIX, handles must be fds.
+## @bug       -
+## @warning   Only one task may receive and one task may send on a
+##            connection at a time.
+## @ingroup   Communication
+# #############################################################################
+import asyncio
+import errno
+import struct
+
+from pcom import lib, Pcom_Common, PcomException, _Buffer, PCOM_OPEN_STREAM, pcom_check_user, pcom_conn_stats
+
+# pcom_frame_hdr_t on the wire: len, type, flags, channel, little endian.
+# Must match pcom_frame.h
+PCOM_FRAME_HDR = struct.Struct("<IBBH")
+PCOM_FRAME_MAX = 16 * 1024 * 1024
+PCOM_FRAME_DATA = 0
+
+_EAGAIN = (-errno.EAGAIN, -errno.EWOULDBLOCK)
+_READ_CHUNK = 64 * 1024          # Bytes read at once while reassembling frames
+_SEND_JOIN_MAX = 64 * 1024       # Smaller payloads go out with their header in one call
+
+
+def _wake(future):
+    """ Selector callback, completes the future of the waiting task """
+    if not future.done():
+        future.set_result(None)
+
+
+class _AsyncHandle(Pcom_Common):
+    """ Non-blocking handle waited on through the event loop selector """
+
+    def _set_nonblocking(self, handle: int, what: str):
+        result = lib.pcom_set_nonblocking(handle, 1)
+        if result < 0:
+            self._raise_error(f"Failed to make {what} '{self.name}' non-blocking", result)
+        self._waits = {}
+
+    async def _wait(self, handle: int, writable: bool, *more: int):
+        """ Wait until the handle, or one of more, is readable or writable """
+        if writable in self._waits:
+            raise RuntimeError("Another task is already waiting on this handle")
+        loop = asyncio.get_running_loop()
+        future = loop.create_future()
+        handles = (handle,) + more
+        self._waits[writable] = (loop, future, handles)
+        for h in handles:
+            if writable:
+                loop.add_writer(h, _wake, future)
+            else:
+                loop.add_reader(h, _wake, future)
+        try:
+            await future
+        finally:
+            del self._waits[writable]
+            for h in handles:
+                if writable:
+                    loop.remove_writer(h)
+                else:
+                    loop.remove_reader(h)
+
+    def _cancel_waits(self):
+        """ Stop watching handles about to be closed, waiters get an error """
+        for writable, (loop, future, handles) in list(self._waits.items()):
+            for h in handles:
+                if writable:
+                    loop.remove_writer(h)
+                else:
+                    loop.remove_reader(h)
+            if not future.done():
+                future.set_exception(PcomException(f"Handle of '{self.name}' closed"))
+
+
+class AsyncPcomConnection(_AsyncHandle):
+    """ Connected PCOM client driven by asyncio """
+
+    def __init__(self, name: str, handle: int, credentials: dict = None):
+        """ Wrap a connected handle, from open() or AsyncPcomServer.accept() """
+        self._check_version()
+        self.name = name
+        self.client_handle = handle
+        self.credentials = credentials or {"user": "", "admin": False, "groups": []}
+        self._set_nonblocking(handle, "connection")
+
+        # Received bytes not yet consumed, frames are reassembled here
+        self._pending = bytearray()
+        self._pending_pos = 0
+
+    @classmethod
+    async def open(cls, name: str, flags: int = PCOM_OPEN_STREAM):
+        """ Connect to a server """
+        cls._check_version()
+        # A connect blocks while the server's listen backlog is full, which
+        # would stall the loop that runs the accepting server. Connect on the
+        # default executor: one thread hop per connection, none per message.
+        loop = asyncio.get_running_loop()
+        handle = await loop.run_in_executor(None, lib.pcom_client_open_ex, name.encode('utf-8'), flags)
+        if handle < 0:
+            cls._raise_error(f"Failed to open client as '{name}'", handle)
+        return cls(name, handle)
+
+    def fileno(self) -> int:
+        """ The file descriptor of the connection """
+        return self.client_handle
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *exc):
+        self.close()
+        return False
+
+    def _take_pending(self, view: memoryview) -> int:
+        """ Copy buffered bytes into view, returns the count """
+        count = min(len(view), len(self._pending) - self._pending_pos)
+        if count:
+            view[:count] = self._pending[self._pending_pos:self._pending_pos + count]
+            self._pending_pos += count
+            if self._pending_pos == len(self._pending):
+                self._pending.clear()
+                self._pending_pos = 0
+        return count
+
+    async def recv_into(self, buffer, nbytes: int = 0) -> int:
+        """ Receive into a writable buffer, at most nbytes or the whole buffer
+            if 0. Returns the number of bytes received, 0 when the peer closed. """
+        view = memoryview(buffer).cast("B")
+        if nbytes < 0 or nbytes > len(view):
+            raise ValueError("nbytes larger than the buffer")
+        view = view[:nbytes or len(view)]
+
+        # Bytes left over from frame reassembly come first
+        count = self._take_pending(view)
+        if count or not len(view):
+            return count
+
+        with _Buffer(view, writable=True) as (address, length):
+            while True:
+                result = lib.pcom_client_recv(self.client_handle, address, length)
+                if result not in _EAGAIN:
+                    break
+                await self._wait(self.client_handle, False)
+        if result < 0:
+            self._raise_error(f"Failed to receive data as client '{self.name}'", result)
+        return result
+
+    async def recv(self, length: int) -> bytes:
+        """ Receive up to length bytes, b"" when the peer closed """
+        if length <= 0:
+            return b""
+        view = self._recv_buffer(length)
+        return bytes(view[:await self.recv_into(view, length)])
+
+    async def recv_exact(self, length: int) -> bytes:
+        """ Receive exactly length bytes, raises asyncio.IncompleteReadError
+            if the peer closed first """
+        data = bytearray(length)
+        view = memoryview(data)
+        got = 0
+        while got < length:
+            count = await self.recv_into(view[got:])
+            if count == 0:
+                raise asyncio.IncompleteReadError(bytes(data[:got]), length)
+            got += count
+        return bytes(data)
+
+    async def send(self, data):
+        """ Send all of data, any contiguous buffer. Waits while the kernel
+            buffer is full. """
+        with _Buffer(data) as (address, length):
+            sent = 0
+            while sent < length:
+                result = lib.pcom_client_send(self.client_handle, address + sent, length - sent)
+                if result in _EAGAIN:
+                    await self._wait(self.client_handle, True)
+                    continue
+                if result < 0:
+                    self._raise_error(f"Failed to send data as client '{self.name}'", result)
+                sent += result
+
+    async def _fill(self, need: int) -> bool:
+        """ Read until need bytes are pending, False on EOF """
+        while len(self._pending) - self._pending_pos < need:
+            if self._pending_pos:
+                del self._pending[:self._pending_pos]
+                self._pending_pos = 0
+            view = self._recv_buffer(max(_READ_CHUNK, need - len(self._pending)))
+            with _Buffer(view, writable=True) as (address, length):
+                while True:
+                    result = lib.pcom_client_recv(self.client_handle, address, length)
+                    if result not in _EAGAIN:
+                        break
+                    await self._wait(self.client_handle, False)
+            if result < 0:
+                self._raise_error(f"Failed to receive data as client '{self.name}'", result)
+            if result == 0:
+                return False
+            self._pending += view[:result]
+        return True
+
+    async def recv_frame(self):
+        """ Receive one frame. Returns (type, flags, channel, payload), or
+            None when the peer closed between frames. """
+        if not await self._fill(PCOM_FRAME_HDR.size):
+            if len(self._pending) > self._pending_pos:
+                raise asyncio.IncompleteReadError(bytes(self._pending[self._pending_pos:]), None)
+            return None
+        size, ftype, flags, channel = PCOM_FRAME_HDR.unpack_from(self._pending, self._pending_pos)
+        if size > PCOM_FRAME_MAX:
+            self._raise_error(f"Frame of {size} bytes from '{self.name}' too large", -errno.EMSGSIZE)
+        if not await self._fill(PCOM_FRAME_HDR.size + size):
+            raise asyncio.IncompleteReadError(bytes(self._pending[self._pending_pos:]), None)
+
+        start = self._pending_pos + PCOM_FRAME_HDR.size
+        payload = bytes(self._pending[start:start + size])
+        self._pending_pos = start + size
+        if self._pending_pos == len(self._pending):
+            self._pending.clear()
+            self._pending_pos = 0
+        return ftype, flags, channel, payload
+
+    async def recv_msg(self):
+        """ Receive the payload of one frame, None when the peer closed """
+        frame = await self.recv_frame()
+        return None if frame is None else frame[3]
+
+    async def send_msg(self, payload, ftype: int = PCOM_FRAME_DATA, flags: int = 0, channel: int = 0):
+        """ Send payload, any contiguous buffer, as one frame """
+        view = memoryview(payload).cast("B")
+        if len(view) > PCOM_FRAME_MAX:
+            self._raise_error(f"Frame of {len(view)} bytes to '{self.name}' too large", -errno.EMSGSIZE)
+        header = PCOM_FRAME_HDR.pack(len(view), ftype, flags, channel)
+        if len(view) <= _SEND_JOIN_MAX:
+            # One syscall, copying a small payload is cheaper than a second one
+            await self.send(header + view)
+        else:
+            await self.send(header)
+            await self.send(view)
+
+    def stats(self) -> dict:
+        """ Counters of this connection """
+        return pcom_conn_stats(self.client_handle)
+
+    def close(self):
+        """ Close the connection, tasks waiting on it get a PcomException """
+        if self.client_handle is None:
+            return
+        self._cancel_waits()
+        lib.pcom_client_close(self.client_handle)
+        self.client_handle = None
+
+
+class AsyncPcomServer(_AsyncHandle):
+    """ PCOM server accepting connections on the asyncio event loop """
+
+    def __init__(self, name: str, flags: int = PCOM_OPEN_STREAM):
+        """ Open the server with connection name and socket type """
+        self._check_version()
+        self.name = name
+        self.server_handle = lib.pcom_server_open_ex(name.encode('utf-8'), flags)
+        if self.server_handle < 0:
+            self._raise_error(f"Failed to open server '{self.name}'", self.server_handle)
+        self._set_nonblocking(self.server_handle, "server")
+        # tcp:// servers take local clients on a UNIX listener next to the socket
+        self.local_handle = lib.pcom_tcp_local_handle(self.server_handle)
+        if self.local_handle < 0:
+            self.local_handle = None
+        elif (result := lib.pcom_set_nonblocking(self.local_handle, 1)) < 0:
+            lib.pcom_server_close(self.server_handle)
+            self._raise_error(f"Failed to make server '{self.name}' non-blocking", result)
+
+    def fileno(self) -> int:
+        """ The file descriptor of the listening socket """
+        return self.server_handle
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *exc):
+        self.close()
+        return False
+
+    async def accept(self) -> AsyncPcomConnection:
+        """ Wait for a client, returns its connection with credentials """
+        while True:
+            handle = lib.pcom_server_accept(self.server_handle)
+            if handle not in _EAGAIN:
+                break
+            if self.local_handle is None:
+                await self._wait(self.server_handle, False)
+            else:
+                await self._wait(self.server_handle, False, self.local_handle)
+        if handle < 0:
+            self._raise_error(f"Server '{self.name}' failed to accept client", handle)
+
+        try:
+            info = pcom_check_user(handle)
+        except PcomException:
+            lib.pcom_client_close(handle)
+            raise
+        return AsyncPcomConnection(self.name, handle, info)
+
+    async def serve(self, handler):
+        """ Accept forever, running handler(conn) as a task per client. The
+            connection is closed when the handler returns. """
+        tasks = set()
+
+        async def run(conn):
+            async with conn:
+                await handler(conn)
+
+        while True:
+            try:
+                conn = await self.accept()
+            except PcomException:
+                if self.server_handle is None:
+                    return          # Closed
+                raise
+            task = asyncio.get_running_loop().create_task(run(conn))
+            tasks.add(task)
+            task.add_done_callback(tasks.discard)
+
+    def close(self):
+        """ Close the server, a waiting accept() gets a PcomException """
+        if self.server_handle is None:
+            return
+        self._cancel_waits()
+        lib.pcom_server_close(self.server_handle)
+        self.server_handle = None
+        self.local_handle = None
+
+
+async def start_server(handler, name: str, flags: int = PCOM_OPEN_STREAM) -> AsyncPcomServer:
+    """ Open a server and serve handler(conn) in the background, like
+        asyncio.start_server(). Close the returned server to stop accepting. """
+    server = AsyncPcomServer(name, flags)
+    server.serving = asyncio.get_running_loop().create_task(server.serve(handler))
+    return server
+
+
+if __name__ == "__main__":
+    # Example usage: echo frames back to each client
+    async def echo(conn):
+        while (msg := await conn.recv_msg()) is not None:
+            await conn.send_msg(msg)
+
+    async def main():
+        server = await start_server(echo, "pcomtest")
+        async with await AsyncPcomConnection.open("pcomtest") as conn:
+            await conn.send_msg(b"Hello from asyncio")
+            print(f"Echoed: {(await conn.recv_msg()).decode('utf-8')}")
+        server.close()
+
+    asyncio.run(main())
@@ -0,0 +1,584 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_buf.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Pooled, reference counted message buffers.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <errno.h>
+
+#include "pcom_buf.h"
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define SLAB_SIZE    ((size_t)2 << 20)   // Slab size and alignment of every mapping
+#define SLAB_MAGIC   (0x70627566u)
+#define MIN_SHIFT    (6)                 // PCOM_BUF_MIN
+#define MAX_SHIFT    (18)                // PCOM_BUF_MAX
+#define CLASSES      (MAX_SHIFT - MIN_SHIFT + 1)
+#define HUGE_SHIFT   (16)                // Classes from 64 KiB on get huge page slabs
+#define LARGE        (CLASSES)           // Class of a singly mapped buffer
+
+#define LOCAL_BYTES  ((size_t)256 << 10) // Per thread and class before spilling half
+#define SHARED_BYTES ((size_t)8 << 20)   // Resident per shared class list
+#define LARGE_CACHE  ((size_t)64 << 20)  // Large buffers kept for reuse
+
+#define STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define STAT_SUB(field, n) __atomic_fetch_sub(&(field), (n), __ATOMIC_RELAXED)
+#define STAT_GET(field)    __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+/** Header at the start of every mapping, found by masking a buffer address */
+typedef struct slab {
+    uint32_t magic;
+    uint32_t cls;          // Size class, LARGE for a single large buffer
+    uint32_t shift;        // log2 of the slot size, slabs only
+    uint32_t slots;        // Slots in the slab
+    uint32_t carved;       // Slots handed out so far, under the class lock
+    int hugetlb;           // On MAP_HUGETLB pages, madvise() does not apply
+    size_t size;           // Slot size, or capacity of a large buffer
+    size_t first;          // Offset of the first slot
+    size_t map_len;        // Bytes mapped
+    struct slab* next;     // Large buffer cache
+    uint32_t refs[];       // Reference count per slot
+} slab_t;
+
+/** Link kept in the first bytes of a free buffer */
+typedef struct free_buf {
+    struct free_buf* next;
+    int released;          // Pages after the first given back to the kernel
+} free_t;
+
+/** Shared free list and slab of one class */
+typedef struct {
+    pthread_mutex_t lock;
+    free_t* head;
+    size_t count;
+    size_t resident;       // Buffers on the list that were not released
+    slab_t* slab;          // Slab being carved
+} shared_t;
+
+/** Free lists of one thread, no locks */
+typedef struct {
+    free_t* head[CLASSES];
+    uint32_t count[CLASSES];
+    int live;              // Registered to be flushed at thread exit
+} cache_t;
+
+static __thread cache_t tls_cache;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t cache_key;
+static size_t page_size;
+
+static shared_t shared[CLASSES];
+static pthread_once_t shared_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t large_lock = PTHREAD_MUTEX_INITIALIZER;
+static slab_t* large_cache;
+static size_t large_cached;
+static int no_hugetlb;
+
+static pcom_buf_stats_t stats;   // Counters updated on the slow paths only
+
+static inline size_t
+round_up(size_t n, size_t align) { return (n + align - 1) & ~(align - 1); }
+
+static inline slab_t*
+slab_of(const void* buf) { return (slab_t*)((uintptr_t)buf & ~(uintptr_t)(SLAB_SIZE - 1)); }
+
+static inline uint32_t*
+refs_of(slab_t* p_s, const void* buf)
+{
+    if (p_s->cls == LARGE) return &p_s->refs[0];
+    return &p_s->refs[((const char*)buf - (const char*)p_s - p_s->first) >> p_s->shift];
+}
+
+static inline int
+class_of(size_t size)
+{
+    if (size <= PCOM_BUF_MIN) return 0;
+    return (64 - __builtin_clzll((unsigned long long)size - 1)) - MIN_SHIFT;
+}
+
+/** Buffers a thread keeps per class before it hands half to the shared list */
+static inline uint32_t
+local_limit(int cls)
+{
+    size_t n = LOCAL_BYTES >> (cls + MIN_SHIFT);
+    return n < 2 ? 2 : (uint32_t)n;
+}
+
+static void
+shared_init(void)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    page_size = page > 0 ? (size_t)page : 4096;
+    for (int c = 0; c < CLASSES; ++c) pthread_mutex_init(&shared[c].lock, NULL);
+}
+
+/** Map len bytes aligned to SLAB_SIZE, huge pages if asked. Updates len. */
+static void*
+map_region(size_t* p_len, int huge, int* p_hugetlb)
+{
+    *p_hugetlb = 0;
+
+#ifdef MAP_HUGETLB
+    if (huge && !__atomic_load_n(&no_hugetlb, __ATOMIC_RELAXED)) {
+        size_t len = round_up(*p_len, SLAB_SIZE);
+        void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED && ((uintptr_t)p & (SLAB_SIZE - 1)) == 0) {
+            *p_len = len;
+            *p_hugetlb = 1;
+            return p;
+        }
+        // No huge pages reserved, or smaller ones than a slab
+        if (p != MAP_FAILED) munmap(p, len);
+        __atomic_store_n(&no_hugetlb, 1, __ATOMIC_RELAXED);
+    }
+#endif
+
+    size_t len = round_up(*p_len, page_size);
+    char* p = mmap(NULL, len + SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+
+    // Trim to an aligned region so headers are found by masking
+    char* p_a = (char*)round_up((uintptr_t)p, SLAB_SIZE);
+    if (p_a > p) munmap(p, (size_t)(p_a - p));
+    munmap(p_a + len, (size_t)(p + SLAB_SIZE - p_a));
+
+#ifdef MADV_HUGEPAGE
+    if (huge) madvise(p_a, len, MADV_HUGEPAGE);
+#endif
+    *p_len = len;
+    return p_a;
+}
+
+static void
+region_account(const slab_t* p_s, int sign)
+{
+    if (sign > 0) STAT_ADD(stats.mapped, p_s->map_len);
+    else STAT_SUB(stats.mapped, p_s->map_len);
+    if (p_s->hugetlb) {
+        if (sign > 0) STAT_ADD(stats.huge, 1);
+        else STAT_SUB(stats.huge, 1);
+    }
+}
+
+/** New slab for a class, slots carved lazily so untouched ones cost no RSS */
+static slab_t*
+slab_create(int cls)
+{
+    size_t len = SLAB_SIZE;
+    int hugetlb;
+    slab_t* p_s = map_region(&len, cls + MIN_SHIFT >= HUGE_SHIFT, &hugetlb);
+    if (!p_s) return NULL;
+
+    size_t size = (size_t)1 << (cls + MIN_SHIFT);
+    size_t align = size < page_size ? size : page_size;
+    uint32_t slots = (uint32_t)((SLAB_SIZE - sizeof(slab_t)) / (size + sizeof(uint32_t)));
+    size_t first = round_up(sizeof(slab_t) + slots * sizeof(uint32_t), align);
+    while (first + slots * size > SLAB_SIZE) {
+        --slots;
+        first = round_up(sizeof(slab_t) + slots * sizeof(uint32_t), align);
+    }
+
+    p_s->magic = SLAB_MAGIC;
+    p_s->cls = (uint32_t)cls;
+    p_s->shift = (uint32_t)(cls + MIN_SHIFT);
+    p_s->slots = slots;
+    p_s->carved = 0;
+    p_s->hugetlb = hugetlb;
+    p_s->size = size;
+    p_s->first = first;
+    p_s->map_len = len;
+    p_s->next = NULL;
+
+    region_account(p_s, 1);
+    STAT_ADD(stats.slabs, 1);
+    return p_s;
+}
+
+/** Give the pages of a free buffer back, all but the first holding its link */
+static void
+release_pages(free_t* p_f, size_t size)
+{
+    p_f->released = 0;
+#ifdef MADV_DONTNEED
+    if (size < 2 * page_size || slab_of(p_f)->hugetlb) return;
+    if (madvise((char*)p_f + page_size, size - page_size, MADV_DONTNEED) == 0) {
+        p_f->released = 1;
+        STAT_ADD(stats.released, size - page_size);
+    }
+#else
+    (void)size;
+#endif
+}
+
+/** Push a chain onto a shared list, releasing pages once it holds enough */
+static void
+shared_push(int cls, free_t* p_first, uint32_t count)
+{
+    shared_t* p_sh = &shared[cls];
+    size_t size = (size_t)1 << (cls + MIN_SHIFT);
+    size_t limit = SHARED_BYTES / size;
+
+    pthread_mutex_lock(&p_sh->lock);
+    while (p_first && count--) {
+        free_t* p_f = p_first;
+        p_first = p_f->next;
+        if (p_sh->resident >= limit) release_pages(p_f, size);
+        else p_f->released = 0;
+        if (!p_f->released) p_sh->resident++;
+        p_f->next = p_sh->head;
+        p_sh->head = p_f;
+        p_sh->count++;
+    }
+    pthread_mutex_unlock(&p_sh->lock);
+}
+
+/** Move up to count buffers from a thread list to the shared list */
+static void
+cache_spill(cache_t* p_c, int cls, uint32_t count)
+{
+    free_t* p_first = p_c->head[cls];
+    free_t* p_last = p_first;
+    uint32_t n = 1;
+
+    if (!p_first || count == 0) return;
+    while (n < count && p_last->next) { p_last = p_last->next; ++n; }
+    p_c->head[cls] = p_last->next;
+    p_c->count[cls] -= n;
+    shared_push(cls, p_first, n);
+}
+
+static void
+cache_flush(void* arg)
+{
+    cache_t* p_c = arg;
+    for (int c = 0; c < CLASSES; ++c) cache_spill(p_c, c, p_c->count[c]);
+    p_c->live = 0;
+}
+
+static void
+key_init(void)
+{
+    pthread_key_create(&cache_key, cache_flush);
+}
+
+/** Flush the thread's lists when it exits, done once per thread */
+static void
+cache_register(cache_t* p_c)
+{
+    pthread_once(&key_once, key_init);
+    if (pthread_setspecific(cache_key, p_c) == 0) p_c->live = 1;
+}
+
+/** Refill an empty thread list from the shared list or a slab, return one */
+static free_t*
+cache_refill(cache_t* p_c, int cls)
+{
+    shared_t* p_sh = &shared[cls];
+    uint32_t want = local_limit(cls) / 2;
+    free_t* p_head = NULL;
+    uint32_t got = 0;
+
+    pthread_once(&shared_once, shared_init);
+    if (__builtin_expect(!p_c->live, 0)) cache_register(p_c);
+
+    pthread_mutex_lock(&p_sh->lock);
+    while (got < want && p_sh->head) {
+        free_t* p_f = p_sh->head;
+        p_sh->head = p_f->next;
+        p_sh->count--;
+        if (!p_f->released) p_sh->resident--;
+        else STAT_SUB(stats.released, ((size_t)1 << (cls + MIN_SHIFT)) - page_size);
+        p_f->next = p_head;
+        p_head = p_f;
+        ++got;
+    }
+    // Fresh slots only when nothing is free, so bursts reuse what they freed
+    if (got == 0) {
+        slab_t* p_s = p_sh->slab;
+        if (!p_s || p_s->carved == p_s->slots) {
+            if ((p_s = slab_create(cls))) p_sh->slab = p_s;
+        }
+        while (p_s && got < want && p_s->carved < p_s->slots) {
+            free_t* p_f = (free_t*)((char*)p_s + p_s->first + ((size_t)p_s->carved++ << p_s->shift));
+            p_f->next = p_head;
+            p_head = p_f;
+            ++got;
+        }
+    }
+    pthread_mutex_unlock(&p_sh->lock);
+
+    if (!p_head) return NULL;
+    p_c->head[cls] = p_head->next;
+    p_c->count[cls] = got - 1;
+    return p_head;
+}
+
+static void*
+large_alloc(size_t size)
+{
+    pthread_once(&shared_once, shared_init);
+    size_t need = round_up(size, page_size);
+    if (need < size) return NULL;
+
+    // A cached buffer at most twice as large as needed
+    pthread_mutex_lock(&large_lock);
+    slab_t** pp_s = &large_cache;
+    while (*pp_s && ((*pp_s)->size < need || (*pp_s)->size / 2 > need)) pp_s = &(*pp_s)->next;
+    slab_t* p_s = *pp_s;
+    if (p_s) {
+        *pp_s = p_s->next;
+        large_cached -= p_s->map_len;
+    }
+    pthread_mutex_unlock(&large_lock);
+
+    if (!p_s) {
+        size_t len = page_size + need;
+        int hugetlb;
+        if (len < need || !(p_s = map_region(&len, need >= SLAB_SIZE, &hugetlb))) return NULL;
+        p_s->magic = SLAB_MAGIC;
+        p_s->cls = LARGE;
+        p_s->shift = 0;
+        p_s->slots = 1;
+        p_s->carved = 1;
+        p_s->hugetlb = hugetlb;
+        p_s->first = page_size;
+        p_s->size = len - page_size;
+        p_s->map_len = len;
+        region_account(p_s, 1);
+        STAT_ADD(stats.large, 1);
+    }
+    p_s->next = NULL;
+    __atomic_store_n(&p_s->refs[0], 1, __ATOMIC_RELAXED);
+    return (char*)p_s + p_s->first;
+}
+
+static void
+large_free(slab_t* p_s)
+{
+    pthread_mutex_lock(&large_lock);
+    if (large_cached + p_s->map_len <= LARGE_CACHE) {
+        p_s->next = large_cache;
+        large_cache = p_s;
+        large_cached += p_s->map_len;
+        p_s = NULL;
+    }
+    pthread_mutex_unlock(&large_lock);
+
+    if (p_s) {
+        region_account(p_s, -1);
+        STAT_SUB(stats.large, 1);
+        munmap(p_s, p_s->map_len);
+    }
+}
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+void*
+pcom_buf_alloc(size_t size)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (size > PCOM_BUF_MAX) return large_alloc(size);
+
+    int cls = class_of(size);
+    cache_t* p_c = &tls_cache;
+    free_t* p_f = p_c->head[cls];
+    if (__builtin_expect(p_f != NULL, 1)) {
+        p_c->head[cls] = p_f->next;
+        p_c->count[cls]--;
+    } else if (!(p_f = cache_refill(p_c, cls))) {
+        return NULL;
+    }
+
+    slab_t* p_s = slab_of(p_f);
+    __atomic_store_n(refs_of(p_s, p_f), 1, __ATOMIC_RELAXED);
+    return p_f;
+
+#else
+
+    (void)size;
+    return NULL;
+
+#endif
+}
+
+void
+pcom_buf_ref(void* buf)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    if (buf) __atomic_fetch_add(refs_of(slab_of(buf), buf), 1, __ATOMIC_RELAXED);
+#else
+    (void)buf;
+#endif
+}
+
+void
+pcom_buf_unref(void* buf)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (!buf) return;
+    slab_t* p_s = slab_of(buf);
+    uint32_t* p_refs = refs_of(p_s, buf);
+
+    // The sole owner skips the locked instruction, nobody else can add a ref
+    if (__atomic_load_n(p_refs, __ATOMIC_ACQUIRE) != 1 &&
+        __atomic_sub_fetch(p_refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+
+    if (p_s->cls == LARGE) { large_free(p_s); return; }
+
+    int cls = (int)p_s->cls;
+    cache_t* p_c = &tls_cache;
+    free_t* p_f = buf;
+    if (__builtin_expect(!p_c->live, 0)) cache_register(p_c);
+    p_f->next = p_c->head[cls];
+    p_c->head[cls] = p_f;
+    if (__builtin_expect(++p_c->count[cls] > local_limit(cls), 0))
+        cache_spill(p_c, cls, local_limit(cls) / 2);
+
+#else
+    (void)buf;
+#endif
+}
+
+size_t
+pcom_buf_capacity(const void* buf)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    return buf ? slab_of(buf)->size : 0;
+#else
+    (void)buf;
+    return 0;
+#endif
+}
+
+int64_t
+pcom_buf_recv(int handle, size_t max, void** pp_buf)
+{
+    if (!pp_buf) return -EINVAL;
+    *pp_buf = NULL;
+
+    void* buf = pcom_buf_alloc(max);
+    if (!buf) return -ENOMEM;
+
+    int64_t result = pcom_client_recv(handle, buf, max);
+    if (result <= 0) {
+        pcom_buf_unref(buf);
+        return result;
+    }
+    *pp_buf = buf;
+    return result;
+}
+
+int
+pcom_buf_recv_frame(int handle, pcom_frame_hdr_t* p_hdr, void** pp_buf)
+{
+    uint8_t raw[PCOM_FRAME_HDR_SIZE];
+
+    if (!p_hdr || !pp_buf) return -EINVAL;
+    *pp_buf = NULL;
+
+    int64_t result = pcom_recv_exact(handle, raw, sizeof(raw));
+    if (result == 0) return 0;
+    if (result < 0) return (int)result;
+    if (result < (int64_t)sizeof(raw)) return -EPIPE;
+    pcom_frame_decode(raw, p_hdr);
+    if (p_hdr->len > PCOM_FRAME_MAX) return -EMSGSIZE;
+    if (p_hdr->len == 0) return 1;
+
+    void* buf = pcom_buf_alloc(p_hdr->len);
+    if (!buf) return -ENOMEM;
+    result = pcom_recv_exact(handle, buf, p_hdr->len);
+    if (result != (int64_t)p_hdr->len) {
+        pcom_buf_unref(buf);
+        return result < 0 ? (int)result : -EPIPE;
+    }
+    *pp_buf = buf;
+    return 1;
+}
+
+void
+pcom_buf_trim(void)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    pthread_once(&shared_once, shared_init);
+    cache_t* p_c = &tls_cache;
+    for (int c = 0; c < CLASSES; ++c) cache_spill(p_c, c, p_c->count[c]);
+
+    for (int c = 0; c < CLASSES; ++c) {
+        shared_t* p_sh = &shared[c];
+        size_t size = (size_t)1 << (c + MIN_SHIFT);
+        pthread_mutex_lock(&p_sh->lock);
+        for (free_t* p_f = p_sh->head; p_f && p_sh->resident; p_f = p_f->next) {
+            if (p_f->released) continue;
+            release_pages(p_f, size);
+            if (p_f->released) p_sh->resident--;
+        }
+        pthread_mutex_unlock(&p_sh->lock);
+    }
+
+    pthread_mutex_lock(&large_lock);
+    slab_t* p_s = large_cache;
+    large_cache = NULL;
+    large_cached = 0;
+    pthread_mutex_unlock(&large_lock);
+    while (p_s) {
+        slab_t* p_next = p_s->next;
+        region_account(p_s, -1);
+        STAT_SUB(stats.large, 1);
+        munmap(p_s, p_s->map_len);
+        p_s = p_next;
+    }
+
+#endif
+}
+
+int
+pcom_buf_stats(pcom_buf_stats_t* p_stats)
+{
+    if (!p_stats) return -1;
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    pthread_once(&shared_once, shared_init);
+    p_stats->mapped = STAT_GET(stats.mapped);
+    p_stats->released = STAT_GET(stats.released);
+    p_stats->slabs = STAT_GET(stats.slabs);
+    p_stats->large = STAT_GET(stats.large);
+    p_stats->huge = STAT_GET(stats.huge);
+    p_stats->cached = 0;
+    for (int c = 0; c < CLASSES; ++c) {
+        pthread_mutex_lock(&shared[c].lock);
+        p_stats->cached += (unsigned long long)shared[c].count << (c + MIN_SHIFT);
+        pthread_mutex_unlock(&shared[c].lock);
+    }
+    pthread_mutex_lock(&large_lock);
+    p_stats->cached += large_cached;
+    pthread_mutex_unlock(&large_lock);
+    return 0;
+
+#else
+
+    return -1;
+
+#endif
+}
@@ -0,0 +1,154 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_buf.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Pooled, reference counted message buffers.
+ ****************************************************************************/
+/** @defgroup  PCOM_BUF
+ * @brief     Size classed buffer pool for the send and receive paths.
+ * @details   Buffers come in power of two size classes from 64 bytes to
+ *            256 KiB, carved from 2 MiB slabs. Each thread keeps a free list
+ *            per class, so allocating and freeing a buffer is a few loads and
+ *            stores without locks. A list that grows too long hands half of
+ *            it to a shared list, where other threads pick it up: buffers
+ *            received on one thread and freed on another circulate instead of
+ *            piling up. Slabs of classes from 64 KiB on are backed by huge
+ *            pages, MAP_HUGETLB if reserved, transparent huge pages otherwise.
+ *
+ *            Larger buffers are mapped one by one and a few are kept for
+ *            reuse. Pages of cached buffers above the shared limit are given
+ *            back to the kernel, so RSS follows the peak working set rather
+ *            than growing with every burst.
+ *
+ *            Every buffer carries a reference count, starting at one. A
+ *            buffer received with pcom_buf_recv() can be passed to other
+ *            threads or queued for several connections, each holder taking
+ *            a reference and dropping it when done.
+ *
+ *                void* buf;
+ *                int64_t n = pcom_buf_recv(handle, 4096, &buf);
+ *                if (n > 0) {
+ *                    handle_message(buf, n);   // may pcom_buf_ref() it
+ *                    pcom_buf_unref(buf);
+ *                }
+ *
+ * @pre       pcom.h, pcom_frame.h, pthreads
+ * @bug       -
+ * @warning   Not available on Windows. Only pointers returned by
+ *            pcom_buf_alloc() may be passed to the other functions.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_BUF_H
+#define PCOM_BUF_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for int64_t
+
+#include "pcom.h"
+#include "pcom_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_BUF_MIN   (64)           // Smallest size class
+#define PCOM_BUF_MAX   (256 * 1024)   // Largest size class, beyond are mapped singly
+
+typedef struct {
+    unsigned long long mapped;   // Bytes mapped for slabs and large buffers
+    unsigned long long cached;   // Bytes in the shared free lists, resident or not
+    unsigned long long released; // Bytes of cached buffers given back to the kernel
+    unsigned long long slabs;    // Slabs mapped
+    unsigned long long large;    // Large buffers mapped, in use or cached
+    unsigned long long huge;     // Slabs and large buffers on MAP_HUGETLB pages
+} pcom_buf_stats_t;
+
+/**
+ * @brief      Allocate a buffer.
+ * @param      size  Bytes needed.
+ * @return     Buffer with a reference count of one, NULL if out of memory.
+ * @details    The buffer is at least size bytes, see pcom_buf_capacity(), and
+ *             aligned to its size class up to the page size. Contents are
+ *             undefined.
+ */
+LIB_EXPORT void*
+pcom_buf_alloc(size_t size);
+
+/**
+ * @brief      Take another reference to a buffer.
+ * @param      buf  Buffer from pcom_buf_alloc().
+ */
+LIB_EXPORT void
+pcom_buf_ref(void* buf);
+
+/**
+ * @brief      Drop a reference, the last one returns the buffer to the pool.
+ * @param      buf  Buffer from pcom_buf_alloc(), NULL is ignored.
+ * @details    Any thread may drop the last reference, the buffer goes to that
+ *             thread's free list.
+ */
+LIB_EXPORT void
+pcom_buf_unref(void* buf);
+
+/**
+ * @brief      Usable size of a buffer.
+ * @param      buf  Buffer from pcom_buf_alloc().
+ * @return     Size of its class, or the mapped size of a large buffer.
+ */
+LIB_EXPORT size_t
+pcom_buf_capacity(const void* buf);
+
+/**
+ * @brief      Receive into a new buffer.
+ * @param      handle  Connected PCOM handle.
+ * @param      max     Most bytes to receive.
+ * @param      pp_buf  Receives the buffer, NULL unless bytes were received.
+ * @return     Bytes received, 0 on EOF, negative error code on failure.
+ * @details    One read, as pcom_client_recv(). The caller owns the reference.
+ */
+LIB_EXPORT int64_t
+pcom_buf_recv(int handle, size_t max, void** pp_buf);
+
+/**
+ * @brief      Receive one frame, its payload into a new buffer.
+ * @param      handle  Connected PCOM handle.
+ * @param      p_hdr   Receives the header.
+ * @param      pp_buf  Receives the payload buffer, NULL for an empty payload.
+ * @return     1 on success, 0 on EOF, negative error code on failure.
+ * @details    Reads the header and then the payload straight into its
+ *             buffer. Do not mix with a pcom_frame_reader_t on the handle,
+ *             which may hold bytes already read.
+ */
+LIB_EXPORT int
+pcom_buf_recv_frame(int handle, pcom_frame_hdr_t* p_hdr, void** pp_buf);
+
+/**
+ * @brief      Return idle memory to the kernel.
+ * @details    Moves the calling thread's free lists to the shared lists,
+ *             releases the pages of every cached buffer of a page or more,
+ *             and unmaps cached large buffers. Slabs stay mapped.
+ */
+LIB_EXPORT void
+pcom_buf_trim(void);
+
+/**
+ * @brief      Get pool statistics.
+ * @param      p_stats  Receives the statistics.
+ * @return     0 on success, -1 if not supported.
+ */
+LIB_EXPORT int
+pcom_buf_stats(pcom_buf_stats_t* p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_BUF_H
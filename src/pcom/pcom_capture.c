@@ -0,0 +1,255 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_capture.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Capture of framed PCOM traffic for replay.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#include "pcom_capture.h"
+#include "libcrc/crc32.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define REC_HEAD (offsetof(pcom_capture_rec_t, crc))   // Record bytes under the CRC
+
+/** CRC32 of the payload followed by the record up to the CRC */
+static uint32_t
+rec_crc(const pcom_capture_rec_t* p_rec, const void* payload)
+{
+    uint32_t crc = crc32_update(payload, p_rec->len, crc32_initialize());
+    return crc32_finalize(crc32_update((const uint8_t*)p_rec, REC_HEAD, crc));
+}
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+#define CAPTURE_BUF (1u << 20)    // Records are written in chunks of this
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static int capture_on;
+static pthread_mutex_t capture_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+static int capture_fd = -1;
+static uint8_t* capture_buf;
+static size_t capture_len;        // Bytes in capture_buf
+static uint64_t capture_t0;       // CLOCK_MONOTONIC ns at start
+static uint64_t capture_bytes;    // File size including the buffer
+static uint64_t capture_max;
+static int64_t capture_records;
+static int capture_error;         // First write error
+
+static uint64_t
+now_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+write_all(const void* data, size_t len)
+{
+    const uint8_t* p = data;
+    while (len > 0 && !capture_error) {
+        ssize_t n = write(capture_fd, p, len);
+        if (n < 0) {
+            if (errno != EINTR) capture_error = pcom_errno_from(errno);
+            continue;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static void
+flush_locked(void)
+{
+    write_all(capture_buf, capture_len);
+    capture_len = 0;
+}
+
+/** Append to the buffer, writing it out when full. Large payloads go directly. */
+static void
+append_locked(const void* data, size_t len)
+{
+    if (capture_len + len > CAPTURE_BUF) flush_locked();
+    if (len > CAPTURE_BUF) { write_all(data, len); return; }
+    memcpy(capture_buf + capture_len, data, len);
+    capture_len += len;
+}
+
+/* A forked child has a copy of the buffer, it must not write it out too */
+static void at_fork_prepare(void) { pthread_mutex_lock(&capture_lock); }
+static void at_fork_parent(void) { pthread_mutex_unlock(&capture_lock); }
+
+static void
+at_fork_child(void)
+{
+    __atomic_store_n(&capture_on, 0, __ATOMIC_RELAXED);
+    if (capture_fd >= 0) close(capture_fd);
+    free(capture_buf);
+    capture_fd = -1;
+    capture_buf = NULL;
+    capture_len = 0;
+    pthread_mutex_unlock(&capture_lock);
+}
+
+static void
+atfork_init(void)
+{
+    pthread_atfork(at_fork_prepare, at_fork_parent, at_fork_child);
+}
+
+static void
+capture_at_exit(void)
+{
+    pcom_capture_stop();
+}
+
+/** Start from the environment when the library loads */
+__attribute__((constructor)) static void
+capture_from_env(void)
+{
+    const char* p_file = getenv("PCOM_CAPTURE_FILE");
+    if (!p_file || !p_file[0]) return;
+    if (pcom_capture_start(p_file, 0) == 0) atexit(capture_at_exit);
+}
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_capture_start(const char* path, uint64_t max_bytes)
+{
+    if (!path || !path[0]) return -EINVAL;
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    pcom_capture_file_t hdr;
+    int result = 0;
+
+    pthread_once(&atfork_once, atfork_init);
+    pthread_mutex_lock(&capture_lock);
+    if (capture_fd >= 0) { pthread_mutex_unlock(&capture_lock); return -EBUSY; }
+
+    capture_buf = malloc(CAPTURE_BUF);
+    capture_fd = capture_buf ? open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : -1;
+    if (capture_fd < 0) {
+        result = capture_buf ? pcom_errno_from(errno) : -ENOMEM;
+        free(capture_buf);
+        capture_buf = NULL;
+        pthread_mutex_unlock(&capture_lock);
+        return result;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, PCOM_CAPTURE_MAGIC, sizeof(hdr.magic));
+    hdr.pid = (uint32_t)getpid();
+    hdr.version = (uint32_t)pcom_version();
+    hdr.start_ns = now_ns(CLOCK_REALTIME);
+    capture_len = 0;
+    capture_error = 0;
+    capture_records = 0;
+    capture_bytes = sizeof(hdr);
+    capture_max = max_bytes;
+    capture_t0 = now_ns(CLOCK_MONOTONIC);
+    append_locked(&hdr, sizeof(hdr));
+    __atomic_store_n(&capture_on, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&capture_lock);
+    return 0;
+
+#else
+    (void)max_bytes;
+    return -1;
+#endif
+}
+
+int64_t
+pcom_capture_stop(void)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    pthread_mutex_lock(&capture_lock);
+    __atomic_store_n(&capture_on, 0, __ATOMIC_RELAXED);
+    if (capture_fd < 0) { pthread_mutex_unlock(&capture_lock); return -EINVAL; }
+
+    flush_locked();
+    if (close(capture_fd) < 0 && !capture_error) capture_error = pcom_errno_from(errno);
+    free(capture_buf);
+    capture_fd = -1;
+    capture_buf = NULL;
+    int64_t result = capture_error ? capture_error : capture_records;
+    pthread_mutex_unlock(&capture_lock);
+    return result;
+
+#else
+    return -1;
+#endif
+}
+
+void
+pcom_capture_frame(int handle, int dir, const pcom_frame_hdr_t* p_hdr, const void* payload)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    static const uint8_t zeros[8];
+    pcom_capture_rec_t rec;
+
+    if (__builtin_expect(!__atomic_load_n(&capture_on, __ATOMIC_RELAXED), 1)) return;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.handle = handle;
+    rec.len = p_hdr->len;
+    rec.dir = (uint8_t)dir;
+    rec.type = p_hdr->type;
+    rec.flags = p_hdr->flags;
+    rec.channel = p_hdr->channel;
+    uint64_t size = pcom_capture_rec_size(&rec);
+    // The payload part of the CRC outside the lock, the time inside so the file is in order
+    uint32_t crc = crc32_update(payload, rec.len, crc32_initialize());
+
+    pthread_mutex_lock(&capture_lock);
+    if (!capture_on || capture_error || (capture_max && capture_bytes + size > capture_max)) {
+        pthread_mutex_unlock(&capture_lock);
+        return;
+    }
+    rec.time_ns = now_ns(CLOCK_MONOTONIC) - capture_t0;
+    rec.crc = crc32_finalize(crc32_update((const uint8_t*)&rec, REC_HEAD, crc));
+    append_locked(&rec, sizeof(rec));
+    if (rec.len) append_locked(payload, rec.len);
+    append_locked(zeros, (size_t)(size - sizeof(rec) - rec.len));
+    capture_bytes += size;
+    ++capture_records;
+    pthread_mutex_unlock(&capture_lock);
+
+#else
+    (void)handle; (void)dir; (void)p_hdr; (void)payload;
+#endif
+}
+
+int
+pcom_capture_rec_valid(const pcom_capture_rec_t* p_rec)
+{
+    return rec_crc(p_rec, p_rec + 1) == p_rec->crc;
+}
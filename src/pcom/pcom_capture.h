@@ -0,0 +1,137 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_capture.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Capture of framed PCOM traffic for replay.
+ ****************************************************************************/
+/** @defgroup  PCOM_CAPTURE
+ * @brief     Record frames with timestamps to a binary file.
+ * @details   While a capture runs, every frame sent with pcom_frame_send()
+ *            and received with pcom_frame_recv() is appended to the capture
+ *            file: a 32 byte record with the time since the start, the
+ *            handle, the direction and the frame header, followed by the
+ *            payload padded to 8 bytes. Each record carries a CRC32 (libcrc)
+ *            of its header and payload. Frames taken from a reader fed by a
+ *            pcom_loop are recorded with pcom_capture_frame().
+ *
+ *            tools/pcom_replay plays a capture back against a server from
+ *            many clients, at the captured pace, scaled or as fast as
+ *            possible, and reports latency percentiles:
+ *
+ *                pcom_capture_start("/tmp/db.pcap", 1 << 30);
+ *                ...                                  // production traffic
+ *                pcom_capture_stop();
+ *
+ *                $ pcom_replay -n @db-test -k 64 -x 2 /tmp/db.pcap
+ *
+ *            Setting PCOM_CAPTURE_FILE in the environment starts a capture
+ *            when the library loads and ends it at exit.
+ *
+ * @pre       pcom.h, pcom_frame.h, libcrc/crc32.h, pthreads
+ * @bug       -
+ * @warning   Not available on Windows. Records are buffered, a process
+ *            killed without exit loses the last MiB. Forked children do not
+ *            capture. Handle numbers are reused after close, so connections
+ *            on the same handle end up in one replay session.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_CAPTURE_H
+#define PCOM_CAPTURE_H
+
+#include <stdint.h>  // for uint64_t
+
+#include "pcom.h"
+#include "pcom_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_CAPTURE_MAGIC  "PCOMCAP1"    // File magic, 8 bytes
+#define PCOM_CAPTURE_IN     (0)           // Frame received
+#define PCOM_CAPTURE_OUT    (1)           // Frame sent
+
+/** File header, followed by records */
+typedef struct {
+    char magic[8];       // PCOM_CAPTURE_MAGIC
+    uint32_t pid;
+    uint32_t version;    // pcom_version() of the capturing process
+    uint64_t start_ns;   // CLOCK_REALTIME at start
+    uint64_t reserved;
+} pcom_capture_file_t;
+
+/** One frame, followed by len payload bytes and zero padding to 8 bytes */
+typedef struct {
+    uint64_t time_ns;    // Since the start
+    int32_t handle;
+    uint32_t len;        // Payload length
+    uint8_t dir;         // PCOM_CAPTURE_IN or PCOM_CAPTURE_OUT
+    uint8_t type;        // Frame header
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t channel;
+    uint16_t reserved2;
+    uint32_t reserved3;
+    uint32_t crc;        // CRC32 of the payload, then of the record up to here
+} pcom_capture_rec_t;
+
+/**
+ * @brief      Start capturing to a file.
+ * @param      path       File to create, replaced if it exists.
+ * @param      max_bytes  File size to stop at, 0 for no limit.
+ * @return     0 on success, -EBUSY if a capture runs, negative error code
+ *             on failure.
+ */
+LIB_EXPORT int
+pcom_capture_start(const char* path, uint64_t max_bytes);
+
+/**
+ * @brief      Stop capturing and close the file.
+ * @return     Number of records written, negative error code on failure.
+ */
+LIB_EXPORT int64_t
+pcom_capture_stop(void);
+
+/**
+ * @brief      Record a frame, if a capture runs.
+ * @param      handle   Connection the frame went over.
+ * @param      dir      PCOM_CAPTURE_IN or PCOM_CAPTURE_OUT.
+ * @param      p_hdr    The frame header.
+ * @param      payload  p_hdr->len bytes.
+ * @details    Costs one load and branch while no capture runs.
+ */
+LIB_EXPORT void
+pcom_capture_frame(int handle, int dir, const pcom_frame_hdr_t* p_hdr, const void* payload);
+
+/**
+ * @brief      Check a record.
+ * @param      p_rec    The record, followed by its payload.
+ * @return     1 if the CRC matches, 0 otherwise.
+ */
+LIB_EXPORT int
+pcom_capture_rec_valid(const pcom_capture_rec_t* p_rec);
+
+/**
+ * @brief      Size of a record with its payload and padding.
+ * @param      p_rec  The record.
+ * @return     Bytes to the next record.
+ */
+static inline uint64_t
+pcom_capture_rec_size(const pcom_capture_rec_t* p_rec)
+{
+    return sizeof(*p_rec) + (((uint64_t)p_rec->len + 7) & ~(uint64_t)7);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_CAPTURE_H
@@ -0,0 +1,304 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_client_pool.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Process wide pool of warm PCOM client connections.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <poll.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include "pcom_client_pool.h"
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define EP_NAME_LEN (256)
+
+#define STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define STAT_GET(field)    __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+/* Lock-free stacks of slot indexes. The head packs a change counter in the
+ * upper 32 bits against ABA and index + 1 in the lower, 0 when empty. */
+typedef uint64_t lf_stack_t;
+
+/** A pooled connection, on an endpoint's idle stack or on the free stack */
+typedef struct {
+    int handle;
+    long long since;   // Put back at, ms
+    uint32_t next;     // Next index + 1 on the same stack
+} slot_t;
+
+typedef struct {
+    int ready;         // Name set, published with release
+    char name[EP_NAME_LEN];
+    lf_stack_t idle;
+} endpoint_t;
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t ep_lock = PTHREAD_MUTEX_INITIALIZER;  // Endpoint inserts
+static endpoint_t endpoints[PCOM_CLIENT_POOL_ENDPOINTS];
+static slot_t slots[PCOM_CLIENT_POOL_MAX];
+static lf_stack_t free_slots;
+
+static int opt_cap = PCOM_CLIENT_POOL_CAP;
+static int opt_idle_ms = PCOM_CLIENT_POOL_IDLE_MS;
+static int opt_check_ms = PCOM_CLIENT_POOL_CHECK_MS;
+static pcom_client_pool_stats_t stats;
+
+static long long
+now_ms(void)
+{
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC_COARSE)
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void
+stack_push(lf_stack_t* p_stack, int index)
+{
+    lf_stack_t old = __atomic_load_n(p_stack, __ATOMIC_RELAXED);
+    lf_stack_t next;
+    do {
+        __atomic_store_n(&slots[index].next, (uint32_t)old, __ATOMIC_RELAXED);
+        next = ((old >> 32) + 1) << 32 | (uint32_t)(index + 1);
+    } while (!__atomic_compare_exchange_n(p_stack, &old, next, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static int
+stack_pop(lf_stack_t* p_stack)
+{
+    lf_stack_t old = __atomic_load_n(p_stack, __ATOMIC_ACQUIRE);
+    lf_stack_t next;
+    do {
+        uint32_t top = (uint32_t)old;
+        if (!top) return -1;
+        // Stale if the slot was taken meanwhile, the counter fails the CAS then
+        uint32_t after = __atomic_load_n(&slots[top - 1].next, __ATOMIC_RELAXED);
+        next = ((old >> 32) + 1) << 32 | after;
+    } while (!__atomic_compare_exchange_n(p_stack, &old, next, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    return (int)(uint32_t)old - 1;
+}
+
+static void
+pool_init(void)
+{
+    for (int i = PCOM_CLIENT_POOL_MAX - 1; i >= 0; --i) stack_push(&free_slots, i);
+}
+
+static uint32_t
+ep_hash(const char* name)
+{
+    uint32_t h = 2166136261u;
+    while (*name) h = (h ^ (uint8_t)*name++) * 16777619u;
+    return h;
+}
+
+/* Find the endpoint for a name, lock-free unless it has to be added */
+static endpoint_t*
+ep_find(const char* name, int create)
+{
+    uint32_t h = ep_hash(name);
+    for (int locked = 0; locked < 2; ++locked) {
+        for (int n = 0; n < PCOM_CLIENT_POOL_ENDPOINTS; ++n) {
+            endpoint_t* p_ep = &endpoints[(h + n) % PCOM_CLIENT_POOL_ENDPOINTS];
+            if (!__atomic_load_n(&p_ep->ready, __ATOMIC_ACQUIRE)) {
+                if (!locked) break;
+                strcpy(p_ep->name, name);
+                __atomic_store_n(&p_ep->ready, 1, __ATOMIC_RELEASE);
+                pthread_mutex_unlock(&ep_lock);
+                return p_ep;
+            }
+            if (strcmp(p_ep->name, name) == 0) {
+                if (locked) pthread_mutex_unlock(&ep_lock);
+                return p_ep;
+            }
+        }
+        if (!create) return NULL;
+        if (!locked) pthread_mutex_lock(&ep_lock);
+    }
+    pthread_mutex_unlock(&ep_lock);
+    return NULL;
+}
+
+static void
+conn_close(int handle)
+{
+    pcom_client_close(handle);
+    STAT_ADD(stats.open, -1ULL);
+    STAT_ADD(stats.closed, 1);
+}
+
+/* An idle request/response connection has nothing to read and no hangup */
+static int
+conn_healthy(int handle)
+{
+    struct pollfd pfd = { .fd = handle, .events = POLLIN };
+    int result;
+    while ((result = poll(&pfd, 1, 0)) < 0 && errno == EINTR) {}
+    return result == 0;
+}
+
+/* Count a new connection against the cap */
+static int
+reserve_open(void)
+{
+    unsigned long long open = STAT_GET(stats.open);
+    do {
+        if (open >= (unsigned long long)__atomic_load_n(&opt_cap, __ATOMIC_RELAXED)) return 0;
+    } while (!__atomic_compare_exchange_n(&stats.open, &open, open + 1, 1,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return 1;
+}
+
+/* Close one idle connection, any endpoint, to make room under the cap */
+static int
+evict_idle(void)
+{
+    for (int n = 0; n < PCOM_CLIENT_POOL_ENDPOINTS; ++n) {
+        endpoint_t* p_ep = &endpoints[n];
+        if (!__atomic_load_n(&p_ep->ready, __ATOMIC_ACQUIRE)) continue;
+        int i = stack_pop(&p_ep->idle);
+        if (i < 0) continue;
+        int handle = slots[i].handle;
+        stack_push(&free_slots, i);
+        STAT_ADD(stats.idle, -1ULL);
+        conn_close(handle);
+        return 1;
+    }
+    return 0;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+void
+pcom_client_pool_config(const pcom_client_pool_opts_t* p_opts)
+{
+    int cap = (p_opts && p_opts->cap > 0) ? p_opts->cap : PCOM_CLIENT_POOL_CAP;
+    if (cap > PCOM_CLIENT_POOL_MAX) cap = PCOM_CLIENT_POOL_MAX;
+    __atomic_store_n(&opt_cap, cap, __ATOMIC_RELAXED);
+    __atomic_store_n(&opt_idle_ms, p_opts ? (p_opts->idle_ms > 0 ? p_opts->idle_ms : 0)
+                                          : PCOM_CLIENT_POOL_IDLE_MS, __ATOMIC_RELAXED);
+    __atomic_store_n(&opt_check_ms, p_opts ? (p_opts->check_ms > 0 ? p_opts->check_ms : 0)
+                                           : PCOM_CLIENT_POOL_CHECK_MS, __ATOMIC_RELAXED);
+}
+
+int
+pcom_client_pool_get(const char* name)
+{
+    if (!name) return -EINVAL;
+    if (strlen(name) >= EP_NAME_LEN) return -ENAMETOOLONG;
+    pthread_once(&pool_once, pool_init);
+
+    endpoint_t* p_ep = ep_find(name, 1);
+    if (!p_ep) return -ENOSPC;
+
+    // Warm connection first
+    int i;
+    while ((i = stack_pop(&p_ep->idle)) >= 0) {
+        int handle = slots[i].handle;
+        long long age = now_ms() - slots[i].since;
+        stack_push(&free_slots, i);
+        STAT_ADD(stats.idle, -1ULL);
+
+        if (age >= __atomic_load_n(&opt_idle_ms, __ATOMIC_RELAXED)) {
+            STAT_ADD(stats.expired, 1);
+            conn_close(handle);
+            continue;
+        }
+        if (age >= __atomic_load_n(&opt_check_ms, __ATOMIC_RELAXED) && !conn_healthy(handle)) {
+            STAT_ADD(stats.unhealthy, 1);
+            conn_close(handle);
+            continue;
+        }
+        STAT_ADD(stats.reused, 1);
+        return handle;
+    }
+
+    // New connection within the cap
+    while (!reserve_open()) {
+        if (!evict_idle()) {
+            STAT_ADD(stats.busy, 1);
+            return -EBUSY;
+        }
+    }
+    int handle = pcom_client_open(name);
+    if (handle < 0) {
+        STAT_ADD(stats.open, -1ULL);
+        return handle;
+    }
+    STAT_ADD(stats.opened, 1);
+    return handle;
+}
+
+void
+pcom_client_pool_put(const char* name, int handle, int reuse)
+{
+    if (handle < 0) return;
+    pthread_once(&pool_once, pool_init);
+
+    endpoint_t* p_ep = name ? ep_find(name, 0) : NULL;
+    if (!p_ep || !reuse || !__atomic_load_n(&opt_idle_ms, __ATOMIC_RELAXED)) {
+        conn_close(handle);
+        return;
+    }
+    int i = stack_pop(&free_slots);
+    if (i < 0) {
+        conn_close(handle);
+        return;
+    }
+    slots[i].handle = handle;
+    slots[i].since = now_ms();
+    STAT_ADD(stats.idle, 1);
+    stack_push(&p_ep->idle, i);
+}
+
+void
+pcom_client_pool_clear(void)
+{
+    pthread_once(&pool_once, pool_init);
+    while (evict_idle()) {}
+}
+
+void
+pcom_client_pool_stats(pcom_client_pool_stats_t* p_stats)
+{
+    if (!p_stats) return;
+    p_stats->open = STAT_GET(stats.open);
+    p_stats->idle = STAT_GET(stats.idle);
+    p_stats->opened = STAT_GET(stats.opened);
+    p_stats->reused = STAT_GET(stats.reused);
+    p_stats->closed = STAT_GET(stats.closed);
+    p_stats->expired = STAT_GET(stats.expired);
+    p_stats->unhealthy = STAT_GET(stats.unhealthy);
+    p_stats->busy = STAT_GET(stats.busy);
+}
+
+#else /* Not supported platforms */
+
+void pcom_client_pool_config(const pcom_client_pool_opts_t* p_opts) { (void)p_opts; }
+int pcom_client_pool_get(const char* name) { (void)name; return -1; }
+void pcom_client_pool_put(const char* name, int handle, int reuse)
+    { (void)reuse; if (name && handle >= 0) pcom_client_close(handle); }
+void pcom_client_pool_clear(void) {}
+void pcom_client_pool_stats(pcom_client_pool_stats_t* p_stats) { (void)p_stats; }
+
+#endif
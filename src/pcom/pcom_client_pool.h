@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_client_pool.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Process wide pool of warm PCOM client connections.
+ ****************************************************************************/
+/** @defgroup  PCOM_CLIENT_POOL
+ * @brief     Reuse client connections instead of opening one per request.
+ * @details   pcom_client_pool_get() hands out an idle connection to the named
+ *            server, or opens a new one if there is none, and
+ *            pcom_client_pool_put() gives it back for the next caller. A
+ *            reused connection costs no socket(), connect(), accept() or
+ *            server side credential check, only the request itself.
+ *
+ *            Idle connections are kept per endpoint name on lock-free stacks,
+ *            so threads take and return them without a mutex. A connection
+ *            idle for longer than check_ms is polled once before it is handed
+ *            out, and one that is closed or has unread data is replaced. Idle
+ *            connections older than idle_ms are closed instead of reused.
+ *            The number of open connections, in use or idle, is capped; when
+ *            the cap is reached an idle connection to another endpoint is
+ *            closed to make room.
+ *
+ *            Meant for request/response use where a connection is idle and
+ *            drained when it is put back. Put a connection back with reuse 0
+ *            after any error or if a response was not read completely.
+ *
+ * @pre       pcom.h
+ * @bug       -
+ * @warning   Linux and other Unix only. A forked child must not use
+ *            connections pooled by its parent.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_CLIENT_POOL_H
+#define PCOM_CLIENT_POOL_H
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_CLIENT_POOL_MAX       (1024)   // Upper bound for the cap
+#define PCOM_CLIENT_POOL_CAP       (64)     // Default cap on open connections
+#define PCOM_CLIENT_POOL_ENDPOINTS (64)     // Distinct endpoint names
+#define PCOM_CLIENT_POOL_IDLE_MS   (30000)  // Default idle lifetime
+#define PCOM_CLIENT_POOL_CHECK_MS  (1000)   // Default idle time before a health check
+
+typedef struct {
+    int cap;             // Max open connections, 0 for default
+    int idle_ms;         // Close connections idle longer, 0 to never keep idle ones
+    int check_ms;        // Health check connections idle longer, 0 to always check
+} pcom_client_pool_opts_t;
+
+typedef struct {
+    unsigned long long open;      // Open now, in use or idle
+    unsigned long long idle;      // Idle now
+    unsigned long long opened;    // Connections opened
+    unsigned long long reused;    // Handed out from the pool
+    unsigned long long closed;    // Connections closed
+    unsigned long long expired;   // Closed for being idle too long
+    unsigned long long unhealthy; // Closed by a failed health check
+    unsigned long long busy;      // Gets refused at the cap
+} pcom_client_pool_stats_t;
+
+/**
+ * @brief      Configure the pool.
+ * @param      p_opts  Options, NULL for defaults.
+ * @details    Takes effect for the following calls. Lowering the cap does
+ *             not close connections already open.
+ */
+LIB_EXPORT void
+pcom_client_pool_config(const pcom_client_pool_opts_t* p_opts);
+
+/**
+ * @brief      Take a connection to a stream server.
+ * @param      name  The connection name, as for pcom_client_open().
+ * @return     Client handle or negative error code, -EBUSY if the cap is
+ *             reached and no idle connection can be closed.
+ * @details    Thread safe. Return the handle with pcom_client_pool_put(),
+ *             never close it directly.
+ */
+LIB_EXPORT int
+pcom_client_pool_get(const char* name);
+
+/**
+ * @brief      Return a connection taken with pcom_client_pool_get().
+ * @param      name    The name it was taken with.
+ * @param      handle  The client handle.
+ * @param      reuse   0 to close it, for example after an error.
+ * @details    Thread safe.
+ */
+LIB_EXPORT void
+pcom_client_pool_put(const char* name, int handle, int reuse);
+
+/**
+ * @brief      Close all idle connections.
+ * @details    Connections in use are closed when they are put back.
+ */
+LIB_EXPORT void
+pcom_client_pool_clear(void);
+
+/**
+ * @brief      Read the pool counters.
+ * @param      p_stats  Receives the counters.
+ */
+LIB_EXPORT void
+pcom_client_pool_stats(pcom_client_pool_stats_t* p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_CLIENT_POOL_H
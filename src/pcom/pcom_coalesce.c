@@ -0,0 +1,481 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_coalesce.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Write coalescing for small messages.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <time.h>
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
+#endif
+#include <string.h>
+#include <errno.h>
+
+#include "pcom_coalesce.h"
+#include "pcom_stats.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+#define CONN_CHUNK  (256)    // Handles per table chunk
+#define CONN_CHUNKS (1024)   // Chunks, handles up to 256K
+
+#define STALL_NS    (1000000) // Retry after a flush that found the peer full
+
+#ifndef MSG_MORE
+#define MSG_MORE (0)
+#endif
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+/** Coalescing state of a handle. Stays in the table once created. */
+typedef struct {
+    pthread_mutex_t lock;
+    int on;                  // Read without the lock by pcom_coalesce_on()
+    int error;               // Failed deadline flush, reported by the next call
+    size_t threshold;
+    uint64_t deadline_ns;    // 0 for no deadline
+    uint64_t due;            // Flush time of the buffered bytes, 0 if not armed
+    char* buf;
+    size_t len;
+} conn_t;
+
+/** Pending deadline in the flusher's heap */
+typedef struct {
+    uint64_t due;
+    int handle;
+} pending_t;
+
+static conn_t* conn_table[CONN_CHUNKS];
+static int conns_on;                      // Handles with coalescing on
+
+static pthread_once_t flusher_once = PTHREAD_ONCE_INIT;
+static int flusher_ok;
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static pending_t* timers;                 // Min heap on due
+static size_t timer_count, timer_cap;
+static uint64_t timer_wake = UINT64_MAX;  // When the flusher wakes up next
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/** State of a handle, NULL if out of range or out of memory */
+static conn_t*
+conn_get(int handle, int create)
+{
+    if (handle < 0 || handle >= CONN_CHUNK * CONN_CHUNKS) return NULL;
+
+    conn_t** pp_chunk = &conn_table[handle / CONN_CHUNK];
+    conn_t* p_chunk = __atomic_load_n(pp_chunk, __ATOMIC_ACQUIRE);
+    if (!p_chunk) {
+        if (!create) return NULL;
+        conn_t* p_new = calloc(CONN_CHUNK, sizeof(*p_new));
+        if (!p_new) return NULL;
+        for (int i = 0; i < CONN_CHUNK; ++i) pthread_mutex_init(&p_new[i].lock, NULL);
+        // Another thread may have installed one meanwhile, use that
+        if (__atomic_compare_exchange_n(pp_chunk, &p_chunk, p_new, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            p_chunk = p_new;
+        } else {
+            for (int i = 0; i < CONN_CHUNK; ++i) pthread_mutex_destroy(&p_new[i].lock);
+            free(p_new);
+        }
+    }
+    return &p_chunk[handle % CONN_CHUNK];
+}
+
+/**
+ * Write head, then iov, all of it. Several syscalls only for more than
+ * PCOM_IOV_MAX pieces or short writes, MSG_MORE on all but the last.
+ * With MSG_DONTWAIT in flags it stops when the socket is full instead
+ * and returns what went out.
+ */
+static int64_t
+write_out(int handle, const char* head, size_t head_len, const pcom_iovec_t* iov, int count,
+          int flags, unsigned* p_syscalls)
+{
+    struct iovec vec[PCOM_IOV_MAX];
+    struct msghdr msg;
+    int64_t total = 0;
+    int first = -1;      // Piece not fully sent, -1 is head
+    size_t skip = 0;     // Bytes of it already sent
+
+#define PIECE_LEN(i)  ((i) < 0 ? head_len : iov[i].len)
+#define PIECE_BASE(i) ((i) < 0 ? head : (const char*)iov[i].base)
+
+    for (;;) {
+        int n = 0, i;
+        for (i = first; i < count && n < PCOM_IOV_MAX; ++i) {
+            size_t off = (i == first) ? skip : 0;
+            if (PIECE_LEN(i) == off) continue;
+            vec[n].iov_base = (char*)PIECE_BASE(i) + off;
+            vec[n].iov_len = PIECE_LEN(i) - off;
+            ++n;
+        }
+        if (n == 0) break;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = vec;
+        msg.msg_iovlen = n;
+        ssize_t result = sendmsg(handle, &msg, MSG_NOSIGNAL | flags | (i < count ? MSG_MORE : 0));
+        ++*p_syscalls;
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return pcom_errno_from(errno);
+            if (flags & MSG_DONTWAIT) break;
+            struct pollfd pfd = { handle, POLLOUT, 0 };
+            if (poll(&pfd, 1, -1) < 0 && errno != EINTR) return pcom_errno_from(errno);
+            continue;
+        }
+
+        total += result;
+        size_t left = (size_t)result;
+        while (first < count && left >= PIECE_LEN(first) - skip) {
+            left -= PIECE_LEN(first) - skip;
+            ++first;
+            skip = 0;
+        }
+        skip += left;
+    }
+
+#undef PIECE_LEN
+#undef PIECE_BASE
+
+    return total;
+}
+
+/** Write the buffer of a locked connection */
+static int64_t
+flush_locked(int handle, conn_t* p_c, unsigned* p_syscalls)
+{
+    int64_t result = p_c->len ? write_out(handle, p_c->buf, p_c->len, NULL, 0, 0, p_syscalls) : 0;
+    p_c->len = 0;
+    p_c->due = 0;
+    return result;
+}
+
+static void
+timer_push(int handle, uint64_t due)
+{
+    pthread_mutex_lock(&timer_lock);
+    if (timer_count == timer_cap) {
+        size_t cap = timer_cap ? timer_cap * 2 : 64;
+        pending_t* p_new = realloc(timers, cap * sizeof(*p_new));
+        if (!p_new) { pthread_mutex_unlock(&timer_lock); return; }  // Flushed by size or call
+        timers = p_new;
+        timer_cap = cap;
+    }
+    size_t i = timer_count++;
+    while (i > 0 && timers[(i - 1) / 2].due > due) {
+        timers[i] = timers[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    timers[i].due = due;
+    timers[i].handle = handle;
+    if (due < timer_wake) pthread_cond_signal(&timer_cond);
+    pthread_mutex_unlock(&timer_lock);
+}
+
+static pending_t
+timer_pop(void)
+{
+    pending_t top = timers[0], last = timers[--timer_count];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= timer_count) break;
+        if (c + 1 < timer_count && timers[c + 1].due < timers[c].due) ++c;
+        if (timers[c].due >= last.due) break;
+        timers[i] = timers[c];
+        i = c;
+    }
+    if (timer_count) timers[i] = last;
+    return top;
+}
+
+/** Deadline flush of a locked connection. Never waits for a stalled peer
+ *  with the lock held, the rest stays buffered for another try. */
+static void
+flush_due(int handle, conn_t* p_c)
+{
+    unsigned syscalls = 0;
+    int64_t result = write_out(handle, p_c->buf, p_c->len, NULL, 0, MSG_DONTWAIT, &syscalls);
+
+    if (result >= 0 && (size_t)result < p_c->len) {
+        memmove(p_c->buf, p_c->buf + result, p_c->len - (size_t)result);
+        p_c->len -= (size_t)result;
+        p_c->due = now_ns() + (p_c->deadline_ns > STALL_NS ? p_c->deadline_ns : STALL_NS);
+        timer_push(handle, p_c->due);
+    } else {
+        if (result < 0) p_c->error = (int)result;
+        p_c->len = 0;
+        p_c->due = 0;
+    }
+    pcom_stats_io(PCOM_STATS_SEND, handle, 0, result < 0 ? result : 0, 0, syscalls, 0, 0);
+}
+
+/** Sleep on timer_cond until due on the monotonic clock, or a signal */
+static void
+wait_until(uint64_t due, uint64_t now)
+{
+    struct timespec ts;
+#if defined(__APPLE__)
+    // No monotonic condition variables, wait on the real time clock
+    clock_gettime(CLOCK_REALTIME, &ts);
+    due = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec + (due - now);
+#else
+    (void)now;
+#endif
+    ts.tv_sec = (time_t)(due / 1000000000ull);
+    ts.tv_nsec = (long)(due % 1000000000ull);
+    pthread_cond_timedwait(&timer_cond, &timer_lock, &ts);
+}
+
+/** Flushes buffers whose deadline passed, sleeps until the next one */
+static void*
+flusher_main(void* arg)
+{
+    (void)arg;
+#if defined(__linux__)
+    // Default timer slack is 50 us, as long as the deadlines themselves
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+#endif
+
+    pthread_mutex_lock(&timer_lock);
+    for (;;) {
+        if (timer_count == 0) {
+            timer_wake = UINT64_MAX;
+            pthread_cond_wait(&timer_cond, &timer_lock);
+            continue;
+        }
+        uint64_t now = now_ns();
+        if (timers[0].due > now) {
+            timer_wake = timers[0].due;
+            wait_until(timers[0].due, now);
+            continue;
+        }
+        pending_t t = timer_pop();
+        pthread_mutex_unlock(&timer_lock);
+
+        // Skip if flushed meanwhile, a refill has a timer of its own
+        conn_t* p_c = conn_get(t.handle, 0);
+        if (p_c) {
+            pthread_mutex_lock(&p_c->lock);
+            if (p_c->due == t.due && p_c->len) flush_due(t.handle, p_c);
+            pthread_mutex_unlock(&p_c->lock);
+        }
+        pthread_mutex_lock(&timer_lock);
+    }
+    return NULL;
+}
+
+static void
+flusher_start(void)
+{
+    pthread_condattr_t attr;
+    pthread_t tid;
+
+    pthread_condattr_init(&attr);
+#if !defined(__APPLE__)
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+#endif
+    pthread_cond_init(&timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&tid, NULL, flusher_main, NULL) == 0) {
+        pthread_detach(tid);
+        flusher_ok = 1;
+    }
+}
+
+#endif
+
+/* ---- Hooks ------------------------------------------------------------- */
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+int
+pcom_coalesce_on(int handle)
+{
+    if (__builtin_expect(__atomic_load_n(&conns_on, __ATOMIC_RELAXED) == 0, 1)) return 0;
+    conn_t* p_c = conn_get(handle, 0);
+    return p_c && __atomic_load_n(&p_c->on, __ATOMIC_ACQUIRE);
+}
+
+int64_t
+pcom_coalesce_send(int handle, const pcom_iovec_t* iov, int count, unsigned* p_syscalls)
+{
+    conn_t* p_c = conn_get(handle, 0);
+    size_t total = 0;
+    int64_t result;
+
+    if (!p_c) return -EBADF;
+    for (int i = 0; i < count; ++i) total += iov[i].len;
+
+    pthread_mutex_lock(&p_c->lock);
+    if (p_c->error) {
+        result = p_c->error;
+        p_c->error = 0;
+    } else if (!p_c->on) {
+        // Disabled since pcom_coalesce_on(), write through
+        result = write_out(handle, NULL, 0, iov, count, 0, p_syscalls);
+    } else if (p_c->len + total < p_c->threshold) {
+        int armed = p_c->len != 0;
+        for (int i = 0; i < count; ++i) {
+            memcpy(p_c->buf + p_c->len, iov[i].base, iov[i].len);
+            p_c->len += iov[i].len;
+        }
+        if (!armed && total && p_c->deadline_ns) {
+            p_c->due = now_ns() + p_c->deadline_ns;
+            timer_push(handle, p_c->due);
+        }
+        result = (int64_t)total;
+    } else {
+        // Full: buffer and message in one gathered write
+        result = write_out(handle, p_c->buf, p_c->len, iov, count, 0, p_syscalls);
+        p_c->len = 0;
+        p_c->due = 0;
+    }
+    pthread_mutex_unlock(&p_c->lock);
+
+    return result < 0 ? result : (int64_t)total;
+}
+
+void
+pcom_coalesce_close(int handle)
+{
+    if (pcom_coalesce_on(handle)) pcom_coalesce_disable(handle);
+}
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_coalesce_enable(int handle, size_t threshold, unsigned deadline_us)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    int type;
+    socklen_t len = sizeof(type);
+    unsigned syscalls = 0;
+
+    if (threshold == 0) return pcom_coalesce_disable(handle);
+    if (getsockopt(handle, SOL_SOCKET, SO_TYPE, &type, &len) < 0) return pcom_errno_from(errno);
+    if (type != SOCK_STREAM) return -EPROTOTYPE;
+    if (deadline_us) {
+        pthread_once(&flusher_once, flusher_start);
+        if (!flusher_ok) return -EAGAIN;
+    }
+    conn_t* p_c = conn_get(handle, 1);
+    if (!p_c) return -ENOMEM;
+
+    pthread_mutex_lock(&p_c->lock);
+    int64_t result = flush_locked(handle, p_c, &syscalls);
+    p_c->error = 0;
+    if (result >= 0 && threshold != p_c->threshold) {
+        char* p_buf = realloc(p_c->buf, threshold);
+        if (p_buf) { p_c->buf = p_buf; p_c->threshold = threshold; }
+        else result = -ENOMEM;
+    }
+    if (result >= 0) {
+        p_c->deadline_ns = (uint64_t)deadline_us * 1000u;
+        if (!p_c->on) {
+            __atomic_store_n(&p_c->on, 1, __ATOMIC_RELEASE);
+            __atomic_fetch_add(&conns_on, 1, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&p_c->lock);
+    if (syscalls) pcom_stats_io(PCOM_STATS_SEND, handle, 0, result < 0 ? result : 0, 0, syscalls, 0, 0);
+    return result < 0 ? (int)result : 0;
+
+#else
+    (void)handle; (void)threshold; (void)deadline_us;
+    return -1;
+#endif
+}
+
+int
+pcom_coalesce_disable(int handle)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    conn_t* p_c = conn_get(handle, 0);
+    unsigned syscalls = 0;
+    int64_t result = 0;
+
+    if (!p_c) return 0;
+    pthread_mutex_lock(&p_c->lock);
+    if (p_c->on) {
+        result = p_c->error ? p_c->error : flush_locked(handle, p_c, &syscalls);
+        __atomic_store_n(&p_c->on, 0, __ATOMIC_RELEASE);
+        __atomic_fetch_sub(&conns_on, 1, __ATOMIC_RELAXED);
+        free(p_c->buf);
+        p_c->buf = NULL;
+        p_c->len = 0;
+        p_c->due = 0;
+        p_c->threshold = 0;
+        p_c->error = 0;
+    }
+    pthread_mutex_unlock(&p_c->lock);
+    if (syscalls) pcom_stats_io(PCOM_STATS_SEND, handle, 0, result < 0 ? result : 0, 0, syscalls, 0, 0);
+    return result < 0 ? (int)result : 0;
+
+#else
+    (void)handle;
+    return -1;
+#endif
+}
+
+int64_t
+pcom_flush(int handle)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (!pcom_coalesce_on(handle)) return 0;
+
+    conn_t* p_c = conn_get(handle, 0);
+    uint64_t t0 = pcom_stats_clock();
+    unsigned syscalls = 0;
+    int64_t result;
+
+    pthread_mutex_lock(&p_c->lock);
+    if (p_c->error) {
+        result = p_c->error;
+        p_c->error = 0;
+    } else {
+        result = flush_locked(handle, p_c, &syscalls);
+    }
+    pthread_mutex_unlock(&p_c->lock);
+    if (syscalls || result < 0)
+        pcom_stats_io(PCOM_STATS_SEND, handle, t0, result < 0 ? result : 0, 0, syscalls, 0, 0);
+    return result;
+
+#else
+    (void)handle;
+    return -1;
+#endif
+}
@@ -0,0 +1,111 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_coalesce.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Write coalescing for small messages.
+ ****************************************************************************/
+/** @defgroup  PCOM_COALESCE
+ * @brief     Per connection output buffer, flushed by size, deadline or call.
+ * @details   A connection with coalescing enabled does not write on every
+ *            pcom_server_send(), pcom_client_send(), pcom_sendv() or
+ *            pcom_frame_send(). The message is copied to an output buffer
+ *            and the buffer goes out in one write when
+ *
+ *            - the next message would fill it to the threshold: buffer and
+ *              message leave together in one gathered write, no copy,
+ *            - deadline_us have passed since the first byte was buffered: a
+ *              background thread flushes it,
+ *            - pcom_flush() is called.
+ *
+ *            Senders of many small messages trade at most deadline_us of
+ *            latency for a write per threshold bytes instead of one per
+ *            message:
+ *
+ *                pcom_coalesce_enable(handle, 16384, 100);   // 100 us
+ *                for (...) pcom_frame_send(handle, &hdr, payload);
+ *                pcom_flush(handle);     // end of burst, don't wait
+ *
+ *            Flushes that need more than one syscall pass MSG_MORE on all
+ *            but the last, so TCP does not push a partial segment between
+ *            them. Statistics count the messages when they are queued and
+ *            the system calls when they are made.
+ *
+ * @pre       pcom.h, pthreads
+ * @bug       -
+ * @warning   Stream handles only. Not for handles in a pcom_loop, which
+ *            writes on its own. Sends return the whole length once queued;
+ *            an error of a deadline flush is returned by the next send or
+ *            pcom_flush() on the handle. Not available on Windows.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_COALESCE_H
+#define PCOM_COALESCE_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for int64_t
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Enable or change coalescing on a handle.
+ * @param      handle       Connected stream handle.
+ * @param      threshold    Buffer size in bytes, 0 disables coalescing.
+ * @param      deadline_us  Longest time bytes wait in the buffer, 0 for no
+ *                          deadline: only the threshold and pcom_flush().
+ * @return     0 on success, -EPROTOTYPE for non-stream handles, negative
+ *             error code on failure.
+ * @details    Buffered bytes are flushed first when the settings change.
+ */
+LIB_EXPORT int
+pcom_coalesce_enable(int handle, size_t threshold, unsigned deadline_us);
+
+/**
+ * @brief      Flush and disable coalescing on a handle.
+ * @param      handle  Connected stream handle.
+ * @return     0 on success, negative error code if the flush failed.
+ * @details    pcom_client_close() does this before closing.
+ */
+LIB_EXPORT int
+pcom_coalesce_disable(int handle);
+
+/**
+ * @brief      Write out the buffered bytes of a handle now.
+ * @param      handle  Connected stream handle.
+ * @return     Bytes written, 0 if none were buffered or coalescing is off,
+ *             negative error code on failure.
+ * @details    Blocks until all are written, like pcom_send_all().
+ */
+LIB_EXPORT int64_t
+pcom_flush(int handle);
+
+/* ---- Hooks for the PCOM modules ---------------------------------------- */
+
+/** True if sends on the handle go through the coalescing buffer */
+int
+pcom_coalesce_on(int handle);
+
+/** Queue or write iov, returns the bytes of iov or an error, counts syscalls */
+int64_t
+pcom_coalesce_send(int handle, const pcom_iovec_t* iov, int count, unsigned* p_syscalls);
+
+/** Flush and disable before the handle is closed */
+void
+pcom_coalesce_close(int handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_COALESCE_H
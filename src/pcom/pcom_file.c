@@ -0,0 +1,270 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_file.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     File transfer over PCOM handles without user space copies.
+ ****************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <sys/sendfile.h>
+#endif
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
+#include <errno.h>
+
+#include "pcom_file.h"
+#include "pcom_coalesce.h"
+#include "pcom_stats.h"
+#include "pcom_trace.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+#define SENDFILE_MAX (1u << 30)   // Bytes per sendfile() call
+
+/* Counters of one transfer for the statistics */
+typedef struct {
+    unsigned syscalls;
+    unsigned eagain;
+} io_t;
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+/** Wait for handle after EAGAIN, 0 or negative error code */
+static int
+wait_ready(int handle, short events, io_t* p_io)
+{
+    struct pollfd pfd = { .fd = handle, .events = events };
+    ++p_io->eagain;
+    while (poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR) return pcom_errno_from(errno);
+    }
+    return 0;
+}
+
+/** Write all of buf to fd, at *p_off if not NULL, to sockets without SIGPIPE */
+static int64_t
+write_full(int fd, const char* buf, size_t len, off_t* p_off, int is_socket, io_t* p_io)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t result = is_socket ? send(fd, buf + done, len - done, MSG_NOSIGNAL) :
+                         p_off ? pwrite(fd, buf + done, len - done, *p_off) :
+                         write(fd, buf + done, len - done);
+        ++p_io->syscalls;
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return pcom_errno_from(errno);
+            int wait = wait_ready(fd, POLLOUT, p_io);
+            if (wait < 0) return wait;
+            continue;
+        }
+        done += (size_t)result;
+        if (p_off) *p_off += result;
+    }
+    return (int64_t)done;
+}
+
+/**
+ * Copy up to len bytes from src to dst through a buffer, reading and writing
+ * at *p_src_off and *p_dst_off where not NULL. Returns the bytes copied,
+ * short at EOF of src.
+ */
+static int64_t
+copy_buffered(int src, off_t* p_src_off, int dst, off_t* p_dst_off, int dst_socket,
+              size_t len, io_t* p_io)
+{
+    size_t size = len < PCOM_FILE_CHUNK ? len : PCOM_FILE_CHUNK;
+    char* buf = malloc(size ? size : 1);
+    int64_t done = 0;
+
+    if (!buf) return -ENOMEM;
+    while ((size_t)done < len) {
+        size_t want = len - (size_t)done < size ? len - (size_t)done : size;
+        ssize_t got = p_src_off ? pread(src, buf, want, *p_src_off) : read(src, buf, want);
+        ++p_io->syscalls;
+        if (got == 0) break;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                int wait = wait_ready(src, POLLIN, p_io);
+                if (wait < 0) { done = wait; break; }
+                continue;
+            }
+            done = pcom_errno_from(errno);
+            break;
+        }
+        if (p_src_off) *p_src_off += got;
+        int64_t result = write_full(dst, buf, (size_t)got, p_dst_off, dst_socket, p_io);
+        if (result < 0) { done = result; break; }
+        done += got;
+    }
+    free(buf);
+    return done;
+}
+
+#if defined(__linux__)
+
+/** Move the n bytes in the pipe into the file, by copy if splice refuses */
+static int64_t
+pipe_to_file(int pipe_rd, int fd, size_t n, off_t* p_off, int* p_fallback, io_t* p_io)
+{
+    size_t done = 0;
+    while (done < n) {
+        ssize_t result = *p_fallback ? -1 : splice(pipe_rd, NULL, fd, p_off, n - done, SPLICE_F_MOVE);
+        if (!*p_fallback) ++p_io->syscalls;
+        if (result < 0 && !*p_fallback) {
+            if (errno == EINTR) continue;
+            if (errno != EINVAL) return pcom_errno_from(errno);
+            *p_fallback = 1;
+        }
+        if (*p_fallback) {
+            // O_APPEND files and the like, copy what is in the pipe
+            result = copy_buffered(pipe_rd, NULL, fd, p_off, 0, n - done, p_io);
+            if (result < 0) return result;
+            if ((size_t)result < n - done) return -EIO;
+        }
+        done += (size_t)result;
+    }
+    return (int64_t)done;
+}
+
+#endif
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+int64_t
+pcom_send_file(int handle, int fd, int64_t offset, size_t len)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    off_t off = (off_t)offset;
+    off_t* p_off = (offset >= 0) ? &off : NULL;
+    io_t io = { 0, 0 };
+    int64_t sent = 0;
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+
+    if (offset < -1) return -EINVAL;
+    // Buffered bytes go first
+    if (pcom_coalesce_on(handle)) {
+        sent = pcom_flush(handle);
+        if (sent < 0) return sent;
+        sent = 0;
+    }
+
+#if defined(__linux__)
+    while ((size_t)sent < len) {
+        size_t chunk = len - (size_t)sent < SENDFILE_MAX ? len - (size_t)sent : SENDFILE_MAX;
+        ssize_t result = sendfile(handle, fd, p_off, chunk);
+        ++io.syscalls;
+        if (result == 0) break;
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                int wait = wait_ready(handle, POLLOUT, &io);
+                if (wait < 0) { sent = wait; break; }
+                continue;
+            }
+            // No page cache behind fd, copy the rest
+            if (errno == EINVAL || errno == ENOSYS) {
+                int64_t rest = copy_buffered(fd, p_off, handle, NULL, 1, len - (size_t)sent, &io);
+                sent = (rest < 0) ? rest : sent + rest;
+            } else {
+                sent = pcom_errno_from(errno);
+            }
+            break;
+        }
+        sent += result;
+    }
+#else
+    sent = copy_buffered(fd, p_off, handle, NULL, 1, len, &io);
+#endif
+
+    pcom_stats_io(PCOM_STATS_SEND, handle, t0, sent, sent > 0, io.syscalls, io.eagain, 0);
+    pcom_trace_end(tr, PCOM_TRACE_SEND, handle, sent, len);
+    return sent;
+
+#else
+    (void)handle; (void)fd; (void)offset; (void)len;
+    return -1;
+#endif
+}
+
+int64_t
+pcom_recv_to_file(int handle, int fd, int64_t offset, size_t len)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    off_t off = (off_t)offset;
+    off_t* p_off = (offset >= 0) ? &off : NULL;
+    io_t io = { 0, 0 };
+    int64_t got = 0;
+    uint64_t t0 = pcom_stats_clock();
+    uint64_t tr = pcom_trace_begin();
+
+    if (offset < -1) return -EINVAL;
+
+#if defined(__linux__)
+    int pipefd[2], fallback = 0;
+    if (pipe2(pipefd, O_CLOEXEC) < 0) return pcom_errno_from(errno);
+    fcntl(pipefd[1], F_SETPIPE_SZ, PCOM_FILE_CHUNK);   // Best effort, 64 KiB otherwise
+
+    // Socket to pipe to file, the pages are moved, not copied
+    while ((size_t)got < len && !fallback) {
+        size_t chunk = len - (size_t)got < PCOM_FILE_CHUNK ? len - (size_t)got : PCOM_FILE_CHUNK;
+        ssize_t in = splice(handle, NULL, pipefd[1], NULL, chunk, SPLICE_F_MOVE);
+        ++io.syscalls;
+        if (in == 0) break;
+        if (in < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                int wait = wait_ready(handle, POLLIN, &io);
+                if (wait < 0) { got = wait; break; }
+                continue;
+            }
+            if (errno == EINVAL) { fallback = 1; break; }
+            got = pcom_errno_from(errno);
+            break;
+        }
+        int64_t out = pipe_to_file(pipefd[0], fd, (size_t)in, p_off, &fallback, &io);
+        if (out < 0) { got = out; break; }
+        got += out;
+    }
+    close(pipefd[0]);
+    close(pipefd[1]);
+    if (fallback && got >= 0 && (size_t)got < len) {
+        int64_t rest = copy_buffered(handle, NULL, fd, p_off, 0, len - (size_t)got, &io);
+        got = (rest < 0) ? rest : got + rest;
+    }
+#else
+    got = copy_buffered(handle, NULL, fd, p_off, 0, len, &io);
+#endif
+
+    pcom_stats_io(PCOM_STATS_RECV, handle, t0, got, got > 0, io.syscalls, io.eagain, 0);
+    pcom_trace_end(tr, PCOM_TRACE_RECV, handle, got, len);
+    return got;
+
+#else
+    (void)handle; (void)fd; (void)offset; (void)len;
+    return -1;
+#endif
+}
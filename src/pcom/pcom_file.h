@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_file.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     File transfer over PCOM handles without user space copies.
+ ****************************************************************************/
+/** @defgroup  PCOM_FILE
+ * @brief     Stream file ranges to and from PCOM handles in the kernel.
+ * @details   pcom_send_file() moves a file range to a handle with sendfile(),
+ *            the page cache feeding the socket directly. pcom_recv_to_file()
+ *            splices from the handle through a pipe into the file. Neither
+ *            copies the bytes through user memory:
+ *
+ *                // Server                          // Client
+ *                pcom_send_file(h, fd, 0, size);    pcom_recv_to_file(h, fd, 0, size);
+ *
+ *            Both resume short transfers, retry on EINTR and wait on EAGAIN
+ *            like pcom_send_all() and pcom_recv_exact(). Where the kernel
+ *            refuses a file (sendfile() from files without page cache,
+ *            splice() into O_APPEND files) and on other systems they fall
+ *            back to read and write through a bounded buffer.
+ *
+ * @pre       pcom.h
+ * @bug       -
+ * @warning   The length must be agreed beforehand, e.g. in a frame: the
+ *            receiver cannot tell file bytes from what follows on the
+ *            stream. Buffered bytes of a coalescing handle are flushed
+ *            first, see pcom_coalesce.h. Not available on Windows.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_FILE_H
+#define PCOM_FILE_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for int64_t
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_FILE_CHUNK (1024 * 1024)  // Pipe size, and buffer size of the fallback
+
+/**
+ * @brief      Send a range of a file.
+ * @param      handle  Connected stream handle.
+ * @param      fd      File open for reading.
+ * @param      offset  Start in the file, -1 for the file position, which
+ *                     is then advanced.
+ * @param      len     Bytes to send.
+ * @return     Bytes sent, fewer than len if the file ends first, negative
+ *             error code on failure.
+ */
+LIB_EXPORT int64_t
+pcom_send_file(int handle, int fd, int64_t offset, size_t len);
+
+/**
+ * @brief      Receive bytes into a file.
+ * @param      handle  Connected stream handle.
+ * @param      fd      File open for writing.
+ * @param      offset  Start in the file, -1 for the file position, which
+ *                     is then advanced.
+ * @param      len     Bytes to receive.
+ * @return     Bytes written, fewer than len if the peer closed first,
+ *             negative error code on failure.
+ */
+LIB_EXPORT int64_t
+pcom_recv_to_file(int handle, int fd, int64_t offset, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_FILE_H
@@ -0,0 +1,421 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_flow.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Credit based flow control for framed PCOM connections.
+ ****************************************************************************/
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#include <poll.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include "pcom_flow.h"
+
+#if defined(__linux__)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define FLOW_READ_CHUNK  (64 * 1024)
+#define FLOW_CREDIT_LEN  (4)         // Credit payload, u32 little endian
+#define FLOW_ADVERTISE   (1)         // Credit frame flag: initial window
+
+struct pcom_flow {
+    int handle;
+    size_t window;            // Our receive window
+    size_t queue_max;
+    size_t peer_window;       // Peer's advertised window, 0 until known
+    unsigned long long credit;  // Payload bytes we may still send
+    long long rx_credit;      // Payload bytes the peer may still send us
+    size_t consumed;          // Consumed by the application, not yet granted
+    size_t last_len;          // Payload of the frame returned last
+
+    pcom_frame_reader_t reader;
+    size_t scanned;           // Bytes after reader.start already accounted
+    uint8_t* rbuf;            // Receive chunk
+
+    uint8_t* out;             // Send queue of encoded frames
+    size_t out_start;         // First unsent byte
+    size_t out_charged;       // End of frames already charged to credit
+    size_t out_len;           // End of queued data
+    size_t out_cap;
+
+    pcom_flow_stats_t stats;
+};
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static long long
+now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int
+remaining_ms(long long deadline)
+{
+    if (deadline < 0) return -1;
+    long long left = deadline - now_ms();
+    return left > 0 ? (int)left : 0;
+}
+
+/* Insert bytes into the send queue at pos, growing it as needed */
+static int
+out_insert(pcom_flow_t* p_f, size_t pos, const void* a, size_t a_len, const void* b, size_t b_len)
+{
+    size_t add = a_len + b_len;
+
+    if (p_f->out_start > 0 && p_f->out_cap - p_f->out_len < add) {
+        memmove(p_f->out, p_f->out + p_f->out_start, p_f->out_len - p_f->out_start);
+        pos -= p_f->out_start;
+        p_f->out_charged -= p_f->out_start;
+        p_f->out_len -= p_f->out_start;
+        p_f->out_start = 0;
+    }
+    if (p_f->out_cap - p_f->out_len < add) {
+        size_t cap = p_f->out_cap ? p_f->out_cap : 4096;
+        while (cap - p_f->out_len < add) cap *= 2;
+        uint8_t* p = realloc(p_f->out, cap);
+        if (!p) return -ENOMEM;
+        p_f->out = p;
+        p_f->out_cap = cap;
+    }
+    memmove(p_f->out + pos + add, p_f->out + pos, p_f->out_len - pos);
+    memcpy(p_f->out + pos, a, a_len);
+    if (b_len) memcpy(p_f->out + pos + a_len, b, b_len);
+    p_f->out_len += add;
+    return 0;
+}
+
+/* Charge queued frames to credit, in order, and write what is charged */
+static int
+out_flush(pcom_flow_t* p_f)
+{
+    while (p_f->out_charged < p_f->out_len) {
+        pcom_frame_hdr_t hdr;
+        pcom_frame_decode(p_f->out + p_f->out_charged, &hdr);
+        if (hdr.type != PCOM_FRAME_CREDIT) {
+            if (hdr.len > p_f->credit) break;
+            p_f->credit -= hdr.len;
+        }
+        p_f->out_charged += PCOM_FRAME_HDR_SIZE + hdr.len;
+    }
+
+    while (p_f->out_start < p_f->out_charged) {
+        ssize_t result = send(p_f->handle, p_f->out + p_f->out_start, p_f->out_charged - p_f->out_start,
+                              MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return pcom_errno_from(errno);
+        }
+        p_f->out_start += (size_t)result;
+    }
+    if (p_f->out_start == p_f->out_len) p_f->out_start = p_f->out_charged = p_f->out_len = 0;
+    return 0;
+}
+
+/* Drop queued frames larger than the window the peer advertised, they could
+ * never get the credit. Only frames not yet charged are looked at. */
+static int
+out_drop_oversized(pcom_flow_t* p_f)
+{
+    size_t pos = p_f->out_charged;
+    int dropped = 0;
+
+    while (pos < p_f->out_len) {
+        pcom_frame_hdr_t hdr;
+        pcom_frame_decode(p_f->out + pos, &hdr);
+        size_t size = PCOM_FRAME_HDR_SIZE + hdr.len;
+        if (hdr.len <= p_f->peer_window) {
+            pos += size;
+            continue;
+        }
+        memmove(p_f->out + pos, p_f->out + pos + size, p_f->out_len - pos - size);
+        p_f->out_len -= size;
+        ++dropped;
+    }
+    return dropped;
+}
+
+/* Queue a credit frame ahead of frames still waiting for credit */
+static int
+send_credit(pcom_flow_t* p_f, uint32_t amount, uint8_t flags)
+{
+    uint8_t hdr[PCOM_FRAME_HDR_SIZE], body[FLOW_CREDIT_LEN];
+    pcom_frame_hdr_t h = { FLOW_CREDIT_LEN, PCOM_FRAME_CREDIT, flags, 0 };
+
+    pcom_frame_encode(hdr, &h);
+    for (int i = 0; i < FLOW_CREDIT_LEN; ++i) body[i] = (uint8_t)(amount >> (8 * i));
+    int result = out_insert(p_f, p_f->out_charged, hdr, sizeof(hdr), body, sizeof(body));
+    if (result < 0) return result;
+    p_f->out_charged += sizeof(hdr) + sizeof(body);
+    p_f->rx_credit += amount;
+    p_f->stats.granted += amount;
+    return out_flush(p_f);
+}
+
+/* Give back what the application has consumed */
+static int
+grant(pcom_flow_t* p_f)
+{
+    int result = send_credit(p_f, (uint32_t)p_f->consumed, 0);
+    if (result == 0) p_f->consumed = 0;
+    return result;
+}
+
+/* Account frames as they arrive: take credit, police the peer's window */
+static int
+scan_frames(pcom_flow_t* p_f)
+{
+    pcom_frame_reader_t* p_r = &p_f->reader;
+    int credited = 0, dropped = 0;
+
+    while (p_r->len - p_r->start - p_f->scanned >= PCOM_FRAME_HDR_SIZE) {
+        const uint8_t* p = p_r->buf + p_r->start + p_f->scanned;
+        pcom_frame_hdr_t hdr;
+        pcom_frame_decode(p, &hdr);
+        if (hdr.len > PCOM_FRAME_MAX) return -EMSGSIZE;
+        if (p_r->len - p_r->start - p_f->scanned < PCOM_FRAME_HDR_SIZE + (size_t)hdr.len) break;
+
+        if (hdr.type == PCOM_FRAME_CREDIT) {
+            if (hdr.len != FLOW_CREDIT_LEN) return -EPROTO;
+            p += PCOM_FRAME_HDR_SIZE;
+            uint32_t amount = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+            p_f->credit += amount;
+            if (hdr.flags & FLOW_ADVERTISE) {
+                p_f->peer_window = amount;
+                dropped += out_drop_oversized(p_f);
+            }
+            credited = 1;
+        } else {
+            p_f->rx_credit -= hdr.len;
+            if (p_f->rx_credit < 0) return -EPROTO;
+        }
+        p_f->scanned += PCOM_FRAME_HDR_SIZE + hdr.len;
+    }
+    int result = credited ? out_flush(p_f) : 0;
+    return (result == 0 && dropped) ? -EMSGSIZE : result;
+}
+
+/* Wait for input, or for socket space while charged data is queued */
+static int
+wait_io(pcom_flow_t* p_f, long long deadline)
+{
+    struct pollfd pfd = { .fd = p_f->handle, .events = POLLIN };
+    if (p_f->out_start < p_f->out_charged) pfd.events |= POLLOUT;
+
+    int result = poll(&pfd, 1, remaining_ms(deadline));
+    if (result < 0) return errno == EINTR ? 0 : pcom_errno_from(errno);
+    if (result == 0) return -ETIMEDOUT;
+
+    if (pfd.revents & POLLOUT) {
+        result = out_flush(p_f);
+        if (result < 0) return result;
+    }
+    if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+        ssize_t len = recv(p_f->handle, p_f->rbuf, FLOW_READ_CHUNK, MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return pcom_errno_from(errno);
+        }
+        if (len == 0) return 1;
+        result = pcom_frame_reader_feed(&p_f->reader, p_f->rbuf, (size_t)len);
+        if (result < 0) return result;
+        return scan_frames(p_f);
+    }
+    return 0;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_flow_create(pcom_flow_t** pp_flow, int handle, const pcom_flow_opts_t* p_opts)
+{
+    int result;
+
+    if (!pp_flow || handle < 0) return -EINVAL;
+    *pp_flow = NULL;
+
+    pcom_flow_t* p_f = calloc(1, sizeof(*p_f));
+    if (!p_f) return -ENOMEM;
+    p_f->handle = handle;
+    p_f->window = (p_opts && p_opts->window) ? p_opts->window : PCOM_FLOW_WINDOW;
+    p_f->queue_max = (p_opts && p_opts->queue_max) ? p_opts->queue_max : PCOM_FLOW_QUEUE_MAX;
+    if (p_f->window > UINT32_MAX / 2) p_f->window = UINT32_MAX / 2;
+    pcom_frame_reader_init(&p_f->reader);
+
+    if (p_opts && (p_opts->sndbuf || p_opts->rcvbuf)) {
+        result = pcom_set_bufsize(handle, p_opts->sndbuf, p_opts->rcvbuf);
+        if (result < 0) goto fail;
+    }
+    if (!(p_f->rbuf = malloc(FLOW_READ_CHUNK))) {
+        result = -ENOMEM;
+        goto fail;
+    }
+    result = send_credit(p_f, (uint32_t)p_f->window, FLOW_ADVERTISE);
+    if (result < 0) goto fail;
+
+    *pp_flow = p_f;
+    return 0;
+
+fail:
+    pcom_flow_destroy(p_f);
+    return result;
+}
+
+int
+pcom_flow_send(pcom_flow_t* p_flow, const pcom_frame_hdr_t* p_hdr, const void* payload)
+{
+    uint8_t hdr[PCOM_FRAME_HDR_SIZE];
+
+    if (!p_flow || !p_hdr || (!payload && p_hdr->len)) return -EINVAL;
+    if (p_hdr->type == PCOM_FRAME_CREDIT) return -EINVAL;
+    if (p_hdr->len > PCOM_FRAME_MAX || p_hdr->len > p_flow->queue_max ||
+        (p_flow->peer_window && p_hdr->len > p_flow->peer_window)) return -EMSGSIZE;
+    pcom_frame_encode(hdr, p_hdr);
+
+    // Nothing queued and credit left: straight out, queue only the remainder
+    if (p_flow->out_len == 0 && p_hdr->len <= p_flow->credit) {
+        struct iovec iov[2] = { { hdr, sizeof(hdr) }, { (void*)payload, p_hdr->len } };
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+        ssize_t sent;
+        while ((sent = sendmsg(p_flow->handle, &msg, MSG_DONTWAIT | MSG_NOSIGNAL)) < 0 && errno == EINTR) {}
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return pcom_errno_from(errno);
+            sent = 0;
+        }
+        p_flow->credit -= p_hdr->len;
+        if ((size_t)sent == sizeof(hdr) + p_hdr->len) return 0;
+
+        int result = (size_t)sent < sizeof(hdr)
+            ? out_insert(p_flow, 0, hdr + sent, sizeof(hdr) - (size_t)sent, payload, p_hdr->len)
+            : out_insert(p_flow, 0, (const uint8_t*)payload + (sent - sizeof(hdr)),
+                         p_hdr->len - ((size_t)sent - sizeof(hdr)), NULL, 0);
+        if (result < 0) return result;
+        p_flow->out_charged = p_flow->out_len;
+        p_flow->stats.would_block++;
+        return PCOM_FLOW_WOULD_BLOCK;
+    }
+
+    if (p_flow->out_len - p_flow->out_start + sizeof(hdr) + p_hdr->len > p_flow->queue_max) {
+        p_flow->stats.queue_full++;
+        return -ENOBUFS;
+    }
+    int result = out_insert(p_flow, p_flow->out_len, hdr, sizeof(hdr), payload, p_hdr->len);
+    if (result < 0) return result;
+    result = out_flush(p_flow);
+    if (result < 0) return result;
+    if (p_flow->out_len == 0) return 0;
+    p_flow->stats.would_block++;
+    return PCOM_FLOW_WOULD_BLOCK;
+}
+
+int
+pcom_flow_recv(pcom_flow_t* p_flow, pcom_frame_hdr_t* p_hdr, const void** p_payload, int timeout_ms)
+{
+    long long deadline = timeout_ms < 0 ? -1 : now_ms() + timeout_ms;
+    int result;
+
+    if (!p_flow || !p_hdr || !p_payload) return -EINVAL;
+
+    // The previous frame is consumed, grant once half the window is
+    p_flow->consumed += p_flow->last_len;
+    p_flow->last_len = 0;
+    if (p_flow->consumed >= p_flow->window / 2 && (result = grant(p_flow)) < 0) return result;
+
+    for (;;) {
+        while (p_flow->scanned > 0) {
+            result = pcom_frame_reader_next(&p_flow->reader, p_hdr, p_payload);
+            if (result <= 0) return result < 0 ? result : -EPROTO;
+            p_flow->scanned -= PCOM_FRAME_HDR_SIZE + p_hdr->len;
+            if (p_hdr->type == PCOM_FRAME_CREDIT) continue;
+            p_flow->last_len = p_hdr->len;
+            return 1;
+        }
+        // Drained, grant the rest before waiting so a large frame can come
+        if (p_flow->consumed && (result = grant(p_flow)) < 0) return result;
+        result = wait_io(p_flow, deadline);
+        if (result < 0) return result;
+        if (result == 1)
+            return p_flow->reader.len == p_flow->reader.start ? 0 : -EPIPE;
+    }
+}
+
+int
+pcom_flow_flush(pcom_flow_t* p_flow, int timeout_ms)
+{
+    long long deadline = timeout_ms < 0 ? -1 : now_ms() + timeout_ms;
+    int result;
+
+    if (!p_flow) return -EINVAL;
+    result = out_flush(p_flow);
+    while (result >= 0 && p_flow->out_len > 0) {
+        result = wait_io(p_flow, deadline);
+        if (result == 1) result = -EPIPE;
+    }
+    return result < 0 ? result : 0;
+}
+
+size_t
+pcom_flow_pending(const pcom_flow_t* p_flow)
+{
+    return p_flow ? p_flow->out_len - p_flow->out_start : 0;
+}
+
+int
+pcom_flow_stats(const pcom_flow_t* p_flow, pcom_flow_stats_t* p_stats)
+{
+    int unsent = 0;
+
+    if (!p_flow || !p_stats) return -EINVAL;
+    *p_stats = p_flow->stats;
+    p_stats->credit = p_flow->credit;
+    p_stats->queued = p_flow->out_len - p_flow->out_start;
+    if (ioctl(p_flow->handle, SIOCOUTQ, &unsent) == 0 && unsent > 0)
+        p_stats->unsent = (unsigned long long)unsent;
+    return 0;
+}
+
+void
+pcom_flow_destroy(pcom_flow_t* p_flow)
+{
+    if (!p_flow) return;
+    pcom_frame_reader_free(&p_flow->reader);
+    free(p_flow->rbuf);
+    free(p_flow->out);
+    free(p_flow);
+}
+
+#else /* Not supported platforms */
+
+int pcom_flow_create(pcom_flow_t** pp_flow, int handle, const pcom_flow_opts_t* p_opts)
+    { (void)handle; (void)p_opts; if (pp_flow) *pp_flow = NULL; return -1; }
+int pcom_flow_send(pcom_flow_t* p_flow, const pcom_frame_hdr_t* p_hdr, const void* payload)
+    { (void)p_flow; (void)p_hdr; (void)payload; return -1; }
+int pcom_flow_recv(pcom_flow_t* p_flow, pcom_frame_hdr_t* p_hdr, const void** p_payload, int timeout_ms)
+    { (void)p_flow; (void)p_hdr; (void)p_payload; (void)timeout_ms; return -1; }
+int pcom_flow_flush(pcom_flow_t* p_flow, int timeout_ms) { (void)p_flow; (void)timeout_ms; return -1; }
+size_t pcom_flow_pending(const pcom_flow_t* p_flow) { (void)p_flow; return 0; }
+int pcom_flow_stats(const pcom_flow_t* p_flow, pcom_flow_stats_t* p_stats)
+    { (void)p_flow; (void)p_stats; return -1; }
+void pcom_flow_destroy(pcom_flow_t* p_flow) { (void)p_flow; }
+
+#endif
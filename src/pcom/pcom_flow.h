@@ -0,0 +1,154 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_flow.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Credit based flow control for framed PCOM connections.
+ ****************************************************************************/
+/** @defgroup  PCOM_FLOW
+ * @brief     Bounded, non-blocking frame sending with receiver credit.
+ * @details   Both ends of a connection wrap it in a pcom_flow_t. Each end
+ *            advertises a receive window, in payload bytes, with a
+ *            PCOM_FRAME_CREDIT frame and grants more as the application
+ *            consumes received frames. A sender never has more unconsumed
+ *            payload outstanding than the peer granted, so a slow consumer
+ *            cannot make the peer buffer without limit.
+ *
+ *            pcom_flow_send() never blocks. A frame that has credit and
+ *            socket space is written at once. Otherwise it is copied to a
+ *            send queue bounded by queue_max and PCOM_FLOW_WOULD_BLOCK is
+ *            returned, telling the producer to slow down. When the queue is
+ *            full the frame is refused with -ENOBUFS. Queued frames leave as
+ *            credit arrives, during pcom_flow_recv() or pcom_flow_flush().
+ *
+ *            Frames of other types than PCOM_FRAME_CREDIT are passed through
+ *            and count against the window. The handle stays blocking for
+ *            other users; pcom_flow uses non-blocking calls per operation.
+ *
+ * @pre       pcom.h, pcom_frame.h
+ * @bug       -
+ * @warning   Linux only. A pcom_flow_t is used by one thread at a time. An
+ *            end that only sends must still call pcom_flow_flush() or
+ *            pcom_flow_recv() to see credit.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_FLOW_H
+#define PCOM_FLOW_H
+
+#include <stddef.h>  // for size_t
+
+#include "pcom.h"
+#include "pcom_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_FLOW_WINDOW    (256 * 1024)   // Default receive window
+#define PCOM_FLOW_QUEUE_MAX (1024 * 1024)  // Default send queue limit
+
+#define PCOM_FLOW_WOULD_BLOCK (1)  // pcom_flow_send(): accepted but queued
+
+typedef struct pcom_flow pcom_flow_t;
+
+typedef struct {
+    size_t window;       // Receive window advertised to the peer, 0 for default
+    size_t queue_max;    // Send queue limit in bytes, 0 for default
+    int sndbuf;          // SO_SNDBUF for the handle, 0 to leave it
+    int rcvbuf;          // SO_RCVBUF for the handle, 0 to leave it
+} pcom_flow_opts_t;
+
+typedef struct {
+    unsigned long long credit;       // Payload bytes the peer will accept now
+    unsigned long long queued;       // Bytes in the send queue
+    unsigned long long unsent;       // Bytes in the kernel send buffer
+    unsigned long long would_block;  // Sends that were queued
+    unsigned long long queue_full;   // Sends refused with -ENOBUFS
+    unsigned long long granted;      // Credit granted to the peer
+} pcom_flow_stats_t;
+
+/**
+ * @brief      Wrap a connected stream handle and advertise the window.
+ * @param      pp_flow  Receives the flow state.
+ * @param      handle   Connected PCOM handle, not owned.
+ * @param      p_opts   Options, NULL for defaults.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_flow_create(pcom_flow_t** pp_flow, int handle, const pcom_flow_opts_t* p_opts);
+
+/**
+ * @brief      Send a frame without blocking.
+ * @param      p_flow   The flow state.
+ * @param      p_hdr    Header, len is the payload length, at most the peer's window.
+ * @param      payload  Payload bytes, copied if the frame is queued.
+ * @return     0 if written, PCOM_FLOW_WOULD_BLOCK if queued, -ENOBUFS if the
+ *             queue is full, other negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_flow_send(pcom_flow_t* p_flow, const pcom_frame_hdr_t* p_hdr, const void* payload);
+
+/**
+ * @brief      Receive a frame, granting credit for the previous one.
+ * @param      p_flow      The flow state.
+ * @param      p_hdr       Receives the header.
+ * @param      p_payload   Receives the payload, valid until the next call.
+ * @param      timeout_ms  Max wait, -1 for no limit.
+ * @return     1 on success, 0 on EOF, -ETIMEDOUT, other negative error code
+ *             on failure, -EPROTO if the peer exceeded its window, -EMSGSIZE
+ *             if queued frames were dropped as larger than the peer's window.
+ * @details    Credit frames are handled internally and send the queue on.
+ *             Frames queued before the peer's window was known and larger
+ *             than it can never be sent, they are dropped when it arrives.
+ */
+LIB_EXPORT int
+pcom_flow_recv(pcom_flow_t* p_flow, pcom_frame_hdr_t* p_hdr, const void** p_payload, int timeout_ms);
+
+/**
+ * @brief      Wait until the send queue is empty.
+ * @param      p_flow      The flow state.
+ * @param      timeout_ms  Max wait, -1 for no limit.
+ * @return     0 when empty, -ETIMEDOUT, -EMSGSIZE as pcom_flow_recv(), other
+ *             negative error code on failure.
+ * @details    Frames received meanwhile are kept for pcom_flow_recv().
+ */
+LIB_EXPORT int
+pcom_flow_flush(pcom_flow_t* p_flow, int timeout_ms);
+
+/**
+ * @brief      Bytes waiting in the send queue.
+ * @param      p_flow  The flow state.
+ * @return     Queued bytes, headers included.
+ */
+LIB_EXPORT size_t
+pcom_flow_pending(const pcom_flow_t* p_flow);
+
+/**
+ * @brief      Read the flow counters.
+ * @param      p_flow   The flow state.
+ * @param      p_stats  Receives the counters.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_flow_stats(const pcom_flow_t* p_flow, pcom_flow_stats_t* p_stats);
+
+/**
+ * @brief      Free the flow state. Queued frames are dropped.
+ * @param      p_flow  The flow state.
+ * @details    The handle is not closed.
+ */
+LIB_EXPORT void
+pcom_flow_destroy(pcom_flow_t* p_flow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_FLOW_H
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_frame.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Length prefixed frames over PCOM stream handles.
+ ****************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "pcom_frame.h"
+#include "pcom_capture.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define FRAME_READ_MIN (16 * 1024) // Receive chunk size
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#define IS_EINTR(r) ((r) == -EINTR)
+#else
+#define IS_EINTR(r) (0)
+#endif
+
+/* Make room for at least need more bytes after len */
+static int
+reader_reserve(pcom_frame_reader_t* p_r, size_t need)
+{
+    if (p_r->start > 0 && (p_r->start == p_r->len || p_r->cap - p_r->len < need)) {
+        memmove(p_r->buf, p_r->buf + p_r->start, p_r->len - p_r->start);
+        p_r->len -= p_r->start;
+        p_r->start = 0;
+    }
+    if (p_r->cap - p_r->len >= need) return 0;
+
+    size_t cap = p_r->cap ? p_r->cap : FRAME_READ_MIN;
+    while (cap - p_r->len < need) cap *= 2;
+    uint8_t* p = realloc(p_r->buf, cap);
+    if (!p) return -ENOMEM;
+    p_r->buf = p;
+    p_r->cap = cap;
+    return 0;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+void
+pcom_frame_encode(uint8_t* out, const pcom_frame_hdr_t* p_hdr)
+{
+    out[0] = (uint8_t)p_hdr->len;
+    out[1] = (uint8_t)(p_hdr->len >> 8);
+    out[2] = (uint8_t)(p_hdr->len >> 16);
+    out[3] = (uint8_t)(p_hdr->len >> 24);
+    out[4] = p_hdr->type;
+    out[5] = p_hdr->flags;
+    out[6] = (uint8_t)p_hdr->channel;
+    out[7] = (uint8_t)(p_hdr->channel >> 8);
+}
+
+void
+pcom_frame_decode(const uint8_t* in, pcom_frame_hdr_t* p_hdr)
+{
+    p_hdr->len = (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+    p_hdr->type = in[4];
+    p_hdr->flags = in[5];
+    p_hdr->channel = (uint16_t)(in[6] | in[7] << 8);
+}
+
+void
+pcom_frame_reader_init(pcom_frame_reader_t* p_reader)
+{
+    memset(p_reader, 0, sizeof(*p_reader));
+}
+
+int
+pcom_frame_reader_feed(pcom_frame_reader_t* p_reader, const void* data, size_t len)
+{
+    int result = reader_reserve(p_reader, len);
+    if (result < 0) return result;
+    memcpy(p_reader->buf + p_reader->len, data, len);
+    p_reader->len += len;
+    return 0;
+}
+
+int
+pcom_frame_reader_next(pcom_frame_reader_t* p_reader, pcom_frame_hdr_t* p_hdr, const void** p_payload)
+{
+    size_t avail = p_reader->len - p_reader->start;
+    if (avail < PCOM_FRAME_HDR_SIZE) return 0;
+
+    const uint8_t* p = p_reader->buf + p_reader->start;
+    pcom_frame_decode(p, p_hdr);
+    if (p_hdr->len > PCOM_FRAME_MAX) return -EMSGSIZE;
+    if (avail < PCOM_FRAME_HDR_SIZE + (size_t)p_hdr->len) return 0;
+
+    *p_payload = p + PCOM_FRAME_HDR_SIZE;
+    p_reader->start += PCOM_FRAME_HDR_SIZE + p_hdr->len;
+    return 1;
+}
+
+void
+pcom_frame_reader_free(pcom_frame_reader_t* p_reader)
+{
+    free(p_reader->buf);
+    memset(p_reader, 0, sizeof(*p_reader));
+}
+
+int
+pcom_frame_send(int handle, const pcom_frame_hdr_t* p_hdr, const void* payload)
+{
+    uint8_t hdr[PCOM_FRAME_HDR_SIZE];
+
+    if (p_hdr->len > PCOM_FRAME_MAX || (!payload && p_hdr->len)) return -EINVAL;
+
+    // Header and payload in one gathered write
+    pcom_frame_encode(hdr, p_hdr);
+    pcom_iovec_t iov[2] = { { hdr, sizeof(hdr) }, { payload, p_hdr->len } };
+    int64_t result = pcom_sendv(handle, iov, 2);
+    if (result < 0) return (int)result;
+    pcom_capture_frame(handle, PCOM_CAPTURE_OUT, p_hdr, payload);
+    return 0;
+}
+
+int
+pcom_frame_recv(int handle, pcom_frame_reader_t* p_reader, pcom_frame_hdr_t* p_hdr, const void** p_payload)
+{
+    for (;;) {
+        int result = pcom_frame_reader_next(p_reader, p_hdr, p_payload);
+        if (result > 0) pcom_capture_frame(handle, PCOM_CAPTURE_IN, p_hdr, *p_payload);
+        if (result != 0) return result;
+
+        // Whole frame in one go when the header is already known
+        size_t need = FRAME_READ_MIN;
+        size_t avail = p_reader->len - p_reader->start;
+        if (avail >= PCOM_FRAME_HDR_SIZE) {
+            pcom_frame_hdr_t hdr;
+            pcom_frame_decode(p_reader->buf + p_reader->start, &hdr);
+            if (PCOM_FRAME_HDR_SIZE + (size_t)hdr.len - avail > need)
+                need = PCOM_FRAME_HDR_SIZE + (size_t)hdr.len - avail;
+        }
+        result = reader_reserve(p_reader, need);
+        if (result < 0) return result;
+
+        int r = pcom_client_recv(handle, p_reader->buf + p_reader->len, p_reader->cap - p_reader->len);
+        if (IS_EINTR(r)) continue;
+        if (r < 0) return r;
+        if (r == 0) return p_reader->len == p_reader->start ? 0 : -EPIPE;
+        p_reader->len += (size_t)r;
+    }
+}
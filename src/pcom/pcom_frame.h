@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_frame.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Length prefixed frames over PCOM stream handles.
+ ****************************************************************************/
+/** @defgroup  PCOM_FRAME
+ * @brief     Message framing for PCOM stream connections.
+ * @details   A frame is an 8 byte header followed by the payload:
+ *
+ *            | Offset | Size | Field                             |
+ *            |--------|------|-----------------------------------|
+ *            | 0      | 4    | Payload length, little endian     |
+ *            | 4      | 1    | Type, PCOM_FRAME_*                |
+ *            | 5      | 1    | Flags, owned by the type          |
+ *            | 6      | 2    | Channel, little endian            |
+ *
+ *            The reader reassembles frames from whatever chunks the stream
+ *            delivers, so it works equally with blocking receives and with
+ *            pcom_loop receive events. Protocols on top (RPC and others)
+ *            use their own frame type.
+ *
+ * @pre       pcom.h
+ * @bug       -
+ * @warning   -
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_FRAME_H
+#define PCOM_FRAME_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint8_t etc.
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_FRAME_HDR_SIZE (8)
+#ifndef PCOM_FRAME_MAX
+#define PCOM_FRAME_MAX      (16 * 1024 * 1024)  // Largest payload accepted
+#endif
+
+/* Frame types */
+#define PCOM_FRAME_DATA     (0)  // Plain application data
+#define PCOM_FRAME_RPC      (1)  // pcom_rpc request or response
+#define PCOM_FRAME_PUBSUB   (2)  // pcom_pubsub publish or subscription
+#define PCOM_FRAME_CREDIT   (3)  // pcom_flow window credit
+#define PCOM_FRAME_MUX      (4)  // pcom_mux channel chunk
+
+typedef struct {
+    uint32_t len;        // Payload length
+    uint8_t  type;       // PCOM_FRAME_* type
+    uint8_t  flags;      // Type specific flags
+    uint16_t channel;    // Logical channel, 0 if unused
+} pcom_frame_hdr_t;
+
+/** Reassembly state for one connection */
+typedef struct {
+    uint8_t* buf;
+    size_t   start;      // First unconsumed byte
+    size_t   len;        // End of buffered data
+    size_t   cap;
+} pcom_frame_reader_t;
+
+/**
+ * @brief      Encode a frame header.
+ * @param      out    PCOM_FRAME_HDR_SIZE bytes.
+ * @param      p_hdr  The header.
+ */
+LIB_EXPORT void
+pcom_frame_encode(uint8_t* out, const pcom_frame_hdr_t* p_hdr);
+
+/**
+ * @brief      Decode a frame header.
+ * @param      in     PCOM_FRAME_HDR_SIZE bytes.
+ * @param      p_hdr  Receives the header.
+ */
+LIB_EXPORT void
+pcom_frame_decode(const uint8_t* in, pcom_frame_hdr_t* p_hdr);
+
+/**
+ * @brief      Prepare a reader.
+ * @param      p_reader  The reader, may be zero initialized instead.
+ */
+LIB_EXPORT void
+pcom_frame_reader_init(pcom_frame_reader_t* p_reader);
+
+/**
+ * @brief      Append received bytes.
+ * @param      p_reader  The reader.
+ * @param      data      Received bytes.
+ * @param      len       Number of bytes.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_frame_reader_feed(pcom_frame_reader_t* p_reader, const void* data, size_t len);
+
+/**
+ * @brief      Take the next complete frame.
+ * @param      p_reader   The reader.
+ * @param      p_hdr      Receives the header.
+ * @param      p_payload  Receives a pointer to the payload, valid until the
+ *                        next call on the reader.
+ * @return     1 if a frame was taken, 0 if more data is needed, negative
+ *             error code if the stream is corrupt (frame too large).
+ */
+LIB_EXPORT int
+pcom_frame_reader_next(pcom_frame_reader_t* p_reader, pcom_frame_hdr_t* p_hdr, const void** p_payload);
+
+/**
+ * @brief      Free the reader's buffer.
+ * @param      p_reader  The reader.
+ */
+LIB_EXPORT void
+pcom_frame_reader_free(pcom_frame_reader_t* p_reader);
+
+/**
+ * @brief      Send one frame, blocking.
+ * @param      handle     Connected PCOM handle.
+ * @param      p_hdr      Header, len is the payload length.
+ * @param      payload    Payload bytes.
+ * @return     0 on success, negative error code on failure.
+ * @details    Header and payload leave in one gathered write, see
+ *             pcom_sendv(). Callers sharing a handle between threads must
+ *             serialize sends themselves.
+ */
+LIB_EXPORT int
+pcom_frame_send(int handle, const pcom_frame_hdr_t* p_hdr, const void* payload);
+
+/**
+ * @brief      Receive one frame, blocking.
+ * @param      handle     Connected PCOM handle.
+ * @param      p_reader   Reader for this handle.
+ * @param      p_hdr      Receives the header.
+ * @param      p_payload  Receives the payload, valid until the next reader call.
+ * @return     1 on success, 0 on EOF, negative error code on failure.
+ * @details    Reads in large chunks, frames already buffered are returned
+ *             without a syscall.
+ */
+LIB_EXPORT int
+pcom_frame_recv(int handle, pcom_frame_reader_t* p_reader, pcom_frame_hdr_t* p_hdr, const void** p_payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_FRAME_H
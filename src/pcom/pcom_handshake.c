@@ -0,0 +1,388 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_handshake.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Version and capability handshake for PCOM connections.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pwd.h>
+#include <time.h>
+#endif
+#include <string.h>
+#include <errno.h>
+
+#include "pcom_handshake.h"
+#include "pcom_coalesce.h"
+#include "pcom_stats.h"
+#include "pcom_tcp.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+/* Hello on the wire, little endian:
+ *   0 "PCOH"   4 size u16   6 flags u16   8 version u32
+ *  12 pid u32 16 uid u32   20 gid u32    24 caps u64
+ *  32 boot id 16 bytes     48 netns u64  56 user name 32 bytes  88 reserved */
+#define HELLO_MAGIC   "PCOH"
+#define HELLO_SIZE    (96)     // Larger hellos of later versions are read in full
+#define HELLO_MAX     (4096)
+#define HELLO_NAME    (32)
+
+#define F_CAN_MOVE    (1 << 0) // Client: may reconnect over the UNIX socket
+#define F_MOVE        (1 << 1) // Server: reconnect over the UNIX socket
+
+typedef struct {
+    unsigned flags;
+    uint32_t version, pid, uid, gid;
+    uint64_t caps;
+    uint8_t boot_id[16];
+    uint64_t netns;
+    char name[HELLO_NAME + 1];
+} hello_t;
+
+static uint64_t local_caps = PCOM_CAP_BUILTIN;
+static pthread_once_t self_once = PTHREAD_ONCE_INIT;
+static hello_t self;       // This process, flags and caps filled per hello
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static void
+put_u16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+
+static void
+put_u32(uint8_t* p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+
+static void
+put_u64(uint8_t* p, uint64_t v) { put_u32(p, (uint32_t)v); put_u32(p + 4, (uint32_t)(v >> 32)); }
+
+static uint16_t
+get_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t
+get_u32(const uint8_t* p) { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+static uint64_t
+get_u64(const uint8_t* p) { return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32); }
+
+/** Boot id and network namespace tell peers on the same host apart */
+static void
+self_init(void)
+{
+    char text[64], name_buf[1024];
+    struct passwd pw, *p_pw = NULL;
+
+    self.version = (uint32_t)pcom_version();
+    self.pid = (uint32_t)getpid();
+    self.uid = (uint32_t)getuid();
+    self.gid = (uint32_t)getgid();
+    if (getpwuid_r(getuid(), &pw, name_buf, sizeof(name_buf), &p_pw) == 0 && p_pw) {
+        strncpy(self.name, p_pw->pw_name, HELLO_NAME);
+        self.name[HELLO_NAME] = '\0';
+    }
+
+#if defined(__linux__)
+    struct stat st;
+    int fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t n = read(fd, text, sizeof(text) - 1);
+        close(fd);
+        // 36 character UUID, hex digits to bytes
+        for (ssize_t i = 0, nib = 0; i < n && nib < 32; ++i) {
+            int c = text[i];
+            int v = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+            if (v < 0) continue;
+            self.boot_id[nib / 2] |= (uint8_t)(v << ((nib & 1) ? 0 : 4));
+            ++nib;
+        }
+    }
+    if (stat("/proc/self/ns/net", &st) == 0) self.netns = (uint64_t)st.st_ino;
+#else
+    (void)text;
+#endif
+}
+
+static void
+hello_encode(uint8_t* p, const hello_t* p_h)
+{
+    memset(p, 0, HELLO_SIZE);
+    memcpy(p, HELLO_MAGIC, 4);
+    put_u16(p + 4, HELLO_SIZE);
+    put_u16(p + 6, (uint16_t)p_h->flags);
+    put_u32(p + 8, p_h->version);
+    put_u32(p + 12, p_h->pid);
+    put_u32(p + 16, p_h->uid);
+    put_u32(p + 20, p_h->gid);
+    put_u64(p + 24, p_h->caps);
+    memcpy(p + 32, p_h->boot_id, 16);
+    put_u64(p + 48, p_h->netns);
+    memcpy(p + 56, p_h->name, strlen(p_h->name));
+}
+
+/** Read len bytes before the deadline, 0 or negative error code */
+static int
+recv_until(int handle, uint8_t* p, size_t len, int timeout_ms, struct timespec* p_t0)
+{
+    size_t got = 0;
+    while (got < len) {
+        int wait = -1;
+        if (timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long spent = (now.tv_sec - p_t0->tv_sec) * 1000 + (now.tv_nsec - p_t0->tv_nsec) / 1000000;
+            wait = (spent >= timeout_ms) ? 0 : timeout_ms - (int)spent;
+        }
+        struct pollfd pfd = { .fd = handle, .events = POLLIN };
+        int ready = poll(&pfd, 1, wait);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return pcom_errno_from(errno);
+        }
+        if (ready == 0) return -ETIMEDOUT;
+
+        ssize_t result = read(handle, p + got, len - got);
+        if (result == 0) return -ECONNRESET;
+        if (result < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+            return pcom_errno_from(errno);
+        }
+        got += (size_t)result;
+    }
+    return 0;
+}
+
+static int
+hello_recv(int handle, int timeout_ms, hello_t* p_h)
+{
+    uint8_t buf[HELLO_SIZE], skip[256];
+    struct timespec t0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int result = recv_until(handle, buf, 8, timeout_ms, &t0);
+    if (result) return result;
+    size_t size = get_u16(buf + 4);
+    if (memcmp(buf, HELLO_MAGIC, 4) != 0 || size < HELLO_SIZE || size > HELLO_MAX) return -EPROTO;
+    result = recv_until(handle, buf + 8, HELLO_SIZE - 8, timeout_ms, &t0);
+    for (size -= HELLO_SIZE; !result && size > 0; size -= (size > sizeof(skip) ? sizeof(skip) : size))
+        result = recv_until(handle, skip, size > sizeof(skip) ? sizeof(skip) : size, timeout_ms, &t0);
+    if (result) return result;
+
+    memset(p_h, 0, sizeof(*p_h));
+    p_h->flags = get_u16(buf + 6);
+    p_h->version = get_u32(buf + 8);
+    p_h->pid = get_u32(buf + 12);
+    p_h->uid = get_u32(buf + 16);
+    p_h->gid = get_u32(buf + 20);
+    p_h->caps = get_u64(buf + 24);
+    memcpy(p_h->boot_id, buf + 32, 16);
+    p_h->netns = get_u64(buf + 48);
+    memcpy(p_h->name, buf + 56, HELLO_NAME);
+    return 0;
+}
+
+static int
+hello_send(int handle, const hello_t* p_h)
+{
+    uint8_t buf[HELLO_SIZE];
+    hello_encode(buf, p_h);
+    int64_t result = pcom_send_all(handle, buf, HELLO_SIZE);
+    // Not held back on a coalescing handle, the peer waits for it
+    if (result >= 0) result = pcom_flush(handle);
+    return result < 0 ? (int)result : 0;
+}
+
+/** This process's hello */
+static void
+hello_self(hello_t* p_h, unsigned flags)
+{
+    pthread_once(&self_once, self_init);
+    *p_h = self;
+    p_h->flags = flags;
+    p_h->caps = __atomic_load_n(&local_caps, __ATOMIC_RELAXED);
+}
+
+static int
+transport_of(int handle)
+{
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    if (getsockname(handle, (struct sockaddr*)&ss, &len) < 0) return pcom_errno_from(errno);
+    return (ss.ss_family == AF_UNIX) ? PCOM_TRANSPORT_UNIX : PCOM_TRANSPORT_TCP;
+}
+
+static int
+same_host(const hello_t* p_a, const hello_t* p_b)
+{
+    static const uint8_t none[16];
+    return memcmp(p_a->boot_id, none, 16) != 0 && memcmp(p_a->boot_id, p_b->boot_id, 16) == 0 &&
+           p_a->netns == p_b->netns;
+}
+
+/** Fill p_peer from the peer's hello, credentials from the kernel where it has them */
+static void
+peer_fill(int handle, int is_server, const hello_t* p_self, const hello_t* p_h, int transport,
+          pcom_hs_peer_t* p_peer)
+{
+    memset(p_peer, 0, sizeof(*p_peer));
+    p_peer->version = (int)p_h->version;
+    p_peer->caps = p_h->caps;
+    p_peer->common = p_self->caps & p_h->caps;
+    p_peer->transport = transport;
+    p_peer->same_host = same_host(p_self, p_h);
+    p_peer->pid = (int)p_h->pid;
+    p_peer->uid = (int)p_h->uid;
+    p_peer->gid = (int)p_h->gid;
+
+#if defined(__linux__)
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (transport == PCOM_TRANSPORT_UNIX &&
+        getsockopt(handle, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) {
+        p_peer->pid = (int)cred.pid;
+        p_peer->uid = (int)cred.uid;
+        p_peer->gid = (int)cred.gid;
+        p_peer->user_verified = 1;
+    }
+#endif
+
+    // The server gets the check_user() result, the claim is the fallback
+    if (is_server && p_peer->user_verified && pcom_server_check_user(handle, &p_peer->user) == 0) return;
+    memset(&p_peer->user, 0, sizeof(p_peer->user));
+    strcpy(p_peer->user.username, p_h->name[0] ? p_h->name : "unknown");
+}
+
+static int
+client_hello(int handle, int timeout_ms, unsigned flags, pcom_hs_peer_t* p_peer)
+{
+    hello_t mine, peer;
+    int transport = transport_of(handle);
+    if (transport < 0) return transport;
+
+    hello_self(&mine, flags);
+    int result = hello_send(handle, &mine);
+    if (!result) result = hello_recv(handle, timeout_ms, &peer);
+    if (result) return result;
+
+    peer_fill(handle, 0, &mine, &peer, transport, p_peer);
+    if ((peer.version >> 16) != (mine.version >> 16)) return -EPROTONOSUPPORT;
+    return (peer.flags & F_MOVE) ? PCOM_HANDSHAKE_MOVED : 0;
+}
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+void
+pcom_handshake_set_caps(uint64_t caps)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    __atomic_store_n(&local_caps, caps, __ATOMIC_RELAXED);
+#else
+    (void)caps;
+#endif
+}
+
+uint64_t
+pcom_handshake_caps(void)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    return __atomic_load_n(&local_caps, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
+int
+pcom_handshake_client(int handle, int timeout_ms, pcom_hs_peer_t* p_peer)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    if (!p_peer) return -EINVAL;
+    return client_hello(handle, timeout_ms, 0, p_peer);
+#else
+    (void)handle; (void)timeout_ms; (void)p_peer;
+    return -1;
+#endif
+}
+
+int
+pcom_handshake_server(int handle, int timeout_ms, pcom_hs_peer_t* p_peer)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    hello_t mine, peer;
+    unsigned flags = 0;
+
+    if (!p_peer) return -EINVAL;
+    int transport = transport_of(handle);
+    if (transport < 0) return transport;
+    int result = hello_recv(handle, timeout_ms, &peer);
+    if (result) return result;
+
+    // A client next door moves to the UNIX listener, if this server has one
+    hello_self(&mine, 0);
+    if ((peer.flags & F_CAN_MOVE) && transport == PCOM_TRANSPORT_TCP && same_host(&mine, &peer) &&
+        (peer.version >> 16) == (mine.version >> 16) && pcom_tcp_local_listening(pcom_tcp_port(handle)))
+        flags |= F_MOVE;
+    mine.flags = flags;
+    result = hello_send(handle, &mine);
+    if (result) return result;
+
+    peer_fill(handle, 1, &mine, &peer, transport, p_peer);
+    if ((peer.version >> 16) != (mine.version >> 16)) return -EPROTONOSUPPORT;
+    return (flags & F_MOVE) ? PCOM_HANDSHAKE_MOVED : 0;
+
+#else
+    (void)handle; (void)timeout_ms; (void)p_peer;
+    return -1;
+#endif
+}
+
+int
+pcom_handshake_open(const char* name, int flags, int timeout_ms, pcom_hs_peer_t* p_peer)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (!p_peer) return -EINVAL;
+    if ((flags & PCOM_OPEN_TYPE_MASK) != PCOM_OPEN_STREAM) return -EPROTONOSUPPORT;
+    int handle = pcom_client_open_ex(name, flags);
+    if (handle < 0) return handle;
+
+    int result = client_hello(handle, timeout_ms, F_CAN_MOVE, p_peer);
+    if (result == PCOM_HANDSHAKE_MOVED) {
+        // Same host: the server's UNIX listener, named after its address
+        int local = pcom_tcp_local_open(handle, p_peer->pid);
+        pcom_client_close(handle);
+        if (local < 0) return local;
+        handle = local;
+        pcom_stats_conn_clear(handle);
+        result = client_hello(handle, timeout_ms, 0, p_peer);
+    }
+    if (result) {
+        pcom_client_close(handle);
+        return result;
+    }
+    return handle;
+
+#else
+    (void)name; (void)flags; (void)timeout_ms; (void)p_peer;
+    return -1;
+#endif
+}
@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_handshake.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Version and capability handshake for PCOM connections.
+ ****************************************************************************/
+/** @defgroup  PCOM_HANDSHAKE
+ * @brief     One round trip after connect: versions, capabilities, identity.
+ * @details   The client sends a hello with its pcom_version(), a capability
+ *            bitmap and who it is; the server answers with its own. Both
+ *            ends then know the peer's version, the capabilities they have
+ *            in common, whether the peer runs on the same host, and the
+ *            peer's credentials:
+ *
+ *                // Client
+ *                pcom_hs_peer_t peer;
+ *                int h = pcom_handshake_open("tcp://db:7000", 0, 1000, &peer);
+ *                if (h >= 0 && (peer.common & PCOM_CAP_MUX)) ...
+ *
+ *                // Server
+ *                int h = pcom_server_accept(server);
+ *                int r = pcom_handshake_server(h, 1000, &peer);
+ *                if (r != 0) pcom_client_close(h);    // failed or moved
+ *
+ *            On UNIX sockets the credentials come from the kernel and the
+ *            server gets the pcom_server_check_user() result with the
+ *            handshake. Over TCP they are what the peer claims.
+ *
+ *            A TCP client opened with pcom_handshake_open() that turns out
+ *            to share host and network namespace with a server listening
+ *            on its UNIX socket too (see pcom_tcp.h) moves to that socket:
+ *            the server answers PCOM_HANDSHAKE_MOVED on the TCP handle and
+ *            the client reconnects and handshakes on the UNIX socket.
+ *
+ * @pre       pcom.h, pcom_tcp.h
+ * @bug       -
+ * @warning   Both ends must handshake, before any other bytes. A peer of a
+ *            different major version is refused with -EPROTONOSUPPORT, after
+ *            the hellos are exchanged so both ends see why. Credentials
+ *            claimed over TCP are not authenticated and never admin.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_HANDSHAKE_H
+#define PCOM_HANDSHAKE_H
+
+#include <stdint.h>  // for uint64_t
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_HANDSHAKE_MOVED  (1)     // Server: the client moved to the UNIX socket
+
+/* Capabilities, bits 32 to 63 are free for applications */
+#define PCOM_CAP_FRAME      (1ull << 0)   // Length prefixed frames, pcom_frame.h
+#define PCOM_CAP_FLOW       (1ull << 1)   // Credit based flow control, pcom_flow.h
+#define PCOM_CAP_MUX        (1ull << 2)   // Prioritized channels, pcom_mux.h
+#define PCOM_CAP_RPC        (1ull << 3)   // Pipelined RPC, pcom_rpc.h
+#define PCOM_CAP_SCHEMA     (1ull << 4)   // Schema messages with CRC trailers, pcom_schema.h
+#define PCOM_CAP_FILE       (1ull << 5)   // Spliced file transfer, pcom_file.h
+#define PCOM_CAP_BUILTIN    (0x3Full)     // What this build of the library has
+#define PCOM_CAP_APP(n)     (1ull << (32 + (n)))   // Application capability n, 0 to 31
+
+#define PCOM_TRANSPORT_UNIX (1)
+#define PCOM_TRANSPORT_TCP  (2)
+
+typedef struct {
+    int version;             // Peer's pcom_version()
+    uint64_t caps;           // Capabilities the peer offers
+    uint64_t common;         // Capabilities both ends offer
+    int transport;           // PCOM_TRANSPORT_* of the connection
+    int same_host;           // Peer on this host and in this network namespace
+    int pid;                 // Peer process id
+    int uid;                 // Peer user id
+    int gid;                 // Peer group id
+    int user_verified;       // 1 if pid, uid and gid come from the kernel
+    pcom_user_info_t user;   // Server: as from pcom_server_check_user(), or the
+                             // claimed user name over TCP. Client: user name only.
+} pcom_hs_peer_t;
+
+/**
+ * @brief      Set the capabilities this process offers.
+ * @param      caps  Bitmap, PCOM_CAP_BUILTIN by default.
+ */
+LIB_EXPORT void
+pcom_handshake_set_caps(uint64_t caps);
+
+/**
+ * @brief      Get the capabilities this process offers.
+ * @return     Bitmap of PCOM_CAP_* bits.
+ */
+LIB_EXPORT uint64_t
+pcom_handshake_caps(void);
+
+/**
+ * @brief      Handshake as the client on a connected handle.
+ * @param      handle      Handle from pcom_client_open().
+ * @param      timeout_ms  Longest wait for the answer, -1 for no limit.
+ * @param      p_peer      Receives what was learned about the server.
+ * @return     0 on success, -ETIMEDOUT, -EPROTO for a peer not speaking the
+ *             handshake, -EPROTONOSUPPORT for another major version,
+ *             negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_handshake_client(int handle, int timeout_ms, pcom_hs_peer_t* p_peer);
+
+/**
+ * @brief      Handshake as the server on an accepted handle.
+ * @param      handle      Handle from pcom_server_accept().
+ * @param      timeout_ms  Longest wait for the hello, -1 for no limit.
+ * @param      p_peer      Receives what was learned about the client.
+ * @return     0 on success, PCOM_HANDSHAKE_MOVED if the client reconnects
+ *             over the UNIX socket (close the handle), negative error code
+ *             as pcom_handshake_client().
+ */
+LIB_EXPORT int
+pcom_handshake_server(int handle, int timeout_ms, pcom_hs_peer_t* p_peer);
+
+/**
+ * @brief      Open a client connection and handshake on it.
+ * @param      name        Connection name, see pcom_client_open().
+ * @param      flags       As pcom_client_open_ex(), stream only.
+ * @param      timeout_ms  Longest wait for each answer, -1 for no limit.
+ * @param      p_peer      Receives what was learned about the server.
+ * @return     Client handle, negative error code on failure.
+ * @details    Moves a TCP connection to the server's UNIX socket when both
+ *             run in the same host and network namespace.
+ */
+LIB_EXPORT int
+pcom_handshake_open(const char* name, int flags, int timeout_ms, pcom_hs_peer_t* p_peer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_HANDSHAKE_H
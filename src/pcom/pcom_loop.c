@@ -0,0 +1,1172 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_loop.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     PCOM event loop with io_uring and epoll backends.
+ ****************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include "pcom_loop.h"
+#include "pcom_tcp.h"
+
+#if defined(__linux__)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+/* Operation tags in io_uring user_data, packed as gen << 40 | fd << 8 | tag */
+#define OP_ACCEPT (1)
+#define OP_RECV   (2)
+#define OP_SEND   (3)
+#define OP_CANCEL (4)
+#define OP_WAKE   (5)
+#define OP_RETRY  (6)
+
+#define ACCEPT_RETRY_MS (100)   // Accept pause when out of handles or memory
+
+#define OP_DATA(tag, fd, gen) \
+    (((uint64_t)((gen) & 0xFFFFFF) << 40) | ((uint64_t)(uint32_t)(fd) << 8) | (tag))
+
+#define EPOLL_BATCH (64)
+
+/** A queued send */
+typedef struct {
+    const char* buf;
+    size_t len;
+    size_t done;
+    void* user;
+    int next;          // Next op in handle queue or free list, -1 at end
+} loop_op_t;
+
+/** Per handle state */
+typedef struct {
+    int added;         // Receiving on the handle
+    int removing;      // Removed, waiting for the receive to be cancelled
+    int recv_armed;    // Receive request outstanding (io_uring) or EPOLLIN set
+    int starved;       // Receive paused for lack of buffers
+    int dirty;         // Handle is in the flush list
+    int cancel;        // Removed, fail sends that are not in flight
+    int inflight;      // Number of queued ops covered by the in-flight send
+    int want_out;      // epoll: waiting for EPOLLOUT
+    int ep_on;         // epoll: handle registered
+    uint32_t ep_mask;  // epoll: registered events
+    unsigned gen;      // Bumped on add/remove, discards stale completions
+    int head, tail;    // Send op queue
+    struct msghdr msg;
+    struct iovec iov[PCOM_LOOP_IOV_MAX];
+} loop_conn_t;
+
+struct pcom_loop {
+    int backend;
+    int server_handle;
+    int local_handle;          // UNIX listener of a TCP server, -1 if none
+    int wake_fd;               // eventfd for pcom_loop_wake()
+    uint64_t wake_val;         // io_uring: target for the eventfd read
+
+    /* Receive buffers */
+    char* buf_mem;
+    int* buf_free;             // epoll: stack of free buffer ids
+    int buf_free_count;
+    int starved_count;
+
+    /* Send ops */
+    loop_op_t* ops;
+    int op_cap;
+    int op_free;
+    int op_used;
+
+    /* Per handle state, indexed by handle */
+    loop_conn_t** conns;
+    int conn_cap;
+    int conn_count;
+
+    /* Handles with sends to issue or receives to arm, ring with room for every handle */
+    int* flush;
+    int flush_head;
+    int flush_count;
+    int flush_cap;
+
+    /* Ready events, ring buffer */
+    pcom_event_t* ready;
+    int ready_head;
+    int ready_count;
+    int ready_cap;
+
+    /* io_uring */
+    int ring_fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+    void* ring_map;
+    size_t ring_map_len;
+    size_t sqes_len;
+    struct io_uring_buf_ring* br;
+    size_t br_len;
+    unsigned short br_tail;
+    unsigned to_submit;
+    int no_multishot_accept;
+    int no_multishot_recv;
+    struct __kernel_timespec retry_ts;
+
+    /* epoll */
+    int epoll_fd;
+    int accept_paused;         // Listeners out of epoll, bit 0 server, bit 1 local
+    long long accept_resume;   // CLOCK_MONOTONIC ms to put them back
+};
+
+/* ---- Bookkeeping ------------------------------------------------------- */
+
+/** Get state for a handle, optionally creating it */
+static loop_conn_t*
+conn_get(pcom_loop_t* p_loop, int fd, int create)
+{
+    if (fd < 0) return NULL;
+    if (fd >= p_loop->conn_cap) {
+        if (!create) return NULL;
+        int cap = p_loop->conn_cap ? p_loop->conn_cap : 64;
+        while (cap <= fd) cap *= 2;
+        loop_conn_t** p_new = realloc(p_loop->conns, cap * sizeof(*p_new));
+        if (!p_new) return NULL;
+        memset(p_new + p_loop->conn_cap, 0, (cap - p_loop->conn_cap) * sizeof(*p_new));
+        p_loop->conns = p_new;
+        p_loop->conn_cap = cap;
+    }
+    loop_conn_t* p_conn = p_loop->conns[fd];
+    if (!p_conn && create) {
+        // mark_dirty() cannot fail later, the flush list fits every handle
+        if (p_loop->conn_count == p_loop->flush_cap) {
+            int cap = p_loop->flush_cap ? p_loop->flush_cap * 2 : 64;
+            int* p_flush = malloc(cap * sizeof(*p_flush));
+            if (!p_flush) return NULL;
+            for (int i = 0; i < p_loop->flush_count; ++i)
+                p_flush[i] = p_loop->flush[(p_loop->flush_head + i) % p_loop->flush_cap];
+            free(p_loop->flush);
+            p_loop->flush = p_flush;
+            p_loop->flush_head = 0;
+            p_loop->flush_cap = cap;
+        }
+        p_conn = calloc(1, sizeof(*p_conn));
+        if (!p_conn) return NULL;
+        p_conn->head = p_conn->tail = -1;
+        p_loop->conns[fd] = p_conn;
+        p_loop->conn_count++;
+    }
+    return p_conn;
+}
+
+/** Allocate a send op */
+static int
+op_alloc(pcom_loop_t* p_loop)
+{
+    if (p_loop->op_free < 0) {
+        int cap = p_loop->op_cap ? p_loop->op_cap * 2 : 64;
+        loop_op_t* p_new = realloc(p_loop->ops, cap * sizeof(*p_new));
+        if (!p_new) return -1;
+        for (int i = p_loop->op_cap; i < cap; ++i) p_new[i].next = (i + 1 < cap) ? i + 1 : -1;
+        p_loop->op_free = p_loop->op_cap;
+        p_loop->ops = p_new;
+        p_loop->op_cap = cap;
+    }
+    int id = p_loop->op_free;
+    p_loop->op_free = p_loop->ops[id].next;
+    p_loop->ops[id].next = -1;
+    p_loop->op_used++;
+    return id;
+}
+
+static void
+op_free(pcom_loop_t* p_loop, int id)
+{
+    p_loop->ops[id].next = p_loop->op_free;
+    p_loop->op_free = id;
+    p_loop->op_used--;
+}
+
+/** Room in the ready ring for n more events and one for every queued send.
+ *  Taken before a handle is accepted, read or failed, so no event is lost. */
+static int
+ready_reserve(pcom_loop_t* p_loop, int n)
+{
+    int need = p_loop->ready_count + p_loop->op_used + n;
+    if (need <= p_loop->ready_cap) return 0;
+    int cap = p_loop->ready_cap ? p_loop->ready_cap : 64;
+    while (cap < need) cap *= 2;
+    pcom_event_t* p_new = malloc(cap * sizeof(*p_new));
+    if (!p_new) return -ENOMEM;
+    for (int i = 0; i < p_loop->ready_count; ++i)
+        p_new[i] = p_loop->ready[(p_loop->ready_head + i) % p_loop->ready_cap];
+    free(p_loop->ready);
+    p_loop->ready = p_new;
+    p_loop->ready_head = 0;
+    p_loop->ready_cap = cap;
+    return 0;
+}
+
+/** Queue an event for the next pcom_loop_wait(), callers reserved the room */
+static int
+push_event(pcom_loop_t* p_loop, int type, int handle, int result,
+           int buf_id, const void* data, void* user)
+{
+    if (p_loop->ready_count == p_loop->ready_cap && ready_reserve(p_loop, 1) < 0) return -ENOMEM;
+    pcom_event_t* p_ev = &p_loop->ready[(p_loop->ready_head + p_loop->ready_count++) % p_loop->ready_cap];
+    p_ev->type = type;
+    p_ev->handle = handle;
+    p_ev->result = result;
+    p_ev->buf_id = buf_id;
+    p_ev->data = data;
+    p_ev->user = user;
+    return 0;
+}
+
+/** Mark a handle for attention on the next flush */
+static void
+mark_dirty(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn)
+{
+    if (p_conn->dirty) return;
+    p_loop->flush[(p_loop->flush_head + p_loop->flush_count++) % p_loop->flush_cap] = fd;
+    p_conn->dirty = 1;
+}
+
+/** Fail queued sends, skipping the first `skip` ops that are still in flight */
+static void
+fail_sends(pcom_loop_t* p_loop, loop_conn_t* p_conn, int fd, int skip, int error)
+{
+    int prev = -1, id = p_conn->head;
+    while (id >= 0 && skip-- > 0) { prev = id; id = p_loop->ops[id].next; }
+    while (id >= 0) {
+        loop_op_t* p_op = &p_loop->ops[id];
+        int next = p_op->next;
+        push_event(p_loop, PCOM_EVENT_SEND, fd, error, -1, p_op->buf, p_op->user);
+        op_free(p_loop, id);
+        id = next;
+    }
+    if (prev < 0) p_conn->head = p_conn->tail = -1;
+    else { p_loop->ops[prev].next = -1; p_conn->tail = prev; }
+}
+
+/** Account a finished send syscall against the handle's queue */
+static void
+complete_send(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn, int result)
+{
+    p_conn->inflight = 0;
+    if (result < 0) {
+        // Stream is broken, nothing queued behind can succeed
+        fail_sends(p_loop, p_conn, fd, 0, result);
+        return;
+    }
+
+    size_t left = (size_t)result;
+    while (p_conn->head >= 0) {
+        int id = p_conn->head;
+        loop_op_t* p_op = &p_loop->ops[id];
+        size_t take = p_op->len - p_op->done;
+        if (take > left) take = left;
+        p_op->done += take;
+        left -= take;
+        if (p_op->done < p_op->len) break;
+        push_event(p_loop, PCOM_EVENT_SEND, fd, (int)p_op->len, -1, p_op->buf, p_op->user);
+        p_conn->head = p_op->next;
+        if (p_conn->head < 0) p_conn->tail = -1;
+        op_free(p_loop, id);
+    }
+
+    if (p_conn->cancel) fail_sends(p_loop, p_conn, fd, 0, -ECANCELED);
+    else if (p_conn->head >= 0) mark_dirty(p_loop, fd, p_conn);
+}
+
+/** Gather the handle's queued sends into its msghdr */
+static void
+build_msg(pcom_loop_t* p_loop, loop_conn_t* p_conn)
+{
+    int n = 0;
+    for (int id = p_conn->head; id >= 0 && n < PCOM_LOOP_IOV_MAX; id = p_loop->ops[id].next) {
+        loop_op_t* p_op = &p_loop->ops[id];
+        p_conn->iov[n].iov_base = (void*)(p_op->buf + p_op->done);
+        p_conn->iov[n].iov_len = p_op->len - p_op->done;
+        ++n;
+    }
+    memset(&p_conn->msg, 0, sizeof(p_conn->msg));
+    p_conn->msg.msg_iov = p_conn->iov;
+    p_conn->msg.msg_iovlen = n;
+    p_conn->inflight = n;
+}
+
+/** The handle no longer receives, report it */
+static void
+finish_remove(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn)
+{
+    p_conn->removing = 0;
+    p_conn->gen++;
+    push_event(p_loop, PCOM_EVENT_REMOVED, fd, 0, -1, NULL, NULL);
+}
+
+/* ---- io_uring backend -------------------------------------------------- */
+
+static int
+sys_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int
+sys_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+                void* arg, size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static int
+sys_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/** Submit pending SQEs, optionally waiting for completions */
+static int
+uring_enter(pcom_loop_t* p_loop, unsigned min_complete, int timeout_ms)
+{
+    unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    void* p_arg = NULL;
+    size_t argsz = 0;
+
+    if (!min_complete && !p_loop->to_submit) return 0;
+
+    if (min_complete && timeout_ms > 0) {
+        memset(&arg, 0, sizeof(arg));
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+        p_arg = &arg;
+        argsz = sizeof(arg);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+
+    int ret = sys_uring_enter(p_loop->ring_fd, p_loop->to_submit, min_complete, flags, p_arg, argsz);
+    if (ret < 0) {
+        int err = errno;
+        // Timeout, signal or full CQ are not errors, completions get reaped
+        if (err == ETIME || err == EINTR || err == EBUSY || err == EAGAIN) return 0;
+        return pcom_errno_from(err);
+    }
+    p_loop->to_submit -= (unsigned)ret < p_loop->to_submit ? (unsigned)ret : p_loop->to_submit;
+    return 0;
+}
+
+/** Get a free SQE. Without SQPOLL the kernel only reads the SQ on enter,
+ *  so the tail can be published before the entry is filled in. */
+static struct io_uring_sqe*
+uring_sqe(pcom_loop_t* p_loop)
+{
+    unsigned tail = *p_loop->sq_tail;
+    if (tail - __atomic_load_n(p_loop->sq_head, __ATOMIC_ACQUIRE) >= p_loop->sq_entries) {
+        uring_enter(p_loop, 0, 0);
+        if (tail - __atomic_load_n(p_loop->sq_head, __ATOMIC_ACQUIRE) >= p_loop->sq_entries)
+            return NULL;
+    }
+    struct io_uring_sqe* p_sqe = &p_loop->sqes[tail & p_loop->sq_mask];
+    memset(p_sqe, 0, sizeof(*p_sqe));
+    __atomic_store_n(p_loop->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    p_loop->to_submit++;
+    return p_sqe;
+}
+
+/** Accept on fd, gen is 1 for a multishot accept */
+static int
+uring_arm_accept(pcom_loop_t* p_loop, int fd)
+{
+    struct io_uring_sqe* p_sqe = uring_sqe(p_loop);
+    if (!p_sqe) return -EBUSY;
+    p_sqe->opcode = IORING_OP_ACCEPT;
+    p_sqe->fd = fd;
+    p_sqe->ioprio = p_loop->no_multishot_accept ? 0 : IORING_ACCEPT_MULTISHOT;
+    p_sqe->user_data = OP_DATA(OP_ACCEPT, fd, !p_loop->no_multishot_accept);
+    return 0;
+}
+
+/** Accept on fd again after ACCEPT_RETRY_MS */
+static int
+uring_arm_retry(pcom_loop_t* p_loop, int fd)
+{
+    struct io_uring_sqe* p_sqe = uring_sqe(p_loop);
+    if (!p_sqe) return -EBUSY;
+    p_loop->retry_ts.tv_sec = 0;
+    p_loop->retry_ts.tv_nsec = ACCEPT_RETRY_MS * 1000000LL;
+    p_sqe->opcode = IORING_OP_TIMEOUT;
+    p_sqe->fd = -1;
+    p_sqe->addr = (uint64_t)(uintptr_t)&p_loop->retry_ts;
+    p_sqe->len = 1;
+    p_sqe->user_data = OP_DATA(OP_RETRY, fd, 0);
+    return 0;
+}
+
+static int
+uring_arm_recv(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn)
+{
+    struct io_uring_sqe* p_sqe = uring_sqe(p_loop);
+    if (!p_sqe) return -EBUSY;
+    p_sqe->opcode = IORING_OP_RECV;
+    p_sqe->fd = fd;
+    p_sqe->ioprio = p_loop->no_multishot_recv ? 0 : IORING_RECV_MULTISHOT;
+    p_sqe->flags = IOSQE_BUFFER_SELECT;
+    p_sqe->buf_group = 0;
+    p_sqe->user_data = OP_DATA(OP_RECV, fd, p_conn->gen);
+    p_conn->recv_armed = 1;
+    return 0;
+}
+
+static int
+uring_arm_wake(pcom_loop_t* p_loop)
+{
+    struct io_uring_sqe* p_sqe = uring_sqe(p_loop);
+    if (!p_sqe) return -EBUSY;
+    p_sqe->opcode = IORING_OP_READ;
+    p_sqe->fd = p_loop->wake_fd;
+    p_sqe->addr = (uint64_t)(uintptr_t)&p_loop->wake_val;
+    p_sqe->len = sizeof(p_loop->wake_val);
+    p_sqe->user_data = OP_DATA(OP_WAKE, p_loop->wake_fd, 0);
+    return 0;
+}
+
+static int
+uring_cancel_recv(pcom_loop_t* p_loop, int fd, unsigned gen)
+{
+    struct io_uring_sqe* p_sqe = uring_sqe(p_loop);
+    if (!p_sqe) return -EBUSY;
+    p_sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    p_sqe->fd = -1;
+    p_sqe->addr = OP_DATA(OP_RECV, fd, gen);
+    p_sqe->user_data = OP_DATA(OP_CANCEL, fd, 0);
+    return 0;
+}
+
+static int
+uring_send(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn)
+{
+    struct io_uring_sqe* p_sqe = uring_sqe(p_loop);
+    if (!p_sqe) return -EBUSY;
+    build_msg(p_loop, p_conn);
+    p_sqe->opcode = IORING_OP_SENDMSG;
+    p_sqe->fd = fd;
+    p_sqe->addr = (uint64_t)(uintptr_t)&p_conn->msg;
+    p_sqe->len = 1;
+    p_sqe->msg_flags = MSG_NOSIGNAL;
+    p_sqe->user_data = OP_DATA(OP_SEND, fd, 0);
+    return 0;
+}
+
+/** Hand a receive buffer back to the kernel */
+static void
+uring_recycle(pcom_loop_t* p_loop, int bid)
+{
+    // Only addr, len and bid are written, resv of entry 0 overlays the tail
+    struct io_uring_buf* p_buf = &p_loop->br->bufs[p_loop->br_tail & (PCOM_LOOP_BUF_COUNT - 1)];
+    p_buf->addr = (uint64_t)(uintptr_t)(p_loop->buf_mem + (size_t)bid * PCOM_LOOP_BUF_SIZE);
+    p_buf->len = PCOM_LOOP_BUF_SIZE;
+    p_buf->bid = (unsigned short)bid;
+    p_loop->br_tail++;
+    __atomic_store_n(&p_loop->br->tail, p_loop->br_tail, __ATOMIC_RELEASE);
+}
+
+static void
+uring_handle_cqe(pcom_loop_t* p_loop, const struct io_uring_cqe* p_cqe)
+{
+    uint64_t data = p_cqe->user_data;
+    int tag = (int)(data & 0xFF);
+    int fd = (int)(uint32_t)(data >> 8);
+    unsigned gen = (unsigned)(data >> 40);
+    int res = p_cqe->res;
+    int more = (p_cqe->flags & IORING_CQE_F_MORE) != 0;
+    int bid = (p_cqe->flags & IORING_CQE_F_BUFFER) ? (int)(p_cqe->flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+    loop_conn_t* p_conn;
+
+    switch (tag) {
+    case OP_ACCEPT:
+        if (res == -EINVAL && gen) {
+            // Kernel without multishot accept, use one shot accepts
+            p_loop->no_multishot_accept = 1;
+            uring_arm_accept(p_loop, fd);
+            break;
+        }
+        push_event(p_loop, PCOM_EVENT_ACCEPT, res >= 0 ? res : -1, res >= 0 ? 0 : res, -1, NULL, NULL);
+        if (more) break;
+        // Only a bad listener or teardown ends accepting. Out of handles or
+        // memory, the listener would fail again at once, so pause first.
+        if (res == -EMFILE || res == -ENFILE || res == -ENOMEM || res == -ENOBUFS)
+            uring_arm_retry(p_loop, fd);
+        else if (res != -EBADF && res != -EINVAL && res != -ECANCELED)
+            uring_arm_accept(p_loop, fd);
+        break;
+
+    case OP_RETRY:
+        if (res != -ECANCELED) uring_arm_accept(p_loop, fd);
+        break;
+
+    case OP_RECV:
+        p_conn = conn_get(p_loop, fd, 0);
+        if (!p_conn || !(p_conn->added || p_conn->removing) || (p_conn->gen & 0xFFFFFF) != gen) {
+            // Completion from a removed or reused handle
+            if (bid >= 0) uring_recycle(p_loop, bid);
+            break;
+        }
+        if (!more) p_conn->recv_armed = 0;
+        if (p_conn->removing) {
+            // Data the kernel read before the cancel took effect is still
+            // delivered, so a handle can move to another loop without loss
+            if (res > 0) push_event(p_loop, PCOM_EVENT_RECV, fd, res, bid,
+                                    p_loop->buf_mem + (size_t)bid * PCOM_LOOP_BUF_SIZE, NULL);
+            else if (bid >= 0) uring_recycle(p_loop, bid);
+            if (!more) finish_remove(p_loop, fd, p_conn);
+            break;
+        }
+        if (res > 0) {
+            push_event(p_loop, PCOM_EVENT_RECV, fd, res, bid,
+                       p_loop->buf_mem + (size_t)bid * PCOM_LOOP_BUF_SIZE, NULL);
+            if (!more) mark_dirty(p_loop, fd, p_conn);
+        } else if (res == -ENOBUFS) {
+            // Resumed by pcom_loop_release()
+            p_conn->starved = 1;
+            p_loop->starved_count++;
+        } else if (res == -EINVAL && !p_loop->no_multishot_recv) {
+            p_loop->no_multishot_recv = 1;
+            mark_dirty(p_loop, fd, p_conn);
+        } else if (res == -ECANCELED || res == -EINTR) {
+            mark_dirty(p_loop, fd, p_conn);
+        } else {
+            if (bid >= 0) uring_recycle(p_loop, bid);
+            p_conn->added = 0;
+            push_event(p_loop, PCOM_EVENT_RECV, fd, res, -1, NULL, NULL);
+        }
+        break;
+
+    case OP_SEND:
+        p_conn = conn_get(p_loop, fd, 0);
+        if (p_conn) complete_send(p_loop, fd, p_conn, res);
+        break;
+
+    case OP_WAKE:
+        if (res >= 0 || res == -EINTR || res == -EAGAIN) uring_arm_wake(p_loop);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/** Reap up to one CQ worth of completions without blocking, the rest waits
+ *  for the next call so the events fit the room pcom_loop_wait() reserved */
+static void
+uring_reap(pcom_loop_t* p_loop)
+{
+    unsigned head = *p_loop->cq_head;
+    unsigned tail = __atomic_load_n(p_loop->cq_tail, __ATOMIC_ACQUIRE);
+    for (unsigned budget = p_loop->cq_mask + 1; head != tail && budget > 0; --budget) {
+        uring_handle_cqe(p_loop, &p_loop->cqes[head & p_loop->cq_mask]);
+        ++head;
+        if (head == tail) {
+            __atomic_store_n(p_loop->cq_head, head, __ATOMIC_RELEASE);
+            tail = __atomic_load_n(p_loop->cq_tail, __ATOMIC_ACQUIRE);
+        }
+    }
+    __atomic_store_n(p_loop->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/** Cancel every request and wait for it, so no request still holds a
+ *  reference to the server or a client handle once destroy returns */
+static void
+uring_cancel_all(pcom_loop_t* p_loop)
+{
+    const uint64_t marker = OP_DATA(OP_CANCEL, 0, 0xFFFFFF);
+
+    struct io_uring_sqe* p_sqe = uring_sqe(p_loop);
+    if (!p_sqe) return;
+    p_sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    p_sqe->fd = -1;
+    p_sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    p_sqe->user_data = marker;
+
+    for (int tries = 0; tries < 50; ++tries) {
+        if (uring_enter(p_loop, 1, 20) < 0) return;
+        unsigned head = *p_loop->cq_head;
+        unsigned tail = __atomic_load_n(p_loop->cq_tail, __ATOMIC_ACQUIRE);
+        int done = 0;
+        for (; head != tail; ++head)
+            done |= p_loop->cqes[head & p_loop->cq_mask].user_data == marker;
+        __atomic_store_n(p_loop->cq_head, head, __ATOMIC_RELEASE);
+        if (done) return;
+    }
+}
+
+static void
+uring_cleanup(pcom_loop_t* p_loop)
+{
+    if (p_loop->ring_fd >= 0) close(p_loop->ring_fd);
+    if (p_loop->sqes) munmap(p_loop->sqes, p_loop->sqes_len);
+    if (p_loop->ring_map) munmap(p_loop->ring_map, p_loop->ring_map_len);
+    if (p_loop->br) munmap(p_loop->br, p_loop->br_len);
+    p_loop->ring_fd = -1;
+    p_loop->sqes = NULL;
+    p_loop->ring_map = NULL;
+    p_loop->br = NULL;
+}
+
+static int
+uring_init(pcom_loop_t* p_loop)
+{
+    struct io_uring_params params;
+    int result;
+
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    p_loop->ring_fd = sys_uring_setup(PCOM_LOOP_ENTRIES, &params);
+    if (p_loop->ring_fd < 0 && errno == EINVAL) {
+        // Older kernel, retry without the optional setup flags
+        memset(&params, 0, sizeof(params));
+        p_loop->ring_fd = sys_uring_setup(PCOM_LOOP_ENTRIES, &params);
+    }
+    if (p_loop->ring_fd < 0) return pcom_errno_from(errno);
+
+    unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & needed) != needed) { uring_cleanup(p_loop); return -ENOSYS; }
+
+    // Map the shared SQ/CQ rings and the SQE array
+    size_t sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    p_loop->ring_map_len = sq_len > cq_len ? sq_len : cq_len;
+    void* p_ring = mmap(NULL, p_loop->ring_map_len, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, p_loop->ring_fd, IORING_OFF_SQ_RING);
+    if (p_ring == MAP_FAILED) { result = errno; uring_cleanup(p_loop); return pcom_errno_from(result); }
+    p_loop->ring_map = p_ring;
+
+    p_loop->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* p_sqes = mmap(NULL, p_loop->sqes_len, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, p_loop->ring_fd, IORING_OFF_SQES);
+    if (p_sqes == MAP_FAILED) { result = errno; uring_cleanup(p_loop); return pcom_errno_from(result); }
+    p_loop->sqes = p_sqes;
+
+    char* p_base = p_ring;
+    p_loop->sq_head = (unsigned*)(p_base + params.sq_off.head);
+    p_loop->sq_tail = (unsigned*)(p_base + params.sq_off.tail);
+    p_loop->sq_mask = *(unsigned*)(p_base + params.sq_off.ring_mask);
+    p_loop->sq_entries = params.sq_entries;
+    p_loop->cq_head = (unsigned*)(p_base + params.cq_off.head);
+    p_loop->cq_tail = (unsigned*)(p_base + params.cq_off.tail);
+    p_loop->cq_mask = *(unsigned*)(p_base + params.cq_off.ring_mask);
+    p_loop->cqes = (struct io_uring_cqe*)(p_base + params.cq_off.cqes);
+
+    // Identity map SQ array slots to SQEs
+    unsigned* p_array = (unsigned*)(p_base + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; ++i) p_array[i] = i;
+
+    // Register the provided receive buffer ring
+    p_loop->br_len = PCOM_LOOP_BUF_COUNT * sizeof(struct io_uring_buf);
+    void* p_br = mmap(NULL, p_loop->br_len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p_br == MAP_FAILED) { result = errno; uring_cleanup(p_loop); return pcom_errno_from(result); }
+    p_loop->br = p_br;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)p_br;
+    reg.ring_entries = PCOM_LOOP_BUF_COUNT;
+    reg.bgid = 0;
+    if (sys_uring_register(p_loop->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        { result = errno; uring_cleanup(p_loop); return pcom_errno_from(result); }
+
+    p_loop->br_tail = 0;
+    for (int i = 0; i < PCOM_LOOP_BUF_COUNT; ++i) uring_recycle(p_loop, i);
+
+    if (p_loop->server_handle >= 0) uring_arm_accept(p_loop, p_loop->server_handle);
+    if (p_loop->local_handle >= 0) uring_arm_accept(p_loop, p_loop->local_handle);
+    uring_arm_wake(p_loop);
+    p_loop->backend = PCOM_LOOP_BACKEND_URING;
+    return 0;
+}
+
+/* ---- epoll backend ----------------------------------------------------- */
+
+/** Sync epoll registration with the handle's wanted events */
+static int
+epoll_update(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn)
+{
+    uint32_t mask = 0;
+    if (p_conn->added && !p_conn->starved) mask |= EPOLLIN;
+    if (p_conn->want_out) mask |= EPOLLOUT;
+    p_conn->recv_armed = (mask & EPOLLIN) != 0;
+
+    if (p_conn->ep_on && mask == p_conn->ep_mask) return 0;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = mask;
+    ev.data.fd = fd;
+
+    int op = !p_conn->ep_on ? EPOLL_CTL_ADD : (mask ? EPOLL_CTL_MOD : EPOLL_CTL_DEL);
+    if (!p_conn->ep_on && !mask) return 0;
+    if (epoll_ctl(p_loop->epoll_fd, op, fd, &ev) < 0 && op != EPOLL_CTL_DEL)
+        return pcom_errno_from(errno);
+
+    p_conn->ep_on = (op != EPOLL_CTL_DEL);
+    p_conn->ep_mask = mask;
+    return 0;
+}
+
+/** Write queued sends until the queue is empty or the socket is full */
+static void
+epoll_send(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn)
+{
+    while (p_conn->head >= 0 && !p_conn->cancel) {
+        build_msg(p_loop, p_conn);
+        ssize_t n = sendmsg(fd, &p_conn->msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            p_conn->inflight = 0;
+            p_conn->want_out = 1;
+            epoll_update(p_loop, fd, p_conn);
+            return;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        complete_send(p_loop, fd, p_conn, n < 0 ? pcom_errno_from(errno) : (int)n);
+    }
+    if (p_conn->want_out) {
+        p_conn->want_out = 0;
+        epoll_update(p_loop, fd, p_conn);
+    }
+}
+
+static void
+epoll_recv(pcom_loop_t* p_loop, int fd, loop_conn_t* p_conn)
+{
+    if (p_loop->buf_free_count == 0) {
+        // Resumed by pcom_loop_release()
+        p_conn->starved = 1;
+        p_loop->starved_count++;
+        epoll_update(p_loop, fd, p_conn);
+        return;
+    }
+
+    int bid = p_loop->buf_free[--p_loop->buf_free_count];
+    char* p_buf = p_loop->buf_mem + (size_t)bid * PCOM_LOOP_BUF_SIZE;
+    ssize_t n = recv(fd, p_buf, PCOM_LOOP_BUF_SIZE, MSG_DONTWAIT);
+
+    if (n > 0) {
+        push_event(p_loop, PCOM_EVENT_RECV, fd, (int)n, bid, p_buf, NULL);
+        return;
+    }
+
+    int err = (n < 0) ? errno : 0;
+    p_loop->buf_free[p_loop->buf_free_count++] = bid;
+    if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR) return;
+
+    p_conn->added = 0;
+    epoll_update(p_loop, fd, p_conn);
+    push_event(p_loop, PCOM_EVENT_RECV, fd, n < 0 ? pcom_errno_from(err) : 0, -1, NULL, NULL);
+}
+
+static long long
+now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/** Stop or resume watching a listener, it stays registered */
+static void
+epoll_listen(pcom_loop_t* p_loop, int fd, int on)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = on ? EPOLLIN : 0;
+    ev.data.fd = fd;
+    epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+/** Out of handles or memory the level triggered listener stays readable and
+ *  would fail again at once, so it sits out ACCEPT_RETRY_MS */
+static void
+epoll_pause_accept(pcom_loop_t* p_loop, int fd)
+{
+    epoll_listen(p_loop, fd, 0);
+    if (!p_loop->accept_paused) p_loop->accept_resume = now_ms() + ACCEPT_RETRY_MS;
+    p_loop->accept_paused |= (fd == p_loop->server_handle) ? 1 : 2;
+}
+
+/** Put paused listeners back when due, returns the wait timeout capped to that */
+static int
+epoll_resume_accept(pcom_loop_t* p_loop, int timeout_ms)
+{
+    if (!p_loop->accept_paused) return timeout_ms;
+    long long left = p_loop->accept_resume - now_ms();
+    if (left > 0) return (timeout_ms < 0 || timeout_ms > left) ? (int)left : timeout_ms;
+    if (p_loop->accept_paused & 1) epoll_listen(p_loop, p_loop->server_handle, 1);
+    if (p_loop->accept_paused & 2) epoll_listen(p_loop, p_loop->local_handle, 1);
+    p_loop->accept_paused = 0;
+    return timeout_ms;
+}
+
+static int
+epoll_poll(pcom_loop_t* p_loop, int timeout_ms)
+{
+    struct epoll_event evs[EPOLL_BATCH];
+    timeout_ms = epoll_resume_accept(p_loop, timeout_ms);
+    int n = epoll_wait(p_loop->epoll_fd, evs, EPOLL_BATCH, timeout_ms);
+    if (n < 0) return (errno == EINTR) ? 0 : pcom_errno_from(errno);
+
+    for (int i = 0; i < n; ++i) {
+        int fd = evs[i].data.fd;
+
+        if (fd == p_loop->wake_fd) {
+            uint64_t val;
+            if (read(fd, &val, sizeof(val)) < 0) { /* Counter already drained */ }
+            continue;
+        }
+
+        if (fd == p_loop->server_handle || fd == p_loop->local_handle) {
+            int client = accept(fd, NULL, NULL);
+            int err = (client < 0) ? errno : 0;
+            if (client >= 0) push_event(p_loop, PCOM_EVENT_ACCEPT, client, 0, -1, NULL, NULL);
+            else if (err != EAGAIN && err != EINTR && err != ECONNABORTED)
+                push_event(p_loop, PCOM_EVENT_ACCEPT, -1, pcom_errno_from(err), -1, NULL, NULL);
+            if (err == EMFILE || err == ENFILE || err == ENOMEM || err == ENOBUFS)
+                epoll_pause_accept(p_loop, fd);
+            continue;
+        }
+
+        loop_conn_t* p_conn = conn_get(p_loop, fd, 0);
+        if (!p_conn) continue;
+        if ((evs[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && p_conn->head >= 0)
+            epoll_send(p_loop, fd, p_conn);
+        if ((evs[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && p_conn->added && !p_conn->starved)
+            epoll_recv(p_loop, fd, p_conn);
+    }
+    return 0;
+}
+
+static int
+epoll_init(pcom_loop_t* p_loop)
+{
+    p_loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (p_loop->epoll_fd < 0) return pcom_errno_from(errno);
+
+    p_loop->buf_free = malloc(PCOM_LOOP_BUF_COUNT * sizeof(int));
+    if (!p_loop->buf_free) return -ENOMEM;
+    for (int i = 0; i < PCOM_LOOP_BUF_COUNT; ++i)
+        p_loop->buf_free[i] = PCOM_LOOP_BUF_COUNT - 1 - i;
+    p_loop->buf_free_count = PCOM_LOOP_BUF_COUNT;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = p_loop->wake_fd;
+    if (epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_ADD, p_loop->wake_fd, &ev) < 0)
+        return pcom_errno_from(errno);
+
+    if (p_loop->server_handle >= 0) {
+        ev.data.fd = p_loop->server_handle;
+        if (epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_ADD, p_loop->server_handle, &ev) < 0)
+            return pcom_errno_from(errno);
+    }
+    if (p_loop->local_handle >= 0) {
+        ev.data.fd = p_loop->local_handle;
+        if (epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_ADD, p_loop->local_handle, &ev) < 0)
+            return pcom_errno_from(errno);
+    }
+    p_loop->backend = PCOM_LOOP_BACKEND_EPOLL;
+    return 0;
+}
+
+/* ---- Common ------------------------------------------------------------ */
+
+/** Issue sends and arm receives for all marked handles */
+static void
+process_flush(pcom_loop_t* p_loop)
+{
+    // Handlers may append to the list while it is walked
+    while (p_loop->flush_count > 0) {
+        int fd = p_loop->flush[p_loop->flush_head];
+        p_loop->flush_head = (p_loop->flush_head + 1) % p_loop->flush_cap;
+        p_loop->flush_count--;
+        loop_conn_t* p_conn = conn_get(p_loop, fd, 0);
+        if (!p_conn) continue;
+
+        p_conn->dirty = 0;
+        if (p_loop->backend == PCOM_LOOP_BACKEND_URING) {
+            if (p_conn->added && !p_conn->recv_armed && !p_conn->starved)
+                uring_arm_recv(p_loop, fd, p_conn);
+            if (p_conn->head >= 0 && !p_conn->inflight && !p_conn->cancel)
+                uring_send(p_loop, fd, p_conn);
+        } else {
+            epoll_update(p_loop, fd, p_conn);
+            epoll_send(p_loop, fd, p_conn);
+        }
+    }
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_loop_create(pcom_loop_t** pp_loop, int server_handle, int flags)
+{
+    int result;
+
+    if (!pp_loop) return -EINVAL;
+    *pp_loop = NULL;
+
+    pcom_loop_t* p_loop = calloc(1, sizeof(*p_loop));
+    if (!p_loop) return -ENOMEM;
+    p_loop->server_handle = server_handle;
+    p_loop->local_handle = (server_handle >= 0) ? pcom_tcp_local_handle(server_handle) : -1;
+    p_loop->ring_fd = -1;
+    p_loop->epoll_fd = -1;
+    p_loop->op_free = -1;
+
+    // Blocking eventfd: io_uring returns EAGAIN at once on non-blocking files
+    p_loop->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (p_loop->wake_fd < 0) {
+        result = errno;
+        free(p_loop);
+        return pcom_errno_from(result);
+    }
+
+    // One slab for all receive buffers
+    p_loop->buf_mem = mmap(NULL, (size_t)PCOM_LOOP_BUF_COUNT * PCOM_LOOP_BUF_SIZE,
+                           PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p_loop->buf_mem == MAP_FAILED) {
+        result = errno;
+        close(p_loop->wake_fd);
+        free(p_loop);
+        return pcom_errno_from(result);
+    }
+
+    result = -ENOSYS;
+    if (!(flags & PCOM_LOOP_EPOLL)) result = uring_init(p_loop);
+    if (result < 0) result = epoll_init(p_loop);
+    if (result < 0) {
+        pcom_loop_destroy(p_loop);
+        return result;
+    }
+
+    *pp_loop = p_loop;
+    return 0;
+}
+
+int
+pcom_loop_backend(const pcom_loop_t* p_loop)
+{
+    return p_loop->backend;
+}
+
+int
+pcom_loop_add(pcom_loop_t* p_loop, int client_handle)
+{
+    loop_conn_t* p_conn = conn_get(p_loop, client_handle, 1);
+    if (!p_conn) return client_handle < 0 ? -EBADF : -ENOMEM;
+    if (p_conn->added) return -EEXIST;
+    if (p_conn->cancel && p_conn->inflight) return -EBUSY;
+
+    // A pending removal of the previous user of this handle is dropped
+    p_conn->cancel = 0;
+    p_conn->added = 1;
+    p_conn->removing = 0;
+    p_conn->starved = 0;
+    p_conn->gen++;
+    mark_dirty(p_loop, client_handle, p_conn);
+    return 0;
+}
+
+int
+pcom_loop_remove(pcom_loop_t* p_loop, int client_handle)
+{
+    loop_conn_t* p_conn = conn_get(p_loop, client_handle, 0);
+    if (!p_conn) return -ENOENT;
+
+    if (p_conn->removing) return 0;
+    if (ready_reserve(p_loop, 1) < 0) return -ENOMEM;
+    if (p_conn->starved) p_loop->starved_count--;
+    p_conn->starved = 0;
+    p_conn->added = 0;
+
+    if (p_loop->backend == PCOM_LOOP_BACKEND_URING && p_conn->recv_armed) {
+        // PCOM_EVENT_REMOVED follows when the cancelled receive completes
+        uring_cancel_recv(p_loop, client_handle, p_conn->gen);
+        p_conn->removing = 1;
+    } else {
+        if (p_loop->backend == PCOM_LOOP_BACKEND_EPOLL) {
+            p_conn->want_out = 0;
+            epoll_update(p_loop, client_handle, p_conn);
+        }
+        finish_remove(p_loop, client_handle, p_conn);
+    }
+
+    // Sends the kernel has not seen yet never will
+    p_conn->cancel = 1;
+    fail_sends(p_loop, p_conn, client_handle, p_conn->inflight, -ECANCELED);
+    return 0;
+}
+
+int
+pcom_loop_send(pcom_loop_t* p_loop, int client_handle, const void* buf, size_t len, void* user)
+{
+    loop_conn_t* p_conn = conn_get(p_loop, client_handle, 1);
+    if (!p_conn) return client_handle < 0 ? -EBADF : -ENOMEM;
+    if (p_conn->cancel) {
+        if (p_conn->inflight) return -EBUSY;
+        p_conn->cancel = 0;
+    }
+    if (len > (size_t)0x7FFFFFFF) return -EMSGSIZE;
+    if (len == 0) return push_event(p_loop, PCOM_EVENT_SEND, client_handle, 0, -1, buf, user);
+
+    int id = op_alloc(p_loop);
+    if (id < 0) return -ENOMEM;
+    loop_op_t* p_op = &p_loop->ops[id];
+    p_op->buf = buf;
+    p_op->len = len;
+    p_op->done = 0;
+    p_op->user = user;
+    p_op->next = -1;
+
+    if (p_conn->tail >= 0) p_loop->ops[p_conn->tail].next = id;
+    else p_conn->head = id;
+    p_conn->tail = id;
+
+    if (!p_conn->inflight) mark_dirty(p_loop, client_handle, p_conn);
+    return 0;
+}
+
+int
+pcom_loop_wait(pcom_loop_t* p_loop, pcom_event_t* events, int max_events, int timeout_ms)
+{
+    int result;
+
+    if (!events || max_events <= 0) return -EINVAL;
+
+    // A completion gives at most a receive and a removal, besides the sends
+    int batch = (p_loop->backend == PCOM_LOOP_BACKEND_URING) ? 2 * (int)(p_loop->cq_mask + 1) : EPOLL_BATCH;
+    if (ready_reserve(p_loop, batch) < 0) return -ENOMEM;
+
+    process_flush(p_loop);
+
+    if (p_loop->backend == PCOM_LOOP_BACKEND_URING) {
+        // One enter submits everything queued and reaps a batch of completions
+        unsigned min_complete = (p_loop->ready_count == 0 && timeout_ms != 0) ? 1 : 0;
+        result = uring_enter(p_loop, min_complete, timeout_ms);
+        if (result < 0) return result;
+        uring_reap(p_loop);
+        // Resubmit partial sends, re-arm receives and whatever the
+        // completions re-armed without waiting
+        if (p_loop->flush_count) process_flush(p_loop);
+        if (p_loop->to_submit) uring_enter(p_loop, 0, 0);
+    } else {
+        result = epoll_poll(p_loop, p_loop->ready_count ? 0 : timeout_ms);
+        if (result < 0) return result;
+        process_flush(p_loop);
+    }
+
+    int n = 0;
+    while (n < max_events && p_loop->ready_count > 0) {
+        events[n++] = p_loop->ready[p_loop->ready_head];
+        p_loop->ready_head = (p_loop->ready_head + 1) % p_loop->ready_cap;
+        p_loop->ready_count--;
+    }
+    return n;
+}
+
+int
+pcom_loop_wake(pcom_loop_t* p_loop)
+{
+    uint64_t one = 1;
+    if (write(p_loop->wake_fd, &one, sizeof(one)) < 0) return pcom_errno_from(errno);
+    return 0;
+}
+
+void
+pcom_loop_release(pcom_loop_t* p_loop, const pcom_event_t* p_event)
+{
+    if (!p_event || p_event->buf_id < 0) return;
+
+    if (p_loop->backend == PCOM_LOOP_BACKEND_URING) uring_recycle(p_loop, p_event->buf_id);
+    else p_loop->buf_free[p_loop->buf_free_count++] = p_event->buf_id;
+
+    if (p_loop->starved_count > 0) {
+        // Resume receives paused by buffer exhaustion
+        for (int fd = 0; fd < p_loop->conn_cap; ++fd) {
+            loop_conn_t* p_conn = p_loop->conns[fd];
+            if (p_conn && p_conn->starved) {
+                p_conn->starved = 0;
+                mark_dirty(p_loop, fd, p_conn);
+            }
+        }
+        p_loop->starved_count = 0;
+    }
+}
+
+void
+pcom_loop_destroy(pcom_loop_t* p_loop)
+{
+    if (!p_loop) return;
+    if (p_loop->backend == PCOM_LOOP_BACKEND_URING) uring_cancel_all(p_loop);
+    uring_cleanup(p_loop);
+    if (p_loop->epoll_fd >= 0) close(p_loop->epoll_fd);
+    if (p_loop->wake_fd >= 0) close(p_loop->wake_fd);
+    if (p_loop->buf_mem && p_loop->buf_mem != MAP_FAILED)
+        munmap(p_loop->buf_mem, (size_t)PCOM_LOOP_BUF_COUNT * PCOM_LOOP_BUF_SIZE);
+    for (int fd = 0; fd < p_loop->conn_cap; ++fd) free(p_loop->conns[fd]);
+    free(p_loop->conns);
+    free(p_loop->ops);
+    free(p_loop->flush);
+    free(p_loop->ready);
+    free(p_loop->buf_free);
+    free(p_loop);
+}
+
+#else /* Not supported platforms */
+
+int pcom_loop_create(pcom_loop_t** pp_loop, int server_handle, int flags)
+    { (void)server_handle; (void)flags; if (pp_loop) *pp_loop = NULL; return -1; }
+int pcom_loop_backend(const pcom_loop_t* p_loop) { (void)p_loop; return 0; }
+int pcom_loop_add(pcom_loop_t* p_loop, int client_handle)
+    { (void)p_loop; (void)client_handle; return -1; }
+int pcom_loop_remove(pcom_loop_t* p_loop, int client_handle)
+    { (void)p_loop; (void)client_handle; return -1; }
+int pcom_loop_send(pcom_loop_t* p_loop, int client_handle, const void* buf, size_t len, void* user)
+    { (void)p_loop; (void)client_handle; (void)buf; (void)len; (void)user; return -1; }
+int pcom_loop_wait(pcom_loop_t* p_loop, pcom_event_t* events, int max_events, int timeout_ms)
+    { (void)p_loop; (void)events; (void)max_events; (void)timeout_ms; return -1; }
+int pcom_loop_wake(pcom_loop_t* p_loop) { (void)p_loop; return -1; }
+void pcom_loop_release(pcom_loop_t* p_loop, const pcom_event_t* p_event)
+    { (void)p_loop; (void)p_event; }
+void pcom_loop_destroy(pcom_loop_t* p_loop) { (void)p_loop; }
+
+#endif
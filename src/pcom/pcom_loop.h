@@ -0,0 +1,190 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_loop.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     PCOM event loop with io_uring and epoll backends.
+ ****************************************************************************/
+/** @defgroup  PCOM_LOOP
+ * @brief     Completion based event loop for PCOM handles.
+ * @details   Drives accept, receive and send for many PCOM handles from one
+ *            thread. On Linux the io_uring backend uses multishot accept,
+ *            multishot receive into a provided buffer ring and gathered
+ *            sends, and reaps all completions with one io_uring_enter() per
+ *            pcom_loop_wait(). When io_uring is unavailable the loop falls
+ *            back to an epoll backend with the same semantics.
+ *            Handles going in and out of the loop are ordinary PCOM handles
+ *            and can be used with pcom_server_check_user(), pcom_client_close()
+ *            and the rest of the blocking API.
+ *
+ * @pre       pcom.h
+ * @bug       -
+ * @warning   Linux only. Other platforms use the blocking API in pcom.h.
+ *            A loop is not thread safe, use one loop per thread. Only
+ *            pcom_loop_wake() may be called from other threads.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_LOOP_H
+#define PCOM_LOOP_H
+
+#include <stddef.h>  // for size_t
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef PCOM_LOOP_ENTRIES
+#define PCOM_LOOP_ENTRIES  (256)   // Submission queue size (power of 2)
+#endif
+#ifndef PCOM_LOOP_BUF_COUNT
+#define PCOM_LOOP_BUF_COUNT (256)  // Number of receive buffers (power of 2)
+#endif
+#ifndef PCOM_LOOP_BUF_SIZE
+#define PCOM_LOOP_BUF_SIZE (4096)  // Size of each receive buffer
+#endif
+#define PCOM_LOOP_IOV_MAX  (16)    // Max queued sends gathered per syscall
+
+/* Flags for pcom_loop_create() */
+#define PCOM_LOOP_DEFAULT  (0)      // io_uring if available, otherwise epoll
+#define PCOM_LOOP_EPOLL    (1 << 0) // Force the epoll backend
+
+/* Backends returned by pcom_loop_backend() */
+#define PCOM_LOOP_BACKEND_URING (1)
+#define PCOM_LOOP_BACKEND_EPOLL (2)
+
+/* Event types */
+#define PCOM_EVENT_ACCEPT  (1)  // New client accepted on the server handle
+#define PCOM_EVENT_RECV    (2)  // Data received, EOF (0) or receive error
+#define PCOM_EVENT_SEND    (3)  // A pcom_loop_send() completed
+#define PCOM_EVENT_REMOVED (4)  // Handle detached after pcom_loop_remove()
+
+typedef struct pcom_loop pcom_loop_t;
+
+typedef struct {
+    int type;            // PCOM_EVENT_* type
+    int handle;          // Client handle the event belongs to
+    int result;          // Bytes transferred, 0 on EOF or negative error code
+    int buf_id;          // Receive buffer id, -1 if no buffer is held
+    const void* data;    // RECV: received bytes. SEND: buffer given to send
+    void* user;          // SEND: user pointer given to pcom_loop_send()
+} pcom_event_t;
+
+/**
+ * @brief      Create an event loop.
+ * @param      pp_loop        Receives the new loop.
+ * @param      server_handle  Server handle to accept on, or -1 for none.
+ * @param      flags          PCOM_LOOP_DEFAULT or PCOM_LOOP_EPOLL.
+ * @return     0 on success, negative error code on failure.
+ * @details    Tries io_uring first and silently falls back to epoll when
+ *             the kernel lacks io_uring, provided buffer rings or extended
+ *             wait arguments. Accepted clients are reported as
+ *             PCOM_EVENT_ACCEPT and are not added to the loop automatically.
+ *             Failed accepts come as PCOM_EVENT_ACCEPT with a negative
+ *             result; out of handles (-EMFILE) or memory the loop pauses
+ *             accepting for a moment, then goes on.
+ */
+LIB_EXPORT int
+pcom_loop_create(pcom_loop_t** pp_loop, int server_handle, int flags);
+
+/**
+ * @brief      Get the backend in use.
+ * @param      p_loop  The loop.
+ * @return     PCOM_LOOP_BACKEND_URING or PCOM_LOOP_BACKEND_EPOLL.
+ */
+LIB_EXPORT int
+pcom_loop_backend(const pcom_loop_t* p_loop);
+
+/**
+ * @brief      Start receiving on a client handle.
+ * @param      p_loop         The loop.
+ * @param      client_handle  Handle from pcom_server_accept(), pcom_client_open()
+ *                            or a PCOM_EVENT_ACCEPT event.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_loop_add(pcom_loop_t* p_loop, int client_handle);
+
+/**
+ * @brief      Stop receiving on a client handle.
+ * @param      p_loop         The loop.
+ * @param      client_handle  The client handle.
+ * @return     0 on success, negative error code on failure.
+ * @details    Sends not yet handed to the kernel complete with -ECANCELED.
+ *             Receive events for data the kernel had already read may still
+ *             follow, then one PCOM_EVENT_REMOVED once nothing more will be
+ *             received. Wait for it before handing the handle to another
+ *             loop. Callers that just close the handle need not wait.
+ */
+LIB_EXPORT int
+pcom_loop_remove(pcom_loop_t* p_loop, int client_handle);
+
+/**
+ * @brief      Queue a send on a client handle.
+ * @param      p_loop         The loop.
+ * @param      client_handle  The client handle.
+ * @param      buf            Data to send. Must stay valid until the
+ *                            matching PCOM_EVENT_SEND.
+ * @param      len            Length of the data.
+ * @param      user           User pointer returned in the send event.
+ * @return     0 on success, negative error code on failure.
+ * @details    Sends are issued on the next pcom_loop_wait(). Queued sends on
+ *             one handle keep their order and are gathered into one syscall.
+ *             Short writes are resumed internally, the event reports the
+ *             full length or an error.
+ */
+LIB_EXPORT int
+pcom_loop_send(pcom_loop_t* p_loop, int client_handle, const void* buf, size_t len, void* user);
+
+/**
+ * @brief      Submit queued work and wait for events.
+ * @param      p_loop      The loop.
+ * @param      events      Array receiving the events.
+ * @param      max_events  Size of the events array.
+ * @param      timeout_ms  Max time to wait, -1 waits forever, 0 polls.
+ * @return     Number of events, negative error code on failure.
+ * @details    Receive events hold a buffer from the loop that must be
+ *             returned with pcom_loop_release() once the data is consumed.
+ */
+LIB_EXPORT int
+pcom_loop_wait(pcom_loop_t* p_loop, pcom_event_t* events, int max_events, int timeout_ms);
+
+/**
+ * @brief      Wake a thread blocked in pcom_loop_wait().
+ * @param      p_loop  The loop.
+ * @return     0 on success, negative error code on failure.
+ * @details    The only loop function that may be called from another thread.
+ *             The woken pcom_loop_wait() may return 0 events.
+ */
+LIB_EXPORT int
+pcom_loop_wake(pcom_loop_t* p_loop);
+
+/**
+ * @brief      Return the receive buffer held by an event to the loop.
+ * @param      p_loop   The loop.
+ * @param      p_event  Event from pcom_loop_wait(). No-op if it holds no buffer.
+ */
+LIB_EXPORT void
+pcom_loop_release(pcom_loop_t* p_loop, const pcom_event_t* p_event);
+
+/**
+ * @brief      Destroy the loop.
+ * @param      p_loop  The loop.
+ * @details    Handles in the loop and the server handle are not closed.
+ */
+LIB_EXPORT void
+pcom_loop_destroy(pcom_loop_t* p_loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_LOOP_H
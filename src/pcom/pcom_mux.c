@@ -0,0 +1,387 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_mux.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Prioritized logical channels over one PCOM connection.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sys/socket.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#endif
+
+#include "pcom_mux.h"
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define CHANNELS (65536)
+
+/** A message being sent, lives on the sender's stack */
+typedef struct mux_msg {
+    struct mux_msg* next;
+    uint16_t channel;
+    const uint8_t* data;
+    size_t len;
+    size_t off;          // Bytes sent so far
+    int done;
+    int result;
+} mux_msg_t;
+
+/** Partly received message */
+typedef struct {
+    uint16_t channel;
+    uint8_t* buf;
+    size_t len;
+    size_t cap;
+} mux_partial_t;
+
+struct pcom_mux {
+    int handle;
+    pcom_mux_opts_t opts;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;       // Writer: a message was queued
+    pthread_cond_t done;       // Senders: a message completed
+    mux_msg_t* head[PCOM_MUX_PRIORITIES];
+    mux_msg_t* tail[PCOM_MUX_PRIORITIES];
+    int stop;
+    int dead;                  // Write error, fails all further sends
+    pthread_t writer;
+
+    int has_reader;
+    pthread_t reader;
+    mux_partial_t* partial;    // Reader thread only
+    int partial_count;
+
+    pcom_mux_stats_t stats;    // Guarded by lock
+    uint8_t prio[CHANNELS];    // Priority + 1, 0 for default
+};
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static int
+channel_prio(const pcom_mux_t* p_m, uint16_t channel)
+{
+    int p = __atomic_load_n(&p_m->prio[channel], __ATOMIC_RELAXED);
+    return p ? p - 1 : PCOM_MUX_PRIO_DEFAULT;
+}
+
+/* Queue holding a message of the channel, -1 if none. Later messages of
+ * the channel join it whatever its priority is now, so a priority change
+ * never lets one overtake and interleave with the one in flight. */
+static int
+queued_prio(const pcom_mux_t* p_m, uint16_t channel)
+{
+    for (int p = 0; p < PCOM_MUX_PRIORITIES; ++p) {
+        for (const mux_msg_t* p_msg = p_m->head[p]; p_msg; p_msg = p_msg->next)
+            if (p_msg->channel == channel) return p;
+    }
+    return -1;
+}
+
+/* Most urgent queued message */
+static mux_msg_t*
+next_msg(pcom_mux_t* p_m, int* p_prio)
+{
+    for (int p = 0; p < PCOM_MUX_PRIORITIES; ++p) {
+        if (p_m->head[p]) {
+            *p_prio = p;
+            return p_m->head[p];
+        }
+    }
+    return NULL;
+}
+
+static void
+fail_all(pcom_mux_t* p_m, int result)
+{
+    for (int p = 0; p < PCOM_MUX_PRIORITIES; ++p) {
+        for (mux_msg_t* p_msg = p_m->head[p]; p_msg; p_msg = p_msg->next) {
+            p_msg->result = result;
+            p_msg->done = 1;
+        }
+        p_m->head[p] = p_m->tail[p] = NULL;
+    }
+    pthread_cond_broadcast(&p_m->done);
+}
+
+/* Writer thread, one chunk of the most urgent message at a time */
+static void*
+writer_main(void* arg)
+{
+    pcom_mux_t* p_m = arg;
+    mux_msg_t* p_last = NULL;   // Message of the previous chunk
+    int prio;
+
+    pthread_mutex_lock(&p_m->lock);
+    while (!p_m->stop) {
+        mux_msg_t* p_msg = next_msg(p_m, &prio);
+        if (!p_msg) {
+            pthread_cond_wait(&p_m->work, &p_m->lock);
+            continue;
+        }
+        if (p_last && p_last != p_msg && p_last->off > 0 && !p_last->done) p_m->stats.preempted++;
+        p_last = p_msg;
+
+        size_t chunk = p_msg->len - p_msg->off;
+        if (chunk > p_m->opts.chunk) chunk = p_m->opts.chunk;
+        pcom_frame_hdr_t hdr = { (uint32_t)chunk, PCOM_FRAME_MUX, 0, p_msg->channel };
+        if (p_msg->off + chunk < p_msg->len) hdr.flags = PCOM_MUX_MORE;
+        uint8_t raw[PCOM_FRAME_HDR_SIZE];
+        pcom_frame_encode(raw, &hdr);
+        pcom_iovec_t iov[2] = { { raw, sizeof(raw) }, { p_msg->data + p_msg->off, chunk } };
+
+        // Only the writer removes messages, so p_msg stays queued meanwhile
+        pthread_mutex_unlock(&p_m->lock);
+        int64_t result = pcom_sendv(p_m->handle, iov, 2);
+        pthread_mutex_lock(&p_m->lock);
+
+        if (result < 0) {
+            p_m->dead = (int)result;
+            fail_all(p_m, (int)result);
+            p_last = NULL;
+            continue;
+        }
+        p_msg->off += chunk;
+        p_m->stats.frames++;
+        p_m->stats.bytes += chunk;
+        if (p_msg->off == p_msg->len) {
+            p_m->head[prio] = p_msg->next;
+            if (!p_m->head[prio]) p_m->tail[prio] = NULL;
+            p_m->stats.messages++;
+            p_msg->done = 1;
+            p_last = NULL;
+            pthread_cond_broadcast(&p_m->done);
+        }
+    }
+    pthread_mutex_unlock(&p_m->lock);
+    return NULL;
+}
+
+static mux_partial_t*
+partial_find(pcom_mux_t* p_m, uint16_t channel)
+{
+    for (int i = 0; i < p_m->partial_count; ++i)
+        if (p_m->partial[i].channel == channel) return &p_m->partial[i];
+    return NULL;
+}
+
+/* Add a chunk to its channel, 1 with *pp_data set when the message is complete */
+static int
+reassemble(pcom_mux_t* p_m, const pcom_frame_hdr_t* p_hdr, const void* payload,
+           const void** pp_data, size_t* p_len)
+{
+    mux_partial_t* p_part = partial_find(p_m, p_hdr->channel);
+
+    // Single chunk message, no copy
+    if (!p_part && !(p_hdr->flags & PCOM_MUX_MORE)) {
+        *pp_data = payload;
+        *p_len = p_hdr->len;
+        return 1;
+    }
+    if (!p_part) {
+        mux_partial_t* p = realloc(p_m->partial, (size_t)(p_m->partial_count + 1) * sizeof(*p));
+        if (!p) return -ENOMEM;
+        p_m->partial = p;
+        p_part = &p[p_m->partial_count++];
+        memset(p_part, 0, sizeof(*p_part));
+        p_part->channel = p_hdr->channel;
+    }
+    if (p_part->len + p_hdr->len > p_m->opts.msg_max) return -EMSGSIZE;
+    if (p_part->cap - p_part->len < p_hdr->len) {
+        size_t cap = p_part->cap ? p_part->cap : p_m->opts.chunk;
+        while (cap - p_part->len < p_hdr->len) cap *= 2;
+        uint8_t* p = realloc(p_part->buf, cap);
+        if (!p) return -ENOMEM;
+        p_part->buf = p;
+        p_part->cap = cap;
+    }
+    memcpy(p_part->buf + p_part->len, payload, p_hdr->len);
+    p_part->len += p_hdr->len;
+    if (p_hdr->flags & PCOM_MUX_MORE) return 0;
+
+    *pp_data = p_part->buf;
+    *p_len = p_part->len;
+    return 1;
+}
+
+/* Drop a delivered partial, swapping the last one into its place */
+static void
+partial_release(pcom_mux_t* p_m, uint16_t channel)
+{
+    mux_partial_t* p_part = partial_find(p_m, channel);
+    if (!p_part) return;
+    free(p_part->buf);
+    *p_part = p_m->partial[--p_m->partial_count];
+}
+
+static void*
+reader_main(void* arg)
+{
+    pcom_mux_t* p_m = arg;
+    pcom_frame_reader_t reader;
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    const void* data;
+    size_t len;
+    int result;
+
+    pcom_frame_reader_init(&reader);
+    while ((result = pcom_frame_recv(p_m->handle, &reader, &hdr, &payload)) > 0) {
+        if (hdr.type != PCOM_FRAME_MUX) continue;
+        result = reassemble(p_m, &hdr, payload, &data, &len);
+        if (result < 0) break;
+        if (result == 0) continue;
+        p_m->opts.on_message(p_m, hdr.channel, data, len, p_m->opts.user);
+        partial_release(p_m, hdr.channel);
+        pthread_mutex_lock(&p_m->lock);
+        p_m->stats.received++;
+        pthread_mutex_unlock(&p_m->lock);
+    }
+    pcom_frame_reader_free(&reader);
+    if (p_m->opts.on_close) p_m->opts.on_close(p_m, result, p_m->opts.user);
+    return NULL;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_mux_create(pcom_mux_t** pp_mux, int handle, const pcom_mux_opts_t* p_opts)
+{
+    int result;
+
+    if (!pp_mux) return -EINVAL;
+    *pp_mux = NULL;
+    if (handle < 0) return -EBADF;
+
+    pcom_mux_t* p_m = calloc(1, sizeof(*p_m));
+    if (!p_m) return -ENOMEM;
+    p_m->handle = handle;
+    if (p_opts) p_m->opts = *p_opts;
+    if (!p_m->opts.chunk || p_m->opts.chunk > PCOM_FRAME_MAX) p_m->opts.chunk = PCOM_MUX_CHUNK;
+    if (!p_m->opts.msg_max) p_m->opts.msg_max = PCOM_MUX_MSG_MAX;
+    pthread_mutex_init(&p_m->lock, NULL);
+    pthread_cond_init(&p_m->work, NULL);
+    pthread_cond_init(&p_m->done, NULL);
+
+    result = pthread_create(&p_m->writer, NULL, writer_main, p_m);
+    if (result != 0) goto fail;
+    if (p_m->opts.on_message) {
+        result = pthread_create(&p_m->reader, NULL, reader_main, p_m);
+        if (result != 0) {
+            pthread_mutex_lock(&p_m->lock);
+            p_m->stop = 1;
+            pthread_cond_signal(&p_m->work);
+            pthread_mutex_unlock(&p_m->lock);
+            pthread_join(p_m->writer, NULL);
+            goto fail;
+        }
+        p_m->has_reader = 1;
+    }
+
+    *pp_mux = p_m;
+    return 0;
+
+fail:
+    pthread_cond_destroy(&p_m->done);
+    pthread_cond_destroy(&p_m->work);
+    pthread_mutex_destroy(&p_m->lock);
+    free(p_m);
+    return pcom_errno_from(result);
+}
+
+int
+pcom_mux_set_priority(pcom_mux_t* p_mux, uint16_t channel, int priority)
+{
+    if (!p_mux || priority < 0 || priority >= PCOM_MUX_PRIORITIES) return -EINVAL;
+    __atomic_store_n(&p_mux->prio[channel], (uint8_t)(priority + 1), __ATOMIC_RELAXED);
+    return 0;
+}
+
+int
+pcom_mux_send(pcom_mux_t* p_mux, uint16_t channel, const void* data, size_t len)
+{
+    if (!p_mux || (!data && len)) return -EINVAL;
+
+    mux_msg_t msg = { NULL, channel, data, len, 0, 0, 0 };
+
+    pthread_mutex_lock(&p_mux->lock);
+    if (p_mux->dead || p_mux->stop) {
+        int result = p_mux->dead ? p_mux->dead : -ECANCELED;
+        pthread_mutex_unlock(&p_mux->lock);
+        return result;
+    }
+    int prio = queued_prio(p_mux, channel);
+    if (prio < 0) prio = channel_prio(p_mux, channel);
+    if (p_mux->tail[prio]) p_mux->tail[prio]->next = &msg;
+    else p_mux->head[prio] = &msg;
+    p_mux->tail[prio] = &msg;
+    pthread_cond_signal(&p_mux->work);
+    while (!msg.done) pthread_cond_wait(&p_mux->done, &p_mux->lock);
+    pthread_mutex_unlock(&p_mux->lock);
+    return msg.result;
+}
+
+int
+pcom_mux_stats(pcom_mux_t* p_mux, pcom_mux_stats_t* p_stats)
+{
+    if (!p_mux || !p_stats) return -EINVAL;
+    pthread_mutex_lock(&p_mux->lock);
+    *p_stats = p_mux->stats;
+    pthread_mutex_unlock(&p_mux->lock);
+    return 0;
+}
+
+void
+pcom_mux_destroy(pcom_mux_t* p_mux)
+{
+    if (!p_mux) return;
+
+    pthread_mutex_lock(&p_mux->lock);
+    p_mux->stop = 1;
+    pthread_cond_signal(&p_mux->work);
+    pthread_mutex_unlock(&p_mux->lock);
+
+    // Unblocks a writer stuck on a full socket and the reader
+    shutdown(p_mux->handle, SHUT_RDWR);
+    pthread_join(p_mux->writer, NULL);
+    if (p_mux->has_reader) pthread_join(p_mux->reader, NULL);
+
+    pthread_mutex_lock(&p_mux->lock);
+    fail_all(p_mux, -ECANCELED);
+    pthread_mutex_unlock(&p_mux->lock);
+
+    for (int i = 0; i < p_mux->partial_count; ++i) free(p_mux->partial[i].buf);
+    free(p_mux->partial);
+    pcom_client_close(p_mux->handle);
+    pthread_cond_destroy(&p_mux->done);
+    pthread_cond_destroy(&p_mux->work);
+    pthread_mutex_destroy(&p_mux->lock);
+    free(p_mux);
+}
+
+#else /* Not supported platforms */
+
+int pcom_mux_create(pcom_mux_t** pp_mux, int handle, const pcom_mux_opts_t* p_opts)
+    { (void)handle; (void)p_opts; if (pp_mux) *pp_mux = NULL; return -1; }
+int pcom_mux_set_priority(pcom_mux_t* p_mux, uint16_t channel, int priority)
+    { (void)p_mux; (void)channel; (void)priority; return -1; }
+int pcom_mux_send(pcom_mux_t* p_mux, uint16_t channel, const void* data, size_t len)
+    { (void)p_mux; (void)channel; (void)data; (void)len; return -1; }
+int pcom_mux_stats(pcom_mux_t* p_mux, pcom_mux_stats_t* p_stats) { (void)p_mux; (void)p_stats; return -1; }
+void pcom_mux_destroy(pcom_mux_t* p_mux) { (void)p_mux; }
+
+#endif
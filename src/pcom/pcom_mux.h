@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_mux.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Prioritized logical channels over one PCOM connection.
+ ****************************************************************************/
+/** @defgroup  PCOM_MUX
+ * @brief     Stream multiplexing with a priority scheduler.
+ * @details   Messages are sent on numbered channels, each with a priority.
+ *            A writer thread cuts messages into chunks of at most chunk
+ *            bytes and before every chunk picks the most urgent waiting
+ *            message, so a small control message waits for at most one bulk
+ *            chunk instead of a whole transfer. Messages of the same
+ *            priority go out in order, one after the other.
+ *
+ *            Chunks are PCOM_FRAME_MUX frames with the channel in the frame
+ *            header and PCOM_MUX_MORE set on all but the last chunk. The
+ *            receiving side reassembles per channel and hands complete
+ *            messages to on_message, on its reader thread.
+ *
+ *            Both ends of a connection use a pcom_mux_t, which owns the
+ *            handle.
+ *
+ * @pre       pcom.h, pcom_frame.h, pthreads
+ * @bug       -
+ * @warning   Not available on Windows.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_MUX_H
+#define PCOM_MUX_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint16_t
+
+#include "pcom.h"
+#include "pcom_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_MUX_PRIORITIES   (8)                  // 0 is the most urgent
+#define PCOM_MUX_PRIO_DEFAULT (4)
+#define PCOM_MUX_CHUNK        (16 * 1024)          // Default chunk size
+#define PCOM_MUX_MSG_MAX      (64 * 1024 * 1024)   // Default largest reassembled message
+
+#define PCOM_MUX_MORE         (1 << 0)  // Frame flag: message continues
+
+typedef struct pcom_mux pcom_mux_t;
+
+typedef struct {
+    /** Complete message received, on the reader thread. NULL to only send. */
+    void (*on_message)(pcom_mux_t* p_mux, uint16_t channel, const void* data, size_t len, void* user);
+    /** Reader stopped, status 0 on EOF or a negative error. May be NULL. */
+    void (*on_close)(pcom_mux_t* p_mux, int status, void* user);
+    void* user;          // Passed to the callbacks
+    size_t chunk;        // Largest frame payload, 0 for default
+    size_t msg_max;      // Largest message accepted, 0 for default
+} pcom_mux_opts_t;
+
+typedef struct {
+    unsigned long long messages;   // Messages sent
+    unsigned long long frames;     // Chunks sent
+    unsigned long long bytes;      // Payload bytes sent
+    unsigned long long preempted;  // Partly sent messages overtaken by a more urgent one
+    unsigned long long received;   // Messages received
+} pcom_mux_stats_t;
+
+/**
+ * @brief      Multiplex a connection and start its threads.
+ * @param      pp_mux  Receives the multiplexer.
+ * @param      handle  Connected stream handle, owned from now on.
+ * @param      p_opts  Options and callbacks, NULL to only send.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_mux_create(pcom_mux_t** pp_mux, int handle, const pcom_mux_opts_t* p_opts);
+
+/**
+ * @brief      Set the priority of a channel.
+ * @param      p_mux     The multiplexer.
+ * @param      channel   Channel number.
+ * @param      priority  0 (most urgent) to PCOM_MUX_PRIORITIES - 1.
+ * @return     0 on success, negative error code on failure.
+ * @details    Channels start at PCOM_MUX_PRIO_DEFAULT. Messages of the
+ *             channel already queued keep their priority, later ones queue
+ *             behind them until they are sent, so the channel stays in order.
+ */
+LIB_EXPORT int
+pcom_mux_set_priority(pcom_mux_t* p_mux, uint16_t channel, int priority);
+
+/**
+ * @brief      Send a message on a channel, blocking until it is written.
+ * @param      p_mux    The multiplexer.
+ * @param      channel  Channel number.
+ * @param      data     Message, sent from the caller's buffer without a copy.
+ * @param      len      Message length.
+ * @return     0 on success, negative error code on failure.
+ * @details    Thread safe. Senders on different channels run concurrently
+ *             and are interleaved chunk by chunk by priority.
+ */
+LIB_EXPORT int
+pcom_mux_send(pcom_mux_t* p_mux, uint16_t channel, const void* data, size_t len);
+
+/**
+ * @brief      Read the counters.
+ * @param      p_mux    The multiplexer.
+ * @param      p_stats  Receives the counters.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_mux_stats(pcom_mux_t* p_mux, pcom_mux_stats_t* p_stats);
+
+/**
+ * @brief      Stop the threads, close the handle and free the multiplexer.
+ * @param      p_mux  The multiplexer.
+ * @details    No pcom_mux_send() may be in progress.
+ */
+LIB_EXPORT void
+pcom_mux_destroy(pcom_mux_t* p_mux);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_MUX_H
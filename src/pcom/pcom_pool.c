@@ -0,0 +1,599 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_pool.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Multithreaded PCOM server with work stealing dispatch.
+ ****************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include "pcom_pool.h"
+#include "pcom_loop.h"
+
+#if defined(__linux__)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define POOL_EVENTS (64)
+
+/* Connection states */
+#define CONN_FREE      (0)
+#define CONN_OPEN      (1)
+#define CONN_MIGRATING (2)  // Removed from the loop, handed over when drained
+#define CONN_CLOSING   (3)  // Removed from the loop, closed when drained
+
+#define STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define STAT_SET(field, n) __atomic_store_n(&(field), (n), __ATOMIC_RELAXED)
+#define STAT_GET(field)    __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+/** A connection waiting in a worker queue */
+typedef struct {
+    int handle;
+    int migrated;      // Already connected on another worker, skip on_connect
+} pool_item_t;
+
+/** A connection owned by a worker */
+typedef struct {
+    int state;
+    int removed;       // Loop reported PCOM_EVENT_REMOVED
+    int sends_pending; // Sends not yet completed
+    int target;        // Worker to hand over to when migrating
+    unsigned hits;     // Recent messages, halved every PCOM_POOL_DECAY_MS
+} pool_conn_t;
+
+typedef struct {
+    pcom_server_pool_t* p_pool;
+    int index;
+    pthread_t thread;
+    pcom_loop_t* p_loop;
+
+    pthread_mutex_t lock;      // Guards the queue
+    pool_item_t* queue;
+    int queue_head, queue_count, queue_cap;
+    int steal_to;              // Worker asking for a connection, -1 if none
+
+    pool_conn_t* conns;        // Indexed by handle, worker thread only
+    int conn_cap;
+    unsigned tick_msgs;        // Messages since the last decay tick
+
+    pcom_pool_stats_t stats;   // Written by the worker, read by anyone
+} pool_worker_t;
+
+struct pcom_server_pool {
+    int server_handle;
+    int workers;
+    int started;               // Worker threads running, equals workers once created
+    int stop;
+    pcom_pool_handlers_t handlers;
+    pthread_t acceptor;
+    pcom_loop_t* p_accept_loop;
+    pool_worker_t* worker;
+};
+
+static __thread pool_worker_t* tls_worker;
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static long long
+now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static pool_conn_t*
+conn_get(pool_worker_t* p_w, int fd, int create)
+{
+    if (fd < 0) return NULL;
+    if (fd >= p_w->conn_cap) {
+        if (!create) return NULL;
+        int cap = p_w->conn_cap ? p_w->conn_cap : 64;
+        while (cap <= fd) cap *= 2;
+        pool_conn_t* p = realloc(p_w->conns, (size_t)cap * sizeof(*p));
+        if (!p) return NULL;
+        memset(p + p_w->conn_cap, 0, (size_t)(cap - p_w->conn_cap) * sizeof(*p));
+        p_w->conns = p;
+        p_w->conn_cap = cap;
+    }
+    pool_conn_t* p_conn = &p_w->conns[fd];
+    if (p_conn->state == CONN_FREE && !create) return NULL;
+    return p_conn;
+}
+
+static int
+queue_push(pool_worker_t* p_w, int handle, int migrated)
+{
+    pthread_mutex_lock(&p_w->lock);
+    if (p_w->queue_count == p_w->queue_cap) {
+        int cap = p_w->queue_cap ? p_w->queue_cap * 2 : 16;
+        pool_item_t* p = malloc((size_t)cap * sizeof(*p));
+        if (!p) {
+            pthread_mutex_unlock(&p_w->lock);
+            return -ENOMEM;
+        }
+        for (int i = 0; i < p_w->queue_count; ++i)
+            p[i] = p_w->queue[(p_w->queue_head + i) % p_w->queue_cap];
+        free(p_w->queue);
+        p_w->queue = p;
+        p_w->queue_cap = cap;
+        p_w->queue_head = 0;
+    }
+    int tail = (p_w->queue_head + p_w->queue_count) % p_w->queue_cap;
+    p_w->queue[tail].handle = handle;
+    p_w->queue[tail].migrated = migrated;
+    p_w->queue_count++;
+    STAT_SET(p_w->stats.queued, (unsigned long long)p_w->queue_count);
+    pthread_mutex_unlock(&p_w->lock);
+    pcom_loop_wake(p_w->p_loop);
+    return 0;
+}
+
+/* Pop the oldest item. Thieves only take fresh connections. */
+static int
+queue_pop(pool_worker_t* p_w, pool_item_t* p_item, int fresh_only)
+{
+    int found = 0;
+    pthread_mutex_lock(&p_w->lock);
+    if (p_w->queue_count > 0) {
+        pool_item_t* p_head = &p_w->queue[p_w->queue_head];
+        if (!fresh_only || !p_head->migrated) {
+            *p_item = *p_head;
+            p_w->queue_head = (p_w->queue_head + 1) % p_w->queue_cap;
+            p_w->queue_count--;
+            STAT_SET(p_w->stats.queued, (unsigned long long)p_w->queue_count);
+            found = 1;
+        }
+    }
+    pthread_mutex_unlock(&p_w->lock);
+    return found;
+}
+
+/* Close or hand over a removed connection once the loop is done with it */
+static void
+conn_finish(pool_worker_t* p_w, int fd, pool_conn_t* p_conn)
+{
+    pcom_server_pool_t* p_pool = p_w->p_pool;
+
+    if (!p_conn->removed || p_conn->sends_pending > 0) return;
+
+    if (p_conn->state == CONN_MIGRATING) {
+        pool_worker_t* p_to = &p_pool->worker[p_conn->target];
+        STAT_ADD(p_w->stats.connections, -1ULL);
+        if (queue_push(p_to, fd, 1) == 0) {
+            STAT_ADD(p_w->stats.donated, 1);
+            STAT_ADD(p_to->stats.stolen, 1);
+            p_conn->state = CONN_FREE;
+            return;
+        }
+        // Out of memory, nowhere to go
+        if (p_pool->handlers.on_close) p_pool->handlers.on_close(p_pool, fd, p_pool->handlers.user);
+    }
+    pcom_client_close(fd);
+    p_conn->state = CONN_FREE;
+}
+
+static void
+conn_close(pool_worker_t* p_w, int fd, pool_conn_t* p_conn)
+{
+    pcom_server_pool_t* p_pool = p_w->p_pool;
+
+    if (p_conn->state == CONN_CLOSING) return;
+    if (p_conn->state == CONN_OPEN) pcom_loop_remove(p_w->p_loop, fd);
+    p_conn->state = CONN_CLOSING;
+    STAT_ADD(p_w->stats.connections, -1ULL);
+    if (p_pool->handlers.on_close) p_pool->handlers.on_close(p_pool, fd, p_pool->handlers.user);
+    conn_finish(p_w, fd, p_conn);
+}
+
+static void
+conn_adopt(pool_worker_t* p_w, const pool_item_t* p_item)
+{
+    pcom_server_pool_t* p_pool = p_w->p_pool;
+    int fd = p_item->handle;
+
+    if (!p_item->migrated && p_pool->handlers.on_connect &&
+        p_pool->handlers.on_connect(p_pool, fd, p_pool->handlers.user) < 0) {
+        pcom_client_close(fd);
+        return;
+    }
+
+    pool_conn_t* p_conn = conn_get(p_w, fd, 1);
+    if (!p_conn || pcom_loop_add(p_w->p_loop, fd) < 0) {
+        if (p_pool->handlers.on_close) p_pool->handlers.on_close(p_pool, fd, p_pool->handlers.user);
+        pcom_client_close(fd);
+        return;
+    }
+    memset(p_conn, 0, sizeof(*p_conn));
+    p_conn->state = CONN_OPEN;
+    STAT_ADD(p_w->stats.connections, 1);
+}
+
+/* Hand the coldest connection to the worker that asked for one */
+static void
+donate(pool_worker_t* p_w, int to)
+{
+    int open = 0, cold = -1;
+
+    for (int fd = 0; fd < p_w->conn_cap; ++fd) {
+        pool_conn_t* p_conn = &p_w->conns[fd];
+        if (p_conn->state != CONN_OPEN) continue;
+        open++;
+        if (p_conn->sends_pending == 0 && (cold < 0 || p_conn->hits < p_w->conns[cold].hits))
+            cold = fd;
+    }
+    // Keep the last connection, a lone hot client already has the core
+    if (open < 2 || cold < 0) return;
+
+    pool_conn_t* p_conn = &p_w->conns[cold];
+    pcom_loop_remove(p_w->p_loop, cold);
+    p_conn->state = CONN_MIGRATING;
+    p_conn->target = to;
+}
+
+/* Idle worker: take a queued connection, or ask the busiest worker for one */
+static void
+steal(pool_worker_t* p_w)
+{
+    pcom_server_pool_t* p_pool = p_w->p_pool;
+    pool_item_t item;
+    int victim = -1;
+    unsigned long long max_load = 0;
+
+    for (int i = 1; i < p_pool->workers; ++i) {
+        pool_worker_t* p_from = &p_pool->worker[(p_w->index + i) % p_pool->workers];
+        if (STAT_GET(p_from->stats.queued) > 0 && queue_pop(p_from, &item, 1)) {
+            STAT_ADD(p_from->stats.donated, 1);
+            STAT_ADD(p_w->stats.stolen, 1);
+            conn_adopt(p_w, &item);
+            return;
+        }
+    }
+
+    for (int i = 0; i < p_pool->workers; ++i) {
+        pool_worker_t* p_from = &p_pool->worker[i];
+        unsigned long long load = STAT_GET(p_from->stats.load);
+        if (i != p_w->index && STAT_GET(p_from->stats.connections) >= 2 && load > max_load) {
+            max_load = load;
+            victim = i;
+        }
+    }
+    if (victim >= 0) {
+        int none = -1;
+        pool_worker_t* p_from = &p_pool->worker[victim];
+        if (__atomic_compare_exchange_n(&p_from->steal_to, &none, p_w->index, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            pcom_loop_wake(p_from->p_loop);
+    }
+}
+
+static void
+decay(pool_worker_t* p_w)
+{
+    unsigned long long load = 0;
+    for (int fd = 0; fd < p_w->conn_cap; ++fd) {
+        pool_conn_t* p_conn = &p_w->conns[fd];
+        if (p_conn->state == CONN_FREE) continue;
+        load += p_conn->hits;
+        p_conn->hits /= 2;
+    }
+    STAT_SET(p_w->stats.load, load);
+}
+
+static void
+handle_event(pool_worker_t* p_w, pcom_event_t* p_ev)
+{
+    pcom_server_pool_t* p_pool = p_w->p_pool;
+    pool_conn_t* p_conn = conn_get(p_w, p_ev->handle, 0);
+
+    switch (p_ev->type) {
+    case PCOM_EVENT_RECV:
+        if (!p_conn || p_conn->state == CONN_CLOSING) break;
+        if (p_ev->result <= 0) {
+            conn_close(p_w, p_ev->handle, p_conn);
+            break;
+        }
+        p_conn->hits++;
+        p_w->tick_msgs++;
+        STAT_ADD(p_w->stats.messages, 1);
+        STAT_ADD(p_w->stats.bytes_in, (unsigned long long)p_ev->result);
+        if (p_pool->handlers.on_data(p_pool, p_ev->handle, p_ev->data, (size_t)p_ev->result,
+                                     p_pool->handlers.user) < 0)
+            conn_close(p_w, p_ev->handle, p_conn);
+        break;
+    case PCOM_EVENT_SEND:
+        free(p_ev->user);
+        if (p_ev->result > 0) STAT_ADD(p_w->stats.bytes_out, (unsigned long long)p_ev->result);
+        if (!p_conn) break;
+        p_conn->sends_pending--;
+        if (p_ev->result < 0 && p_conn->state == CONN_OPEN) conn_close(p_w, p_ev->handle, p_conn);
+        else if (p_conn->state != CONN_OPEN) conn_finish(p_w, p_ev->handle, p_conn);
+        break;
+    case PCOM_EVENT_REMOVED:
+        if (!p_conn) break;
+        p_conn->removed = 1;
+        conn_finish(p_w, p_ev->handle, p_conn);
+        break;
+    }
+    pcom_loop_release(p_w->p_loop, p_ev);
+}
+
+/* Close everything the worker still owns, bounded wait for sends */
+static void
+worker_shutdown(pool_worker_t* p_w)
+{
+    pcom_event_t ev[POOL_EVENTS];
+    int pending = 0;
+
+    for (int fd = 0; fd < p_w->conn_cap; ++fd) {
+        pool_conn_t* p_conn = &p_w->conns[fd];
+        if (p_conn->state == CONN_OPEN || p_conn->state == CONN_MIGRATING) conn_close(p_w, fd, p_conn);
+    }
+    for (int tries = 0; tries < 100; ++tries) {
+        pending = 0;
+        for (int fd = 0; fd < p_w->conn_cap; ++fd) pending += p_w->conns[fd].state != CONN_FREE;
+        if (!pending) break;
+        int n = pcom_loop_wait(p_w->p_loop, ev, POOL_EVENTS, 10);
+        for (int i = 0; i < n; ++i) handle_event(p_w, &ev[i]);
+    }
+    // Still stuck, close anyway. Send buffers are leaked, not freed under the kernel.
+    for (int fd = 0; pending && fd < p_w->conn_cap; ++fd)
+        if (p_w->conns[fd].state != CONN_FREE) pcom_client_close(fd);
+}
+
+static void*
+worker_main(void* arg)
+{
+    pool_worker_t* p_w = arg;
+    pcom_server_pool_t* p_pool = p_w->p_pool;
+    pcom_event_t ev[POOL_EVENTS];
+    pool_item_t item;
+    long long next_tick = now_ms() + PCOM_POOL_DECAY_MS;
+
+    tls_worker = p_w;
+    while (!__atomic_load_n(&p_pool->stop, __ATOMIC_ACQUIRE)) {
+        while (queue_pop(p_w, &item, 0)) conn_adopt(p_w, &item);
+
+        int n = pcom_loop_wait(p_w->p_loop, ev, POOL_EVENTS, PCOM_POOL_DECAY_MS);
+        for (int i = 0; i < n; ++i) handle_event(p_w, &ev[i]);
+
+        int to = __atomic_exchange_n(&p_w->steal_to, -1, __ATOMIC_RELAXED);
+        if (to >= 0) donate(p_w, to);
+
+        long long now = now_ms();
+        if (now >= next_tick) {
+            next_tick = now + PCOM_POOL_DECAY_MS;
+            decay(p_w);
+            if (p_w->tick_msgs == 0 && p_pool->workers > 1) steal(p_w);
+            p_w->tick_msgs = 0;
+        }
+    }
+    worker_shutdown(p_w);
+    tls_worker = NULL;
+    return NULL;
+}
+
+/* Least loaded worker by owned plus queued connections */
+static pool_worker_t*
+pick_worker(pcom_server_pool_t* p_pool)
+{
+    pool_worker_t* p_best = NULL;
+    unsigned long long best = 0;
+
+    for (int i = 0; i < p_pool->workers; ++i) {
+        pool_worker_t* p_w = &p_pool->worker[i];
+        unsigned long long n = STAT_GET(p_w->stats.connections) + STAT_GET(p_w->stats.queued);
+        if (!p_best || n < best || (n == best && STAT_GET(p_w->stats.load) < STAT_GET(p_best->stats.load))) {
+            p_best = p_w;
+            best = n;
+        }
+    }
+    return p_best;
+}
+
+static void*
+acceptor_main(void* arg)
+{
+    pcom_server_pool_t* p_pool = arg;
+    pcom_event_t ev[POOL_EVENTS];
+
+    while (!__atomic_load_n(&p_pool->stop, __ATOMIC_ACQUIRE)) {
+        int n = pcom_loop_wait(p_pool->p_accept_loop, ev, POOL_EVENTS, -1);
+        for (int i = 0; i < n; ++i) {
+            if (ev[i].type != PCOM_EVENT_ACCEPT || ev[i].result < 0) continue;
+            if (queue_push(pick_worker(p_pool), ev[i].handle, 0) < 0) pcom_client_close(ev[i].handle);
+        }
+    }
+    return NULL;
+}
+
+static void
+pin_thread(pthread_t thread, int index)
+{
+    cpu_set_t set;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 0) return;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    pthread_setaffinity_np(thread, sizeof(set), &set);  // Best effort
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_server_pool_create(pcom_server_pool_t** pp_pool, int server_handle, int workers,
+                        const pcom_pool_handlers_t* p_handlers, int loop_flags)
+{
+    int result;
+
+    if (!pp_pool) return -EINVAL;
+    *pp_pool = NULL;
+    if (server_handle < 0 || !p_handlers || !p_handlers->on_data) return -EINVAL;
+
+    if (workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers <= 0) workers = 1;
+    if (workers > PCOM_POOL_MAX_WORKERS) workers = PCOM_POOL_MAX_WORKERS;
+
+    pcom_server_pool_t* p_pool = calloc(1, sizeof(*p_pool));
+    if (!p_pool) return -ENOMEM;
+    p_pool->worker = calloc((size_t)workers, sizeof(*p_pool->worker));
+    if (!p_pool->worker) {
+        free(p_pool);
+        return -ENOMEM;
+    }
+    p_pool->server_handle = server_handle;
+    p_pool->handlers = *p_handlers;
+
+    // Workers read the count to steal, so it is final before any thread runs
+    for (int i = 0; i < workers; ++i) {
+        pool_worker_t* p_w = &p_pool->worker[i];
+        p_w->p_pool = p_pool;
+        p_w->index = i;
+        p_w->steal_to = -1;
+        pthread_mutex_init(&p_w->lock, NULL);
+        result = pcom_loop_create(&p_w->p_loop, -1, loop_flags);
+        if (result < 0) {
+            pthread_mutex_destroy(&p_w->lock);
+            goto fail;
+        }
+        p_pool->workers++;
+    }
+    for (int i = 0; i < workers; ++i) {
+        pool_worker_t* p_w = &p_pool->worker[i];
+        result = pthread_create(&p_w->thread, NULL, worker_main, p_w);
+        if (result != 0) {
+            result = pcom_errno_from(result);
+            goto fail;
+        }
+        pin_thread(p_w->thread, i);
+        p_pool->started++;
+    }
+
+    result = pcom_loop_create(&p_pool->p_accept_loop, server_handle, loop_flags);
+    if (result < 0) goto fail;
+    result = pthread_create(&p_pool->acceptor, NULL, acceptor_main, p_pool);
+    if (result != 0) {
+        pcom_loop_destroy(p_pool->p_accept_loop);
+        p_pool->p_accept_loop = NULL;
+        result = pcom_errno_from(result);
+        goto fail;
+    }
+
+    *pp_pool = p_pool;
+    return 0;
+
+fail:
+    pcom_server_pool_destroy(p_pool);
+    return result;
+}
+
+int
+pcom_server_pool_send(pcom_server_pool_t* p_pool, int handle, const void* buf, size_t len)
+{
+    pool_worker_t* p_w = tls_worker;
+    if (!p_w || p_w->p_pool != p_pool) return -EPERM;
+    pool_conn_t* p_conn = conn_get(p_w, handle, 0);
+    if (!p_conn) return -ENOENT;
+    if (p_conn->state == CONN_CLOSING) return -EPIPE;
+    if (!buf && len) return -EINVAL;
+
+    void* copy = malloc(len ? len : 1);
+    if (!copy) return -ENOMEM;
+    if (len) memcpy(copy, buf, len);
+    int result = pcom_loop_send(p_w->p_loop, handle, copy, len, copy);
+    if (result < 0) {
+        free(copy);
+        return result;
+    }
+    p_conn->sends_pending++;
+    return 0;
+}
+
+int
+pcom_server_pool_workers(const pcom_server_pool_t* p_pool)
+{
+    return p_pool->workers;
+}
+
+int
+pcom_server_pool_stats(const pcom_server_pool_t* p_pool, int worker, pcom_pool_stats_t* p_stats)
+{
+    if (!p_pool || !p_stats || worker < 0 || worker >= p_pool->workers) return -EINVAL;
+    const pcom_pool_stats_t* p_src = &p_pool->worker[worker].stats;
+    p_stats->connections = STAT_GET(p_src->connections);
+    p_stats->queued      = STAT_GET(p_src->queued);
+    p_stats->load        = STAT_GET(p_src->load);
+    p_stats->messages    = STAT_GET(p_src->messages);
+    p_stats->bytes_in    = STAT_GET(p_src->bytes_in);
+    p_stats->bytes_out   = STAT_GET(p_src->bytes_out);
+    p_stats->stolen      = STAT_GET(p_src->stolen);
+    p_stats->donated     = STAT_GET(p_src->donated);
+    return 0;
+}
+
+void
+pcom_server_pool_destroy(pcom_server_pool_t* p_pool)
+{
+    pool_item_t item;
+
+    if (!p_pool) return;
+    __atomic_store_n(&p_pool->stop, 1, __ATOMIC_RELEASE);
+
+    if (p_pool->p_accept_loop) {
+        pcom_loop_wake(p_pool->p_accept_loop);
+        pthread_join(p_pool->acceptor, NULL);
+        pcom_loop_destroy(p_pool->p_accept_loop);
+    }
+    for (int i = 0; i < p_pool->started; ++i) {
+        pcom_loop_wake(p_pool->worker[i].p_loop);
+        pthread_join(p_pool->worker[i].thread, NULL);
+    }
+
+    // Connections still queued, migrated ones were seen by on_connect
+    for (int i = 0; i < p_pool->workers; ++i) {
+        pool_worker_t* p_w = &p_pool->worker[i];
+        while (queue_pop(p_w, &item, 0)) {
+            if (item.migrated && p_pool->handlers.on_close)
+                p_pool->handlers.on_close(p_pool, item.handle, p_pool->handlers.user);
+            pcom_client_close(item.handle);
+        }
+        pcom_loop_destroy(p_w->p_loop);
+        pthread_mutex_destroy(&p_w->lock);
+        free(p_w->queue);
+        free(p_w->conns);
+    }
+    free(p_pool->worker);
+    free(p_pool);
+}
+
+#else /* Not supported platforms */
+
+int pcom_server_pool_create(pcom_server_pool_t** pp_pool, int server_handle, int workers,
+                            const pcom_pool_handlers_t* p_handlers, int loop_flags)
+    { (void)server_handle; (void)workers; (void)p_handlers; (void)loop_flags;
+      if (pp_pool) *pp_pool = NULL; return -1; }
+int pcom_server_pool_send(pcom_server_pool_t* p_pool, int handle, const void* buf, size_t len)
+    { (void)p_pool; (void)handle; (void)buf; (void)len; return -1; }
+int pcom_server_pool_workers(const pcom_server_pool_t* p_pool) { (void)p_pool; return 0; }
+int pcom_server_pool_stats(const pcom_server_pool_t* p_pool, int worker, pcom_pool_stats_t* p_stats)
+    { (void)p_pool; (void)worker; (void)p_stats; return -1; }
+void pcom_server_pool_destroy(pcom_server_pool_t* p_pool) { (void)p_pool; }
+
+#endif
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_pool.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Multithreaded PCOM server with work stealing dispatch.
+ ****************************************************************************/
+/** @defgroup  PCOM_POOL
+ * @brief     PCOM server worker pool.
+ * @details   Accepts clients on a server handle and spreads the connections
+ *            over N worker threads, one per core. Each worker runs its own
+ *            pcom_loop with a queue of incoming connections. New connections
+ *            go to the least loaded worker. An idle worker first steals
+ *            queued connections from other workers, then asks the busiest
+ *            worker to hand over its coldest connection, so a hot client ends
+ *            up alone on its worker instead of starving its neighbours.
+ *            Connections move between workers without losing or reordering
+ *            data, and never while sends are pending.
+ *
+ *            Handlers run on the worker thread that owns the connection.
+ *            Per worker load counters can be read at any time.
+ *
+ * @pre       pcom.h, pcom_loop.h, pthreads
+ * @bug       -
+ * @warning   Linux only.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_POOL_H
+#define PCOM_POOL_H
+
+#include <stddef.h>  // for size_t
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_POOL_MAX_WORKERS (256)
+#define PCOM_POOL_DECAY_MS    (100)  // Load counters are halved this often
+
+typedef struct pcom_server_pool pcom_server_pool_t;
+
+/** Connection callbacks, all called on the owning worker thread */
+typedef struct {
+    /** New client. Return negative to reject and close it. May be NULL. */
+    int  (*on_connect)(pcom_server_pool_t* p_pool, int handle, void* user);
+    /** Data received. Return negative to close the connection. */
+    int  (*on_data)(pcom_server_pool_t* p_pool, int handle, const void* data, size_t len, void* user);
+    /** Connection is closing, the handle is closed after this. May be NULL. */
+    void (*on_close)(pcom_server_pool_t* p_pool, int handle, void* user);
+    void* user;          // Passed to every callback
+} pcom_pool_handlers_t;
+
+/** Per worker load counters */
+typedef struct {
+    unsigned long long connections;  // Connections owned now
+    unsigned long long queued;       // Connections waiting in the worker queue
+    unsigned long long load;         // Recent messages, decaying
+    unsigned long long messages;     // Messages handled
+    unsigned long long bytes_in;     // Bytes received
+    unsigned long long bytes_out;    // Bytes sent
+    unsigned long long stolen;       // Connections taken from other workers
+    unsigned long long donated;      // Connections handed to other workers
+} pcom_pool_stats_t;
+
+/**
+ * @brief      Create a server pool and start its threads.
+ * @param      pp_pool        Receives the new pool.
+ * @param      server_handle  Server handle from pcom_server_open().
+ * @param      workers        Number of worker threads, <= 0 for one per CPU.
+ * @param      p_handlers     Connection callbacks, copied.
+ * @param      loop_flags     Flags for each worker's pcom_loop_create().
+ * @return     0 on success, negative error code on failure.
+ * @details    Workers are pinned to CPUs round robin. The server handle is
+ *             not closed by the pool.
+ */
+LIB_EXPORT int
+pcom_server_pool_create(pcom_server_pool_t** pp_pool, int server_handle, int workers,
+                        const pcom_pool_handlers_t* p_handlers, int loop_flags);
+
+/**
+ * @brief      Queue data to a connection.
+ * @param      p_pool  The pool.
+ * @param      handle  Connection handle passed to the callback.
+ * @param      buf     Data, copied.
+ * @param      len     Length of the data.
+ * @return     0 on success, negative error code on failure.
+ * @details    Only from inside a callback for a connection the calling
+ *             worker owns. Sent on the worker's next loop iteration.
+ */
+LIB_EXPORT int
+pcom_server_pool_send(pcom_server_pool_t* p_pool, int handle, const void* buf, size_t len);
+
+/**
+ * @brief      Get the number of workers.
+ * @param      p_pool  The pool.
+ * @return     Number of worker threads.
+ */
+LIB_EXPORT int
+pcom_server_pool_workers(const pcom_server_pool_t* p_pool);
+
+/**
+ * @brief      Read a worker's load counters.
+ * @param      p_pool   The pool.
+ * @param      worker   Worker index, 0 to pcom_server_pool_workers() - 1.
+ * @param      p_stats  Receives the counters.
+ * @return     0 on success, negative error code on failure.
+ * @details    Thread safe, counters are read without stopping the worker.
+ */
+LIB_EXPORT int
+pcom_server_pool_stats(const pcom_server_pool_t* p_pool, int worker, pcom_pool_stats_t* p_stats);
+
+/**
+ * @brief      Stop the pool and free it.
+ * @param      p_pool  The pool.
+ * @details    Stops accepting, calls on_close for every open connection,
+ *             closes the connections and joins all threads.
+ */
+LIB_EXPORT void
+pcom_server_pool_destroy(pcom_server_pool_t* p_pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_POOL_H
@@ -0,0 +1,548 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_pubsub.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Publish/subscribe fan-out broker over PCOM.
+ ****************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <pthread.h>
+#endif
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "pcom_pubsub.h"
+#include "pcom_loop.h"
+#include "pcom_buf.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define PUBLISH_HDR (8 + 2)  // Key and topic length in front of the topic
+
+static void
+put_u64(uint8_t* p, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t
+get_u64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = v << 8 | p[i];
+    return v;
+}
+
+static int
+send_topic(int handle, int op, int policy, const char* topic)
+{
+    uint8_t payload[1 + PCOM_PUBSUB_TOPIC_MAX];
+    size_t len = topic ? strlen(topic) : 0;
+
+    if (len > PCOM_PUBSUB_TOPIC_MAX) return -EINVAL;
+    payload[0] = (uint8_t)policy;
+    if (len) memcpy(payload + 1, topic, len);
+    pcom_frame_hdr_t hdr = { (uint32_t)(1 + len), PCOM_FRAME_PUBSUB, (uint8_t)op, 0 };
+    return pcom_frame_send(handle, &hdr, payload);
+}
+
+#if defined(__linux__)
+
+#define BROKER_EVENTS (64)
+#define SEND_WINDOW   PCOM_LOOP_IOV_MAX  // Messages handed to the loop per subscriber
+
+#define STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define STAT_GET(field)    __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+/** Published message, one pooled buffer shared by all subscriber queues */
+typedef struct pubsub_msg {
+    struct pubsub_msg* next;  // Inbox link
+    int refs;                 // Broker thread only
+    uint64_t key;
+    const char* topic;        // Points into wire
+    size_t topic_len;
+    size_t len;               // Bytes in wire
+    uint8_t wire[];           // Complete frame
+} pubsub_msg_t;
+
+typedef struct {
+    int fd;
+    int index;                // Position in the broker's subscriber list
+    int policy;
+    int closing;              // Removed from the loop, freed when drained
+    int removed;              // Loop reported PCOM_EVENT_REMOVED
+    int inflight;             // Sends handed to the loop
+    pubsub_msg_t** queue;     // Ring of queue_len messages
+    int head, count;
+    char** topics;
+    int topic_count;
+    pcom_frame_reader_t reader;
+} pubsub_sub_t;
+
+struct pcom_broker {
+    int queue_len;
+    int policy;
+    int stop;
+    pthread_t thread;
+    pcom_loop_t* p_loop;
+
+    pthread_mutex_t lock;       // Guards the inbox
+    pubsub_msg_t* inbox_head;
+    pubsub_msg_t* inbox_tail;
+
+    pubsub_sub_t** subs;        // Indexed by handle, broker thread only
+    int sub_cap;
+    pubsub_sub_t** list;        // Open subscribers, for fan-out
+    int list_count;
+
+    pcom_pubsub_stats_t stats;
+};
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static inline void
+msg_ref(pubsub_msg_t* p_msg) { p_msg->refs++; }
+
+static inline void
+msg_unref(pubsub_msg_t* p_msg) { if (--p_msg->refs == 0) pcom_buf_unref(p_msg); }
+
+static pubsub_sub_t*
+sub_get(pcom_broker_t* p_b, int fd)
+{
+    return (fd >= 0 && fd < p_b->sub_cap) ? p_b->subs[fd] : NULL;
+}
+
+static pubsub_sub_t*
+sub_create(pcom_broker_t* p_b, int fd)
+{
+    if (fd >= p_b->sub_cap) {
+        int cap = p_b->sub_cap ? p_b->sub_cap : 64;
+        while (cap <= fd) cap *= 2;
+        pubsub_sub_t** p = realloc(p_b->subs, (size_t)cap * sizeof(*p));
+        if (!p) return NULL;
+        memset(p + p_b->sub_cap, 0, (size_t)(cap - p_b->sub_cap) * sizeof(*p));
+        p_b->subs = p;
+        pubsub_sub_t** p_list = realloc(p_b->list, (size_t)cap * sizeof(*p_list));
+        if (!p_list) return NULL;
+        p_b->list = p_list;
+        p_b->sub_cap = cap;
+    }
+    pubsub_sub_t* p_sub = calloc(1, sizeof(*p_sub));
+    if (!p_sub) return NULL;
+    p_sub->queue = calloc((size_t)p_b->queue_len, sizeof(*p_sub->queue));
+    if (!p_sub->queue) {
+        free(p_sub);
+        return NULL;
+    }
+    p_sub->fd = fd;
+    p_sub->policy = p_b->policy;
+    p_sub->index = p_b->list_count;
+    p_b->list[p_b->list_count++] = p_sub;
+    p_b->subs[fd] = p_sub;
+    STAT_ADD(p_b->stats.subscribers, 1);
+    return p_sub;
+}
+
+/* Hand queued messages to the loop, up to the send window */
+static void
+sub_pump(pcom_broker_t* p_b, pubsub_sub_t* p_sub)
+{
+    while (p_sub->count > 0 && p_sub->inflight < SEND_WINDOW) {
+        pubsub_msg_t* p_msg = p_sub->queue[p_sub->head];
+        if (pcom_loop_send(p_b->p_loop, p_sub->fd, p_msg->wire, p_msg->len, p_msg) < 0) break;
+        p_sub->head = (p_sub->head + 1) % p_b->queue_len;
+        p_sub->count--;
+        p_sub->inflight++;
+    }
+}
+
+static void
+sub_finish(pcom_broker_t* p_b, pubsub_sub_t* p_sub)
+{
+    if (!p_sub->removed || p_sub->inflight > 0) return;
+    p_b->subs[p_sub->fd] = NULL;
+    pcom_client_close(p_sub->fd);
+    for (int i = 0; i < p_sub->topic_count; ++i) free(p_sub->topics[i]);
+    free(p_sub->topics);
+    free(p_sub->queue);
+    pcom_frame_reader_free(&p_sub->reader);
+    free(p_sub);
+}
+
+static void
+sub_close(pcom_broker_t* p_b, pubsub_sub_t* p_sub)
+{
+    if (p_sub->closing) return;
+    p_sub->closing = 1;
+    pcom_loop_remove(p_b->p_loop, p_sub->fd);
+
+    while (p_sub->count > 0) {
+        msg_unref(p_sub->queue[p_sub->head]);
+        p_sub->head = (p_sub->head + 1) % p_b->queue_len;
+        p_sub->count--;
+    }
+    pubsub_sub_t* p_last = p_b->list[--p_b->list_count];
+    p_b->list[p_sub->index] = p_last;
+    p_last->index = p_sub->index;
+    STAT_ADD(p_b->stats.subscribers, -1ULL);
+    sub_finish(p_b, p_sub);
+}
+
+static int
+sub_matches(const pubsub_sub_t* p_sub, const pubsub_msg_t* p_msg)
+{
+    for (int i = 0; i < p_sub->topic_count; ++i) {
+        size_t len = strlen(p_sub->topics[i]);
+        if (len <= p_msg->topic_len && memcmp(p_sub->topics[i], p_msg->topic, len) == 0) return 1;
+    }
+    return 0;
+}
+
+static void
+sub_enqueue(pcom_broker_t* p_b, pubsub_sub_t* p_sub, pubsub_msg_t* p_msg)
+{
+    int cap = p_b->queue_len;
+
+    if (p_sub->policy == PCOM_PUBSUB_CONFLATE) {
+        // Behind already: replace the queued value for the same key in place
+        for (int i = 0; i < p_sub->count; ++i) {
+            pubsub_msg_t** pp = &p_sub->queue[(p_sub->head + i) % cap];
+            if ((*pp)->key == p_msg->key && (*pp)->topic_len == p_msg->topic_len &&
+                memcmp((*pp)->topic, p_msg->topic, p_msg->topic_len) == 0) {
+                msg_unref(*pp);
+                msg_ref(p_msg);
+                *pp = p_msg;
+                STAT_ADD(p_b->stats.conflated, 1);
+                return;
+            }
+        }
+    }
+    if (p_sub->count == cap) {
+        if (p_sub->policy == PCOM_PUBSUB_DISCONNECT) {
+            STAT_ADD(p_b->stats.disconnected, 1);
+            sub_close(p_b, p_sub);
+            return;
+        }
+        msg_unref(p_sub->queue[p_sub->head]);
+        p_sub->head = (p_sub->head + 1) % cap;
+        p_sub->count--;
+        STAT_ADD(p_b->stats.dropped, 1);
+    }
+    msg_ref(p_msg);
+    p_sub->queue[(p_sub->head + p_sub->count) % cap] = p_msg;
+    p_sub->count++;
+    sub_pump(p_b, p_sub);
+}
+
+static void
+fan_out(pcom_broker_t* p_b, pubsub_msg_t* p_msg)
+{
+    // Walk backwards, a DISCONNECT swaps the last subscriber into the hole
+    for (int i = p_b->list_count - 1; i >= 0; --i) {
+        pubsub_sub_t* p_sub = p_b->list[i];
+        if (sub_matches(p_sub, p_msg)) sub_enqueue(p_b, p_sub, p_msg);
+    }
+}
+
+static void
+sub_topic(pubsub_sub_t* p_sub, int op, const uint8_t* payload, size_t len)
+{
+    if (len < 1 || len - 1 > PCOM_PUBSUB_TOPIC_MAX) return;
+    const char* topic = (const char*)payload + 1;
+    size_t topic_len = len - 1;
+
+    for (int i = 0; i < p_sub->topic_count; ++i) {
+        if (strlen(p_sub->topics[i]) != topic_len || memcmp(p_sub->topics[i], topic, topic_len) != 0)
+            continue;
+        if (op == PCOM_PUBSUB_UNSUBSCRIBE) {
+            free(p_sub->topics[i]);
+            p_sub->topics[i] = p_sub->topics[--p_sub->topic_count];
+        }
+        op = 0;
+        break;
+    }
+    if (op == PCOM_PUBSUB_SUBSCRIBE) {
+        char** p = realloc(p_sub->topics, (size_t)(p_sub->topic_count + 1) * sizeof(*p));
+        char* p_topic = malloc(topic_len + 1);
+        if (p) p_sub->topics = p;
+        if (!p || !p_topic) {
+            free(p_topic);
+            return;
+        }
+        memcpy(p_topic, topic, topic_len);
+        p_topic[topic_len] = '\0';
+        p_sub->topics[p_sub->topic_count++] = p_topic;
+    }
+    if (payload[0] >= PCOM_PUBSUB_DROP_OLDEST && payload[0] <= PCOM_PUBSUB_CONFLATE)
+        p_sub->policy = payload[0];
+}
+
+static void
+handle_event(pcom_broker_t* p_b, pcom_event_t* p_ev)
+{
+    pubsub_sub_t* p_sub = sub_get(p_b, p_ev->handle);
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    int result;
+
+    switch (p_ev->type) {
+    case PCOM_EVENT_ACCEPT:
+        if (p_ev->result < 0) break;
+        if (!sub_create(p_b, p_ev->handle)) {
+            pcom_client_close(p_ev->handle);
+            break;
+        }
+        if (pcom_loop_add(p_b->p_loop, p_ev->handle) < 0) {
+            p_sub = sub_get(p_b, p_ev->handle);
+            p_sub->removed = 1;
+            sub_close(p_b, p_sub);
+        }
+        break;
+    case PCOM_EVENT_RECV:
+        if (!p_sub || p_sub->closing) break;
+        if (p_ev->result <= 0 || pcom_frame_reader_feed(&p_sub->reader, p_ev->data, (size_t)p_ev->result) < 0) {
+            sub_close(p_b, p_sub);
+            break;
+        }
+        while ((result = pcom_frame_reader_next(&p_sub->reader, &hdr, &payload)) > 0)
+            if (hdr.type == PCOM_FRAME_PUBSUB &&
+                (hdr.flags == PCOM_PUBSUB_SUBSCRIBE || hdr.flags == PCOM_PUBSUB_UNSUBSCRIBE))
+                sub_topic(p_sub, hdr.flags, payload, hdr.len);
+        if (result < 0) sub_close(p_b, p_sub);
+        break;
+    case PCOM_EVENT_SEND:
+        msg_unref(p_ev->user);
+        if (!p_sub) break;
+        p_sub->inflight--;
+        if (p_ev->result > 0) STAT_ADD(p_b->stats.delivered, 1);
+        if (p_sub->closing) sub_finish(p_b, p_sub);
+        else if (p_ev->result < 0) sub_close(p_b, p_sub);
+        else sub_pump(p_b, p_sub);
+        break;
+    case PCOM_EVENT_REMOVED:
+        if (!p_sub) break;
+        p_sub->removed = 1;
+        sub_finish(p_b, p_sub);
+        break;
+    }
+    pcom_loop_release(p_b->p_loop, p_ev);
+}
+
+static void
+broker_shutdown(pcom_broker_t* p_b)
+{
+    pcom_event_t ev[BROKER_EVENTS];
+
+    while (p_b->list_count > 0) sub_close(p_b, p_b->list[p_b->list_count - 1]);
+    for (int tries = 0; tries < 100; ++tries) {
+        int left = 0;
+        for (int fd = 0; fd < p_b->sub_cap; ++fd) left += p_b->subs[fd] != NULL;
+        if (!left) break;
+        int n = pcom_loop_wait(p_b->p_loop, ev, BROKER_EVENTS, 10);
+        for (int i = 0; i < n; ++i) handle_event(p_b, &ev[i]);
+    }
+    // Still stuck, close anyway. Messages are leaked, not freed under the kernel.
+    for (int fd = 0; fd < p_b->sub_cap; ++fd)
+        if (p_b->subs[fd]) pcom_client_close(fd);
+}
+
+static void*
+broker_main(void* arg)
+{
+    pcom_broker_t* p_b = arg;
+    pcom_event_t ev[BROKER_EVENTS];
+
+    while (!__atomic_load_n(&p_b->stop, __ATOMIC_ACQUIRE)) {
+        int n = pcom_loop_wait(p_b->p_loop, ev, BROKER_EVENTS, -1);
+        for (int i = 0; i < n; ++i) handle_event(p_b, &ev[i]);
+
+        pthread_mutex_lock(&p_b->lock);
+        pubsub_msg_t* p_msg = p_b->inbox_head;
+        p_b->inbox_head = p_b->inbox_tail = NULL;
+        pthread_mutex_unlock(&p_b->lock);
+
+        while (p_msg) {
+            pubsub_msg_t* p_next = p_msg->next;
+            fan_out(p_b, p_msg);
+            msg_unref(p_msg);
+            p_msg = p_next;
+        }
+    }
+    broker_shutdown(p_b);
+    return NULL;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_pubsub_create(pcom_broker_t** pp_broker, int server_handle, const pcom_pubsub_opts_t* p_opts)
+{
+    int result;
+
+    if (!pp_broker) return -EINVAL;
+    *pp_broker = NULL;
+    if (server_handle < 0) return -EBADF;
+
+    pcom_broker_t* p_b = calloc(1, sizeof(*p_b));
+    if (!p_b) return -ENOMEM;
+    p_b->queue_len = (p_opts && p_opts->queue_len > 0) ? p_opts->queue_len : PCOM_PUBSUB_QUEUE_LEN;
+    p_b->policy = (p_opts && p_opts->policy) ? p_opts->policy : PCOM_PUBSUB_DROP_OLDEST;
+    if (p_b->policy < PCOM_PUBSUB_DROP_OLDEST || p_b->policy > PCOM_PUBSUB_CONFLATE) {
+        free(p_b);
+        return -EINVAL;
+    }
+    pthread_mutex_init(&p_b->lock, NULL);
+
+    result = pcom_loop_create(&p_b->p_loop, server_handle, PCOM_LOOP_DEFAULT);
+    if (result < 0) goto fail;
+    result = pthread_create(&p_b->thread, NULL, broker_main, p_b);
+    if (result != 0) {
+        pcom_loop_destroy(p_b->p_loop);
+        result = pcom_errno_from(result);
+        goto fail;
+    }
+
+    *pp_broker = p_b;
+    return 0;
+
+fail:
+    pthread_mutex_destroy(&p_b->lock);
+    free(p_b);
+    return result;
+}
+
+int
+pcom_pubsub_publish(pcom_broker_t* p_broker, const char* topic, uint64_t key, const void* data, size_t len)
+{
+    if (!p_broker || !topic || (!data && len)) return -EINVAL;
+    size_t topic_len = strlen(topic);
+    if (topic_len > PCOM_PUBSUB_TOPIC_MAX) return -EINVAL;
+    size_t payload_len = PUBLISH_HDR + topic_len + len;
+    if (payload_len > PCOM_FRAME_MAX) return -EMSGSIZE;
+
+    // The only copy: straight into the frame every subscriber gets
+    pubsub_msg_t* p_msg = pcom_buf_alloc(sizeof(*p_msg) + PCOM_FRAME_HDR_SIZE + payload_len);
+    if (!p_msg) return -ENOMEM;
+    pcom_frame_hdr_t hdr = { (uint32_t)payload_len, PCOM_FRAME_PUBSUB, PCOM_PUBSUB_PUBLISH, 0 };
+    uint8_t* p = p_msg->wire;
+    pcom_frame_encode(p, &hdr);
+    p += PCOM_FRAME_HDR_SIZE;
+    put_u64(p, key);
+    p[8] = (uint8_t)topic_len;
+    p[9] = (uint8_t)(topic_len >> 8);
+    memcpy(p + PUBLISH_HDR, topic, topic_len);
+    if (len) memcpy(p + PUBLISH_HDR + topic_len, data, len);
+
+    p_msg->next = NULL;
+    p_msg->refs = 1;
+    p_msg->key = key;
+    p_msg->topic = (const char*)p + PUBLISH_HDR;
+    p_msg->topic_len = topic_len;
+    p_msg->len = PCOM_FRAME_HDR_SIZE + payload_len;
+
+    pthread_mutex_lock(&p_broker->lock);
+    int was_empty = p_broker->inbox_head == NULL;
+    if (p_broker->inbox_tail) p_broker->inbox_tail->next = p_msg;
+    else p_broker->inbox_head = p_msg;
+    p_broker->inbox_tail = p_msg;
+    pthread_mutex_unlock(&p_broker->lock);
+
+    STAT_ADD(p_broker->stats.published, 1);
+    // The broker drains the whole inbox per wakeup
+    if (was_empty) pcom_loop_wake(p_broker->p_loop);
+    return 0;
+}
+
+int
+pcom_pubsub_stats(const pcom_broker_t* p_broker, pcom_pubsub_stats_t* p_stats)
+{
+    if (!p_broker || !p_stats) return -EINVAL;
+    p_stats->subscribers  = STAT_GET(p_broker->stats.subscribers);
+    p_stats->published    = STAT_GET(p_broker->stats.published);
+    p_stats->delivered    = STAT_GET(p_broker->stats.delivered);
+    p_stats->dropped      = STAT_GET(p_broker->stats.dropped);
+    p_stats->conflated    = STAT_GET(p_broker->stats.conflated);
+    p_stats->disconnected = STAT_GET(p_broker->stats.disconnected);
+    return 0;
+}
+
+void
+pcom_pubsub_destroy(pcom_broker_t* p_broker)
+{
+    if (!p_broker) return;
+    __atomic_store_n(&p_broker->stop, 1, __ATOMIC_RELEASE);
+    pcom_loop_wake(p_broker->p_loop);
+    pthread_join(p_broker->thread, NULL);
+
+    pubsub_msg_t* p_msg = p_broker->inbox_head;
+    while (p_msg) {
+        pubsub_msg_t* p_next = p_msg->next;
+        pcom_buf_unref(p_msg);
+        p_msg = p_next;
+    }
+    pcom_loop_destroy(p_broker->p_loop);
+    pthread_mutex_destroy(&p_broker->lock);
+    free(p_broker->subs);
+    free(p_broker->list);
+    free(p_broker);
+}
+
+#else /* Not supported platforms */
+
+int pcom_pubsub_create(pcom_broker_t** pp_broker, int server_handle, const pcom_pubsub_opts_t* p_opts)
+    { (void)server_handle; (void)p_opts; if (pp_broker) *pp_broker = NULL; return -1; }
+int pcom_pubsub_publish(pcom_broker_t* p_broker, const char* topic, uint64_t key, const void* data, size_t len)
+    { (void)p_broker; (void)topic; (void)key; (void)data; (void)len; return -1; }
+int pcom_pubsub_stats(const pcom_broker_t* p_broker, pcom_pubsub_stats_t* p_stats)
+    { (void)p_broker; (void)p_stats; return -1; }
+void pcom_pubsub_destroy(pcom_broker_t* p_broker) { (void)p_broker; }
+
+#endif
+
+/* ---- Subscriber functions ---------------------------------------------- */
+
+int
+pcom_pubsub_subscribe(int handle, const char* topic, int policy)
+{
+    if (policy < PCOM_PUBSUB_DEFAULT || policy > PCOM_PUBSUB_CONFLATE) return -EINVAL;
+    return send_topic(handle, PCOM_PUBSUB_SUBSCRIBE, policy, topic);
+}
+
+int
+pcom_pubsub_unsubscribe(int handle, const char* topic)
+{
+    return send_topic(handle, PCOM_PUBSUB_UNSUBSCRIBE, PCOM_PUBSUB_DEFAULT, topic);
+}
+
+int
+pcom_pubsub_recv(int handle, pcom_frame_reader_t* p_reader, pcom_pubsub_msg_t* p_msg)
+{
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    int result;
+
+    while ((result = pcom_frame_recv(handle, p_reader, &hdr, &payload)) > 0) {
+        if (hdr.type != PCOM_FRAME_PUBSUB || hdr.flags != PCOM_PUBSUB_PUBLISH) continue;
+        if (hdr.len < PUBLISH_HDR) return -EPROTO;
+        const uint8_t* p = payload;
+        size_t topic_len = (size_t)(p[8] | p[9] << 8);
+        if (hdr.len < PUBLISH_HDR + topic_len) return -EPROTO;
+        p_msg->key = get_u64(p);
+        p_msg->topic = (const char*)p + PUBLISH_HDR;
+        p_msg->topic_len = topic_len;
+        p_msg->data = p + PUBLISH_HDR + topic_len;
+        p_msg->len = hdr.len - PUBLISH_HDR - topic_len;
+        return 1;
+    }
+    return result;
+}
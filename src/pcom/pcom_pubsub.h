@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_pubsub.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Publish/subscribe fan-out broker over PCOM.
+ ****************************************************************************/
+/** @defgroup  PCOM_PUBSUB
+ * @brief     One producer, many local subscribers.
+ * @details   The broker accepts subscribers on a server handle and runs them
+ *            on its own pcom_loop thread. pcom_pubsub_publish() copies the
+ *            message once into a refcounted buffer, already framed for the
+ *            wire, and returns without waiting for any subscriber. The
+ *            broker thread queues a reference to that buffer for every
+ *            matching subscriber and sends it from there, gathered, without
+ *            further copies.
+ *
+ *            Each subscriber has a bounded queue. When a subscriber falls
+ *            behind and its queue is full its slow consumer policy decides:
+ *            - PCOM_PUBSUB_DROP_OLDEST drops the oldest queued message.
+ *            - PCOM_PUBSUB_DISCONNECT closes the subscriber.
+ *            - PCOM_PUBSUB_CONFLATE keeps only the newest message per topic
+ *              and key while behind, dropping the oldest if that is not
+ *              enough.
+ *
+ *            Topics are matched by prefix, "" subscribes to everything.
+ *            Messages are PCOM_FRAME_PUBSUB frames (see pcom_frame.h):
+ *            publish payload is key (8, little endian), topic length (2),
+ *            topic, data; subscribe payload is policy (1), topic.
+ *
+ * @pre       pcom.h, pcom_frame.h, pcom_loop.h, pcom_buf.h, pthreads
+ * @bug       -
+ * @warning   Broker is Linux only. The subscriber functions are portable.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_PUBSUB_H
+#define PCOM_PUBSUB_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint64_t
+
+#include "pcom.h"
+#include "pcom_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_PUBSUB_QUEUE_LEN  (1024)  // Default per subscriber queue length
+#define PCOM_PUBSUB_TOPIC_MAX  (255)   // Longest topic
+
+/* Slow consumer policies */
+#define PCOM_PUBSUB_DEFAULT     (0)  // Subscribe: use the broker's policy
+#define PCOM_PUBSUB_DROP_OLDEST (1)
+#define PCOM_PUBSUB_DISCONNECT  (2)
+#define PCOM_PUBSUB_CONFLATE    (3)
+
+/* Frame flags on PCOM_FRAME_PUBSUB frames */
+#define PCOM_PUBSUB_PUBLISH     (1)
+#define PCOM_PUBSUB_SUBSCRIBE   (2)
+#define PCOM_PUBSUB_UNSUBSCRIBE (3)
+
+typedef struct pcom_broker pcom_broker_t;
+
+typedef struct {
+    int queue_len;       // Messages queued per subscriber, 0 for default
+    int policy;          // Default slow consumer policy, 0 for DROP_OLDEST
+} pcom_pubsub_opts_t;
+
+typedef struct {
+    unsigned long long subscribers;   // Connected now
+    unsigned long long published;     // Messages published
+    unsigned long long delivered;     // Messages sent to a subscriber
+    unsigned long long dropped;       // Dropped by DROP_OLDEST or CONFLATE
+    unsigned long long conflated;     // Replaced by a newer one with the same key
+    unsigned long long disconnected;  // Subscribers closed by DISCONNECT
+} pcom_pubsub_stats_t;
+
+/** A received message, pointers valid until the next receive */
+typedef struct {
+    const char* topic;   // Not NUL terminated
+    size_t topic_len;
+    uint64_t key;
+    const void* data;
+    size_t len;
+} pcom_pubsub_msg_t;
+
+/**
+ * @brief      Create a broker and start its thread.
+ * @param      pp_broker      Receives the broker.
+ * @param      server_handle  Stream server handle from pcom_server_open().
+ * @param      p_opts         Options, NULL for defaults.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_pubsub_create(pcom_broker_t** pp_broker, int server_handle, const pcom_pubsub_opts_t* p_opts);
+
+/**
+ * @brief      Publish a message to all matching subscribers.
+ * @param      p_broker  The broker.
+ * @param      topic     Topic, at most PCOM_PUBSUB_TOPIC_MAX bytes.
+ * @param      key       Conflation key, unique per topic.
+ * @param      data      Message data, copied once.
+ * @param      len       Length of the data.
+ * @return     0 on success, negative error code on failure.
+ * @details    Thread safe and never blocks on subscribers.
+ */
+LIB_EXPORT int
+pcom_pubsub_publish(pcom_broker_t* p_broker, const char* topic, uint64_t key, const void* data, size_t len);
+
+/**
+ * @brief      Read the broker counters.
+ * @param      p_broker  The broker.
+ * @param      p_stats   Receives the counters.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_pubsub_stats(const pcom_broker_t* p_broker, pcom_pubsub_stats_t* p_stats);
+
+/**
+ * @brief      Stop the broker, close all subscribers and free it.
+ * @param      p_broker  The broker.
+ * @details    Messages not yet sent are dropped. The server handle is not closed.
+ */
+LIB_EXPORT void
+pcom_pubsub_destroy(pcom_broker_t* p_broker);
+
+/**
+ * @brief      Subscribe to a topic prefix.
+ * @param      handle  Handle from pcom_client_open() to the broker.
+ * @param      topic   Topic prefix, "" for all topics.
+ * @param      policy  PCOM_PUBSUB_* slow consumer policy or PCOM_PUBSUB_DEFAULT.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_pubsub_subscribe(int handle, const char* topic, int policy);
+
+/**
+ * @brief      Drop a subscription made with the same prefix.
+ * @param      handle  Handle from pcom_client_open() to the broker.
+ * @param      topic   Topic prefix.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_pubsub_unsubscribe(int handle, const char* topic);
+
+/**
+ * @brief      Receive the next message, blocking.
+ * @param      handle    Handle from pcom_client_open() to the broker.
+ * @param      p_reader  Frame reader for this handle.
+ * @param      p_msg     Receives the message.
+ * @return     1 on success, 0 on EOF, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_pubsub_recv(int handle, pcom_frame_reader_t* p_reader, pcom_pubsub_msg_t* p_msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_PUBSUB_H
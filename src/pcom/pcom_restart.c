@@ -0,0 +1,359 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_restart.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Hot restart of PCOM servers by passing their sockets on.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <poll.h>
+#include <time.h>
+#endif
+#include <string.h>
+#include <errno.h>
+
+#include "pcom_restart.h"
+#include "pcom_coalesce.h"
+#include "pcom_stats.h"
+#include "pcom_tcp.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+/* Control messages, one per SEQPACKET record, both ends on the same host:
+ *   "PCRQ" max connections            successor asks
+ *   "PCRS" servers, local mask, conns control, servers, UNIX listeners
+ *   "PCRC" count                      a batch of connections
+ *   "PCOK" connections received       successor serves */
+#define MSG_REQUEST   "PCRQ"
+#define MSG_SERVERS   "PCRS"
+#define MSG_CONNS     "PCRC"
+#define MSG_READY     "PCOK"
+#define CONN_BATCH    (128)                            // Connections per message
+#define FDS_MAX       (1 + 2 * PCOM_RESTART_MAX_SERVERS > CONN_BATCH ? \
+                       1 + 2 * PCOM_RESTART_MAX_SERVERS : CONN_BATCH)
+
+#ifndef MSG_CMSG_CLOEXEC
+#define MSG_CMSG_CLOEXEC 0
+#endif
+
+typedef struct {
+    char magic[4];
+    uint32_t a, b, c;
+} msg_t;
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+/** Monotonic time in ms */
+static int64_t
+now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/** Wait for events on fd until the deadline (-1 none), 0 or negative error code */
+static int
+wait_until(int fd, short events, int64_t deadline)
+{
+    struct pollfd pfd = { .fd = fd, .events = events };
+    for (;;) {
+        int timeout = -1;
+        if (deadline >= 0) {
+            int64_t left = deadline - now_ms();
+            timeout = left > 0 ? (int)left : 0;
+        }
+        int n = poll(&pfd, 1, timeout);
+        if (n > 0) return 0;
+        if (n == 0) return -ETIMEDOUT;
+        if (errno != EINTR) return pcom_errno_from(errno);
+    }
+}
+
+static void
+close_all(const int* fds, int count)
+{
+    for (int i = 0; i < count; ++i) if (fds[i] >= 0) close(fds[i]);
+}
+
+/** Send one control message with count fds attached */
+static int
+send_msg(int sock, const char* magic, uint32_t a, uint32_t b, uint32_t c,
+         const int* fds, int count)
+{
+    union { char buf[CMSG_SPACE(sizeof(int) * FDS_MAX)]; struct cmsghdr align; } ctrl;
+    msg_t m;
+    struct iovec iov = { &m, sizeof(m) };
+    struct msghdr mh;
+
+    memcpy(m.magic, magic, 4);
+    m.a = a; m.b = b; m.c = c;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    if (count > 0) {
+        memset(&ctrl, 0, sizeof(ctrl));
+        mh.msg_control = ctrl.buf;
+        mh.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)count);
+        struct cmsghdr* p_cm = CMSG_FIRSTHDR(&mh);
+        p_cm->cmsg_level = SOL_SOCKET;
+        p_cm->cmsg_type = SCM_RIGHTS;
+        p_cm->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)count);
+        memcpy(CMSG_DATA(p_cm), fds, sizeof(int) * (size_t)count);
+    }
+    while (sendmsg(sock, &mh, MSG_NOSIGNAL) < 0) {
+        if (errno != EINTR) return pcom_errno_from(errno);
+    }
+    return 0;
+}
+
+/**
+ * Receive one control message of the expected kind before the deadline.
+ * Returns the number of fds stored in fds, negative error code on failure.
+ */
+static int
+recv_msg(int sock, const char* magic, msg_t* p_m, int* fds, int max, int64_t deadline)
+{
+    union { char buf[CMSG_SPACE(sizeof(int) * FDS_MAX)]; struct cmsghdr align; } ctrl;
+    struct iovec iov = { p_m, sizeof(*p_m) };
+    struct msghdr mh;
+    ssize_t got;
+    int count = 0;
+
+    int result = wait_until(sock, POLLIN, deadline);
+    if (result < 0) return result;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = ctrl.buf;
+    mh.msg_controllen = sizeof(ctrl.buf);
+    while ((got = recvmsg(sock, &mh, MSG_CMSG_CLOEXEC)) < 0) {
+        if (errno != EINTR) return pcom_errno_from(errno);
+    }
+
+    // Take every fd that arrived, so none leak when the message is bad
+    for (struct cmsghdr* p_cm = CMSG_FIRSTHDR(&mh); p_cm; p_cm = CMSG_NXTHDR(&mh, p_cm)) {
+        if (p_cm->cmsg_level != SOL_SOCKET || p_cm->cmsg_type != SCM_RIGHTS) continue;
+        int n = (int)((p_cm->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < n; ++i) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(p_cm) + i * sizeof(int), sizeof(int));
+            if (count < max) fds[count++] = fd;
+            else close(fd);
+        }
+    }
+    if (got == 0) { close_all(fds, count); return -ECONNABORTED; }
+    if (got != sizeof(*p_m) || memcmp(p_m->magic, magic, 4) != 0 || (mh.msg_flags & MSG_CTRUNC))
+        { close_all(fds, count); return -EPROTO; }
+    return count;
+}
+
+/** 0 if the peer runs as this user or as root */
+static int
+peer_allowed(int sock)
+{
+    uid_t uid;
+#if defined(__linux__)
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) return pcom_errno_from(errno);
+    uid = cred.uid;
+#else
+    gid_t gid;
+    if (getpeereid(sock, &uid, &gid) < 0) return pcom_errno_from(errno);
+#endif
+    return (uid == geteuid() || uid == 0) ? 0 : -EPERM;
+}
+
+/** The handoff on an accepted successor connection */
+static int
+handoff(int sock, int control_handle, const int* servers, int server_count,
+        const int* conns, int conn_count, int64_t deadline)
+{
+    int fds[FDS_MAX];
+    uint32_t mask = 0;
+    msg_t m;
+    int result = peer_allowed(sock);
+    if (result < 0) return result;
+
+    result = recv_msg(sock, MSG_REQUEST, &m, fds, FDS_MAX, deadline);
+    if (result < 0) return result;
+    close_all(fds, result);
+    int count = (conn_count < (int64_t)m.a) ? conn_count : (int)m.a;
+
+    // Whatever was coalesced goes out before the peer owns the connection
+    for (int i = 0; i < count; ++i) {
+        if (pcom_coalesce_on(conns[i]) && pcom_flush(conns[i]) < 0) return -EIO;
+    }
+
+    // Control and server handles, then the UNIX listeners of TCP servers
+    int n = 0;
+    fds[n++] = control_handle;
+    for (int i = 0; i < server_count; ++i) fds[n++] = servers[i];
+    for (int i = 0; i < server_count; ++i) {
+        int local = pcom_tcp_local_handle(servers[i]);
+        if (local >= 0) { fds[n++] = local; mask |= 1u << i; }
+    }
+    result = send_msg(sock, MSG_SERVERS, (uint32_t)server_count, mask, (uint32_t)count, fds, n);
+    for (int i = 0; i < count && result == 0; i += CONN_BATCH) {
+        int batch = (count - i < CONN_BATCH) ? count - i : CONN_BATCH;
+        result = send_msg(sock, MSG_CONNS, (uint32_t)batch, 0, 0, conns + i, batch);
+    }
+    if (result < 0) return result;
+
+    // The successor serves once it says so
+    result = recv_msg(sock, MSG_READY, &m, fds, FDS_MAX, deadline);
+    if (result < 0) return result;
+    close_all(fds, result);
+    return count;
+}
+
+/** Close what a failed takeover received */
+static void
+takeover_undo(pcom_restart_t* p_rs, int* conns, int conn_count)
+{
+    for (int i = 0; i < p_rs->server_count; ++i) {
+        pcom_tcp_server_close(p_rs->servers[i]);
+        close(p_rs->servers[i]);
+    }
+    close_all(conns, conn_count);
+    if (p_rs->listen >= 0) close(p_rs->listen);
+    p_rs->server_count = 0;
+    p_rs->conn_count = 0;
+    p_rs->listen = -1;
+}
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_restart_listen(const char* control_name)
+{
+    return pcom_server_open_ex(control_name, PCOM_OPEN_SEQPACKET);
+}
+
+int
+pcom_restart_handoff(int control_handle, const int* servers, int server_count,
+                     const int* conns, int conn_count, int timeout_ms)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (server_count < 0 || server_count > PCOM_RESTART_MAX_SERVERS || conn_count < 0 ||
+        (server_count && !servers) || (conn_count && !conns)) return -EINVAL;
+    int64_t deadline = (timeout_ms < 0) ? -1 : now_ms() + timeout_ms;
+
+    // Wait for the successor
+    int result = wait_until(control_handle, POLLIN, deadline);
+    if (result < 0) return result;
+    int sock = accept(control_handle, NULL, NULL);
+    if (sock < 0) return pcom_errno_from(errno);
+
+    result = handoff(sock, control_handle, servers, server_count, conns, conn_count, deadline);
+    close(sock);
+    // Still serving: the UNIX listeners answer for this process again
+    for (int i = 0; result < 0 && i < server_count; ++i) {
+        int local = pcom_tcp_local_handle(servers[i]);
+        if (local >= 0) pcom_tcp_local_adopt(servers[i], local);
+    }
+    return result;
+
+#else
+    (void)control_handle; (void)servers; (void)server_count;
+    (void)conns; (void)conn_count; (void)timeout_ms;
+    return -1;
+#endif
+}
+
+int
+pcom_restart_takeover(const char* control_name, pcom_restart_t* p_rs,
+                      int* conns, int max_conns, int timeout_ms)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    int fds[FDS_MAX];
+    msg_t m;
+
+    if (!p_rs || max_conns < 0) return -EINVAL;
+    if (!conns) max_conns = 0;
+    memset(p_rs, 0, sizeof(*p_rs));
+    p_rs->control = -1;
+    p_rs->listen = -1;
+    int64_t deadline = (timeout_ms < 0) ? -1 : now_ms() + timeout_ms;
+
+    int sock = pcom_client_open_ex(control_name, PCOM_OPEN_SEQPACKET);
+    if (sock < 0) return sock;
+    int result = send_msg(sock, MSG_REQUEST, (uint32_t)max_conns, 0, 0, NULL, 0);
+
+    // Control and server handles, the UNIX listeners of the TCP servers
+    int n = (result < 0) ? result : recv_msg(sock, MSG_SERVERS, &m, fds, FDS_MAX, deadline);
+    if (n < 0) { close(sock); return n; }
+    int locals = __builtin_popcount(m.b);
+    if (m.a > PCOM_RESTART_MAX_SERVERS || (m.b >> m.a) != 0 || m.c > (uint32_t)max_conns ||
+        n != 1 + (int)m.a + locals) {
+        close_all(fds, n);
+        close(sock);
+        return -EPROTO;
+    }
+    p_rs->listen = fds[0];
+    p_rs->server_count = (int)m.a;
+    memcpy(p_rs->servers, fds + 1, sizeof(int) * m.a);
+    for (int i = 0, l = 1 + (int)m.a; i < p_rs->server_count; ++i) {
+        if (m.b & (1u << i)) pcom_tcp_local_adopt(p_rs->servers[i], fds[l++]);
+    }
+
+    // Connections in batches, counted afresh in this process
+    int want = (int)m.c;
+    while (p_rs->conn_count < want) {
+        n = recv_msg(sock, MSG_CONNS, &m, conns + p_rs->conn_count,
+                     want - p_rs->conn_count, deadline);
+        if (n >= 0 && (int)m.a != n) { close_all(conns + p_rs->conn_count, n); n = -EPROTO; }
+        if (n < 0) {
+            takeover_undo(p_rs, conns, p_rs->conn_count);
+            close(sock);
+            return n;
+        }
+        for (int i = 0; i < n; ++i) pcom_stats_conn_clear(conns[p_rs->conn_count + i]);
+        p_rs->conn_count += n;
+    }
+    p_rs->control = sock;
+    return 0;
+
+#else
+    (void)control_name; (void)p_rs; (void)conns; (void)max_conns; (void)timeout_ms;
+    return -1;
+#endif
+}
+
+int
+pcom_restart_ready(pcom_restart_t* p_rs)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    if (!p_rs || p_rs->control < 0) return -EINVAL;
+    int result = send_msg(p_rs->control, MSG_READY, (uint32_t)p_rs->conn_count, 0, 0, NULL, 0);
+    close(p_rs->control);
+    p_rs->control = -1;
+    return result;
+
+#else
+    (void)p_rs;
+    return -1;
+#endif
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_restart.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Hot restart of PCOM servers by passing their sockets on.
+ ****************************************************************************/
+/** @defgroup  PCOM_RESTART
+ * @brief     Hand listening sockets and live connections to a new process.
+ * @details   The running server listens on a control name. Its successor
+ *            connects there and receives the server handles, and optionally
+ *            connections, over SCM_RIGHTS. The listeners are never closed,
+ *            so clients connecting during the restart wait in the backlog
+ *            instead of being refused, and passed connections carry on with
+ *            the new process without reconnecting:
+ *
+ *                // Old process, control handle polled with its other handles
+ *                int ctl = pcom_restart_listen("@db-restart");
+ *                ...
+ *                int n = pcom_restart_handoff(ctl, &server, 1, idle, n_idle, 5000);
+ *                if (n >= 0) {
+ *                    // Stop accepting, close ctl, the server and idle[0..n),
+ *                    // finish the requests in flight, then exit
+ *                }
+ *
+ *                // New process
+ *                pcom_restart_t rs;
+ *                int conns[1024];
+ *                if (pcom_restart_takeover("@db-restart", &rs, conns, 1024, 5000) == 0) {
+ *                    server = rs.servers[0];
+ *                    ctl = rs.listen;
+ *                    // Add server and conns[0..rs.conn_count) to the loop
+ *                    pcom_restart_ready(&rs);
+ *                } else {
+ *                    server = pcom_server_open("db");   // first start
+ *                    ctl = pcom_restart_listen("@db-restart");
+ *                }
+ *
+ *            The old process keeps serving until the successor calls
+ *            pcom_restart_ready(), so a successor that fails to start costs
+ *            nothing: the handoff returns an error and the old process
+ *            carries on. Until then both processes may accept.
+ *
+ *            TCP servers bring their UNIX listener (see pcom_tcp.h) along.
+ *
+ * @pre       pcom.h
+ * @bug       -
+ * @warning   Only the user of the old process, or root, can take over.
+ *            Pass only connections the old process has stopped reading
+ *            from, between messages: bytes it has read are not passed on.
+ *            Coalesced output is flushed before a connection is passed.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_RESTART_H
+#define PCOM_RESTART_H
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_RESTART_MAX_SERVERS (16)
+
+/** Sockets taken over from the old process */
+typedef struct {
+    int control;                              // Connection to the old process until ready
+    int listen;                               // Control handle for the next restart
+    int servers[PCOM_RESTART_MAX_SERVERS];    // Server handles, in the order passed
+    int server_count;
+    int conn_count;                           // Connections received
+} pcom_restart_t;
+
+/**
+ * @brief      Listen for a successor on a control name.
+ * @param      control_name  Connection name, see pcom_server_open().
+ * @return     Control handle, negative error code on failure.
+ * @details    The handle becomes readable when a successor connects. Close
+ *             it with pcom_server_close().
+ */
+LIB_EXPORT int
+pcom_restart_listen(const char* control_name);
+
+/**
+ * @brief      Pass server handles and connections to a successor.
+ * @param      control_handle  Handle from pcom_restart_listen().
+ * @param      servers         Server handles to pass, up to PCOM_RESTART_MAX_SERVERS.
+ * @param      server_count    Number of server handles.
+ * @param      conns           Connections to pass, may be NULL.
+ * @param      conn_count      Number of connections.
+ * @param      timeout_ms      Longest wait for the successor to connect and
+ *                             to become ready, -1 for no limit.
+ * @return     Number of connections passed, the first ones of conns, or
+ *             negative error code: -ETIMEDOUT, -EPERM for a successor of
+ *             another user, -ECONNABORTED if it gave up before ready.
+ * @details    The control handle is passed too, for the successor's own
+ *             restart. On success the successor serves: stop accepting,
+ *             close the control and server handles and the passed
+ *             connections, drain the rest. On failure nothing changed for
+ *             the old process.
+ */
+LIB_EXPORT int
+pcom_restart_handoff(int control_handle, const int* servers, int server_count,
+                     const int* conns, int conn_count, int timeout_ms);
+
+/**
+ * @brief      Take over the sockets of the process listening on a control name.
+ * @param      control_name  Connection name given to pcom_restart_listen().
+ * @param      p_rs          Receives the server handles and the control handle.
+ * @param      conns         Receives passed connections, may be NULL.
+ * @param      max_conns     Room in conns.
+ * @param      timeout_ms    Longest wait for the old process, -1 for no limit.
+ * @return     0 on success, -ECONNREFUSED or -ENOENT if no process listens
+ *             (first start), negative error code on failure.
+ * @details    Call pcom_restart_ready() once the handles are served. To give
+ *             up instead, close the handles, p_rs->listen and p_rs->control.
+ */
+LIB_EXPORT int
+pcom_restart_takeover(const char* control_name, pcom_restart_t* p_rs,
+                      int* conns, int max_conns, int timeout_ms);
+
+/**
+ * @brief      Tell the old process that the successor serves now.
+ * @param      p_rs  Filled by pcom_restart_takeover().
+ * @return     0 on success, negative error code on failure.
+ * @details    Closes the control handle.
+ */
+LIB_EXPORT int
+pcom_restart_ready(pcom_restart_t* p_rs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_RESTART_H
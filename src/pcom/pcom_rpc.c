@@ -0,0 +1,624 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_rpc.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Pipelined request/response RPC over PCOM connections.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include "pcom_rpc.h"
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define RPC_MSG_HDR   (PCOM_FRAME_HDR_SIZE + PCOM_RPC_HDR_SIZE)
+#define RPC_SMALL     (512)    // Messages up to this are built on the stack
+#define RPC_TABLE_MIN (64)     // Initial completion table size (power of 2)
+
+/** Caller blocked in pcom_rpc_call() */
+typedef struct {
+    pthread_cond_t cond;
+    int done;
+    int status;
+    void* buf;
+    size_t cap;
+    size_t len;
+} rpc_waiter_t;
+
+/** Completion table entry */
+typedef struct {
+    uint64_t id;             // 0 marks a free slot
+    pcom_rpc_done_t done;
+    void* user;
+    rpc_waiter_t* p_waiter;  // Set for blocking calls instead of done
+} rpc_pending_t;
+
+struct pcom_rpc_client {
+    int handle;
+    pthread_t reader;
+    pthread_mutex_t send_lock;  // One message on the wire at a time
+    pthread_mutex_t lock;       // Guards everything below
+    rpc_pending_t* table;       // Open addressing, linear probing
+    size_t mask;
+    int count;
+    uint64_t next_id;
+    int dead;                   // Connection gone, error for new calls
+};
+
+typedef struct {
+    uint32_t method;
+    int used;
+    pcom_rpc_handler_t handler;
+    void* user;
+} rpc_method_t;
+
+struct pcom_rpc_server {
+    pcom_rpc_send_t send;
+    void* send_ctx;
+    pthread_mutex_t send_lock;  // For the default blocking send
+    rpc_method_t* methods;      // Open addressing, linear probing
+    size_t method_mask;
+    int method_count;
+    pthread_mutex_t lock;       // Guards the reader table
+    pcom_frame_reader_t** readers;
+    int reader_cap;
+};
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static inline size_t
+hash_u64(uint64_t v) { return (size_t)((v * 0x9E3779B97F4A7C15ULL) >> 17); }
+
+static void
+put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t
+get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Build frame header, RPC header and body in one buffer, then hand it to send */
+static int
+rpc_send_msg(int (*send)(void*, int, const void*, size_t), void* ctx, int handle,
+             uint8_t flags, uint64_t id, uint32_t word, const void* data, size_t len)
+{
+    uint8_t small[RPC_SMALL];
+    uint8_t* p = small;
+    int result;
+
+    if (len > PCOM_FRAME_MAX - PCOM_RPC_HDR_SIZE) return -EMSGSIZE;
+    if (RPC_MSG_HDR + len > sizeof(small)) {
+        p = malloc(RPC_MSG_HDR + len);
+        if (!p) return -ENOMEM;
+    }
+
+    pcom_frame_hdr_t hdr = { (uint32_t)(PCOM_RPC_HDR_SIZE + len), PCOM_FRAME_RPC, flags, 0 };
+    pcom_frame_encode(p, &hdr);
+    put_u32(p + PCOM_FRAME_HDR_SIZE, (uint32_t)id);
+    put_u32(p + PCOM_FRAME_HDR_SIZE + 4, (uint32_t)(id >> 32));
+    put_u32(p + PCOM_FRAME_HDR_SIZE + 8, word);
+    if (len) memcpy(p + RPC_MSG_HDR, data, len);
+
+    result = send(ctx, handle, p, RPC_MSG_HDR + len);
+    if (p != small) free(p);
+    return result;
+}
+
+static int
+default_send(void* ctx, int handle, const void* buf, size_t len)
+{
+    (void)ctx;
+    int64_t result = pcom_send_all(handle, buf, len);
+    return result < 0 ? (int)result : 0;
+}
+
+/* ---- Client ------------------------------------------------------------ */
+
+static rpc_pending_t*
+table_find(pcom_rpc_client_t* p_c, uint64_t id)
+{
+    for (size_t i = hash_u64(id) & p_c->mask;; i = (i + 1) & p_c->mask) {
+        if (p_c->table[i].id == id) return &p_c->table[i];
+        if (p_c->table[i].id == 0) return NULL;
+    }
+}
+
+/* Backward shift delete keeps probe chains intact without tombstones */
+static void
+table_remove(pcom_rpc_client_t* p_c, rpc_pending_t* p_e)
+{
+    size_t hole = (size_t)(p_e - p_c->table);
+    for (size_t i = (hole + 1) & p_c->mask; p_c->table[i].id; i = (i + 1) & p_c->mask) {
+        size_t home = hash_u64(p_c->table[i].id) & p_c->mask;
+        // Move back unless its home lies cyclically in (hole, i]
+        if (((i - home) & p_c->mask) >= ((i - hole) & p_c->mask)) {
+            p_c->table[hole] = p_c->table[i];
+            hole = i;
+        }
+    }
+    p_c->table[hole].id = 0;
+    p_c->count--;
+}
+
+static int
+table_insert(pcom_rpc_client_t* p_c, const rpc_pending_t* p_new)
+{
+    // Keep the load factor under 1/2
+    if ((size_t)(p_c->count + 1) * 2 > p_c->mask + 1) {
+        size_t size = (p_c->mask + 1) * 2;
+        rpc_pending_t* p_old = p_c->table;
+        size_t old_size = p_c->mask + 1;
+        rpc_pending_t* p = calloc(size, sizeof(*p));
+        if (!p) return -ENOMEM;
+        p_c->table = p;
+        p_c->mask = size - 1;
+        p_c->count = 0;
+        for (size_t i = 0; i < old_size; ++i)
+            if (p_old[i].id) table_insert(p_c, &p_old[i]);
+        free(p_old);
+    }
+    size_t i = hash_u64(p_new->id) & p_c->mask;
+    while (p_c->table[i].id) i = (i + 1) & p_c->mask;
+    p_c->table[i] = *p_new;
+    p_c->count++;
+    return 0;
+}
+
+/* Complete every request with an error, the connection is gone. The first
+ * reason sticks, a destroy outranks the read error its shutdown causes. */
+static void
+fail_all(pcom_rpc_client_t* p_c, int error)
+{
+    pthread_mutex_lock(&p_c->lock);
+    if (!p_c->dead) p_c->dead = error;
+    error = p_c->dead;
+    while (p_c->count > 0) {
+        rpc_pending_t* p_e = NULL;
+        for (size_t i = 0; i <= p_c->mask && !p_e; ++i)
+            if (p_c->table[i].id) p_e = &p_c->table[i];
+        rpc_pending_t e = *p_e;
+        table_remove(p_c, p_e);
+        if (e.p_waiter) {
+            e.p_waiter->status = error;
+            e.p_waiter->done = 1;
+            pthread_cond_signal(&e.p_waiter->cond);
+        } else {
+            pthread_mutex_unlock(&p_c->lock);
+            e.done(error, NULL, 0, e.user);
+            pthread_mutex_lock(&p_c->lock);
+        }
+    }
+    pthread_mutex_unlock(&p_c->lock);
+}
+
+static void
+complete(pcom_rpc_client_t* p_c, uint64_t id, int status, const void* data, size_t len)
+{
+    pthread_mutex_lock(&p_c->lock);
+    rpc_pending_t* p_e = table_find(p_c, id);
+    if (!p_e) {
+        // Caller timed out, response is dropped
+        pthread_mutex_unlock(&p_c->lock);
+        return;
+    }
+    rpc_pending_t e = *p_e;
+    table_remove(p_c, p_e);
+    if (e.p_waiter) {
+        rpc_waiter_t* p_w = e.p_waiter;
+        if (len && p_w->cap) memcpy(p_w->buf, data, len < p_w->cap ? len : p_w->cap);
+        p_w->len = len;
+        p_w->status = status;
+        p_w->done = 1;
+        pthread_cond_signal(&p_w->cond);
+        pthread_mutex_unlock(&p_c->lock);
+        return;
+    }
+    pthread_mutex_unlock(&p_c->lock);
+    e.done(status, data, len, e.user);
+}
+
+static void*
+reader_main(void* arg)
+{
+    pcom_rpc_client_t* p_c = arg;
+    pcom_frame_reader_t reader;
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    int result;
+
+    pcom_frame_reader_init(&reader);
+    while ((result = pcom_frame_recv(p_c->handle, &reader, &hdr, &payload)) > 0) {
+        if (hdr.type != PCOM_FRAME_RPC || !(hdr.flags & PCOM_RPC_RESPONSE)) continue;
+        if (hdr.len < PCOM_RPC_HDR_SIZE) {
+            result = -EPROTO;
+            break;
+        }
+        const uint8_t* p = payload;
+        uint64_t id = (uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+        complete(p_c, id, (int32_t)get_u32(p + 8), p + PCOM_RPC_HDR_SIZE, hdr.len - PCOM_RPC_HDR_SIZE);
+    }
+    pcom_frame_reader_free(&reader);
+    fail_all(p_c, result < 0 ? result : -EPIPE);
+    return NULL;
+}
+
+/* Register the request, then put it on the wire */
+static int
+client_issue(pcom_rpc_client_t* p_c, uint32_t method, const void* req, size_t len,
+             rpc_pending_t* p_new)
+{
+    int result;
+
+    if (!req && len) return -EINVAL;
+
+    pthread_mutex_lock(&p_c->lock);
+    if (p_c->dead) {
+        result = p_c->dead;
+        pthread_mutex_unlock(&p_c->lock);
+        return result;
+    }
+    p_new->id = p_c->next_id++;
+    result = table_insert(p_c, p_new);
+    pthread_mutex_unlock(&p_c->lock);
+    if (result < 0) return result;
+
+    pthread_mutex_lock(&p_c->send_lock);
+    result = rpc_send_msg(default_send, NULL, p_c->handle, 0, p_new->id, method, req, len);
+    pthread_mutex_unlock(&p_c->send_lock);
+
+    if (result < 0) {
+        // Withdraw unless the reader already failed it
+        pthread_mutex_lock(&p_c->lock);
+        rpc_pending_t* p_e = table_find(p_c, p_new->id);
+        if (p_e) table_remove(p_c, p_e);
+        else result = 1;
+        pthread_mutex_unlock(&p_c->lock);
+    }
+    return result;
+}
+
+/* ---- Server ------------------------------------------------------------ */
+
+static rpc_method_t*
+method_find(const pcom_rpc_server_t* p_s, uint32_t method)
+{
+    if (!p_s->methods) return NULL;
+    for (size_t i = hash_u64(method) & p_s->method_mask;; i = (i + 1) & p_s->method_mask) {
+        if (!p_s->methods[i].used) return NULL;
+        if (p_s->methods[i].method == method) return &p_s->methods[i];
+    }
+}
+
+static pcom_frame_reader_t*
+reader_get(pcom_rpc_server_t* p_s, int handle)
+{
+    pcom_frame_reader_t* p_r = NULL;
+
+    pthread_mutex_lock(&p_s->lock);
+    if (handle >= p_s->reader_cap) {
+        int cap = p_s->reader_cap ? p_s->reader_cap : 64;
+        while (cap <= handle) cap *= 2;
+        pcom_frame_reader_t** p = realloc(p_s->readers, (size_t)cap * sizeof(*p));
+        if (!p) goto out;
+        memset(p + p_s->reader_cap, 0, (size_t)(cap - p_s->reader_cap) * sizeof(*p));
+        p_s->readers = p;
+        p_s->reader_cap = cap;
+    }
+    if (!p_s->readers[handle]) p_s->readers[handle] = calloc(1, sizeof(pcom_frame_reader_t));
+    p_r = p_s->readers[handle];
+out:
+    pthread_mutex_unlock(&p_s->lock);
+    return p_r;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_rpc_client_create(pcom_rpc_client_t** pp_client, int handle)
+{
+    int result;
+
+    if (!pp_client) return -EINVAL;
+    *pp_client = NULL;
+    if (handle < 0) return -EBADF;
+
+    pcom_rpc_client_t* p_c = calloc(1, sizeof(*p_c));
+    if (!p_c) return -ENOMEM;
+    p_c->table = calloc(RPC_TABLE_MIN, sizeof(*p_c->table));
+    if (!p_c->table) {
+        free(p_c);
+        return -ENOMEM;
+    }
+    p_c->mask = RPC_TABLE_MIN - 1;
+    p_c->handle = handle;
+    p_c->next_id = 1;
+    pthread_mutex_init(&p_c->lock, NULL);
+    pthread_mutex_init(&p_c->send_lock, NULL);
+
+    result = pthread_create(&p_c->reader, NULL, reader_main, p_c);
+    if (result != 0) {
+        pthread_mutex_destroy(&p_c->lock);
+        pthread_mutex_destroy(&p_c->send_lock);
+        free(p_c->table);
+        free(p_c);
+        return pcom_errno_from(result);
+    }
+
+    *pp_client = p_c;
+    return 0;
+}
+
+int
+pcom_rpc_call_async(pcom_rpc_client_t* p_client, uint32_t method, const void* req, size_t len,
+                    pcom_rpc_done_t done, void* user)
+{
+    if (!p_client || !done) return -EINVAL;
+    rpc_pending_t e = { 0, done, user, NULL };
+    int result = client_issue(p_client, method, req, len, &e);
+    return result > 0 ? 0 : result;
+}
+
+int
+pcom_rpc_call(pcom_rpc_client_t* p_client, uint32_t method, const void* req, size_t len,
+              void* resp, size_t resp_cap, size_t* p_resp_len, int timeout_ms)
+{
+    rpc_waiter_t w = { .buf = resp, .cap = resp ? resp_cap : 0 };
+    pthread_condattr_t attr;
+    struct timespec deadline;
+    int result;
+
+    if (!p_client) return -EINVAL;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&w.cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    rpc_pending_t e = { 0, NULL, NULL, &w };
+    result = client_issue(p_client, method, req, len, &e);
+    if (result < 0) {
+        pthread_cond_destroy(&w.cond);
+        return result;
+    }
+
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&p_client->lock);
+    while (!w.done) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&w.cond, &p_client->lock);
+        } else if (pthread_cond_timedwait(&w.cond, &p_client->lock, &deadline) == ETIMEDOUT && !w.done) {
+            rpc_pending_t* p_e = table_find(p_client, e.id);
+            if (p_e) table_remove(p_client, p_e);
+            w.status = -ETIMEDOUT;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&p_client->lock);
+    pthread_cond_destroy(&w.cond);
+
+    if (p_resp_len) *p_resp_len = w.len;
+    return w.status;
+}
+
+int
+pcom_rpc_client_pending(pcom_rpc_client_t* p_client)
+{
+    pthread_mutex_lock(&p_client->lock);
+    int count = p_client->count;
+    pthread_mutex_unlock(&p_client->lock);
+    return count;
+}
+
+void
+pcom_rpc_client_destroy(pcom_rpc_client_t* p_client)
+{
+    if (!p_client) return;
+
+    // Wake the reader, it fails what is left
+    pthread_mutex_lock(&p_client->lock);
+    p_client->dead = -ECANCELED;
+    pthread_mutex_unlock(&p_client->lock);
+    shutdown(p_client->handle, SHUT_RDWR);
+    pthread_join(p_client->reader, NULL);
+    fail_all(p_client, -ECANCELED);
+
+    pcom_client_close(p_client->handle);
+    pthread_mutex_destroy(&p_client->lock);
+    pthread_mutex_destroy(&p_client->send_lock);
+    free(p_client->table);
+    free(p_client);
+}
+
+int
+pcom_rpc_server_create(pcom_rpc_server_t** pp_srv, pcom_rpc_send_t send, void* send_ctx)
+{
+    if (!pp_srv) return -EINVAL;
+    pcom_rpc_server_t* p_s = calloc(1, sizeof(*p_s));
+    *pp_srv = p_s;
+    if (!p_s) return -ENOMEM;
+    p_s->send = send;
+    p_s->send_ctx = send_ctx;
+    pthread_mutex_init(&p_s->lock, NULL);
+    pthread_mutex_init(&p_s->send_lock, NULL);
+    return 0;
+}
+
+int
+pcom_rpc_server_register(pcom_rpc_server_t* p_srv, uint32_t method, pcom_rpc_handler_t handler, void* user)
+{
+    rpc_method_t* p_m = method_find(p_srv, method);
+    if (p_m) {
+        if (handler) {
+            p_m->handler = handler;
+            p_m->user = user;
+            return 0;
+        }
+        // Slot stays, requests get -ENOSYS again
+        p_m->handler = NULL;
+        return 0;
+    }
+    if (!handler) return -ENOENT;
+
+    if ((size_t)(p_srv->method_count + 1) * 2 > (p_srv->methods ? p_srv->method_mask + 1 : 0)) {
+        size_t size = p_srv->methods ? (p_srv->method_mask + 1) * 2 : 16;
+        rpc_method_t* p_old = p_srv->methods;
+        size_t old_size = p_old ? p_srv->method_mask + 1 : 0;
+        rpc_method_t* p = calloc(size, sizeof(*p));
+        if (!p) return -ENOMEM;
+        p_srv->methods = p;
+        p_srv->method_mask = size - 1;
+        for (size_t i = 0; i < old_size; ++i) {
+            if (!p_old[i].used) continue;
+            size_t j = hash_u64(p_old[i].method) & p_srv->method_mask;
+            while (p[j].used) j = (j + 1) & p_srv->method_mask;
+            p[j] = p_old[i];
+        }
+        free(p_old);
+    }
+    size_t i = hash_u64(method) & p_srv->method_mask;
+    while (p_srv->methods[i].used) i = (i + 1) & p_srv->method_mask;
+    p_srv->methods[i] = (rpc_method_t){ method, 1, handler, user };
+    p_srv->method_count++;
+    return 0;
+}
+
+int
+pcom_rpc_server_feed(pcom_rpc_server_t* p_srv, int handle, const void* data, size_t len)
+{
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    int result, count = 0;
+
+    if (!p_srv || handle < 0) return -EINVAL;
+    pcom_frame_reader_t* p_r = reader_get(p_srv, handle);
+    if (!p_r) return -ENOMEM;
+    result = pcom_frame_reader_feed(p_r, data, len);
+    if (result < 0) return result;
+
+    while ((result = pcom_frame_reader_next(p_r, &hdr, &payload)) > 0) {
+        if (hdr.type != PCOM_FRAME_RPC || (hdr.flags & PCOM_RPC_RESPONSE)) continue;
+        if (hdr.len < PCOM_RPC_HDR_SIZE) return -EPROTO;
+
+        const uint8_t* p = payload;
+        pcom_rpc_req_t req;
+        req.handle = handle;
+        req.id = (uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+        req.method = get_u32(p + 8);
+
+        rpc_method_t* p_m = method_find(p_srv, req.method);
+        if (!p_m || !p_m->handler) {
+            result = pcom_rpc_reply(p_srv, &req, -ENOSYS, NULL, 0);
+        } else {
+            result = p_m->handler(p_srv, &req, p + PCOM_RPC_HDR_SIZE,
+                                  hdr.len - PCOM_RPC_HDR_SIZE, p_m->user);
+        }
+        if (result < 0) return result;
+        count++;
+    }
+    return result < 0 ? result : count;
+}
+
+int
+pcom_rpc_reply(pcom_rpc_server_t* p_srv, const pcom_rpc_req_t* p_req, int32_t status,
+               const void* data, size_t len)
+{
+    int result;
+
+    if (!p_srv || !p_req || (!data && len)) return -EINVAL;
+    if (p_srv->send)
+        return rpc_send_msg(p_srv->send, p_srv->send_ctx, p_req->handle, PCOM_RPC_RESPONSE,
+                            p_req->id, (uint32_t)status, data, len);
+
+    // Replies from several threads must not interleave on the wire
+    pthread_mutex_lock(&p_srv->send_lock);
+    result = rpc_send_msg(default_send, NULL, p_req->handle, PCOM_RPC_RESPONSE,
+                          p_req->id, (uint32_t)status, data, len);
+    pthread_mutex_unlock(&p_srv->send_lock);
+    return result;
+}
+
+void
+pcom_rpc_server_drop(pcom_rpc_server_t* p_srv, int handle)
+{
+    pthread_mutex_lock(&p_srv->lock);
+    if (handle >= 0 && handle < p_srv->reader_cap && p_srv->readers[handle]) {
+        pcom_frame_reader_free(p_srv->readers[handle]);
+        free(p_srv->readers[handle]);
+        p_srv->readers[handle] = NULL;
+    }
+    pthread_mutex_unlock(&p_srv->lock);
+}
+
+void
+pcom_rpc_server_destroy(pcom_rpc_server_t* p_srv)
+{
+    if (!p_srv) return;
+    for (int i = 0; i < p_srv->reader_cap; ++i) {
+        if (!p_srv->readers[i]) continue;
+        pcom_frame_reader_free(p_srv->readers[i]);
+        free(p_srv->readers[i]);
+    }
+    pthread_mutex_destroy(&p_srv->lock);
+    pthread_mutex_destroy(&p_srv->send_lock);
+    free(p_srv->readers);
+    free(p_srv->methods);
+    free(p_srv);
+}
+
+#else /* Not supported platforms */
+
+int pcom_rpc_client_create(pcom_rpc_client_t** pp_client, int handle)
+    { (void)handle; if (pp_client) *pp_client = NULL; return -1; }
+int pcom_rpc_call_async(pcom_rpc_client_t* p_client, uint32_t method, const void* req, size_t len,
+                        pcom_rpc_done_t done, void* user)
+    { (void)p_client; (void)method; (void)req; (void)len; (void)done; (void)user; return -1; }
+int pcom_rpc_call(pcom_rpc_client_t* p_client, uint32_t method, const void* req, size_t len,
+                  void* resp, size_t resp_cap, size_t* p_resp_len, int timeout_ms)
+    { (void)p_client; (void)method; (void)req; (void)len; (void)resp; (void)resp_cap;
+      (void)p_resp_len; (void)timeout_ms; return -1; }
+int pcom_rpc_client_pending(pcom_rpc_client_t* p_client) { (void)p_client; return 0; }
+void pcom_rpc_client_destroy(pcom_rpc_client_t* p_client) { (void)p_client; }
+int pcom_rpc_server_create(pcom_rpc_server_t** pp_srv, pcom_rpc_send_t send, void* send_ctx)
+    { (void)send; (void)send_ctx; if (pp_srv) *pp_srv = NULL; return -1; }
+int pcom_rpc_server_register(pcom_rpc_server_t* p_srv, uint32_t method, pcom_rpc_handler_t handler, void* user)
+    { (void)p_srv; (void)method; (void)handler; (void)user; return -1; }
+int pcom_rpc_server_feed(pcom_rpc_server_t* p_srv, int handle, const void* data, size_t len)
+    { (void)p_srv; (void)handle; (void)data; (void)len; return -1; }
+int pcom_rpc_reply(pcom_rpc_server_t* p_srv, const pcom_rpc_req_t* p_req, int32_t status,
+                   const void* data, size_t len)
+    { (void)p_srv; (void)p_req; (void)status; (void)data; (void)len; return -1; }
+void pcom_rpc_server_drop(pcom_rpc_server_t* p_srv, int handle) { (void)p_srv; (void)handle; }
+void pcom_rpc_server_destroy(pcom_rpc_server_t* p_srv) { (void)p_srv; }
+
+#endif
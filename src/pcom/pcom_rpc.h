@@ -0,0 +1,209 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_rpc.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Pipelined request/response RPC over PCOM connections.
+ ****************************************************************************/
+/** @defgroup  PCOM_RPC
+ * @brief     Request/response RPC with correlation IDs.
+ * @details   Requests carry a method ID and a 64 bit correlation ID. A client
+ *            keeps any number of requests in flight on one connection and a
+ *            completion table matches each response to its caller, so the
+ *            server may answer in any order. Calls can block (from many
+ *            threads at once) or complete through a callback.
+ *
+ *            Messages are PCOM_FRAME_RPC frames (see pcom_frame.h) with a 12
+ *            byte header in front of the body:
+ *
+ *            | Offset | Size | Field                                      |
+ *            |--------|------|--------------------------------------------|
+ *            | 0      | 8    | Correlation ID, little endian              |
+ *            | 8      | 4    | Request: method ID. Response: status.      |
+ *
+ *            Frame flags tell requests (0) from responses (PCOM_RPC_RESPONSE).
+ *            The server side is transport agnostic: feed it received bytes
+ *            from pcom_server_recv(), a pcom_loop or a pcom_server_pool and
+ *            give it a send function.
+ *
+ * @pre       pcom.h, pcom_frame.h, pthreads
+ * @bug       -
+ * @warning   Not available on Windows.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_RPC_H
+#define PCOM_RPC_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint32_t etc.
+
+#include "pcom.h"
+#include "pcom_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_RPC_HDR_SIZE  (12)
+#define PCOM_RPC_RESPONSE  (1 << 0)  // Frame flag on responses
+
+typedef struct pcom_rpc_client pcom_rpc_client_t;
+typedef struct pcom_rpc_server pcom_rpc_server_t;
+
+/** Completion callback, status is the server's status or a negative error */
+typedef void (*pcom_rpc_done_t)(int status, const void* data, size_t len, void* user);
+
+/** A request being served. Copy it to reply later. */
+typedef struct {
+    int handle;          // Connection the request came from
+    uint64_t id;         // Correlation ID
+    uint32_t method;     // Method ID
+} pcom_rpc_req_t;
+
+/** Method handler, reply now or later with pcom_rpc_reply(). Negative drops the connection. */
+typedef int (*pcom_rpc_handler_t)(pcom_rpc_server_t* p_srv, const pcom_rpc_req_t* p_req,
+                                  const void* data, size_t len, void* user);
+
+/** Transport used for replies, must send all len bytes or fail */
+typedef int (*pcom_rpc_send_t)(void* ctx, int handle, const void* buf, size_t len);
+
+/**
+ * @brief      Create an RPC client on a connected handle.
+ * @param      pp_client  Receives the client.
+ * @param      handle     Connected stream handle from pcom_client_open().
+ * @return     0 on success, negative error code on failure.
+ * @details    The client owns the handle from now on and starts a thread
+ *             that reads responses. Callbacks run on that thread.
+ */
+LIB_EXPORT int
+pcom_rpc_client_create(pcom_rpc_client_t** pp_client, int handle);
+
+/**
+ * @brief      Issue a request and return at once.
+ * @param      p_client  The client.
+ * @param      method    Method ID.
+ * @param      req       Request body.
+ * @param      len       Length of the request body.
+ * @param      done      Called once with the response or an error.
+ * @param      user      Passed to done.
+ * @return     0 on success, negative error code on failure (done is not called).
+ * @details    Thread safe.
+ */
+LIB_EXPORT int
+pcom_rpc_call_async(pcom_rpc_client_t* p_client, uint32_t method, const void* req, size_t len,
+                    pcom_rpc_done_t done, void* user);
+
+/**
+ * @brief      Issue a request and wait for the response.
+ * @param      p_client    The client.
+ * @param      method      Method ID.
+ * @param      req         Request body.
+ * @param      len         Length of the request body.
+ * @param      resp        Buffer for the response body.
+ * @param      resp_cap    Size of the response buffer.
+ * @param      p_resp_len  Receives the full response length, may be NULL.
+ *                         Bodies longer than resp_cap are truncated.
+ * @param      timeout_ms  Max time to wait, -1 waits forever.
+ * @return     The server's status (>= 0 or negative), -ETIMEDOUT, or a
+ *             negative error code if the connection failed.
+ * @details    Thread safe, concurrent callers share the connection.
+ */
+LIB_EXPORT int
+pcom_rpc_call(pcom_rpc_client_t* p_client, uint32_t method, const void* req, size_t len,
+              void* resp, size_t resp_cap, size_t* p_resp_len, int timeout_ms);
+
+/**
+ * @brief      Number of requests waiting for a response.
+ * @param      p_client  The client.
+ * @return     Requests in flight.
+ */
+LIB_EXPORT int
+pcom_rpc_client_pending(pcom_rpc_client_t* p_client);
+
+/**
+ * @brief      Close the connection and free the client.
+ * @param      p_client  The client.
+ * @details    Requests still in flight complete with -ECANCELED.
+ */
+LIB_EXPORT void
+pcom_rpc_client_destroy(pcom_rpc_client_t* p_client);
+
+/**
+ * @brief      Create an RPC server.
+ * @param      pp_srv    Receives the server.
+ * @param      send      Reply transport, NULL for blocking pcom_server_send().
+ * @param      send_ctx  Passed to send.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_rpc_server_create(pcom_rpc_server_t** pp_srv, pcom_rpc_send_t send, void* send_ctx);
+
+/**
+ * @brief      Register a method handler.
+ * @param      p_srv    The server.
+ * @param      method   Method ID.
+ * @param      handler  Handler, NULL to unregister.
+ * @param      user     Passed to the handler.
+ * @return     0 on success, negative error code on failure.
+ * @details    Register all methods before feeding data. Requests for
+ *             unknown methods are answered with status -ENOSYS.
+ */
+LIB_EXPORT int
+pcom_rpc_server_register(pcom_rpc_server_t* p_srv, uint32_t method, pcom_rpc_handler_t handler, void* user);
+
+/**
+ * @brief      Feed bytes received on a connection and run complete requests.
+ * @param      p_srv   The server.
+ * @param      handle  Connection the bytes came from.
+ * @param      data    Received bytes, any chunking.
+ * @param      len     Number of bytes.
+ * @return     Number of requests dispatched, negative error code if the
+ *             stream is corrupt or a handler asked to drop the connection.
+ * @details    Different handles may be fed from different threads, one
+ *             handle from one thread at a time.
+ */
+LIB_EXPORT int
+pcom_rpc_server_feed(pcom_rpc_server_t* p_srv, int handle, const void* data, size_t len);
+
+/**
+ * @brief      Send the response to a request.
+ * @param      p_srv   The server.
+ * @param      p_req   The request, from the handler or a copy of it.
+ * @param      status  Status returned to the caller.
+ * @param      data    Response body.
+ * @param      len     Length of the response body.
+ * @return     0 on success, negative error code on failure.
+ * @details    May be called from the handler or later, in any order. Must be
+ *             called where the server's send function may be used.
+ */
+LIB_EXPORT int
+pcom_rpc_reply(pcom_rpc_server_t* p_srv, const pcom_rpc_req_t* p_req, int32_t status,
+               const void* data, size_t len);
+
+/**
+ * @brief      Forget a connection's partial data, call when it closes.
+ * @param      p_srv   The server.
+ * @param      handle  The connection.
+ */
+LIB_EXPORT void
+pcom_rpc_server_drop(pcom_rpc_server_t* p_srv, int handle);
+
+/**
+ * @brief      Free the server. Handles are not closed.
+ * @param      p_srv   The server.
+ */
+LIB_EXPORT void
+pcom_rpc_server_destroy(pcom_rpc_server_t* p_srv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_RPC_H
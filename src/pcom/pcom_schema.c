@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_schema.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Runtime of the schema driven zero-copy message format.
+ ****************************************************************************/
+#include <string.h>
+#include <errno.h>
+
+#include "pcom_schema.h"
+#include "libcrc/crc32.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define VT_OFF   (8)    // Header field holding the vtable offset
+
+/* Reserve len bytes aligned to align at the end of the message */
+static uint32_t
+builder_alloc(pcom_schema_builder_t* p_b, size_t len, size_t align)
+{
+    size_t at = (p_b->len + align - 1) & ~(align - 1);
+    if (p_b->error) return 0;
+    if (at + len > p_b->cap || at + len > UINT32_MAX - 4) { p_b->error = -ENOBUFS; return 0; }
+    memset(p_b->buf + p_b->len, 0, at - p_b->len);
+    p_b->len = at + len;
+    return (uint32_t)at;
+}
+
+/* True if [at, at + len) lies within [lo, hi) */
+static int
+in_range(uint64_t at, uint64_t len, uint64_t lo, uint64_t hi)
+{
+    return at >= lo && at <= hi && len <= hi - at;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int64_t
+pcom_schema_verify(const void* buf, size_t len, const pcom_schema_desc_t* desc)
+{
+    if (!buf || !desc || len < PCOM_SCHEMA_HDR_SIZE) return -EBADMSG;
+
+    uint32_t size = pcom_schema_size(buf);
+    uint16_t flags = pcom_schema_get_u16(buf, 6);
+    uint32_t vt = pcom_schema_get_u32(buf, VT_OFF);
+
+    if (size > len) return -EMSGSIZE;
+    if (size < PCOM_SCHEMA_HDR_SIZE || pcom_schema_id(buf) != desc->id) return -EBADMSG;
+    if ((desc->flags & PCOM_SCHEMA_CRC) && !(flags & PCOM_SCHEMA_CRC)) return -EBADMSG;
+
+    // End of the body, before the trailer
+    uint32_t end = size;
+    if (flags & PCOM_SCHEMA_CRC) {
+        if (size < PCOM_SCHEMA_HDR_SIZE + 4) return -EBADMSG;
+        end -= 4;
+        if (crc32_calc(buf, end) != pcom_schema_get_u32(buf, end)) return -EBADMSG;
+    }
+
+    // Vtable right after a fixed part at least as large as ours, 4 aligned
+    if (vt < desc->fixed_size || (vt & 3) || !in_range(vt, 4, 0, end)) return -EBADMSG;
+    uint32_t count = pcom_schema_get_u32(buf, vt);
+    if (!in_range(vt + 4ull, 4ull * count, 0, end)) return -EBADMSG;
+    uint64_t tail = vt + 4ull + 4ull * count;
+
+    for (uint32_t i = 0; i < desc->ref_count; ++i) {
+        uint32_t at = pcom_schema_get_u32(buf, desc->ref_off[i]);
+        uint32_t n = pcom_schema_get_u32(buf, desc->ref_off[i] + 4);
+        if (at ? !in_range(at, n, tail, end) : n != 0) return -EBADMSG;
+    }
+
+    // Optional fields we know, those of newer writers are skipped
+    for (uint32_t i = 0; i < desc->opt_count && i < count; ++i) {
+        uint32_t at = pcom_schema_get_u32(buf, vt + 4 + 4 * i);
+        uint32_t n = desc->opt_size[i];
+        if (!at) continue;
+        if (n == 0) {
+            if ((at & 3) || !in_range(at, 4, tail, end)) return -EBADMSG;
+            n = pcom_schema_get_u32(buf, at);
+            if (!in_range(at + 4ull, n, tail, end)) return -EBADMSG;
+        } else if ((at & (n - 1)) || !in_range(at, n, tail, end)) {
+            return -EBADMSG;
+        }
+    }
+    return size;
+}
+
+void
+pcom_schema_begin(pcom_schema_builder_t* p_b, void* buf, size_t cap, const pcom_schema_desc_t* desc)
+{
+    p_b->buf = buf;
+    p_b->cap = cap;
+    p_b->desc = desc;
+    p_b->error = 0;
+    p_b->len = (size_t)desc->fixed_size + 4 + 4 * (size_t)desc->opt_count;
+    if (!buf || p_b->len > cap) { p_b->error = -ENOBUFS; p_b->len = 0; return; }
+
+    memset(buf, 0, p_b->len);
+    pcom_schema_put_u16(buf, 4, desc->id);
+    pcom_schema_put_u16(buf, 6, desc->flags);
+    pcom_schema_put_u32(buf, VT_OFF, desc->fixed_size);
+    pcom_schema_put_u32(buf, desc->fixed_size, desc->opt_count);
+}
+
+void
+pcom_schema_put_ref(pcom_schema_builder_t* p_b, uint32_t off, const void* data, size_t len)
+{
+    if (p_b->error) return;
+    if (off + 8 > p_b->desc->fixed_size) { p_b->error = -EINVAL; return; }
+    if (len == 0) {
+        pcom_schema_put_u32(p_b->buf, off, 0);
+        pcom_schema_put_u32(p_b->buf, off + 4, 0);
+        return;
+    }
+
+    uint32_t at = builder_alloc(p_b, len, 1);
+    if (!at) return;
+    memcpy(p_b->buf + at, data, len);
+    pcom_schema_put_u32(p_b->buf, off, at);
+    pcom_schema_put_u32(p_b->buf, off + 4, (uint32_t)len);
+}
+
+uint32_t
+pcom_schema_put_opt(pcom_schema_builder_t* p_b, uint32_t index, const void* data, size_t len)
+{
+    if (p_b->error) return 0;
+    if (index >= p_b->desc->opt_count) { p_b->error = -EINVAL; return 0; }
+
+    uint32_t size = p_b->desc->opt_size[index];
+    uint32_t at;
+    if (size == 0) {
+        at = builder_alloc(p_b, 4 + len, 4);
+        if (!at) return 0;
+        pcom_schema_put_u32(p_b->buf, at, (uint32_t)len);
+        if (len) memcpy(p_b->buf + at + 4, data, len);
+    } else {
+        if (len != size) { p_b->error = -EINVAL; return 0; }
+        at = builder_alloc(p_b, size, size);
+        if (!at) return 0;
+        memcpy(p_b->buf + at, data, size);
+    }
+    pcom_schema_put_u32(p_b->buf, p_b->desc->fixed_size + 4 + 4 * index, at);
+    return at;
+}
+
+int64_t
+pcom_schema_finish(pcom_schema_builder_t* p_b)
+{
+    if (p_b->error) return p_b->error;
+
+    int crc = (p_b->desc->flags & PCOM_SCHEMA_CRC) != 0;
+    uint32_t at = crc ? builder_alloc(p_b, 4, 1) : (uint32_t)p_b->len;
+    if (p_b->error) return p_b->error;
+
+    pcom_schema_put_u32(p_b->buf, 0, (uint32_t)p_b->len);
+    if (crc) pcom_schema_put_u32(p_b->buf, at, crc32_calc(p_b->buf, at));
+    return (int64_t)p_b->len;
+}
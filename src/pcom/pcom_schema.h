@@ -0,0 +1,253 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_schema.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Runtime of the schema driven zero-copy message format.
+ ****************************************************************************/
+/** @defgroup  PCOM_SCHEMA
+ * @brief     Binary messages read in place, without parsing or allocation.
+ * @details   tools/pcom_schema.py generates a C header with inline accessors
+ *            and a C++ header with view and builder classes from a schema:
+ *
+ *                package trading;
+ *                message Order 1 crc {
+ *                    u64 id;
+ *                    char[8] symbol;
+ *                    string note;
+ *                    optional u32 expire;
+ *                }
+ *
+ *            A message is laid out little endian as
+ *
+ *                header   size u32, id u16, flags u16, vtable u32, reserved u32
+ *                fixed    required fields at fixed, naturally aligned offsets.
+ *                         string/bytes fields are an (offset u32, len u32) ref
+ *                vtable   count u32, then count offsets u32 of optional fields,
+ *                         0 when absent
+ *                tail     string/bytes data and present optional fields
+ *                trailer  CRC32 of everything before it, if PCOM_SCHEMA_CRC
+ *
+ *            pcom_schema_verify() checks a received buffer once: size, id,
+ *            every offset and the CRC. After that the generated accessors
+ *            read fields straight from the receive buffer or shared memory.
+ *
+ *            Schemas evolve by appending optional fields. Readers treat
+ *            vtable entries they do not know as absent; fields a newer writer
+ *            added are skipped.
+ *
+ * @pre       pcom.h, libcrc/crc32.h
+ * @bug       -
+ * @warning   Accessors do no bounds checks, call verify first on any buffer
+ *            that did not come from a trusted builder. Buffers must be
+ *            8 byte aligned for direct access on strict alignment CPUs.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_SCHEMA_H
+#define PCOM_SCHEMA_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint32_t etc.
+#include <string.h>  // for memcpy
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_SCHEMA_HDR_SIZE  (16)
+#define PCOM_SCHEMA_CRC       (1 << 0)  // Header flag: CRC32 trailer present
+
+/** Per message layout, emitted by the generator */
+typedef struct {
+    uint16_t id;             // Message id
+    uint16_t flags;          // PCOM_SCHEMA_CRC if the schema asks for a CRC
+    uint32_t fixed_size;     // Header and fixed fields, where the vtable starts
+    uint32_t opt_count;      // Optional fields known to this schema
+    const uint32_t* opt_size;   // Size of each optional field, 0 for string/bytes
+    uint32_t ref_count;      // string/bytes refs in the fixed part
+    const uint32_t* ref_off;    // Offset of each ref
+} pcom_schema_desc_t;
+
+/** Message being built in a caller supplied buffer */
+typedef struct {
+    uint8_t* buf;
+    size_t cap;
+    size_t len;              // Bytes used so far
+    const pcom_schema_desc_t* desc;
+    int error;               // First error, sticky
+} pcom_schema_builder_t;
+
+/* ---- Little endian field access ---------------------------------------- */
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define PCOM_SCHEMA_LE16(v) __builtin_bswap16(v)
+#define PCOM_SCHEMA_LE32(v) __builtin_bswap32(v)
+#define PCOM_SCHEMA_LE64(v) __builtin_bswap64(v)
+#else
+#define PCOM_SCHEMA_LE16(v) (v)
+#define PCOM_SCHEMA_LE32(v) (v)
+#define PCOM_SCHEMA_LE64(v) (v)
+#endif
+
+static inline uint8_t
+pcom_schema_get_u8(const void* msg, uint32_t off) { return ((const uint8_t*)msg)[off]; }
+
+static inline uint16_t
+pcom_schema_get_u16(const void* msg, uint32_t off) {
+    uint16_t v; memcpy(&v, (const uint8_t*)msg + off, sizeof(v)); return PCOM_SCHEMA_LE16(v);
+}
+
+static inline uint32_t
+pcom_schema_get_u32(const void* msg, uint32_t off) {
+    uint32_t v; memcpy(&v, (const uint8_t*)msg + off, sizeof(v)); return PCOM_SCHEMA_LE32(v);
+}
+
+static inline uint64_t
+pcom_schema_get_u64(const void* msg, uint32_t off) {
+    uint64_t v; memcpy(&v, (const uint8_t*)msg + off, sizeof(v)); return PCOM_SCHEMA_LE64(v);
+}
+
+static inline float
+pcom_schema_get_f32(const void* msg, uint32_t off) {
+    uint32_t u = pcom_schema_get_u32(msg, off); float v; memcpy(&v, &u, sizeof(v)); return v;
+}
+
+static inline double
+pcom_schema_get_f64(const void* msg, uint32_t off) {
+    uint64_t u = pcom_schema_get_u64(msg, off); double v; memcpy(&v, &u, sizeof(v)); return v;
+}
+
+static inline void
+pcom_schema_put_u8(void* msg, uint32_t off, uint8_t v) { ((uint8_t*)msg)[off] = v; }
+
+static inline void
+pcom_schema_put_u16(void* msg, uint32_t off, uint16_t v) {
+    v = PCOM_SCHEMA_LE16(v); memcpy((uint8_t*)msg + off, &v, sizeof(v));
+}
+
+static inline void
+pcom_schema_put_u32(void* msg, uint32_t off, uint32_t v) {
+    v = PCOM_SCHEMA_LE32(v); memcpy((uint8_t*)msg + off, &v, sizeof(v));
+}
+
+static inline void
+pcom_schema_put_u64(void* msg, uint32_t off, uint64_t v) {
+    v = PCOM_SCHEMA_LE64(v); memcpy((uint8_t*)msg + off, &v, sizeof(v));
+}
+
+static inline void
+pcom_schema_put_f32(void* msg, uint32_t off, float v) {
+    uint32_t u; memcpy(&u, &v, sizeof(u)); pcom_schema_put_u32(msg, off, u);
+}
+
+static inline void
+pcom_schema_put_f64(void* msg, uint32_t off, double v) {
+    uint64_t u; memcpy(&u, &v, sizeof(u)); pcom_schema_put_u64(msg, off, u);
+}
+
+/** Size of a verified message */
+static inline uint32_t
+pcom_schema_size(const void* msg) { return pcom_schema_get_u32(msg, 0); }
+
+/** Message id, valid once size >= PCOM_SCHEMA_HDR_SIZE */
+static inline uint16_t
+pcom_schema_id(const void* msg) { return pcom_schema_get_u16(msg, 4); }
+
+/** Offset of optional field index, 0 if absent or unknown to the writer */
+static inline uint32_t
+pcom_schema_opt(const void* msg, uint32_t index) {
+    uint32_t vt = pcom_schema_get_u32(msg, 8);
+    if (index >= pcom_schema_get_u32(msg, vt)) return 0;
+    return pcom_schema_get_u32(msg, vt + 4 + 4 * index);
+}
+
+/** Data of a string/bytes ref at off, NULL with length 0 if empty */
+static inline const uint8_t*
+pcom_schema_ref(const void* msg, uint32_t off, uint32_t* p_len) {
+    uint32_t at = pcom_schema_get_u32(msg, off);
+    *p_len = pcom_schema_get_u32(msg, off + 4);
+    return at ? (const uint8_t*)msg + at : NULL;
+}
+
+/** Data of an optional string/bytes field, NULL with length 0 if absent */
+static inline const uint8_t*
+pcom_schema_opt_ref(const void* msg, uint32_t index, uint32_t* p_len) {
+    uint32_t at = pcom_schema_opt(msg, index);
+    *p_len = at ? pcom_schema_get_u32(msg, at) : 0;
+    return at ? (const uint8_t*)msg + at + 4 : NULL;
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+/**
+ * @brief      Check a received message before accessing its fields.
+ * @param      buf   Message, for example a pcom receive buffer.
+ * @param      len   Bytes available in buf, may exceed the message.
+ * @param      desc  Layout from the generated header.
+ * @return     Message size on success, -EBADMSG if it is malformed or has
+ *             another id, -EMSGSIZE if it is longer than len.
+ * @details    Checks the header, every offset and length, and the CRC32
+ *             trailer if present. A CRC schema rejects messages without one.
+ */
+LIB_EXPORT int64_t
+pcom_schema_verify(const void* buf, size_t len, const pcom_schema_desc_t* desc);
+
+/**
+ * @brief      Start a message in a caller supplied buffer.
+ * @param      p_b   Builder.
+ * @param      buf   Output buffer, 8 byte aligned.
+ * @param      cap   Size of buf.
+ * @param      desc  Layout from the generated header.
+ * @details    Fixed fields start out zero, strings empty and optional fields
+ *             absent. Errors are kept in the builder and reported by
+ *             pcom_schema_finish().
+ */
+LIB_EXPORT void
+pcom_schema_begin(pcom_schema_builder_t* p_b, void* buf, size_t cap, const pcom_schema_desc_t* desc);
+
+/**
+ * @brief      Append string/bytes data and point the ref at off to it.
+ * @param      p_b   Builder.
+ * @param      off   Offset of the ref in the fixed part.
+ * @param      data  Data to copy.
+ * @param      len   Length of data.
+ */
+LIB_EXPORT void
+pcom_schema_put_ref(pcom_schema_builder_t* p_b, uint32_t off, const void* data, size_t len);
+
+/**
+ * @brief      Append an optional field and mark it present.
+ * @param      p_b    Builder.
+ * @param      index  Optional field index.
+ * @param      data   Value, little endian, or string/bytes data.
+ * @param      len    Length of data.
+ * @return     Offset of the value in the message, 0 on error.
+ * @details    Scalars are aligned to their size. string/bytes fields
+ *             (opt_size 0) are stored as len u32 followed by the data.
+ */
+LIB_EXPORT uint32_t
+pcom_schema_put_opt(pcom_schema_builder_t* p_b, uint32_t index, const void* data, size_t len);
+
+/**
+ * @brief      Complete the message: size, and CRC32 trailer if the schema has one.
+ * @param      p_b  Builder.
+ * @return     Message size on success, -ENOBUFS if the buffer was too small,
+ *             -EINVAL on a bad field index or size.
+ */
+LIB_EXPORT int64_t
+pcom_schema_finish(pcom_schema_builder_t* p_b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_SCHEMA_H
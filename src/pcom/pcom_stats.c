@@ -0,0 +1,357 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_stats.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Counters and latency histograms for PCOM calls.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include "pcom_stats.h"
+
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_STATS)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#define CONN_CHUNK  (256)    // Handles per table chunk
+#define CONN_CHUNKS (1024)   // Chunks, handles up to 256K are tracked
+
+/* Only the owning thread writes a block, a load and a store do without a
+ * locked instruction. Readers on other threads load relaxed. */
+#define OWN_ADD(field, n) \
+    __atomic_store_n(&(field), __atomic_load_n(&(field), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#define STAT_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+#define STAT_GET(field)    __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+#define OP_WORDS (sizeof(pcom_stats_op_t) / sizeof(unsigned long long))
+#define MAX_WORD ((offsetof(pcom_stats_op_t, latency) + offsetof(pcom_stats_hist_t, max_ns)) \
+                  / sizeof(unsigned long long))
+
+/** Counters of one thread, on the live list until the thread exits */
+typedef struct block {
+    struct block* next;
+    struct block* prev;
+    pcom_stats_t stats;
+} block_t;
+
+static int stats_flags = PCOM_STATS_ALL;
+
+static __thread block_t* tls_block;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t block_key;
+static pthread_mutex_t blocks_lock = PTHREAD_MUTEX_INITIALIZER;  // List, retired, base
+static block_t* blocks;          // Live threads
+static pcom_stats_t retired;     // Exited threads
+static pcom_stats_t base;        // Totals at the last reset
+
+static pcom_conn_stats_t* conn_table[CONN_CHUNKS];
+
+/** Add the words of p_src to p_dst, max_ns taken as a maximum */
+static void
+stats_add(pcom_stats_t* p_dst, pcom_stats_t* p_src)
+{
+    for (int op = 0; op < PCOM_STATS_OPS; ++op) {
+        unsigned long long* p_d = (unsigned long long*)&p_dst->op[op];
+        unsigned long long* p_s = (unsigned long long*)&p_src->op[op];
+        for (size_t w = 0; w < OP_WORDS; ++w) {
+            unsigned long long v = STAT_GET(p_s[w]);
+            if (w != MAX_WORD) p_d[w] += v;
+            else if (v > p_d[w]) p_d[w] = v;
+        }
+    }
+}
+
+static void
+block_retire(void* arg)
+{
+    block_t* p_b = arg;
+
+    pthread_mutex_lock(&blocks_lock);
+    stats_add(&retired, &p_b->stats);
+    if (p_b->prev) p_b->prev->next = p_b->next;
+    else blocks = p_b->next;
+    if (p_b->next) p_b->next->prev = p_b->prev;
+    pthread_mutex_unlock(&blocks_lock);
+
+    tls_block = NULL;
+    free(p_b);
+}
+
+static void
+key_init(void)
+{
+    pthread_key_create(&block_key, block_retire);
+}
+
+/** The calling thread's block, created on first use. NULL if out of memory. */
+static block_t*
+block_get(void)
+{
+    block_t* p_b = tls_block;
+    if (__builtin_expect(p_b != NULL, 1)) return p_b;
+
+    pthread_once(&key_once, key_init);
+    p_b = calloc(1, sizeof(*p_b));
+    if (!p_b) return NULL;
+    if (pthread_setspecific(block_key, p_b) != 0) { free(p_b); return NULL; }
+
+    pthread_mutex_lock(&blocks_lock);
+    p_b->next = blocks;
+    if (blocks) blocks->prev = p_b;
+    blocks = p_b;
+    pthread_mutex_unlock(&blocks_lock);
+
+    tls_block = p_b;
+    return p_b;
+}
+
+/** Counters of a handle, NULL if out of range or out of memory */
+static pcom_conn_stats_t*
+conn_get(int handle, int create)
+{
+    if (handle < 0 || handle >= CONN_CHUNK * CONN_CHUNKS) return NULL;
+
+    pcom_conn_stats_t** pp_chunk = &conn_table[handle / CONN_CHUNK];
+    pcom_conn_stats_t* p_chunk = __atomic_load_n(pp_chunk, __ATOMIC_ACQUIRE);
+    if (!p_chunk) {
+        if (!create) return NULL;
+        pcom_conn_stats_t* p_new = calloc(CONN_CHUNK, sizeof(*p_new));
+        if (!p_new) return NULL;
+        // Another thread may have installed one meanwhile, use that
+        if (__atomic_compare_exchange_n(pp_chunk, &p_chunk, p_new, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            p_chunk = p_new;
+        else
+            free(p_new);
+    }
+    return &p_chunk[handle % CONN_CHUNK];
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+hist_record(pcom_stats_hist_t* p_h, uint64_t t0)
+{
+    uint64_t ns = now_ns() - t0;
+    int bucket = (ns < 2) ? 0 : 63 - __builtin_clzll(ns);
+
+    if (bucket >= PCOM_STATS_BUCKETS) bucket = PCOM_STATS_BUCKETS - 1;
+    OWN_ADD(p_h->count, 1);
+    OWN_ADD(p_h->sum_ns, ns);
+    OWN_ADD(p_h->buckets[bucket], 1);
+    if (ns > STAT_GET(p_h->max_ns)) __atomic_store_n(&p_h->max_ns, ns, __ATOMIC_RELAXED);
+}
+
+static inline int
+is_error(int64_t result)
+{
+    return result < 0 && result != -EAGAIN && result != -EWOULDBLOCK;
+}
+
+/* ---- Hooks ------------------------------------------------------------- */
+
+uint64_t
+pcom_stats_clock(void)
+{
+    int flags = __atomic_load_n(&stats_flags, __ATOMIC_RELAXED);
+    return (flags & PCOM_STATS_TIME) ? now_ns() : 0;
+}
+
+void
+pcom_stats_io(int op, int handle, uint64_t t0, int64_t result, unsigned messages,
+              unsigned syscalls, unsigned eagain, unsigned partial)
+{
+    int flags = __atomic_load_n(&stats_flags, __ATOMIC_RELAXED);
+    block_t* p_b;
+
+    if (!flags || !(p_b = block_get())) return;
+
+    pcom_stats_op_t* p_op = &p_b->stats.op[op];
+    if (flags & PCOM_STATS_COUNT) {
+        OWN_ADD(p_op->calls, 1);
+        if (is_error(result)) OWN_ADD(p_op->errors, 1);
+        if (result > 0) OWN_ADD(p_op->bytes, (unsigned long long)result);
+        if (messages) OWN_ADD(p_op->messages, messages);
+        if (syscalls) OWN_ADD(p_op->syscalls, syscalls);
+        if (eagain) OWN_ADD(p_op->eagain, eagain);
+        if (partial) OWN_ADD(p_op->partial, partial);
+
+        pcom_conn_stats_t* p_c = conn_get(handle, 1);
+        if (p_c) {
+            int out = (op == PCOM_STATS_SEND);
+            if (result > 0) STAT_ADD(*(out ? &p_c->bytes_out : &p_c->bytes_in), (unsigned long long)result);
+            if (messages) STAT_ADD(*(out ? &p_c->msgs_out : &p_c->msgs_in), messages);
+            if (syscalls) STAT_ADD(p_c->syscalls, syscalls);
+            if (eagain) STAT_ADD(p_c->eagain, eagain);
+            if (partial) STAT_ADD(p_c->partial, partial);
+            if (is_error(result)) STAT_ADD(p_c->errors, 1);
+        }
+    }
+    if (t0) hist_record(&p_op->latency, t0);
+}
+
+void
+pcom_stats_call(int op, int handle, uint64_t t0, int result)
+{
+    int flags = __atomic_load_n(&stats_flags, __ATOMIC_RELAXED);
+    block_t* p_b;
+
+    if (!flags || !(p_b = block_get())) return;
+
+    pcom_stats_op_t* p_op = &p_b->stats.op[op];
+    if (flags & PCOM_STATS_COUNT) {
+        OWN_ADD(p_op->calls, 1);
+        if (is_error(result)) OWN_ADD(p_op->errors, 1);
+        if (result == -EAGAIN || result == -EWOULDBLOCK) OWN_ADD(p_op->eagain, 1);
+
+        pcom_conn_stats_t* p_c = conn_get(handle, 1);
+        if (p_c && is_error(result)) STAT_ADD(p_c->errors, 1);
+        if (p_c && op == PCOM_STATS_ACCEPT && result >= 0) STAT_ADD(p_c->accepts, 1);
+    }
+    if (op == PCOM_STATS_ACCEPT && result >= 0) pcom_stats_conn_clear(result);
+    if (t0) hist_record(&p_op->latency, t0);
+}
+
+void
+pcom_stats_conn_clear(int handle)
+{
+    pcom_conn_stats_t* p_c = conn_get(handle, 0);
+    if (!p_c) return;
+
+    unsigned long long* p_w = (unsigned long long*)p_c;
+    for (size_t w = 0; w < sizeof(*p_c) / sizeof(*p_w); ++w) __atomic_store_n(&p_w[w], 0, __ATOMIC_RELAXED);
+}
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+void
+pcom_stats_enable(int flags)
+{
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_STATS)
+    __atomic_store_n(&stats_flags, flags & PCOM_STATS_ALL, __ATOMIC_RELAXED);
+#else
+    (void)flags;
+#endif
+}
+
+int
+pcom_stats_get(pcom_stats_t* p_stats)
+{
+    if (!p_stats) return -1;
+
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_STATS)
+
+    memset(p_stats, 0, sizeof(*p_stats));
+
+    pthread_mutex_lock(&blocks_lock);
+    stats_add(p_stats, &retired);
+    for (block_t* p_b = blocks; p_b; p_b = p_b->next) {
+        stats_add(p_stats, &p_b->stats);
+        p_stats->threads++;
+    }
+
+    // Everything but the maximums counts from the last reset
+    for (int op = 0; op < PCOM_STATS_OPS; ++op) {
+        unsigned long long* p_d = (unsigned long long*)&p_stats->op[op];
+        unsigned long long* p_s = (unsigned long long*)&base.op[op];
+        for (size_t w = 0; w < OP_WORDS; ++w)
+            if (w != MAX_WORD) p_d[w] -= p_s[w];
+    }
+    pthread_mutex_unlock(&blocks_lock);
+    return 0;
+
+#else
+
+    return -1;
+
+#endif
+}
+
+int
+pcom_stats_conn(int handle, pcom_conn_stats_t* p_stats)
+{
+    if (!p_stats) return -1;
+
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_STATS)
+
+    if (handle < 0 || handle >= CONN_CHUNK * CONN_CHUNKS) return -EBADF;
+
+    memset(p_stats, 0, sizeof(*p_stats));
+    pcom_conn_stats_t* p_c = conn_get(handle, 0);
+    if (!p_c) return 0;
+
+    unsigned long long* p_d = (unsigned long long*)p_stats;
+    unsigned long long* p_s = (unsigned long long*)p_c;
+    for (size_t w = 0; w < sizeof(*p_c) / sizeof(*p_d); ++w) p_d[w] = STAT_GET(p_s[w]);
+    return 0;
+
+#else
+
+    (void)handle;
+    return -1;
+
+#endif
+}
+
+void
+pcom_stats_reset(void)
+{
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_STATS)
+
+    pthread_mutex_lock(&blocks_lock);
+    memset(&base, 0, sizeof(base));
+    stats_add(&base, &retired);
+    retired.threads = 0;
+    for (int op = 0; op < PCOM_STATS_OPS; ++op) retired.op[op].latency.max_ns = 0;
+    for (block_t* p_b = blocks; p_b; p_b = p_b->next) {
+        stats_add(&base, &p_b->stats);
+        for (int op = 0; op < PCOM_STATS_OPS; ++op)
+            __atomic_store_n(&p_b->stats.op[op].latency.max_ns, 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&blocks_lock);
+
+#endif
+}
+
+unsigned long long
+pcom_stats_percentile(const pcom_stats_hist_t* p_hist, double percentile)
+{
+    if (!p_hist || p_hist->count == 0) return 0;
+
+    // Rank of the sample, rounded up
+    double rank = percentile / 100.0 * (double)p_hist->count;
+    unsigned long long target = (unsigned long long)rank;
+    if ((double)target < rank) ++target;
+    if (target == 0) target = 1;
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < PCOM_STATS_BUCKETS - 1; ++i) {
+        seen += p_hist->buckets[i];
+        if (seen >= target) {
+            unsigned long long upper = (2ull << i) - 1;
+            return upper < p_hist->max_ns ? upper : p_hist->max_ns;
+        }
+    }
+    return p_hist->max_ns;
+}
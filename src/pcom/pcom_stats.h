@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_stats.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Counters and latency histograms for PCOM calls.
+ ****************************************************************************/
+/** @defgroup  PCOM_STATS
+ * @brief     Built-in instrumentation of accept, check_user, send and recv.
+ * @details   Every call counts calls, errors, messages, bytes, system calls,
+ *            short reads/writes and EAGAINs, and records how long it took in
+ *            a histogram with power of two buckets. Process wide totals are
+ *            kept per thread: a thread only ever writes its own block, with
+ *            plain relaxed stores, and pcom_stats_get() adds all blocks up.
+ *            Blocks of threads that exit are folded into the totals.
+ *
+ *            Per handle counters sit in a table indexed by the handle and are
+ *            updated with relaxed atomic adds. A handle's counters are cleared
+ *            when it is opened or accepted, so they stay readable after
+ *            close until the number is reused. Accepts are counted on the
+ *            server handle.
+ *
+ *            Send and receive latencies include the time a blocking call
+ *            waits for the peer, accept latencies the time spent waiting for
+ *            a client.
+ *
+ *            Build with -DPCOM_NO_STATS to compile the instrumentation out.
+ *
+ * @pre       pcom.h, pthreads
+ * @bug       -
+ * @warning   Not available on Windows. pcom_stats_reset() racing with
+ *            updates may leave a max_ns from before the reset.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_STATS_H
+#define PCOM_STATS_H
+
+#include <stdint.h>  // for uint64_t
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_STATS_ACCEPT     (0)   // pcom_server_accept()
+#define PCOM_STATS_CHECK_USER (1)   // pcom_server_check_user()
+#define PCOM_STATS_SEND       (2)   // All send functions
+#define PCOM_STATS_RECV       (3)   // All receive functions
+#define PCOM_STATS_OPS        (4)
+
+#define PCOM_STATS_BUCKETS    (40)  // Bucket i counts [2^i, 2^(i+1)) ns, the last one all above
+
+#define PCOM_STATS_COUNT      (1 << 0)  // Update counters
+#define PCOM_STATS_TIME       (1 << 1)  // Time calls, two clock reads per call
+#define PCOM_STATS_ALL        (PCOM_STATS_COUNT | PCOM_STATS_TIME)
+
+typedef struct {
+    unsigned long long count;                       // Calls timed
+    unsigned long long sum_ns;                      // Total time
+    unsigned long long max_ns;                      // Longest call
+    unsigned long long buckets[PCOM_STATS_BUCKETS]; // Calls per duration bucket
+} pcom_stats_hist_t;
+
+typedef struct {
+    unsigned long long calls;     // Calls made
+    unsigned long long errors;    // Calls failed, EAGAIN not counted
+    unsigned long long messages;  // Messages sent or received
+    unsigned long long bytes;     // Bytes sent or received
+    unsigned long long syscalls;  // System calls made
+    unsigned long long partial;   // Short writes, and short reads of pcom_recv_exact()
+    unsigned long long eagain;    // EAGAIN/EWOULDBLOCK returned by the kernel
+    pcom_stats_hist_t latency;    // Call durations
+} pcom_stats_op_t;
+
+typedef struct {
+    pcom_stats_op_t op[PCOM_STATS_OPS];  // Indexed by PCOM_STATS_ACCEPT...
+    unsigned long long threads;          // Threads with a live counter block
+} pcom_stats_t;
+
+typedef struct {
+    unsigned long long bytes_out;  // Bytes sent
+    unsigned long long bytes_in;   // Bytes received
+    unsigned long long msgs_out;   // Messages sent
+    unsigned long long msgs_in;    // Messages received
+    unsigned long long syscalls;   // System calls made
+    unsigned long long partial;    // Short writes and short exact reads
+    unsigned long long eagain;     // EAGAIN/EWOULDBLOCK returned by the kernel
+    unsigned long long errors;     // Failed calls
+    unsigned long long accepts;    // Clients accepted, on server handles
+} pcom_conn_stats_t;
+
+/**
+ * @brief      Select what is recorded.
+ * @param      flags  PCOM_STATS_COUNT and/or PCOM_STATS_TIME, 0 for nothing.
+ * @details    The default is PCOM_STATS_ALL.
+ */
+LIB_EXPORT void
+pcom_stats_enable(int flags);
+
+/**
+ * @brief      Take a snapshot of the process wide totals.
+ * @param      p_stats  Receives the totals since start or the last reset.
+ * @return     0 on success, negative error code on failure.
+ * @details    Adds up the per thread blocks. Counters of calls in progress
+ *             on other threads may be seen partly updated.
+ */
+LIB_EXPORT int
+pcom_stats_get(pcom_stats_t* p_stats);
+
+/**
+ * @brief      Read the counters of one handle.
+ * @param      handle   Connection or server handle.
+ * @param      p_stats  Receives the counters.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_stats_conn(int handle, pcom_conn_stats_t* p_stats);
+
+/**
+ * @brief      Restart the process wide totals from zero.
+ * @details    Per handle counters are not affected.
+ */
+LIB_EXPORT void
+pcom_stats_reset(void);
+
+/**
+ * @brief      Estimate a percentile from a histogram.
+ * @param      p_hist      The histogram.
+ * @param      percentile  0 to 100.
+ * @return     Upper bound in ns of the bucket holding the percentile,
+ *             capped at max_ns. 0 for an empty histogram.
+ */
+LIB_EXPORT unsigned long long
+pcom_stats_percentile(const pcom_stats_hist_t* p_hist, double percentile);
+
+/* ---- Hooks for the PCOM modules ---------------------------------------- */
+
+#ifndef PCOM_NO_STATS
+
+/** Start time of a call in ns, 0 when timing is off */
+uint64_t
+pcom_stats_clock(void);
+
+/** Record a send or receive: result is bytes or a negative error code */
+void
+pcom_stats_io(int op, int handle, uint64_t t0, int64_t result, unsigned messages,
+              unsigned syscalls, unsigned eagain, unsigned partial);
+
+/** Record an accept (result is the new handle) or a check_user */
+void
+pcom_stats_call(int op, int handle, uint64_t t0, int result);
+
+/** Clear the counters of a newly opened handle */
+void
+pcom_stats_conn_clear(int handle);
+
+#else
+
+#define pcom_stats_clock() ((uint64_t)0)
+#define pcom_stats_io(op, h, t0, r, m, s, e, p) \
+    ((void)(op), (void)(h), (void)(t0), (void)(r), (void)(m), (void)(s), (void)(e), (void)(p))
+#define pcom_stats_call(op, h, t0, r) ((void)(op), (void)(h), (void)(t0), (void)(r))
+#define pcom_stats_conn_clear(h)      ((void)(h))
+
+#endif // PCOM_NO_STATS
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_STATS_H
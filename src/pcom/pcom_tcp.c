@@ -0,0 +1,547 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_tcp.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     TCP transport behind the PCOM connection names.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <ifaddrs.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#endif
+#include <string.h>
+#include <errno.h>
+
+#include "pcom_tcp.h"
+
+/* ---- Private definintions and functions -------------------------------- */
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+#define HOST_MAX      (256)
+#define PORT_MAX      (8)
+#define LOCAL_CHUNK   (256)    // Server handles per table chunk
+#define LOCAL_CHUNKS  (256)    // Chunks, server handles up to 64K
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+static pthread_mutex_t opts_lock = PTHREAD_MUTEX_INITIALIZER;
+static pcom_tcp_opts_t opts = PCOM_TCP_OPTS_DEFAULT;
+
+/* UNIX listener + 1 per TCP server handle, 0 if none */
+static int* local_table[LOCAL_CHUNKS];
+
+/** Table slot of a server handle, NULL if out of range or out of memory */
+static int*
+local_slot(int handle, int create)
+{
+    if (handle < 0 || handle >= LOCAL_CHUNK * LOCAL_CHUNKS) return NULL;
+
+    int** pp_chunk = &local_table[handle / LOCAL_CHUNK];
+    int* p_chunk = __atomic_load_n(pp_chunk, __ATOMIC_ACQUIRE);
+    if (!p_chunk) {
+        if (!create) return NULL;
+        int* p_new = calloc(LOCAL_CHUNK, sizeof(*p_new));
+        if (!p_new) return NULL;
+        if (__atomic_compare_exchange_n(pp_chunk, &p_chunk, p_new, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            p_chunk = p_new;
+        else
+            free(p_new);
+    }
+    return &p_chunk[handle % LOCAL_CHUNK];
+}
+
+/** Split tcp://host:port, [v6]:port and :port. Empty host means any. */
+static int
+parse_name(const char* name, char* host, char* port)
+{
+    const char* p = name + strlen(PCOM_TCP_PREFIX);
+    const char* p_end;
+
+    if (*p == '[') {
+        p_end = strchr(++p, ']');
+        if (!p_end || p_end[1] != ':') return -EINVAL;
+    } else {
+        p_end = strrchr(p, ':');
+        if (!p_end) return -EINVAL;
+    }
+    size_t len = (size_t)(p_end - p);
+    if (len >= HOST_MAX) return -ENAMETOOLONG;
+    memcpy(host, p, len);
+    host[len] = '\0';
+    if (len == 1 && host[0] == '*') host[0] = '\0';
+
+    p_end += (*p_end == ']') ? 2 : 1;
+    len = strlen(p_end);
+    if (len == 0 || len >= PORT_MAX || strspn(p_end, "0123456789") != len) return -EINVAL;
+    if (atoi(p_end) > 65535) return -EINVAL;
+    memcpy(port, p_end, len + 1);
+    return 0;
+}
+
+static int
+resolve(const char* name, int passive, struct addrinfo** pp_res, int* p_port)
+{
+    char host[HOST_MAX], port[PORT_MAX];
+    struct addrinfo hints;
+
+    int result = parse_name(name, host, port);
+    if (result) return result;
+    *p_port = atoi(port);
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV | (passive ? AI_PASSIVE : 0);
+    result = getaddrinfo(host[0] ? host : NULL, port, &hints, pp_res);
+    switch (result) {
+        case 0:          return 0;
+        case EAI_MEMORY: return -ENOMEM;
+        case EAI_SYSTEM: return pcom_errno_from(errno);
+        default:         return -EHOSTUNREACH;
+    }
+}
+
+/** Apply the TCP options, best effort */
+static void
+tune(int fd, const pcom_tcp_opts_t* p_o)
+{
+    int on = 1;
+
+    if (p_o->nodelay) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (p_o->keepalive_idle > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+#if defined(TCP_KEEPIDLE)
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &p_o->keepalive_idle, sizeof(int));
+#elif defined(TCP_KEEPALIVE)
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPALIVE, &p_o->keepalive_idle, sizeof(int));
+#endif
+#if defined(TCP_KEEPINTVL) && defined(TCP_KEEPCNT)
+        if (p_o->keepalive_intvl > 0)
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &p_o->keepalive_intvl, sizeof(int));
+        if (p_o->keepalive_count > 0)
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &p_o->keepalive_count, sizeof(int));
+#endif
+    }
+#if defined(SO_BUSY_POLL)
+    if (p_o->busy_poll_us > 0)
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &p_o->busy_poll_us, sizeof(int));
+#endif
+}
+
+/** Port of an IPv4 or IPv6 address */
+static int
+sa_port(const struct sockaddr* p_sa)
+{
+    if (p_sa->sa_family == AF_INET) return ntohs(((const struct sockaddr_in*)p_sa)->sin_port);
+    if (p_sa->sa_family == AF_INET6) return ntohs(((const struct sockaddr_in6*)p_sa)->sin6_port);
+    return -EAFNOSUPPORT;
+}
+
+#if defined(__linux__)
+
+/** Abstract socket address of the UNIX listener beside a TCP listener on p_sa */
+static socklen_t
+local_addr(struct sockaddr_un* p_addr, const struct sockaddr* p_sa)
+{
+    char host[INET6_ADDRSTRLEN] = "";
+
+    if (p_sa->sa_family == AF_INET6)
+        inet_ntop(AF_INET6, &((const struct sockaddr_in6*)p_sa)->sin6_addr, host, sizeof(host));
+    else
+        inet_ntop(AF_INET, &((const struct sockaddr_in*)p_sa)->sin_addr, host, sizeof(host));
+    memset(p_addr, 0, sizeof(*p_addr));
+    p_addr->sun_family = AF_UNIX;
+    int n = snprintf(p_addr->sun_path + 1, sizeof(p_addr->sun_path) - 1, PCOM_TCP_LOCAL_NAME,
+                     host, (unsigned)sa_port(p_sa));
+    return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+}
+
+/** True if the address is loopback or one of this host's interfaces */
+static int
+is_local(const struct sockaddr* p_sa)
+{
+    struct ifaddrs* p_ifs;
+    int local = 0;
+
+    if (p_sa->sa_family == AF_INET) {
+        const struct sockaddr_in* p_in = (const struct sockaddr_in*)p_sa;
+        if ((ntohl(p_in->sin_addr.s_addr) >> 24) == 127) return 1;
+    } else if (p_sa->sa_family == AF_INET6) {
+        const struct sockaddr_in6* p_in6 = (const struct sockaddr_in6*)p_sa;
+        if (IN6_IS_ADDR_LOOPBACK(&p_in6->sin6_addr)) return 1;
+    } else {
+        return 0;
+    }
+
+    if (getifaddrs(&p_ifs) < 0) return 0;
+    for (struct ifaddrs* p_if = p_ifs; p_if && !local; p_if = p_if->ifa_next) {
+        const struct sockaddr* p_a = p_if->ifa_addr;
+        if (!p_a || p_a->sa_family != p_sa->sa_family) continue;
+        if (p_a->sa_family == AF_INET)
+            local = ((const struct sockaddr_in*)p_a)->sin_addr.s_addr ==
+                    ((const struct sockaddr_in*)p_sa)->sin_addr.s_addr;
+        else
+            local = memcmp(&((const struct sockaddr_in6*)p_a)->sin6_addr,
+                           &((const struct sockaddr_in6*)p_sa)->sin6_addr, sizeof(struct in6_addr)) == 0;
+    }
+    freeifaddrs(p_ifs);
+    return local;
+}
+
+/** UNIX listener next to the TCP listener fd, negative error code if it cannot be had */
+static int
+local_listen(int tcp_fd)
+{
+    struct sockaddr_storage ss;
+    struct sockaddr_un addr;
+    socklen_t len = sizeof(ss);
+
+    if (getsockname(tcp_fd, (struct sockaddr*)&ss, &len) < 0) return pcom_errno_from(errno);
+    len = local_addr(&addr, (struct sockaddr*)&ss);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return pcom_errno_from(errno);
+    // Non-blocking, pcom_tcp_accept() polls it together with the TCP socket
+    if (bind(fd, (struct sockaddr*)&addr, len) < 0 || listen(fd, SOMAXCONN) < 0 ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+        int result = pcom_errno_from(errno);
+        close(fd);
+        return result;
+    }
+    return fd;
+}
+
+/** True if the UNIX peer on fd may speak for the TCP server. Anyone can bind an
+ *  abstract name first, so the name alone proves nothing: the peer runs as this
+ *  user or root, or is the process pid that answered over TCP. */
+static int
+local_verify(int fd, pid_t pid)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) return 0;
+    return cred.uid == geteuid() || cred.uid == 0 || (pid > 0 && cred.pid == pid);
+}
+
+/** Connect to the UNIX listener of a local TCP server on p_sa, -1 if there is none */
+static int
+local_connect(const struct sockaddr* p_sa, pid_t pid)
+{
+    struct sockaddr_storage cand[3];
+    struct sockaddr_un addr;
+    int n = 0;
+
+    // The address itself, then a server on any IPv4 and on any IPv6 address
+    memset(cand, 0, sizeof(cand));
+    if (p_sa->sa_family == AF_INET) {
+        memcpy(&cand[n++], p_sa, sizeof(struct sockaddr_in));
+        struct sockaddr_in* p_any = (struct sockaddr_in*)&cand[n++];
+        p_any->sin_family = AF_INET;
+        p_any->sin_port = ((const struct sockaddr_in*)p_sa)->sin_port;
+    } else {
+        memcpy(&cand[n++], p_sa, sizeof(struct sockaddr_in6));
+    }
+    struct sockaddr_in6* p_any6 = (struct sockaddr_in6*)&cand[n++];
+    p_any6->sin6_family = AF_INET6;
+    p_any6->sin6_port = htons((uint16_t)sa_port(p_sa));
+
+    for (int i = 0; i < n; ++i) {
+        socklen_t len = local_addr(&addr, (struct sockaddr*)&cand[i]);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&addr, len) == 0 &&
+            local_verify(fd, pid)) return fd;
+        close(fd);
+    }
+    return -1;
+}
+
+#endif
+
+#endif
+
+/* ---- Hooks ------------------------------------------------------------- */
+
+int
+pcom_tcp_is_name(const char* name)
+{
+    return name && strncmp(name, PCOM_TCP_PREFIX, strlen(PCOM_TCP_PREFIX)) == 0;
+}
+
+int
+pcom_tcp_server_open(const char* name, int flags)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    struct addrinfo* p_res;
+    pcom_tcp_opts_t o;
+    int port, fd = -1, result, on = 1;
+
+    if ((flags & PCOM_OPEN_TYPE_MASK) != PCOM_OPEN_STREAM) return -EPROTONOSUPPORT;
+    result = resolve(name, 1, &p_res, &port);
+    if (result) return result;
+    pcom_tcp_get_opts(&o);
+
+    // First address that binds, IPv6 any also takes IPv4 on most systems
+    result = -EADDRNOTAVAIL;
+    for (struct addrinfo* p_ai = p_res; p_ai; p_ai = p_ai->ai_next) {
+        fd = socket(p_ai->ai_family, SOCK_STREAM, 0);
+        if (fd < 0) { result = pcom_errno_from(errno); continue; }
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, p_ai->ai_addr, p_ai->ai_addrlen) == 0 && listen(fd, SOMAXCONN) == 0) break;
+        result = pcom_errno_from(errno);
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(p_res);
+    if (fd < 0) return result;
+    tune(fd, &o);
+
+#if defined(__linux__)
+    // Local clients expect the UNIX listener, no server without it
+    if (o.prefer_local) {
+        int local = local_listen(fd);
+        int* p_slot = (local >= 0) ? local_slot(fd, 1) : NULL;
+        if (!p_slot) {
+            result = (local >= 0) ? -ENOMEM : local;
+            if (local >= 0) close(local);
+            close(fd);
+            return result;
+        }
+        __atomic_store_n(p_slot, local + 1, __ATOMIC_RELEASE);
+    }
+#endif
+    return fd;
+
+#else
+    (void)name; (void)flags;
+    return -1;
+#endif
+}
+
+int
+pcom_tcp_client_open(const char* name, int flags)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    struct addrinfo* p_res;
+    pcom_tcp_opts_t o;
+    int port, fd = -1, result;
+
+    if ((flags & PCOM_OPEN_TYPE_MASK) != PCOM_OPEN_STREAM) return -EPROTONOSUPPORT;
+    result = resolve(name, 0, &p_res, &port);
+    if (result) return result;
+    pcom_tcp_get_opts(&o);
+
+#if defined(__linux__)
+    // Same host: the UNIX socket beside the server, if it has one
+    if (o.prefer_local && is_local(p_res->ai_addr) && (fd = local_connect(p_res->ai_addr, 0)) >= 0) {
+        freeaddrinfo(p_res);
+        return fd;
+    }
+#endif
+
+    result = -EHOSTUNREACH;
+    for (struct addrinfo* p_ai = p_res; p_ai; p_ai = p_ai->ai_next) {
+        fd = socket(p_ai->ai_family, SOCK_STREAM, 0);
+        if (fd < 0) { result = pcom_errno_from(errno); continue; }
+        tune(fd, &o);
+        if (connect(fd, p_ai->ai_addr, p_ai->ai_addrlen) == 0) break;
+        result = pcom_errno_from(errno);
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(p_res);
+    return fd >= 0 ? fd : result;
+
+#else
+    (void)name; (void)flags;
+    return -1;
+#endif
+}
+
+int
+pcom_tcp_accept(int server_handle, int local_handle)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+    struct pollfd pfd[2] = { { server_handle, POLLIN, 0 }, { local_handle, POLLIN, 0 } };
+    int flags = fcntl(server_handle, F_GETFL);
+    if (flags < 0) return pcom_errno_from(errno);
+    int nonblocking = (flags & O_NONBLOCK) != 0;
+
+    for (;;) {
+        if (!nonblocking && poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return pcom_errno_from(errno);
+        }
+        for (int i = 0; i < 2; ++i) {
+            if (!nonblocking && !pfd[i].revents) continue;
+            int fd = accept(pfd[i].fd, NULL, NULL);
+            if (fd >= 0) {
+#if !defined(__linux__)
+                // Linux copies the options from the listener
+                if (i == 0) { pcom_tcp_opts_t o; pcom_tcp_get_opts(&o); tune(fd, &o); }
+#endif
+                return fd;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED && errno != EINTR)
+                return pcom_errno_from(errno);
+        }
+        // Another thread took the client, or nothing is pending
+        if (nonblocking) return -EAGAIN;
+    }
+
+#else
+    (void)server_handle; (void)local_handle;
+    return -1;
+#endif
+}
+
+void
+pcom_tcp_server_close(int server_handle)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    int* p_slot = local_slot(server_handle, 0);
+    int local = p_slot ? __atomic_exchange_n(p_slot, 0, __ATOMIC_ACQ_REL) - 1 : -1;
+    if (local >= 0) close(local);
+#else
+    (void)server_handle;
+#endif
+}
+
+int
+pcom_tcp_local_listening(int port)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    for (int c = 0; c < LOCAL_CHUNKS; ++c) {
+        int* p_chunk = __atomic_load_n(&local_table[c], __ATOMIC_ACQUIRE);
+        if (!p_chunk) continue;
+        for (int i = 0; i < LOCAL_CHUNK; ++i) {
+            if (__atomic_load_n(&p_chunk[i], __ATOMIC_ACQUIRE) > 0 &&
+                pcom_tcp_port(c * LOCAL_CHUNK + i) == port) return 1;
+        }
+    }
+#else
+    (void)port;
+#endif
+    return 0;
+}
+
+int
+pcom_tcp_local_open(int handle, int pid)
+{
+#if defined(__linux__)
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+
+    if (getpeername(handle, (struct sockaddr*)&ss, &len) < 0) return pcom_errno_from(errno);
+    if (sa_port((struct sockaddr*)&ss) < 0) return -EAFNOSUPPORT;
+    int fd = local_connect((struct sockaddr*)&ss, (pid_t)pid);
+    return fd >= 0 ? fd : -ECONNREFUSED;
+#else
+    (void)handle; (void)pid;
+    return -1;
+#endif
+}
+
+int
+pcom_tcp_local_adopt(int server_handle, int local_handle)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    int* p_slot = (local_handle >= 0) ? local_slot(server_handle, 1) : NULL;
+    if (!p_slot) return (local_handle < 0) ? -EBADF : -ENOMEM;
+    // listen() again makes this process the peer clients see in SO_PEERCRED
+    if (listen(local_handle, SOMAXCONN) < 0) return pcom_errno_from(errno);
+    int old = __atomic_exchange_n(p_slot, local_handle + 1, __ATOMIC_ACQ_REL) - 1;
+    if (old >= 0 && old != local_handle) close(old);
+    return 0;
+#else
+    (void)server_handle; (void)local_handle;
+    return -1;
+#endif
+}
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_tcp_set_opts(const pcom_tcp_opts_t* p_opts)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    static const pcom_tcp_opts_t defaults = PCOM_TCP_OPTS_DEFAULT;
+    if (!p_opts) p_opts = &defaults;
+    if (p_opts->busy_poll_us < 0 || p_opts->keepalive_idle < 0 ||
+        p_opts->keepalive_intvl < 0 || p_opts->keepalive_count < 0) return -EINVAL;
+
+    pthread_mutex_lock(&opts_lock);
+    opts = *p_opts;
+    pthread_mutex_unlock(&opts_lock);
+    return 0;
+#else
+    (void)p_opts;
+    return -1;
+#endif
+}
+
+void
+pcom_tcp_get_opts(pcom_tcp_opts_t* p_opts)
+{
+    if (!p_opts) return;
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    pthread_mutex_lock(&opts_lock);
+    *p_opts = opts;
+    pthread_mutex_unlock(&opts_lock);
+#else
+    memset(p_opts, 0, sizeof(*p_opts));
+#endif
+}
+
+int
+pcom_tcp_port(int handle)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+
+    if (getsockname(handle, (struct sockaddr*)&ss, &len) < 0) return pcom_errno_from(errno);
+    return sa_port((struct sockaddr*)&ss);
+#else
+    (void)handle;
+    return -1;
+#endif
+}
+
+int
+pcom_tcp_local_handle(int server_handle)
+{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+    int* p_slot = local_slot(server_handle, 0);
+    return p_slot ? __atomic_load_n(p_slot, __ATOMIC_ACQUIRE) - 1 : -1;
+#else
+    (void)server_handle;
+    return -1;
+#endif
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_tcp.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     TCP transport behind the PCOM connection names.
+ ****************************************************************************/
+/** @defgroup  PCOM_TCP
+ * @brief     tcp://host:port names for servers and clients on other hosts.
+ * @details   pcom_server_open() and pcom_client_open() take
+ *
+ *                tcp://host:port       host name, IPv4 address or [IPv6]
+ *                tcp://:port           server on all addresses
+ *                tcp://127.0.0.1:0     server on a free port, see pcom_tcp_port()
+ *
+ *            next to the local names, so framing, RPC, pools and statistics
+ *            work across nodes unchanged. Sockets get TCP_NODELAY, keepalive
+ *            and optionally SO_BUSY_POLL as set with pcom_tcp_set_opts().
+ *            Options set on a server are inherited by the connections it
+ *            accepts.
+ *
+ *            A TCP server also listens on the Linux abstract socket
+ *            "@pcom-tcp-<address>-<port>" of its bound address, and fails to
+ *            open if that name is taken. A client whose tcp:// name resolves
+ *            to an address of its own host connects there instead and skips
+ *            the TCP stack, if SO_PEERCRED shows the process at the other
+ *            end runs as the client's user or as root. Clients of servers
+ *            run by other users connect over TCP, unless they moved with
+ *            pcom_handshake_open() and the peer is the process that answered
+ *            over TCP. pcom_server_accept() and pcom_loop accept on both.
+ *
+ * @pre       pcom.h
+ * @bug       -
+ * @warning   Only stream sockets. pcom_server_check_user() has no kernel
+ *            credentials for peers connected over TCP and fails with
+ *            -ENOTSUP. Close TCP servers with pcom_server_close().
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_TCP_H
+#define PCOM_TCP_H
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_TCP_PREFIX     "tcp://"
+#define PCOM_TCP_LOCAL_NAME "pcom-tcp-%s-%u"   // Abstract socket of a TCP server address and port
+
+typedef struct {
+    int nodelay;          // TCP_NODELAY, 1 by default
+    int busy_poll_us;     // SO_BUSY_POLL in us, 0 (off) by default, needs CAP_NET_ADMIN
+    int keepalive_idle;   // Idle seconds before keepalive probes, 0 disables keepalive
+    int keepalive_intvl;  // Seconds between probes
+    int keepalive_count;  // Unanswered probes before the connection is dropped
+    int prefer_local;     // Connect to local servers over their UNIX socket, 1 by default
+} pcom_tcp_opts_t;
+
+#define PCOM_TCP_OPTS_DEFAULT { 1, 0, 30, 10, 3, 1 }
+
+/**
+ * @brief      Set the options for TCP handles opened from now on.
+ * @param      p_opts  Options, NULL for PCOM_TCP_OPTS_DEFAULT.
+ * @return     0 on success, -EINVAL for negative values.
+ * @details    SO_BUSY_POLL is best effort: without CAP_NET_ADMIN the kernel
+ *             refuses it and the socket keeps interrupt driven receives.
+ */
+LIB_EXPORT int
+pcom_tcp_set_opts(const pcom_tcp_opts_t* p_opts);
+
+/**
+ * @brief      Get the options in effect.
+ * @param      p_opts  Receives the options.
+ */
+LIB_EXPORT void
+pcom_tcp_get_opts(pcom_tcp_opts_t* p_opts);
+
+/**
+ * @brief      Local port of a TCP handle.
+ * @param      handle  TCP server or connection handle.
+ * @return     Port number, negative error code if the handle is not TCP.
+ */
+LIB_EXPORT int
+pcom_tcp_port(int handle);
+
+/**
+ * @brief      The UNIX listener a TCP server accepts local clients on.
+ * @param      server_handle  Handle from pcom_server_open().
+ * @return     Listener handle, -1 if the server has none.
+ * @details    For event loops that wait on the server handle themselves.
+ */
+LIB_EXPORT int
+pcom_tcp_local_handle(int server_handle);
+
+/* ---- Hooks for the PCOM modules ---------------------------------------- */
+
+/** True for tcp:// names */
+int
+pcom_tcp_is_name(const char* name);
+
+/** pcom_server_open_ex() for tcp:// names */
+int
+pcom_tcp_server_open(const char* name, int flags);
+
+/** pcom_client_open_ex() for tcp:// names */
+int
+pcom_tcp_client_open(const char* name, int flags);
+
+/** Accept on a TCP server and its UNIX listener, whichever has a client */
+int
+pcom_tcp_accept(int server_handle, int local_handle);
+
+/** Close the UNIX listener of a server, if any */
+void
+pcom_tcp_server_close(int server_handle);
+
+/** True if a TCP server of this process on port has a UNIX listener */
+int
+pcom_tcp_local_listening(int port);
+
+/** Connect to the verified UNIX listener of the TCP server at the other end of handle,
+ *  pid is the server process as it answered over TCP, or error code */
+int
+pcom_tcp_local_open(int handle, int pid);
+
+/** Make local_handle the UNIX listener of a server passed from another process */
+int
+pcom_tcp_local_adopt(int server_handle, int local_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_TCP_H
@@ -0,0 +1,308 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_trace.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Ring buffer tracing of PCOM calls.
+ ****************************************************************************/
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "pcom_trace.h"
+
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_TRACE)
+
+/* ---- Private definintions and functions -------------------------------- */
+
+static inline int
+pcom_errno_from(int err) { return (err > 0) ? -err : -1;}
+
+/** Events of one thread in one run */
+typedef struct ring {
+    struct ring* next;
+    unsigned gen;         // Run it belongs to
+    int dead;             // Owner done with it, freed by the next start
+    uint32_t tid;
+    uint64_t mask;        // Events - 1
+    uint64_t head;        // Events written, published with release
+    pcom_trace_event_t events[];
+} ring_t;
+
+static int trace_on;
+static unsigned trace_gen;       // Bumped by every start
+static uint64_t trace_mask = PCOM_TRACE_EVENTS - 1;
+static uint64_t tick0, ns0;      // Clock pair at start
+
+static __thread ring_t* tls_ring;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ring_key;
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static ring_t* rings;
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t
+ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return now_ns();
+#endif
+}
+
+static uint32_t
+thread_id(void)
+{
+#if defined(__linux__)
+    return (uint32_t)syscall(SYS_gettid);
+#else
+    static uint32_t next_id;
+    return __atomic_add_fetch(&next_id, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+static void
+ring_release(void* arg)
+{
+    ring_t* p_r = arg;
+    __atomic_store_n(&p_r->dead, 1, __ATOMIC_RELEASE);
+    tls_ring = NULL;
+}
+
+static void
+key_init(void)
+{
+    pthread_key_create(&ring_key, ring_release);
+}
+
+/** A ring of the current run for the calling thread */
+static ring_t*
+ring_new(unsigned gen)
+{
+    uint64_t mask = __atomic_load_n(&trace_mask, __ATOMIC_RELAXED);
+    ring_t* p_r = malloc(sizeof(*p_r) + (mask + 1) * sizeof(pcom_trace_event_t));
+    if (!p_r) return NULL;
+
+    pthread_once(&key_once, key_init);
+    p_r->gen = gen;
+    p_r->dead = 0;
+    p_r->tid = thread_id();
+    p_r->mask = mask;
+    p_r->head = 0;
+    if (pthread_setspecific(ring_key, p_r) != 0) { free(p_r); return NULL; }
+    if (tls_ring) __atomic_store_n(&tls_ring->dead, 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&rings_lock);
+    p_r->next = rings;
+    rings = p_r;
+    pthread_mutex_unlock(&rings_lock);
+
+    tls_ring = p_r;
+    return p_r;
+}
+
+/** Copy the events of a ring still being written, oldest first */
+static uint32_t
+ring_copy(ring_t* p_r, pcom_trace_event_t* p_out)
+{
+    uint64_t head = __atomic_load_n(&p_r->head, __ATOMIC_ACQUIRE);
+    uint64_t size = p_r->mask + 1;
+    uint64_t first = head > size ? head - size : 0;
+
+    for (uint64_t i = first; i < head; ++i) p_out[i - first] = p_r->events[i & p_r->mask];
+
+    // Drop what the owner overwrote meanwhile, the event in progress included
+    uint64_t now = __atomic_load_n(&p_r->head, __ATOMIC_ACQUIRE);
+    if (!__atomic_load_n(&p_r->dead, __ATOMIC_ACQUIRE)) ++now;
+    uint64_t lost = (now > first + size) ? now - size - first : 0;
+    if (lost >= head - first) return 0;
+    memmove(p_out, p_out + lost, (head - first - lost) * sizeof(*p_out));
+    return (uint32_t)(head - first - lost);
+}
+
+/* ---- Hooks ------------------------------------------------------------- */
+
+uint64_t
+pcom_trace_begin(void)
+{
+    if (__builtin_expect(!__atomic_load_n(&trace_on, __ATOMIC_RELAXED), 1)) return 0;
+    return ticks() | 1;
+}
+
+void
+pcom_trace_end(uint64_t t0, int op, int handle, int64_t result, size_t len)
+{
+    if (!t0) return;
+
+    uint64_t end = ticks();
+    unsigned gen = __atomic_load_n(&trace_gen, __ATOMIC_ACQUIRE);
+    ring_t* p_r = tls_ring;
+    if (!p_r || p_r->gen != gen) {
+        p_r = ring_new(gen);
+        if (!p_r) return;
+    }
+
+    pcom_trace_event_t* p_e = &p_r->events[p_r->head & p_r->mask];
+    uint64_t size = (result >= 0 && op != PCOM_TRACE_ACCEPT && op != PCOM_TRACE_CHECK_USER) ?
+                    (uint64_t)result : len;
+    p_e->start = t0;
+    p_e->duration = end - t0;
+    p_e->handle = (op == PCOM_TRACE_ACCEPT && result >= 0) ? (int32_t)result : handle;
+    p_e->size = size > UINT32_MAX ? UINT32_MAX : (uint32_t)size;
+    p_e->error = result < 0 ? (int16_t)-result : 0;
+    p_e->op = (uint8_t)op;
+    p_e->reserved = 0;
+    p_e->reserved2 = 0;
+    __atomic_store_n(&p_r->head, p_r->head + 1, __ATOMIC_RELEASE);
+}
+
+static pid_t env_pid;  // Process that started tracing from the environment
+
+/** Save at exit, forked children to <file>.<pid> */
+static void
+trace_at_exit(void)
+{
+    char path[4096];
+    const char* p_file = getenv("PCOM_TRACE_FILE");
+
+    if (!p_file) return;
+    if (getpid() == env_pid) snprintf(path, sizeof(path), "%s", p_file);
+    else snprintf(path, sizeof(path), "%s.%d", p_file, (int)getpid());
+    pcom_trace_save(path);
+}
+
+/** Start from the environment when the library loads */
+__attribute__((constructor)) static void
+trace_from_env(void)
+{
+    const char* p_file = getenv("PCOM_TRACE_FILE");
+    const char* p_events = getenv("PCOM_TRACE_EVENTS");
+    if (!p_file || !p_file[0]) return;
+    env_pid = getpid();
+    if (pcom_trace_start(p_events ? (size_t)strtoul(p_events, NULL, 0) : 0) == 0) atexit(trace_at_exit);
+}
+
+#endif
+
+/* ---- Public functions -------------------------------------------------- */
+
+int
+pcom_trace_start(size_t events)
+{
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_TRACE)
+
+    uint64_t size = 2;
+    if (events == 0) events = PCOM_TRACE_EVENTS;
+    if (events > (1u << 24)) return -EINVAL;
+    while (size < events) size <<= 1;
+
+    pthread_mutex_lock(&rings_lock);
+    __atomic_store_n(&trace_on, 0, __ATOMIC_RELAXED);
+
+    // Rings nobody writes any more go, live ones are replaced on next use
+    for (ring_t** pp = &rings; *pp;) {
+        ring_t* p_r = *pp;
+        if (__atomic_load_n(&p_r->dead, __ATOMIC_ACQUIRE)) { *pp = p_r->next; free(p_r); }
+        else pp = &p_r->next;
+    }
+    __atomic_store_n(&trace_mask, size - 1, __ATOMIC_RELAXED);
+    tick0 = ticks();
+    ns0 = now_ns();
+    __atomic_add_fetch(&trace_gen, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&trace_on, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&rings_lock);
+    return 0;
+
+#else
+
+    (void)events;
+    return -1;
+
+#endif
+}
+
+void
+pcom_trace_stop(void)
+{
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_TRACE)
+    __atomic_store_n(&trace_on, 0, __ATOMIC_RELAXED);
+#endif
+}
+
+int64_t
+pcom_trace_save(const char* path)
+{
+    if (!path || !path[0]) return -1;
+
+#if (defined(__linux__) || defined(__unix__) || defined(__APPLE__)) && !defined(PCOM_NO_TRACE)
+
+    pcom_trace_file_t hdr;
+    pcom_trace_event_t* p_buf = NULL;
+    int64_t total = 0;
+    int result = 0;
+
+    FILE* p_file = fopen(path, "wb");
+    if (!p_file) return pcom_errno_from(errno);
+
+    pthread_mutex_lock(&rings_lock);
+    unsigned gen = __atomic_load_n(&trace_gen, __ATOMIC_ACQUIRE);
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, PCOM_TRACE_MAGIC, sizeof(hdr.magic));
+    hdr.pid = (uint32_t)getpid();
+    hdr.tick0 = tick0;
+    hdr.ns0 = ns0;
+    hdr.tick1 = ticks();
+    hdr.ns1 = now_ns();
+    for (ring_t* p_r = rings; p_r; p_r = p_r->next) hdr.rings += (p_r->gen == gen);
+    if (fwrite(&hdr, sizeof(hdr), 1, p_file) != 1) result = pcom_errno_from(errno);
+
+    for (ring_t* p_r = rings; p_r && !result; p_r = p_r->next) {
+        if (p_r->gen != gen) continue;
+        pcom_trace_event_t* p_new = realloc(p_buf, (p_r->mask + 1) * sizeof(*p_buf));
+        if (!p_new) { result = -ENOMEM; break; }
+        p_buf = p_new;
+
+        pcom_trace_ring_t ring = { p_r->tid, ring_copy(p_r, p_buf) };
+        if (fwrite(&ring, sizeof(ring), 1, p_file) != 1 ||
+            fwrite(p_buf, sizeof(*p_buf), ring.count, p_file) != ring.count)
+            result = pcom_errno_from(errno);
+        total += ring.count;
+    }
+    pthread_mutex_unlock(&rings_lock);
+
+    free(p_buf);
+    if (fclose(p_file) != 0 && !result) result = pcom_errno_from(errno);
+    return result ? result : total;
+
+#else
+
+    return -1;
+
+#endif
+}
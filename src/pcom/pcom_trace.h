@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_trace.h
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Ring buffer tracing of PCOM calls.
+ ****************************************************************************/
+/** @defgroup  PCOM_TRACE
+ * @brief     Per call events for offline latency analysis.
+ * @details   While tracing is on, every accept, check_user, send and receive
+ *            appends an event to a ring buffer of the calling thread: start,
+ *            duration, handle, op, size and errno. Only the owning thread
+ *            writes a ring, the oldest events are overwritten when it is
+ *            full. Timestamps are TSC ticks on x86 and CLOCK_MONOTONIC
+ *            elsewhere, so an event costs a few nanoseconds. When tracing is
+ *            off a call pays one load and branch; built with -DPCOM_NO_TRACE
+ *            nothing at all.
+ *
+ *            pcom_trace_save() writes the rings to a compact binary file and
+ *            tools/pcom_trace_dump converts it to Chrome trace JSON, which
+ *            chrome://tracing and ui.perfetto.dev open.
+ *
+ *            Setting PCOM_TRACE_FILE in the environment starts tracing when
+ *            the library loads and saves to that file at exit, forked
+ *            children to <file>.<pid>. PCOM_TRACE_EVENTS sets the ring size
+ *            then.
+ *
+ * @pre       pcom.h, pthreads
+ * @bug       -
+ * @warning   Not available on Windows. Rings of exited threads are kept
+ *            until the next pcom_trace_start(). Events written while
+ *            pcom_trace_save() runs may be left out.
+ * @ingroup   PCOM
+ ****************************************************************************/
+#ifndef PCOM_TRACE_H
+#define PCOM_TRACE_H
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint64_t
+
+#include "pcom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCOM_TRACE_ACCEPT     (0)   // Same numbers as PCOM_STATS_*
+#define PCOM_TRACE_CHECK_USER (1)
+#define PCOM_TRACE_SEND       (2)
+#define PCOM_TRACE_RECV       (3)
+
+#define PCOM_TRACE_EVENTS     (4096)        // Default events per thread
+#define PCOM_TRACE_MAGIC      "PCOMTRC1"    // File magic, 8 bytes
+
+/** One call */
+typedef struct {
+    uint64_t start;      // Ticks
+    uint64_t duration;   // Ticks
+    int32_t handle;      // Connection, the accepted one for accepts
+    uint32_t size;       // Bytes moved, requested on errors
+    int16_t error;       // errno, 0 on success
+    uint8_t op;          // PCOM_TRACE_*
+    uint8_t reserved;
+    uint32_t reserved2;
+} pcom_trace_event_t;
+
+/** File header, followed by rings */
+typedef struct {
+    char magic[8];       // PCOM_TRACE_MAGIC
+    uint32_t pid;
+    uint32_t rings;
+    uint64_t tick0;      // Ticks and CLOCK_MONOTONIC ns at start ...
+    uint64_t ns0;
+    uint64_t tick1;      // ... and at save, to convert ticks to ns
+    uint64_t ns1;
+} pcom_trace_file_t;
+
+/** Ring header, followed by count events, oldest first */
+typedef struct {
+    uint32_t tid;
+    uint32_t count;
+} pcom_trace_ring_t;
+
+/**
+ * @brief      Start tracing, dropping events of earlier runs.
+ * @param      events  Ring size per thread, rounded up to a power of two.
+ *                     0 for PCOM_TRACE_EVENTS.
+ * @return     0 on success, negative error code on failure.
+ */
+LIB_EXPORT int
+pcom_trace_start(size_t events);
+
+/**
+ * @brief      Stop tracing. The events are kept for pcom_trace_save().
+ */
+LIB_EXPORT void
+pcom_trace_stop(void);
+
+/**
+ * @brief      Write the events of this run to a file.
+ * @param      path  File to create.
+ * @return     Number of events written, negative error code on failure.
+ * @details    Can be called while tracing is on.
+ */
+LIB_EXPORT int64_t
+pcom_trace_save(const char* path);
+
+/* ---- Hooks for the PCOM modules ---------------------------------------- */
+
+#ifndef PCOM_NO_TRACE
+
+/** Start of a call, 0 when tracing is off */
+uint64_t
+pcom_trace_begin(void);
+
+/** Record a call: result is bytes, a handle or a negative error code */
+void
+pcom_trace_end(uint64_t t0, int op, int handle, int64_t result, size_t len);
+
+#else
+
+#define pcom_trace_begin() ((uint64_t)0)
+#define pcom_trace_end(t0, op, h, r, l) ((void)(t0), (void)(op), (void)(h), (void)(r), (void)(l))
+
+#endif // PCOM_NO_TRACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCOM_TRACE_H
@@ -0,0 +1,323 @@
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <pwd.h>
+#include <grp.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "../pcom.h"
+
+static void
+test_version(void) {
+    int version = pcom_version();
+    assert(version >= 0x10000);
+    printf("✅ Test passed: Version = %x\n", version);
+}
+
+static void
+test_seqpacket(void) {
+    int sfd = pcom_server_open_ex("pcomtest_seq", PCOM_OPEN_SEQPACKET);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open_ex("pcomtest_seq", PCOM_OPEN_SEQPACKET);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+
+    // Three messages in one syscall, boundaries kept at the receiver
+    pcom_msg_t out[3] = {
+        { .buf = "alpha", .len = 5 }, { .buf = "be", .len = 2 }, { .buf = "gamma!", .len = 6 } };
+    assert(pcom_send_batch(cfd, out, 3) == 3);
+
+    char buf[3][16];
+    pcom_msg_t in[3];
+    memset(in, 0, sizeof(in));
+    for (int i = 0; i < 3; ++i) { in[i].buf = buf[i]; in[i].len = sizeof(buf[i]); }
+    int got = 0;
+    while (got < 3) {
+        int n = pcom_recv_batch(afd, in + got, 3 - got);
+        assert(n > 0);
+        got += n;
+    }
+    assert(in[0].msg_len == 5 && memcmp(buf[0], "alpha", 5) == 0);
+    assert(in[1].msg_len == 2 && memcmp(buf[1], "be", 2) == 0);
+    assert(in[2].msg_len == 6 && memcmp(buf[2], "gamma!", 6) == 0);
+
+    // Plain recv reads exactly one message
+    assert(pcom_client_send(cfd, "one", 3) == 3);
+    assert(pcom_client_send(cfd, "two", 3) == 3);
+    assert(pcom_server_recv(afd, buf[0], sizeof(buf[0])) == 3);
+
+    pcom_client_close(afd);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: SEQPACKET batch send/recv keeps message boundaries\n");
+}
+
+static void
+test_dgram(void) {
+    int sfd = pcom_server_open_ex("pcomtest_dgram", PCOM_OPEN_DGRAM);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open_ex("pcomtest_dgram", PCOM_OPEN_DGRAM);
+    assert(cfd >= 0);
+
+    pcom_msg_t out[2] = { { .buf = "t1", .len = 2 }, { .buf = "t22", .len = 3 } };
+    assert(pcom_send_batch(cfd, out, 2) == 2);
+
+    // Server learns the peer address and replies to it
+    char buf[2][8];
+    pcom_peer_t peers[2];
+    pcom_msg_t in[2];
+    memset(in, 0, sizeof(in));
+    for (int i = 0; i < 2; ++i) { in[i].buf = buf[i]; in[i].len = sizeof(buf[i]); in[i].peer = &peers[i]; }
+    int got = 0;
+    while (got < 2) {
+        int n = pcom_recv_batch(sfd, in + got, 2 - got);
+        assert(n > 0);
+        got += n;
+    }
+    assert(in[0].msg_len == 2 && in[1].msg_len == 3);
+    assert(peers[0].len > 0);
+
+    pcom_msg_t reply = { .buf = "ack", .len = 3, .peer = &peers[0] };
+    assert(pcom_send_batch(sfd, &reply, 1) == 1);
+    assert(pcom_client_recv(cfd, buf[0], sizeof(buf[0])) == 3);
+    assert(memcmp(buf[0], "ack", 3) == 0);
+
+    // Truncation is reported
+    assert(pcom_client_send(cfd, "0123456789", 10) == 10);
+    in[0].len = 4;
+    assert(pcom_recv_batch(sfd, in, 1) == 1);
+    assert(in[0].flags & PCOM_MSG_TRUNC);
+
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: DGRAM batch send/recv with peer reply\n");
+}
+
+static void
+test_names(void) {
+    char buf[8];
+
+    // Abstract namespace leaves no file behind
+    int sfd = pcom_server_open("@pcomtest_abstract");
+    assert(sfd >= 0);
+    assert(access("/var/tmp/@pcomtest_abstract.sock", F_OK) != 0);
+    int cfd = pcom_client_open("@pcomtest_abstract");
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(pcom_client_send(cfd, "hi", 2) == 2);
+    assert(pcom_server_recv(afd, buf, sizeof(buf)) == 2);
+    pcom_client_close(afd);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+
+    // Configurable socket directory
+    assert(pcom_set_socket_dir("relative") < 0);
+    assert(pcom_set_socket_dir("/tmp") == 0);
+    sfd = pcom_server_open("pcomtest_dir");
+    assert(sfd >= 0);
+    assert(access("/tmp/pcomtest_dir.sock", F_OK) == 0);
+    cfd = pcom_client_open("pcomtest_dir");
+    assert(cfd >= 0);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    unlink("/tmp/pcomtest_dir.sock");
+    assert(pcom_set_socket_dir(NULL) == 0);
+
+    // Paths longer than sun_path
+    char dir[200], path[240];
+    snprintf(dir, sizeof(dir), "/tmp/pcomtest_%0120d", 0);
+    mkdir(dir, 0700);
+    snprintf(path, sizeof(path), "%s/long.sock", dir);
+    sfd = pcom_server_open(path);
+    assert(sfd >= 0);
+    cfd = pcom_client_open(path);
+    assert(cfd >= 0);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    assert(unlink(path) == 0);
+    rmdir(dir);
+    printf("✅ Test passed: Abstract, directory and long path names\n");
+}
+
+static void
+test_check_user(void) {
+    pcom_user_info_t info, again;
+    struct passwd* p_pw = getpwuid(getuid());
+
+    int sfd = pcom_server_open("@pcomtest_cred");
+    assert(sfd >= 0);
+    int cfd = pcom_client_open("@pcomtest_cred");
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+
+    assert(pcom_server_check_user(afd, &info) == 0);
+    assert(strcmp(info.username, p_pw->pw_name) == 0);
+    assert(info.is_admin == (getuid() == 0));
+    assert(info.group_count >= 1);
+    assert(getgrgid(getgid()) && strcmp(info.group_list[0], getgrgid(getgid())->gr_name) == 0);
+
+    // Second check is served from the cache and gives the same answer
+    assert(pcom_server_check_user(afd, &again) == 0);
+    assert(strcmp(again.username, info.username) == 0);
+    assert(again.group_count == info.group_count);
+
+    pcom_cred_cache_invalidate();
+    pcom_cred_cache_set_ttl(0);
+    assert(pcom_server_check_user(afd, &again) == 0);
+    assert(strcmp(again.username, info.username) == 0);
+    pcom_cred_cache_set_ttl(PCOM_CRED_CACHE_TTL);
+
+    pcom_client_close(afd);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Check user (%s, %d groups), cached and uncached\n",
+           info.username, info.group_count);
+}
+
+/* Check a client in count supplementary groups, one of them its primary group */
+static int
+check_groups(int sfd, int count) {
+    pcom_user_info_t info;
+    int go[2], done[2], status;
+    char c;
+
+    assert(pipe(go) == 0 && pipe(done) == 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        gid_t groups[PCOM_MAX_GROUP_COUNT + 8];
+        groups[0] = getgid();
+        for (int i = 1; i < count; ++i) groups[i] = (gid_t)(60000 + i);
+        if (setgroups((size_t)count, groups) < 0) _exit(2);
+        int cfd = pcom_client_open("@pcomtest_cred");
+        if (cfd < 0 || write(go[1], "g", 1) != 1 || read(done[0], &c, 1) != 1) _exit(1);
+        _exit(0);
+    }
+    close(go[1]);
+    close(done[0]);
+    int result = -EPERM;
+    if (read(go[0], &c, 1) == 1) {
+        int afd = pcom_server_accept(sfd);
+        assert(afd >= 0);
+        result = pcom_server_check_user(afd, &info);
+        assert(result != 0 || info.group_count >= 1);
+        assert(write(done[1], "d", 1) == 1);
+        pcom_client_close(afd);
+    }
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status));
+    close(go[0]);
+    close(done[1]);
+    return WEXITSTATUS(status) == 2 ? -EPERM : result;
+}
+
+static void
+test_check_groups(void) {
+    int sfd = pcom_server_open("@pcomtest_cred");
+    assert(sfd >= 0);
+
+    // The primary group takes one slot, it is not counted twice
+    int fits = check_groups(sfd, PCOM_MAX_GROUP_COUNT);
+    if (fits == -EPERM) {
+        pcom_server_close(sfd);
+        printf("Test skipped: Group overflow needs CAP_SETGID\n");
+        return;
+    }
+    assert(fits == 0);
+    assert(check_groups(sfd, PCOM_MAX_GROUP_COUNT + 1) == -EOVERFLOW);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: %d groups fit, one more fails with -EOVERFLOW\n", PCOM_MAX_GROUP_COUNT);
+}
+
+#define BIG_LEN (8 * 1024 * 1024)
+
+static void*
+big_reader(void* arg) {
+    int fd = *(int*)arg;
+    unsigned char* buf = malloc(BIG_LEN + 16);
+    assert(buf);
+    assert(pcom_recv_exact(fd, buf, BIG_LEN) == BIG_LEN);
+    for (size_t i = 0; i < BIG_LEN; ++i) assert(buf[i] == (unsigned char)(i * 7));
+    // Peer closes after the payload, the rest comes up short
+    assert(pcom_recv_exact(fd, buf, 16) == 5);
+    assert(memcmp(buf, "tail!", 5) == 0);
+    free(buf);
+    return NULL;
+}
+
+static void
+test_send_all(void) {
+    pthread_t tid;
+    unsigned char* data = malloc(BIG_LEN);
+    assert(data);
+    for (size_t i = 0; i < BIG_LEN; ++i) data[i] = (unsigned char)(i * 7);
+
+    int sfd = pcom_server_open("@pcomtest_all");
+    assert(sfd >= 0);
+    int cfd = pcom_client_open("@pcomtest_all");
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(pthread_create(&tid, NULL, big_reader, &afd) == 0);
+
+    // Non-blocking sender so partial writes and EAGAIN are exercised
+    assert(pcom_set_nonblocking(cfd, 1) == 0 && (fcntl(cfd, F_GETFL) & O_NONBLOCK));
+    pcom_iovec_t iov[4] = {
+        { data, 3 }, { data + 3, 0 }, { data + 3, BIG_LEN / 2 - 3 }, { data + BIG_LEN / 2, BIG_LEN / 2 }
+    };
+    assert(pcom_sendv(cfd, iov, 4) == BIG_LEN);
+    assert(pcom_send_all(cfd, "tail!", 5) == 5);
+    pcom_client_close(cfd);
+
+    pthread_join(tid, NULL);
+    free(data);
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Full send and receive of %d bytes\n", BIG_LEN);
+}
+
+static void
+test_nonblocking(void) {
+    char buf[8];
+    int sfd = pcom_server_open("@pcomtest_nonblock");
+    assert(sfd >= 0);
+
+    // Nothing to accept or receive: EAGAIN instead of waiting
+    assert(pcom_set_nonblocking(sfd, 1) == 0);
+    assert(pcom_server_accept(sfd) == -EAGAIN);
+    int cfd = pcom_client_open("@pcomtest_nonblock");
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(pcom_set_nonblocking(afd, 1) == 0);
+    assert(pcom_client_recv(afd, buf, sizeof(buf)) == -EAGAIN);
+
+    // Back to blocking
+    assert(pcom_set_nonblocking(afd, 0) == 0 && !(fcntl(afd, F_GETFL) & O_NONBLOCK));
+    assert(pcom_client_send(cfd, "ok", 2) == 2);
+    assert(pcom_client_recv(afd, buf, sizeof(buf)) == 2);
+    assert(pcom_set_nonblocking(-1, 1) == -EBADF);
+
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Non-blocking accept and receive return EAGAIN\n");
+}
+
+int main(void) {
+    test_version();
+    test_seqpacket();
+    test_dgram();
+    test_names();
+    test_check_user();
+    test_check_groups();
+    test_send_all();
+    test_nonblocking();
+    return 0;
+}
@@ -0,0 +1,157 @@
+import unittest
+import threading
+import time
+import sys
+import os
+
+# Ensure parent dir is in sys.path
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), "..")))
+
+from pcom import PcomServer, PcomClient, PcomException, PcomTcpOpts, PCOM_OPEN_SEQPACKET, lib
+
+TEST_NAME = "@pcomtest_py"
+
+class TestPcomBuffers(unittest.TestCase):
+    def setUp(self):
+        self.server = PcomServer(TEST_NAME)
+        self.client = PcomClient(TEST_NAME)
+        self.peer = self.server.accept()
+
+    def tearDown(self):
+        self.client.close()
+        self.peer.close()
+        self.server.close()
+
+    def test_recv_returns_received_bytes_only(self):
+        self.client.send(b"0123456789")
+        data = self.peer.recv(1 << 20)
+        self.assertEqual(data, b"0123456789")
+
+    def test_recv_buffer_reused(self):
+        self.client.send(b"abc")
+        self.assertEqual(self.peer.recv(64), b"abc")
+        view = self.peer._recv_buffer(64)
+        self.client.send(b"defg")
+        self.assertEqual(self.peer.recv(32), b"defg")
+        self.assertIs(self.peer._recv_buffer(32), view)
+
+    def test_recv_buffer_per_thread(self):
+        other = []
+        thread = threading.Thread(target=lambda: other.append(self.peer._recv_buffer(64)))
+        thread.start()
+        thread.join()
+        self.assertIsNot(self.peer._recv_buffer(64), other[0])
+
+    def test_send_buffer_protocol(self):
+        payload = bytearray(range(256)) * 16
+        self.client.send(memoryview(payload)[256:])
+        self.client.send(bytes(payload[:256]))
+        self.assertEqual(self.peer.recv_exact(len(payload)), bytes(payload[256:] + payload[:256]))
+
+    def test_recv_into(self):
+        buf = bytearray(16)
+        self.client.send(b"hello")
+        n = self.peer.recv_into(memoryview(buf)[4:])
+        self.assertEqual(n, 5)
+        self.assertEqual(buf[4:9], b"hello")
+
+        self.client.send(b"world!")
+        self.assertEqual(self.peer.recv_exact_into(buf, 6), 6)
+        self.assertEqual(buf[:6], b"world!")
+
+        with self.assertRaises(ValueError):
+            self.peer.recv_into(buf, 17)
+        with self.assertRaises((TypeError, BufferError)):
+            self.peer.recv_into(b"read only")
+
+    def test_recv_into_eof(self):
+        self.client.close()
+        self.assertEqual(self.peer.recv_into(bytearray(8)), 0)
+        self.client = PcomClient(TEST_NAME)
+        self.server.accept().close()
+
+    def test_blocking_recv_releases_gil(self):
+        ticks = []
+        stop = threading.Event()
+
+        def count():
+            while not stop.is_set():
+                ticks.append(1)
+                time.sleep(0.001)
+
+        counter = threading.Thread(target=count)
+        counter.start()
+        sender = threading.Timer(0.1, self.client.send, args=(b"late",))
+        sender.start()
+        self.assertEqual(self.peer.recv(4), b"late")
+        stop.set()
+        counter.join()
+        sender.join()
+        self.assertGreater(len(ticks), 10)
+
+    def test_closed_handle_raises(self):
+        self.client.close()
+        self.client.client_handle = -1
+        with self.assertRaises(PcomException):
+            self.client.send(b"x")
+        self.client = PcomClient(TEST_NAME)
+        self.server.accept().close()
+
+class TestPcomThreads(unittest.TestCase):
+    def test_concurrent_recv(self):
+        # Whole messages, each received once even with two threads receiving
+        name = TEST_NAME + "_seq"
+        server = PcomServer(name, PCOM_OPEN_SEQPACKET)
+        client = PcomClient(name, flags=PCOM_OPEN_SEQPACKET)
+        peer = server.accept()
+        count = 2000
+        got = [[], []]
+
+        def receive(out):
+            while True:
+                data = peer.recv(4096)
+                if not data:
+                    return
+                self.assertEqual(data[8:], data[:8] * 127)
+                out.append(int.from_bytes(data[:8], "little"))
+
+        threads = [threading.Thread(target=receive, args=(out,)) for out in got]
+        for thread in threads:
+            thread.start()
+        for i in range(count):
+            client.send(i.to_bytes(8, "little") * 128)
+        client.close()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(sorted(got[0] + got[1]), list(range(count)))
+        peer.close()
+        server.close()
+
+
+class TestPcomTcp(unittest.TestCase):
+    def setUp(self):
+        # Over TCP even on this host, the peer has no credentials
+        opts = PcomTcpOpts()
+        lib.pcom_tcp_get_opts(opts)
+        opts.prefer_local = 0
+        self.assertEqual(lib.pcom_tcp_set_opts(opts), 0)
+        self.server = PcomServer("tcp://127.0.0.1:0")
+
+    def tearDown(self):
+        self.server.close()
+        lib.pcom_tcp_set_opts(None)
+
+    def test_accept_without_credentials(self):
+        port = lib.pcom_tcp_port(self.server.server_handle)
+        self.assertGreater(port, 0)
+        client = PcomClient(f"tcp://127.0.0.1:{port}")
+        peer = self.server.accept()
+        self.assertEqual(peer.credentials, {"user": "", "admin": False, "groups": []})
+        client.send(b"over tcp")
+        self.assertEqual(peer.recv(64), b"over tcp")
+        client.close()
+        peer.close()
+
+
+if __name__ == "__main__":
+    unittest.main()
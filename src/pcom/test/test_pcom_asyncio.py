@@ -0,0 +1,110 @@
+import unittest
+import asyncio
+import threading
+import sys
+import os
+
+# Ensure parent dir is in sys.path
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), "..")))
+
+from pcom import PcomClient, PcomException, lib
+from pcom_asyncio import AsyncPcomServer, AsyncPcomConnection, start_server, PCOM_FRAME_HDR
+
+TEST_NAME = "@pcomtest_asyncio"
+CLIENTS = 50
+ROUNDS = 20
+
+async def echo_msgs(conn):
+    while (msg := await conn.recv_msg()) is not None:
+        await conn.send_msg(msg)
+
+class TestPcomAsyncio(unittest.TestCase):
+    def test_many_clients(self):
+        async def client(i):
+            async with await AsyncPcomConnection.open(TEST_NAME) as conn:
+                for r in range(ROUNDS):
+                    msg = f"{i}:{r}".encode() * (r + 1)
+                    await conn.send_msg(msg)
+                    self.assertEqual(await conn.recv_msg(), msg)
+
+        async def main():
+            server = await start_server(echo_msgs, TEST_NAME)
+            await asyncio.gather(*(client(i) for i in range(CLIENTS)))
+            server.close()
+            await server.serving
+
+        asyncio.run(main())
+
+    def test_large_frames_and_backpressure(self):
+        payload = bytes(range(256)) * 8192      # 2 MiB, larger than the socket buffers
+
+        async def main():
+            async with AsyncPcomServer(TEST_NAME) as server:
+                client_task = asyncio.ensure_future(AsyncPcomConnection.open(TEST_NAME))
+                peer = await server.accept()
+                client = await client_task
+                self.assertIsInstance(peer.credentials["user"], str)
+                sender = asyncio.ensure_future(client.send_msg(memoryview(payload), channel=7))
+                ftype, flags, channel, data = await peer.recv_frame()
+                await sender
+                self.assertEqual((ftype, flags, channel), (0, 0, 7))
+                self.assertEqual(data, payload)
+                client.close()
+                self.assertIsNone(await peer.recv_msg())
+                peer.close()
+
+        asyncio.run(main())
+
+    def test_interop_with_blocking_client(self):
+        async def main():
+            async with AsyncPcomServer(TEST_NAME) as server:
+                # Blocking peer on another thread, raw frames and plain bytes
+                def blocking():
+                    c = PcomClient(TEST_NAME)
+                    c.send(PCOM_FRAME_HDR.pack(5, 0, 0, 0) + b"hello" + b"tail")
+                    c.close()
+                thread = threading.Thread(target=blocking)
+                thread.start()
+                async with await server.accept() as peer:
+                    self.assertEqual(await peer.recv_msg(), b"hello")
+                    self.assertEqual(await peer.recv_exact(4), b"tail")
+                    with self.assertRaises(asyncio.IncompleteReadError):
+                        await peer.recv_exact(1)
+                thread.join()
+
+        asyncio.run(main())
+
+    def test_close_wakes_waiter(self):
+        async def main():
+            server = AsyncPcomServer(TEST_NAME)
+            waiter = asyncio.ensure_future(server.accept())
+            await asyncio.sleep(0.01)
+            with self.assertRaises(RuntimeError):
+                await server.accept()
+            server.close()
+            with self.assertRaises(PcomException):
+                await waiter
+
+        asyncio.run(main())
+
+    def test_tcp_local_client(self):
+        async def main():
+            async with AsyncPcomServer("tcp://127.0.0.1:0") as server:
+                port = lib.pcom_tcp_port(server.server_handle)
+                self.assertIsNotNone(server.local_handle)
+                # Same host, so the client comes in on the UNIX listener
+                def blocking():
+                    c = PcomClient(f"tcp://127.0.0.1:{port}")
+                    c.send(b"local")
+                    c.close()
+                thread = threading.Thread(target=blocking)
+                thread.start()
+                async with await asyncio.wait_for(server.accept(), 5) as peer:
+                    self.assertNotEqual(peer.credentials["user"], "")
+                    self.assertEqual(await peer.recv_exact(5), b"local")
+                thread.join()
+
+        asyncio.run(main())
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,171 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "../pcom_buf.h"
+
+#define TEST_NAME "@pcomtest_buf"
+#define BURST     (1000)
+#define BURSTS    (10)
+#define THREADS   (4)
+#define OPS       (1000000)
+
+static void* g_burst[BURST];
+
+static double
+now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void
+test_classes(void) {
+    void* a = pcom_buf_alloc(1);
+    void* b = pcom_buf_alloc(65);
+    void* c = pcom_buf_alloc(PCOM_BUF_MAX);
+    void* d = pcom_buf_alloc(PCOM_BUF_MAX + 1);
+    void* e = pcom_buf_alloc(5u << 20);
+    assert(a && b && c && d && e);
+    assert(pcom_buf_capacity(a) == PCOM_BUF_MIN && pcom_buf_capacity(b) == 128);
+    assert(pcom_buf_capacity(c) == PCOM_BUF_MAX);
+    assert(pcom_buf_capacity(d) > PCOM_BUF_MAX && pcom_buf_capacity(e) >= (5u << 20));
+    assert((uintptr_t)a % 64 == 0 && (uintptr_t)c % 4096 == 0 && (uintptr_t)e % 4096 == 0);
+    memset(c, 0xab, PCOM_BUF_MAX);
+    memset(e, 0xcd, 5u << 20);
+
+    // The last reference returns it, the next allocation of the class reuses it
+    pcom_buf_ref(b);
+    pcom_buf_unref(b);
+    memset(b, 1, 128);
+    pcom_buf_unref(b);
+    assert(pcom_buf_alloc(100) == b);
+    pcom_buf_unref(b);
+
+    // Large buffers are cached and handed out again
+    pcom_buf_unref(e);
+    assert(pcom_buf_alloc(4u << 20) == e);
+
+    pcom_buf_unref(a);
+    pcom_buf_unref(c);
+    pcom_buf_unref(d);
+    pcom_buf_unref(e);
+    pcom_buf_unref(NULL);
+    printf("✅ Test passed: Size classes, references and reuse\n");
+}
+
+static void*
+burst_alloc(void* arg) {
+    size_t size = (size_t)(uintptr_t)arg;
+    for (int i = 0; i < BURST; ++i) {
+        g_burst[i] = pcom_buf_alloc(size + (size_t)i % 64);
+        assert(g_burst[i]);
+        memset(g_burst[i], i, 64);
+    }
+    return NULL;
+}
+
+static void*
+burst_free(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BURST; ++i) pcom_buf_unref(g_burst[i]);
+    return NULL;
+}
+
+static void
+test_bursts(void) {
+    pcom_buf_stats_t st;
+    unsigned long long mapped = 0;
+    const size_t sizes[] = { 200, 3000, 20000 };
+
+    // Allocated on one thread, freed on another, new threads every burst
+    for (int round = 0; round < BURSTS; ++round) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+            pthread_t t;
+            assert(pthread_create(&t, NULL, burst_alloc, (void*)(uintptr_t)sizes[s]) == 0);
+            pthread_join(t, NULL);
+            assert(pthread_create(&t, NULL, burst_free, NULL) == 0);
+            pthread_join(t, NULL);
+        }
+        assert(pcom_buf_stats(&st) == 0);
+        if (round == 0) mapped = st.mapped;
+        assert(st.mapped == mapped);
+    }
+    assert(st.cached > 0);
+
+    // Trim gives the pages of cached buffers back
+    pcom_buf_trim();
+    assert(pcom_buf_stats(&st) == 0);
+    assert(st.released > 0 && st.large == 0);
+    printf("✅ Test passed: %d bursts across threads, %llu KiB mapped throughout\n",
+           BURSTS, mapped / 1024);
+}
+
+static void
+test_recv(void) {
+    pcom_frame_hdr_t hdr = { 70000, PCOM_FRAME_DATA, 1, 3 };
+    char* payload = malloc(hdr.len);
+    void* buf;
+    for (uint32_t i = 0; i < hdr.len; ++i) payload[i] = (char)i;
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+
+    assert(pcom_client_send(cfd, "ping", 4) == 4);
+    assert(pcom_buf_recv(afd, 4096, &buf) == 4 && memcmp(buf, "ping", 4) == 0);
+    assert(pcom_buf_capacity(buf) == 4096);
+    pcom_buf_unref(buf);
+
+    assert(pcom_frame_send(cfd, &hdr, payload) == 0);
+    assert(pcom_buf_recv_frame(afd, &hdr, &buf) == 1);
+    assert(hdr.len == 70000 && hdr.flags == 1 && hdr.channel == 3);
+    assert(memcmp(buf, payload, hdr.len) == 0);
+    pcom_buf_unref(buf);
+
+    pcom_client_close(cfd);
+    assert(pcom_buf_recv(afd, 64, &buf) == 0 && buf == NULL);
+    assert(pcom_buf_recv_frame(afd, &hdr, &buf) == 0 && buf == NULL);
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    free(payload);
+    printf("✅ Test passed: Messages and frames received into pool buffers\n");
+}
+
+static void*
+churn(void* arg) {
+    void* held[8];
+    (void)arg;
+    for (int i = 0; i < OPS; ++i) {
+        void* p = pcom_buf_alloc(64u << (i & 7));
+        assert(p);
+        if (i >= 8) pcom_buf_unref(held[i & 7]);
+        held[i & 7] = p;
+    }
+    for (int i = 0; i < 8; ++i) pcom_buf_unref(held[i]);
+    return NULL;
+}
+
+static void
+test_throughput(void) {
+    pthread_t tids[THREADS];
+    double t0 = now_s();
+    for (int i = 0; i < THREADS; ++i) assert(pthread_create(&tids[i], NULL, churn, NULL) == 0);
+    for (int i = 0; i < THREADS; ++i) pthread_join(tids[i], NULL);
+    double ns = (now_s() - t0) * 1e9 / ((double)THREADS * OPS);
+    printf("✅ Test passed: %d threads, %.1f ns per allocation and free\n", THREADS, ns);
+}
+
+int main(void) {
+    test_classes();
+    test_bursts();
+    test_recv();
+    test_throughput();
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "../pcom_capture.h"
+
+#define TEST_NAME "@pcomtest_capture"
+#define FRAMES    (1000)
+
+typedef struct {
+    uint8_t* p_map;
+    size_t size;
+} capture_t;
+
+static void
+map(const char* path, capture_t* p_c) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    assert(fd >= 0 && fstat(fd, &st) == 0);
+    p_c->size = (size_t)st.st_size;
+    p_c->p_map = mmap(NULL, p_c->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    assert(p_c->p_map != MAP_FAILED);
+    close(fd);
+}
+
+static void
+test_capture(int sfd, const char* path) {
+    pcom_frame_reader_t reader;
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    capture_t c;
+    char msg[64];
+
+    int cfd = pcom_client_open(TEST_NAME);
+    int afd = pcom_server_accept(sfd);
+    assert(cfd >= 0 && afd >= 0);
+    pcom_frame_reader_init(&reader);
+
+    // Nothing recorded before the start
+    pcom_frame_hdr_t h0 = { 3, PCOM_FRAME_DATA, 0, 0 };
+    assert(pcom_frame_send(cfd, &h0, "pre") == 0);
+    assert(pcom_frame_recv(afd, &reader, &hdr, &payload) == 1);
+
+    assert(pcom_capture_start(path, 0) == 0);
+    assert(pcom_capture_start(path, 0) == -EBUSY);
+    for (int i = 0; i < FRAMES; ++i) {
+        pcom_frame_hdr_t h = { (uint32_t)snprintf(msg, sizeof(msg), "request %d", i), PCOM_FRAME_DATA, 1, (uint16_t)i };
+        assert(pcom_frame_send(cfd, &h, msg) == 0);
+        assert(pcom_frame_recv(afd, &reader, &hdr, &payload) == 1);
+    }
+    // Empty frames and frames from a reader fed elsewhere
+    pcom_frame_hdr_t empty = { 0, PCOM_FRAME_DATA, 0, 7 };
+    pcom_capture_frame(afd, PCOM_CAPTURE_IN, &empty, NULL);
+    assert(pcom_capture_stop() == 2 * FRAMES + 1);
+    assert(pcom_capture_stop() == -EINVAL);
+    assert(pcom_frame_send(cfd, &h0, "pst") == 0);
+
+    // Both ends of each frame, in order, with valid CRCs
+    map(path, &c);
+    const pcom_capture_file_t* p_file = (const pcom_capture_file_t*)c.p_map;
+    assert(memcmp(p_file->magic, PCOM_CAPTURE_MAGIC, 8) == 0 && p_file->pid == (uint32_t)getpid());
+    size_t at = sizeof(*p_file);
+    uint64_t last = 0;
+    for (int i = 0; i < 2 * FRAMES + 1; ++i) {
+        pcom_capture_rec_t* p_rec = (pcom_capture_rec_t*)(c.p_map + at);
+        assert(at % 8 == 0 && at + pcom_capture_rec_size(p_rec) <= c.size);
+        assert(pcom_capture_rec_valid(p_rec) && p_rec->time_ns >= last);
+        last = p_rec->time_ns;
+        if (i < 2 * FRAMES) {
+            int len = snprintf(msg, sizeof(msg), "request %d", i / 2);
+            assert(p_rec->dir == (i % 2 ? PCOM_CAPTURE_IN : PCOM_CAPTURE_OUT));
+            assert(p_rec->handle == (i % 2 ? afd : cfd) && p_rec->channel == (uint16_t)(i / 2));
+            assert(p_rec->len == (uint32_t)len && memcmp(p_rec + 1, msg, (size_t)len) == 0);
+            assert(p_rec->type == PCOM_FRAME_DATA && p_rec->flags == 1);
+        } else {
+            assert(p_rec->len == 0 && p_rec->channel == 7);
+        }
+        at += pcom_capture_rec_size(p_rec);
+    }
+    assert(at == c.size);
+
+    // A flipped bit is caught
+    pcom_capture_rec_t* p_first = (pcom_capture_rec_t*)(c.p_map + sizeof(*p_file));
+    ((uint8_t*)(p_first + 1))[0] ^= 1;
+    assert(!pcom_capture_rec_valid(p_first));
+    munmap(c.p_map, c.size);
+
+    pcom_frame_reader_free(&reader);
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+    printf("✅ Test passed: %d frames captured both ways with timestamps and CRCs\n", FRAMES);
+}
+
+static void
+test_limit(int sfd, const char* path) {
+    pcom_frame_reader_t reader;
+    pcom_frame_hdr_t hdr, h = { 24, PCOM_FRAME_DATA, 0, 0 };
+    const void* payload;
+    char msg[24] = "limited";
+    struct stat st;
+
+    int cfd = pcom_client_open(TEST_NAME);
+    int afd = pcom_server_accept(sfd);
+    pcom_frame_reader_init(&reader);
+
+    // Room for the header and 10 records of 32 + 24 bytes
+    assert(pcom_capture_start(path, sizeof(pcom_capture_file_t) + 10 * 56 + 55) == 0);
+    for (int i = 0; i < 20; ++i) assert(pcom_frame_send(cfd, &h, msg) == 0);
+    for (int i = 0; i < 20; ++i) assert(pcom_frame_recv(afd, &reader, &hdr, &payload) == 1);
+    assert(pcom_capture_stop() == 10);
+    assert(stat(path, &st) == 0 && st.st_size == (off_t)(sizeof(pcom_capture_file_t) + 10 * 56));
+
+    // No capture in a forked child, the parent's buffer is not written twice
+    assert(pcom_capture_start(path, 0) == 0);
+    assert(pcom_frame_send(cfd, &h, msg) == 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        pcom_frame_send(cfd, &h, msg);
+        _exit(pcom_capture_stop() == -EINVAL ? 0 : 1);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(pcom_capture_stop() == 1);
+    assert(stat(path, &st) == 0 && st.st_size == (off_t)(sizeof(pcom_capture_file_t) + 56));
+
+    assert(pcom_capture_start("/nonexistent/dir/capture", 0) == -ENOENT);
+    pcom_frame_reader_free(&reader);
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+    printf("✅ Test passed: Size limit, forked children and errors\n");
+}
+
+int main(void) {
+    char path[64];
+    strcpy(path, "/tmp/pcomtest_captureXXXXXX");
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    test_capture(sfd, path);
+    test_limit(sfd, path);
+    pcom_server_close(sfd);
+    unlink(path);
+    return 0;
+}
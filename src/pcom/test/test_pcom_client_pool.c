@@ -0,0 +1,153 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../pcom_client_pool.h"
+
+#define TEST_NAME "@pcomtest_cpool"
+#define THREADS   (8)
+#define REQUESTS  (500)
+
+/* Echo until EOF or "bye" */
+static void*
+echo_conn(void* arg) {
+    int fd = (int)(intptr_t)arg;
+    char buf[64];
+    int len;
+    while ((len = pcom_client_recv(fd, buf, sizeof(buf))) > 0) {
+        if (len == 3 && memcmp(buf, "bye", 3) == 0) break;
+        assert(pcom_send_all(fd, buf, (size_t)len) == len);
+    }
+    pcom_client_close(fd);
+    return NULL;
+}
+
+static void*
+echo_server(void* arg) {
+    int sfd = *(int*)arg;
+    int fd;
+    while ((fd = pcom_server_accept(sfd)) >= 0) {
+        pthread_t tid;
+        assert(pthread_create(&tid, NULL, echo_conn, (void*)(intptr_t)fd) == 0);
+        pthread_detach(tid);
+    }
+    return NULL;
+}
+
+static int
+request(int fd, int n) {
+    int back;
+    if (pcom_send_all(fd, &n, sizeof(n)) != sizeof(n)) return -1;
+    if (pcom_recv_exact(fd, &back, sizeof(back)) != sizeof(back)) return -1;
+    return back == n ? 0 : -1;
+}
+
+static void
+test_reuse(void) {
+    pcom_client_pool_stats_t st;
+
+    int fd = pcom_client_pool_get(TEST_NAME);
+    assert(fd >= 0);
+    assert(request(fd, 1) == 0);
+    pcom_client_pool_put(TEST_NAME, fd, 1);
+
+    int again = pcom_client_pool_get(TEST_NAME);
+    assert(again == fd);
+    assert(request(again, 2) == 0);
+    pcom_client_pool_put(TEST_NAME, again, 1);
+
+    pcom_client_pool_stats(&st);
+    assert(st.opened == 1 && st.reused == 1 && st.open == 1 && st.idle == 1);
+    assert(pcom_client_pool_get(NULL) == -EINVAL);
+    printf("✅ Test passed: Connection reused\n");
+}
+
+static void*
+worker(void* arg) {
+    (void)arg;
+    for (int i = 0; i < REQUESTS; ++i) {
+        int fd;
+        while ((fd = pcom_client_pool_get(TEST_NAME)) == -EBUSY) sched_yield();
+        assert(fd >= 0);
+        assert(request(fd, i) == 0);
+        pcom_client_pool_put(TEST_NAME, fd, 1);
+    }
+    return NULL;
+}
+
+static void
+test_threads(void) {
+    pthread_t tid[THREADS];
+    pcom_client_pool_stats_t st;
+    pcom_client_pool_opts_t opts = { 4, PCOM_CLIENT_POOL_IDLE_MS, PCOM_CLIENT_POOL_CHECK_MS };
+
+    pcom_client_pool_config(&opts);
+    for (int i = 0; i < THREADS; ++i) assert(pthread_create(&tid[i], NULL, worker, NULL) == 0);
+    for (int i = 0; i < THREADS; ++i) pthread_join(tid[i], NULL);
+
+    pcom_client_pool_stats(&st);
+    assert(st.open <= 4 && st.open == st.idle);
+    assert(st.opened <= 4 && st.closed == 0);
+    printf("✅ Test passed: %d threads x %d requests over %llu connections (%llu refused at cap)\n",
+           THREADS, REQUESTS, st.opened, st.busy);
+}
+
+static void
+test_health(void) {
+    pcom_client_pool_stats_t before, st;
+    pcom_client_pool_opts_t opts = { 4, PCOM_CLIENT_POOL_IDLE_MS, 0 };
+
+    pcom_client_pool_config(&opts);
+    pcom_client_pool_clear();
+    pcom_client_pool_stats(&before);
+    assert(before.idle == 0 && before.open == 0);
+
+    // Server side goes away while the connection is idle
+    int fd = pcom_client_pool_get(TEST_NAME);
+    assert(fd >= 0);
+    assert(request(fd, 3) == 0);
+    assert(pcom_send_all(fd, "bye", 3) == 3);
+    pcom_client_pool_put(TEST_NAME, fd, 1);
+    usleep(50000);
+
+    fd = pcom_client_pool_get(TEST_NAME);
+    assert(fd >= 0);
+    assert(request(fd, 4) == 0);
+    pcom_client_pool_put(TEST_NAME, fd, 1);
+    pcom_client_pool_stats(&st);
+    assert(st.unhealthy == before.unhealthy + 1);
+    assert(st.opened == before.opened + 2);
+
+    // Too old to keep
+    opts.idle_ms = 1;
+    pcom_client_pool_config(&opts);
+    usleep(20000);
+    fd = pcom_client_pool_get(TEST_NAME);
+    assert(fd >= 0);
+    pcom_client_pool_put(TEST_NAME, fd, 0);
+    pcom_client_pool_stats(&st);
+    assert(st.expired == before.expired + 1);
+    assert(st.open == 0 && st.idle == 0);
+
+    pcom_client_pool_config(NULL);
+    printf("✅ Test passed: Dead and expired connections replaced\n");
+}
+
+int main(void) {
+    pthread_t tid;
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    assert(pthread_create(&tid, NULL, echo_server, &sfd) == 0);
+    pthread_detach(tid);
+
+    test_reuse();
+    test_threads();
+    test_health();
+
+    pcom_client_pool_clear();
+    pcom_server_close(sfd);
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include "../pcom_coalesce.h"
+#include "../pcom_frame.h"
+#include "../pcom_stats.h"
+
+#define TEST_NAME "@pcomtest_coalesce"
+#define MSG_LEN   (32)
+#define MSGS      (200000)
+
+typedef struct {
+    int fd;
+    long long bytes;
+} drain_t;
+
+static double
+now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Reads until EOF, checking the byte pattern of the messages */
+static void*
+drain(void* arg) {
+    drain_t* p_d = arg;
+    unsigned char buf[65536];
+    int r;
+    while ((r = pcom_server_recv(p_d->fd, buf, sizeof(buf))) > 0) {
+        for (int i = 0; i < r; ++i) assert(buf[i] == (unsigned char)((p_d->bytes + i) / MSG_LEN));
+        p_d->bytes += r;
+    }
+    assert(r == 0);
+    return NULL;
+}
+
+static void
+connect_pair(int sfd, int* p_cfd, int* p_afd) {
+    *p_cfd = pcom_client_open(TEST_NAME);
+    assert(*p_cfd >= 0);
+    *p_afd = pcom_server_accept(sfd);
+    assert(*p_afd >= 0);
+}
+
+/* MSGS small messages, returns the send syscalls they took */
+static unsigned long long
+send_many(int sfd, size_t threshold, double* p_ns) {
+    pcom_conn_stats_t cs;
+    drain_t d = { -1, 0 };
+    unsigned char msg[MSG_LEN];
+    pthread_t tid;
+    int cfd;
+
+    connect_pair(sfd, &cfd, &d.fd);
+    if (threshold) assert(pcom_coalesce_enable(cfd, threshold, 1000) == 0);
+    assert(pthread_create(&tid, NULL, drain, &d) == 0);
+
+    double t0 = now_s();
+    for (int i = 0; i < MSGS; ++i) {
+        memset(msg, i, sizeof(msg));
+        assert(pcom_client_send(cfd, msg, sizeof(msg)) == MSG_LEN);
+    }
+    assert(pcom_flush(cfd) >= 0);
+    *p_ns = (now_s() - t0) * 1e9 / MSGS;
+
+    assert(pcom_stats_conn(cfd, &cs) == 0);
+    assert(cs.msgs_out == MSGS && cs.bytes_out == (unsigned long long)MSGS * MSG_LEN);
+    pcom_client_close(cfd);
+    pthread_join(tid, NULL);
+    assert(d.bytes == (long long)MSGS * MSG_LEN);
+    pcom_client_close(d.fd);
+    return cs.syscalls;
+}
+
+static void
+test_threshold(int sfd) {
+    double ns_plain, ns_coalesced;
+    unsigned long long plain = send_many(sfd, 0, &ns_plain);
+    unsigned long long coalesced = send_many(sfd, 16384, &ns_coalesced);
+    assert(plain == MSGS);
+    assert(coalesced < plain / 100);   // 391 unless the deadline flushed a few
+    printf("✅ Test passed: %d messages in %llu writes instead of %llu (%.0f vs %.0f ns each)\n",
+           MSGS, coalesced, plain, ns_coalesced, ns_plain);
+}
+
+static void
+test_deadline(int sfd) {
+    char buf[64];
+    int cfd, afd;
+    struct pollfd pfd;
+
+    connect_pair(sfd, &cfd, &afd);
+    pfd.fd = afd;
+    pfd.events = POLLIN;
+
+    // No deadline: held until pcom_flush()
+    assert(pcom_coalesce_enable(cfd, 4096, 0) == 0);
+    assert(pcom_client_send(cfd, "held", 4) == 4);
+    assert(poll(&pfd, 1, 50) == 0);
+    assert(pcom_flush(cfd) == 4);
+    assert(pcom_flush(cfd) == 0);
+    assert(pcom_server_recv(afd, buf, sizeof(buf)) == 4 && memcmp(buf, "held", 4) == 0);
+
+    // 200 us deadline: flushed in the background
+    assert(pcom_coalesce_enable(cfd, 4096, 200) == 0);
+    double worst = 0;
+    for (int i = 0; i < 20; ++i) {
+        double t0 = now_s();
+        assert(pcom_client_send(cfd, "tick", 4) == 4);
+        assert(poll(&pfd, 1, 1000) == 1);
+        double us = (now_s() - t0) * 1e6;
+        if (us > worst) worst = us;
+        assert(pcom_server_recv(afd, buf, sizeof(buf)) == 4 && memcmp(buf, "tick", 4) == 0);
+    }
+    assert(worst >= 150);
+
+    // Frames go through the buffer too, whole and in order
+    pcom_frame_reader_t reader;
+    pcom_frame_hdr_t hdr = { 5, PCOM_FRAME_DATA, 0, 0 };
+    const void* payload;
+    pcom_frame_reader_init(&reader);
+    for (uint32_t i = 0; i < 3; ++i) { hdr.channel = i; assert(pcom_frame_send(cfd, &hdr, "frame") == 0); }
+    assert(pcom_flush(cfd) == 3 * (PCOM_FRAME_HDR_SIZE + 5));
+    for (uint32_t i = 0; i < 3; ++i) {
+        assert(pcom_frame_recv(afd, &reader, &hdr, &payload) == 1);
+        assert(hdr.channel == i && hdr.len == 5 && memcmp(payload, "frame", 5) == 0);
+    }
+    pcom_frame_reader_free(&reader);
+
+    // Closing writes out the rest
+    assert(pcom_client_send(cfd, "last", 4) == 4);
+    pcom_client_close(cfd);
+    assert(pcom_server_recv(afd, buf, sizeof(buf)) == 4 && memcmp(buf, "last", 4) == 0);
+    assert(pcom_server_recv(afd, buf, sizeof(buf)) == 0);
+    pcom_client_close(afd);
+    printf("✅ Test passed: Held until flush, deadline flushes within %.0f us, close flushes\n", worst);
+}
+
+static void
+test_stalled(int sfd) {
+    static char fill[65536], buf[65536];
+    long long filled = 0, got = 0;
+    int cfd, afd, c2, a2;
+    ssize_t r;
+    struct pollfd pfd;
+
+    // The peer of cfd reads nothing, its socket fills up
+    connect_pair(sfd, &cfd, &afd);
+    connect_pair(sfd, &c2, &a2);
+    while ((r = send(cfd, fill, sizeof(fill), MSG_DONTWAIT)) > 0) filled += r;
+    assert(errno == EAGAIN || errno == EWOULDBLOCK);
+    assert(pcom_coalesce_enable(cfd, 4096, 200) == 0);
+    assert(pcom_coalesce_enable(c2, 4096, 200) == 0);
+    assert(pcom_client_send(cfd, "stalled", 7) == 7);
+    struct timespec ts = { 0, 5000000 };
+    nanosleep(&ts, NULL);
+
+    // The flusher did not wait on it: other deadlines and the handle itself go on
+    pfd.fd = a2;
+    pfd.events = POLLIN;
+    assert(pcom_client_send(c2, "tick", 4) == 4);
+    assert(poll(&pfd, 1, 1000) == 1);
+    assert(pcom_server_recv(a2, buf, sizeof(buf)) == 4 && memcmp(buf, "tick", 4) == 0);
+    assert(pcom_client_send(cfd, "more", 4) == 4);
+
+    // Once the peer reads, the buffered tail follows in order
+    while (got < filled + 11) {
+        r = pcom_server_recv(afd, buf, sizeof(buf));
+        assert(r > 0);
+        if (got + r > filled) {
+            long long from = (got > filled) ? got - filled : 0;
+            long long at = (got > filled) ? 0 : filled - got;
+            assert(memcmp(buf + at, "stalledmore" + from, (size_t)(r - at)) == 0);
+        }
+        got += r;
+    }
+    assert(got == filled + 11);
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+    pcom_client_close(c2);
+    pcom_client_close(a2);
+    printf("✅ Test passed: Deadline flush leaves a full socket for later, others flush meanwhile\n");
+}
+
+static void
+test_errors(void) {
+    int sfd = pcom_server_open_ex("@pcomtest_coalesce_seq", PCOM_OPEN_SEQPACKET);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open_ex("@pcomtest_coalesce_seq", PCOM_OPEN_SEQPACKET);
+    assert(cfd >= 0);
+    assert(pcom_coalesce_enable(cfd, 4096, 100) == -EPROTOTYPE);
+    assert(pcom_flush(cfd) == 0);
+    assert(pcom_coalesce_disable(cfd) == 0);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Coalescing refused on message sockets\n");
+}
+
+int main(void) {
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    test_threshold(sfd);
+    test_deadline(sfd);
+    test_stalled(sfd);
+    pcom_server_close(sfd);
+    test_errors();
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "../pcom.hpp"
+
+using namespace crow::pcom;
+
+#define TEST_NAME "@pcomtest_cpp"
+#define SESSIONS  (200)
+#define ROUNDS    (20)
+
+static std::span<const std::byte> bytes(const char* str) {
+    return std::as_bytes(std::span<const char>(str, strlen(str)));
+}
+
+static void
+test_raii() {
+    server srv(TEST_NAME);
+    connection client(TEST_NAME);
+    connection peer = srv.accept();
+    std::byte buf[16];
+
+    client.send_all(std::string_view("hello"));
+    assert(peer.recv_exact(std::span(buf, 5)) == 5 && memcmp(buf, "hello", 5) == 0);
+    assert(server::check_user(peer).name.size() > 0);
+
+    // Moves hand over the handle, the source is left empty
+    int handle = peer.handle();
+    connection moved = std::move(peer);
+    assert(!peer && moved.handle() == handle);
+    moved.send_all(bytes("ok"));
+    assert(client.recv(buf) == 2);
+
+    moved.close();
+    assert(client.recv(buf) == 0);
+
+    bool thrown = false;
+    try {
+        connection bad("@pcomtest_cpp_nobody");
+    } catch (const error& e) {
+        thrown = (e.code().value() == ECONNREFUSED || e.code().value() == ENOENT);
+    }
+    assert(thrown);
+    printf("✅ Test passed: RAII connection and server, move and errors\n");
+}
+
+/* Echoes until the client hangs up */
+static task<void>
+echo(reactor& r, connection conn) {
+    std::byte buf[256];
+    for (;;) {
+        size_t n = co_await r.recv(conn, buf);
+        if (n == 0) break;
+        co_await r.send(conn, std::span<const std::byte>(buf, n));
+    }
+}
+
+static task<void>
+acceptor(reactor& r, int sessions) {
+    for (int i = 0; i < sessions; ++i) r.spawn(echo(r, co_await r.accept()));
+}
+
+/* One client session: ROUNDS request/echo pairs, counted when all match */
+static task<void>
+session(reactor& r, int id, int& done, int sessions) {
+    connection conn(TEST_NAME);
+    char msg[32];
+    std::byte buf[32];
+
+    for (int i = 0; i < ROUNDS; ++i) {
+        int len = snprintf(msg, sizeof(msg), "%d:%d", id, i);
+        co_await r.send(conn, std::as_bytes(std::span<const char>(msg, (size_t)len)));
+        size_t got = co_await r.recv_exact(conn, std::span(buf, (size_t)len));
+        if (got != (size_t)len || memcmp(buf, msg, (size_t)len) != 0) co_return;
+    }
+    if (++done == sessions) r.stop();
+}
+
+static task<void>
+failing(reactor&) {
+    throw error(-EPIPE, "test");
+    co_return;
+}
+
+static void
+test_reactor(int flags) {
+    server srv(TEST_NAME);
+    reactor server_r(srv, flags);
+    reactor client_r(flags);
+    int done = 0;
+
+    // Sessions are spawned from this thread, the reactors run on their own
+    server_r.spawn(acceptor(server_r, SESSIONS));
+    std::thread server_t([&] { server_r.run(); });
+    for (int i = 0; i < SESSIONS; ++i) client_r.spawn(session(client_r, i, done, SESSIONS));
+    client_r.run();
+    assert(done == SESSIONS);
+
+    server_r.stop();
+    server_t.join();
+
+    // An exception escaping a spawned task ends run()
+    client_r.spawn(failing(client_r));
+    bool thrown = false;
+    try {
+        client_r.run();
+    } catch (const error& e) {
+        thrown = (e.code().value() == EPIPE);
+    }
+    assert(thrown);
+    printf("✅ Test passed: %s reactor echoed %d sessions x %d rounds\n",
+           client_r.backend() == PCOM_LOOP_BACKEND_URING ? "io_uring" : "epoll", SESSIONS, ROUNDS);
+}
+
+int main() {
+    test_raii();
+    test_reactor(PCOM_LOOP_EPOLL);
+    test_reactor(PCOM_LOOP_DEFAULT);
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "../pcom_file.h"
+#include "../pcom_coalesce.h"
+#include "../pcom_stats.h"
+
+#define TEST_NAME "@pcomtest_file"
+#define FILE_LEN  (32u << 20)
+
+typedef struct {
+    int fd;          // Handle to send on
+    int file;
+    int64_t offset;
+    size_t len;
+    int64_t result;
+} job_t;
+
+static double
+now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int
+temp_file(char* path, int flags) {
+    strcpy(path, "/tmp/pcomtest_fileXXXXXX");
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    if (flags) assert(fcntl(fd, F_SETFL, flags) == 0);
+    return fd;
+}
+
+static void*
+sender(void* arg) {
+    job_t* p_j = arg;
+    p_j->result = pcom_send_file(p_j->fd, p_j->file, p_j->offset, p_j->len);
+    return NULL;
+}
+
+static void
+connect_pair(int sfd, int* p_cfd, int* p_afd) {
+    *p_cfd = pcom_client_open(TEST_NAME);
+    assert(*p_cfd >= 0);
+    *p_afd = pcom_server_accept(sfd);
+    assert(*p_afd >= 0);
+}
+
+static void
+assert_same(int a, off_t a_off, int b, off_t b_off, size_t len) {
+    char* p_a = malloc(len);
+    char* p_b = malloc(len);
+    assert(pread(a, p_a, len, a_off) == (ssize_t)len);
+    assert(pread(b, p_b, len, b_off) == (ssize_t)len);
+    assert(memcmp(p_a, p_b, len) == 0);
+    free(p_a);
+    free(p_b);
+}
+
+static void
+test_transfer(int sfd, int src) {
+    char path[64];
+    pcom_conn_stats_t cs;
+    job_t job = { -1, src, 0, FILE_LEN, 0 };
+    pthread_t tid;
+    int cfd;
+
+    connect_pair(sfd, &job.fd, &cfd);
+    int dst = temp_file(path, 0);
+    unlink(path);
+
+    double t0 = now_s();
+    assert(pthread_create(&tid, NULL, sender, &job) == 0);
+    assert(pcom_recv_to_file(cfd, dst, 0, FILE_LEN) == FILE_LEN);
+    pthread_join(tid, NULL);
+    double s = now_s() - t0;
+    assert(job.result == FILE_LEN);
+    assert_same(src, 0, dst, 0, FILE_LEN);
+
+    // A few syscalls per MiB, not one per buffer
+    assert(pcom_stats_conn(job.fd, &cs) == 0);
+    assert(cs.bytes_out == FILE_LEN && cs.syscalls < 64);
+    printf("✅ Test passed: %u MiB sent in %llu syscalls, %.0f MiB/s\n",
+           FILE_LEN >> 20, cs.syscalls, (FILE_LEN >> 20) / s);
+
+    // A range at the file position, the rest of the stream intact
+    assert(lseek(src, 1000, SEEK_SET) == 1000);
+    assert(lseek(dst, 0, SEEK_SET) == 0);
+    assert(ftruncate(dst, 0) == 0);
+    assert(pcom_send_file(job.fd, src, -1, 5000) == 5000);
+    assert(lseek(src, 0, SEEK_CUR) == 6000);
+    assert(pcom_client_send(job.fd, "tail", 4) == 4);
+    assert(pcom_recv_to_file(cfd, dst, -1, 5000) == 5000);
+    assert(lseek(dst, 0, SEEK_CUR) == 5000);
+    assert_same(src, 1000, dst, 0, 5000);
+    char buf[8];
+    assert(pcom_recv_exact(cfd, buf, 4) == 4 && memcmp(buf, "tail", 4) == 0);
+
+    // Short at end of file and when the peer closes
+    assert(pcom_send_file(job.fd, src, FILE_LEN - 10, 100) == 10);
+    pcom_client_close(job.fd);
+    assert(pcom_recv_to_file(cfd, dst, 0, 100) == 10);
+    assert_same(src, FILE_LEN - 10, dst, 0, 10);
+    pcom_client_close(cfd);
+    close(dst);
+    printf("✅ Test passed: Ranges at offsets and file positions, short at EOF\n");
+}
+
+static void
+test_fallbacks(int sfd, int src) {
+    char path[64], buf[8];
+    int pipefd[2], afd, cfd;
+
+    connect_pair(sfd, &afd, &cfd);
+
+    // Coalesced bytes go out before the file
+    assert(pcom_coalesce_enable(afd, 4096, 0) == 0);
+    assert(pcom_client_send(afd, "head", 4) == 4);
+    assert(pcom_send_file(afd, src, 0, 64) == 64);
+    assert(pcom_recv_exact(cfd, buf, 4) == 4 && memcmp(buf, "head", 4) == 0);
+
+    // splice() refuses O_APPEND files, copied instead
+    int dst = temp_file(path, O_APPEND);
+    unlink(path);
+    assert(pcom_recv_to_file(cfd, dst, -1, 64) == 64);
+    assert_same(src, 0, dst, 0, 64);
+    close(dst);
+
+    // sendfile() needs page cache, a pipe has none
+    assert(pipe(pipefd) == 0);
+    assert(write(pipefd[1], "from a pipe", 11) == 11);
+    close(pipefd[1]);
+    assert(pcom_send_file(afd, pipefd[0], -1, 100) == 11);
+    close(pipefd[0]);
+    assert(pcom_recv_exact(cfd, buf, 8) == 8 && memcmp(buf, "from a p", 8) == 0);
+
+    assert(pcom_send_file(afd, src, -2, 1) == -EINVAL);
+    assert(pcom_send_file(afd, -1, 0, 1) == -EBADF);
+    pcom_client_close(afd);
+    pcom_client_close(cfd);
+    printf("✅ Test passed: Coalesced bytes first, O_APPEND and pipe sources copied\n");
+}
+
+int main(void) {
+    char path[64];
+    int src = temp_file(path, 0);
+    unlink(path);
+    char* data = malloc(FILE_LEN);
+    srand(47);
+    for (size_t i = 0; i < FILE_LEN; ++i) data[i] = (char)rand();
+    assert(write(src, data, FILE_LEN) == FILE_LEN);
+    free(data);
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    test_transfer(sfd, src);
+    test_fallbacks(sfd, src);
+    pcom_server_close(sfd);
+    close(src);
+    return 0;
+}
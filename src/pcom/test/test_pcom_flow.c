@@ -0,0 +1,178 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include "../pcom_flow.h"
+
+#define TEST_NAME  "@pcomtest_flow"
+#define WINDOW     (16 * 1024)
+#define QUEUE_MAX  (64 * 1024)
+#define FRAME_LEN  (1000)
+#define TOTAL      (2000)
+
+typedef struct {
+    pcom_flow_t* p_flow;
+    int received;
+} consumer_t;
+
+static void*
+consumer(void* arg) {
+    consumer_t* p_c = arg;
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    for (int seq = 0; seq < TOTAL; ++seq) {
+        assert(pcom_flow_recv(p_c->p_flow, &hdr, &payload, 5000) == 1);
+        assert(hdr.type == PCOM_FRAME_DATA && hdr.len == FRAME_LEN);
+        int got;
+        memcpy(&got, payload, sizeof(got));
+        assert(got == seq);
+        p_c->received++;
+    }
+    return NULL;
+}
+
+static int
+send_seq(pcom_flow_t* p_flow, int seq) {
+    char data[FRAME_LEN] = { 0 };
+    pcom_frame_hdr_t hdr = { FRAME_LEN, PCOM_FRAME_DATA, 0, 0 };
+    memcpy(data, &seq, sizeof(seq));
+    return pcom_flow_send(p_flow, &hdr, data);
+}
+
+static void
+test_backpressure(void) {
+    pcom_flow_t *p_tx, *p_rx;
+    pcom_flow_stats_t st, rst;
+    pthread_t tid;
+    pcom_flow_opts_t tx_opts = { WINDOW, QUEUE_MAX, 8192, 8192 };
+    pcom_flow_opts_t rx_opts = { WINDOW, QUEUE_MAX, 8192, 8192 };
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(pcom_flow_create(&p_tx, cfd, &tx_opts) == 0);
+    assert(pcom_flow_create(&p_rx, afd, &rx_opts) == 0);
+
+    // Nobody reads: the queue fills up and then refuses
+    int seq = 0, result;
+    while ((result = send_seq(p_tx, seq)) >= 0) {
+        assert(result == 0 || result == PCOM_FLOW_WOULD_BLOCK);
+        ++seq;
+    }
+    assert(result == -ENOBUFS);
+    assert(pcom_flow_pending(p_tx) <= QUEUE_MAX);
+
+    // Only the advertised window leaves
+    size_t before = pcom_flow_pending(p_tx);
+    assert(pcom_flow_flush(p_tx, 50) == -ETIMEDOUT);
+    assert(pcom_flow_stats(p_tx, &st) == 0);
+    size_t moved = before - pcom_flow_pending(p_tx);
+    assert(moved > 0 && moved <= (WINDOW / FRAME_LEN) * (FRAME_LEN + PCOM_FRAME_HDR_SIZE));
+    assert(st.credit < FRAME_LEN && st.queue_full == 1);
+
+    // Reader drains, producer keeps up on credit
+    consumer_t c = { p_rx, 0 };
+    assert(pthread_create(&tid, NULL, consumer, &c) == 0);
+    while (seq < TOTAL) {
+        result = send_seq(p_tx, seq);
+        if (result == -ENOBUFS) {
+            result = pcom_flow_flush(p_tx, 10);
+            assert(result == 0 || result == -ETIMEDOUT);
+            continue;
+        }
+        assert(result >= 0);
+        assert(pcom_flow_pending(p_tx) <= QUEUE_MAX);
+        ++seq;
+    }
+    assert(pcom_flow_flush(p_tx, 5000) == 0);
+    pthread_join(tid, NULL);
+    assert(c.received == TOTAL);
+
+    assert(pcom_flow_stats(p_tx, &st) == 0);
+    assert(pcom_flow_stats(p_rx, &rst) == 0);
+    assert(st.queued == 0 && st.would_block > 0);
+    assert(rst.granted >= (unsigned long long)TOTAL * FRAME_LEN);
+
+    pcom_flow_destroy(p_tx);
+    pcom_flow_destroy(p_rx);
+    pcom_client_close(afd);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: %d frames over a %d byte window (%llu queued, %llu refused)\n",
+           TOTAL, WINDOW, st.would_block, st.queue_full);
+}
+
+static void
+test_window_violation(void) {
+    static char big[WINDOW + 1];
+    pcom_flow_t* p_rx;
+    pcom_frame_hdr_t hdr = { sizeof(big), PCOM_FRAME_DATA, 0, 0 };
+    const void* payload;
+    pcom_flow_opts_t opts = { WINDOW, 0, 0, 0 };
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(pcom_flow_create(&p_rx, afd, &opts) == 0);
+
+    // A peer ignoring the window is cut off
+    assert(pcom_frame_send(cfd, &hdr, big) == 0);
+    assert(pcom_flow_recv(p_rx, &hdr, &payload, 1000) == -EPROTO);
+
+    pcom_flow_destroy(p_rx);
+    pcom_client_close(afd);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Frame beyond the window rejected\n");
+}
+
+static void
+test_late_window(void) {
+    static char big[WINDOW + 1];
+    pcom_flow_t *p_tx, *p_rx;
+    pcom_frame_hdr_t hdr = { sizeof(big), PCOM_FRAME_DATA, 0, 0 };
+    const void* payload;
+    pcom_flow_opts_t opts = { WINDOW, QUEUE_MAX, 0, 0 };
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+
+    // Queued before the peer's window is known, one frame larger than it
+    assert(pcom_flow_create(&p_tx, cfd, &opts) == 0);
+    assert(pcom_flow_send(p_tx, &hdr, big) == PCOM_FLOW_WOULD_BLOCK);
+    hdr.len = 5;
+    assert(pcom_flow_send(p_tx, &hdr, "small") == PCOM_FLOW_WOULD_BLOCK);
+
+    // The window arrives: the big frame fails, the one behind it goes out
+    assert(pcom_flow_create(&p_rx, afd, &opts) == 0);
+    assert(pcom_flow_flush(p_tx, 1000) == -EMSGSIZE);
+    assert(pcom_flow_flush(p_tx, 1000) == 0);
+    assert(pcom_flow_recv(p_rx, &hdr, &payload, 1000) == 1);
+    assert(hdr.len == 5 && memcmp(payload, "small", 5) == 0);
+    assert(pcom_flow_send(NULL, &hdr, "x") == -EINVAL);
+
+    pcom_flow_destroy(p_tx);
+    pcom_flow_destroy(p_rx);
+    pcom_client_close(afd);
+    pcom_client_close(cfd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Queued frame beyond the late window fails, the queue goes on\n");
+}
+
+int main(void) {
+    test_backpressure();
+    test_window_violation();
+    test_late_window();
+    return 0;
+}
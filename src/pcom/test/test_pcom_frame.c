@@ -0,0 +1,86 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../pcom_frame.h"
+
+static void
+test_reassembly(void) {
+    pcom_frame_reader_t r;
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    uint8_t wire[64];
+
+    // Two frames back to back, fed one byte at a time
+    pcom_frame_hdr_t a = { 5, PCOM_FRAME_DATA, 0x12, 7 };
+    pcom_frame_hdr_t b = { 0, PCOM_FRAME_RPC, 0, 0xBEEF };
+    pcom_frame_encode(wire, &a);
+    memcpy(wire + PCOM_FRAME_HDR_SIZE, "hello", 5);
+    pcom_frame_encode(wire + PCOM_FRAME_HDR_SIZE + 5, &b);
+    size_t total = 2 * PCOM_FRAME_HDR_SIZE + 5;
+
+    pcom_frame_reader_init(&r);
+    int frames = 0;
+    for (size_t i = 0; i < total; ++i) {
+        assert(pcom_frame_reader_feed(&r, wire + i, 1) == 0);
+        while (pcom_frame_reader_next(&r, &hdr, &payload) == 1) {
+            if (frames++ == 0) {
+                assert(hdr.len == 5 && hdr.type == PCOM_FRAME_DATA && hdr.flags == 0x12 && hdr.channel == 7);
+                assert(memcmp(payload, "hello", 5) == 0);
+            } else {
+                assert(hdr.len == 0 && hdr.type == PCOM_FRAME_RPC && hdr.channel == 0xBEEF);
+            }
+        }
+    }
+    assert(frames == 2);
+
+    // Oversized length is rejected
+    pcom_frame_hdr_t big = { PCOM_FRAME_MAX + 1, PCOM_FRAME_DATA, 0, 0 };
+    pcom_frame_encode(wire, &big);
+    assert(pcom_frame_reader_feed(&r, wire, PCOM_FRAME_HDR_SIZE) == 0);
+    assert(pcom_frame_reader_next(&r, &hdr, &payload) < 0);
+    pcom_frame_reader_free(&r);
+    printf("✅ Test passed: Frames reassembled from single bytes\n");
+}
+
+static void
+test_send_recv(void) {
+    pcom_frame_reader_t r;
+    pcom_frame_hdr_t hdr;
+    const void* payload;
+    size_t big_len = 100000;
+    char* big = malloc(big_len);
+    for (size_t i = 0; i < big_len; ++i) big[i] = (char)i;
+
+    int sfd = pcom_server_open("@pcomtest_frame");
+    assert(sfd >= 0);
+    int cfd = pcom_client_open("@pcomtest_frame");
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+
+    pcom_frame_hdr_t small = { 3, PCOM_FRAME_DATA, 0, 1 };
+    pcom_frame_hdr_t large = { (uint32_t)big_len, PCOM_FRAME_DATA, 0, 2 };
+    assert(pcom_frame_send(cfd, &small, "abc") == 0);
+    assert(pcom_frame_send(cfd, &large, big) == 0);
+    pcom_client_close(cfd);
+
+    pcom_frame_reader_init(&r);
+    assert(pcom_frame_recv(afd, &r, &hdr, &payload) == 1);
+    assert(hdr.channel == 1 && hdr.len == 3 && memcmp(payload, "abc", 3) == 0);
+    assert(pcom_frame_recv(afd, &r, &hdr, &payload) == 1);
+    assert(hdr.channel == 2 && hdr.len == big_len && memcmp(payload, big, big_len) == 0);
+    assert(pcom_frame_recv(afd, &r, &hdr, &payload) == 0);
+    pcom_frame_reader_free(&r);
+
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    free(big);
+    printf("✅ Test passed: Blocking frame send/recv, small and large\n");
+}
+
+int main(void) {
+    test_reassembly();
+    test_send_recv();
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "../pcom_handshake.h"
+#include "../pcom_tcp.h"
+
+#define TEST_NAME "@pcomtest_handshake"
+
+typedef struct {
+    int sfd;
+    int count;           // Connections to accept
+    int results[2];
+    pcom_hs_peer_t peers[2];
+} server_t;
+
+static void*
+serve(void* arg) {
+    server_t* p_s = arg;
+    for (int i = 0; i < p_s->count; ++i) {
+        int h = pcom_server_accept(p_s->sfd);
+        assert(h >= 0);
+        p_s->results[i] = pcom_handshake_server(h, 1000, &p_s->peers[i]);
+        // Echo a byte so the client sees a working connection
+        char c;
+        if (p_s->results[i] == 0 && pcom_server_recv(h, &c, 1) == 1) pcom_server_send(h, &c, 1);
+        pcom_client_close(h);
+    }
+    return NULL;
+}
+
+static int
+run(int sfd, int count, const char* name, pcom_hs_peer_t* p_peer, server_t* p_s) {
+    pthread_t tid;
+    char c = 'x';
+    memset(p_s, 0, sizeof(*p_s));
+    p_s->sfd = sfd;
+    p_s->count = count;
+    assert(pthread_create(&tid, NULL, serve, p_s) == 0);
+    int h = pcom_handshake_open(name, 0, 1000, p_peer);
+    assert(h >= 0);
+    assert(pcom_client_send(h, &c, 1) == 1 && pcom_client_recv(h, &c, 1) == 1 && c == 'x');
+    pthread_join(tid, NULL);
+    return h;
+}
+
+static void
+test_unix(void) {
+    pcom_hs_peer_t peer;
+    server_t s;
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+
+    int h = run(sfd, 1, TEST_NAME, &peer, &s);
+    assert(s.results[0] == 0);
+    assert(peer.version == pcom_version() && peer.common == PCOM_CAP_BUILTIN);
+    assert(peer.transport == PCOM_TRANSPORT_UNIX && peer.same_host && peer.user_verified);
+    assert(peer.pid == getpid() && peer.uid == (int)getuid());
+
+    // The server has the check_user() result without asking again
+    assert(s.peers[0].user_verified && s.peers[0].pid == getpid());
+    assert(strcmp(s.peers[0].user.username, peer.user.username) == 0);
+    assert(s.peers[0].user.group_count > 0 && s.peers[0].user.is_admin == (getuid() == 0));
+    pcom_client_close(h);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: UNIX handshake with kernel credentials and check_user\n");
+}
+
+static void
+test_caps(void) {
+    pcom_hs_peer_t peer;
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        pcom_handshake_set_caps(PCOM_CAP_FRAME | PCOM_CAP_APP(1));
+        int h = pcom_handshake_open(TEST_NAME, 0, 1000, &peer);
+        _exit(h >= 0 && peer.common == (PCOM_CAP_FRAME | PCOM_CAP_APP(1)) ? 0 : 1);
+    }
+    pcom_handshake_set_caps(PCOM_CAP_BUILTIN | PCOM_CAP_APP(1) | PCOM_CAP_APP(2));
+    int h = pcom_server_accept(sfd);
+    assert(h >= 0);
+    assert(pcom_handshake_server(h, 1000, &peer) == 0);
+    assert(peer.caps == (PCOM_CAP_FRAME | PCOM_CAP_APP(1)));
+    assert(peer.common == (PCOM_CAP_FRAME | PCOM_CAP_APP(1)) && peer.pid == pid);
+
+    int status;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    pcom_handshake_set_caps(PCOM_CAP_BUILTIN);
+    pcom_client_close(h);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Capabilities intersected across processes\n");
+}
+
+static void
+test_tcp(void) {
+    pcom_tcp_opts_t o = PCOM_TCP_OPTS_DEFAULT;
+    pcom_hs_peer_t peer;
+    server_t s;
+    char name[64];
+
+    // No UNIX listener: stays on TCP, credentials as claimed
+    o.prefer_local = 0;
+    assert(pcom_tcp_set_opts(&o) == 0);
+    int sfd = pcom_server_open("tcp://127.0.0.1:0");
+    assert(sfd >= 0);
+    snprintf(name, sizeof(name), "tcp://127.0.0.1:%d", pcom_tcp_port(sfd));
+    int h = run(sfd, 1, name, &peer, &s);
+    assert(s.results[0] == 0);
+    assert(peer.transport == PCOM_TRANSPORT_TCP && peer.same_host && !peer.user_verified);
+    assert(s.peers[0].transport == PCOM_TRANSPORT_TCP && !s.peers[0].user_verified);
+    assert(s.peers[0].pid == getpid() && s.peers[0].user.is_admin == 0);
+    assert(strcmp(s.peers[0].user.username, peer.user.username) == 0);
+    pcom_client_close(h);
+    pcom_server_close(sfd);
+
+    // The server listens on its UNIX socket too, the client moves there.
+    // prefer_local is off on the client side, so it starts on TCP.
+    o.prefer_local = 1;
+    assert(pcom_tcp_set_opts(&o) == 0);
+    sfd = pcom_server_open("tcp://127.0.0.1:0");
+    assert(sfd >= 0 && pcom_tcp_local_handle(sfd) >= 0);
+    snprintf(name, sizeof(name), "tcp://127.0.0.1:%d", pcom_tcp_port(sfd));
+    o.prefer_local = 0;
+    assert(pcom_tcp_set_opts(&o) == 0);
+    h = run(sfd, 2, name, &peer, &s);
+    assert(s.results[0] == PCOM_HANDSHAKE_MOVED && s.peers[0].transport == PCOM_TRANSPORT_TCP);
+    assert(s.results[1] == 0 && s.peers[1].transport == PCOM_TRANSPORT_UNIX && s.peers[1].user_verified);
+    assert(peer.transport == PCOM_TRANSPORT_UNIX && peer.user_verified);
+    pcom_client_close(h);
+    pcom_server_close(sfd);
+    pcom_tcp_set_opts(NULL);
+    printf("✅ Test passed: TCP handshake, moved to the UNIX socket on the same host\n");
+}
+
+static void
+test_errors(void) {
+    pcom_hs_peer_t peer;
+    unsigned char hello[96] = { 'P', 'C', 'O', 'H', 96, 0 };
+    unsigned char reply[96];
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+
+    // Silent client
+    int c = pcom_client_open(TEST_NAME);
+    int h = pcom_server_accept(sfd);
+    assert(pcom_handshake_server(h, 50, &peer) == -ETIMEDOUT);
+    pcom_client_close(c);
+    pcom_client_close(h);
+
+    // Something else on the wire
+    c = pcom_client_open(TEST_NAME);
+    h = pcom_server_accept(sfd);
+    assert(pcom_client_send(c, "GET / HTTP/1.1\r\n", 16) == 16);
+    assert(pcom_handshake_server(h, 1000, &peer) == -EPROTO);
+    pcom_client_close(c);
+    pcom_client_close(h);
+
+    // Next major version: refused, but the client still gets the answer
+    hello[10] = (unsigned char)((pcom_version() >> 16) + 1);
+    c = pcom_client_open(TEST_NAME);
+    h = pcom_server_accept(sfd);
+    assert(pcom_client_send(c, hello, sizeof(hello)) == sizeof(hello));
+    assert(pcom_handshake_server(h, 1000, &peer) == -EPROTONOSUPPORT);
+    assert(peer.version == (((pcom_version() >> 16) + 1) << 16));
+    assert(pcom_recv_exact(c, reply, sizeof(reply)) == sizeof(reply) && memcmp(reply, "PCOH", 4) == 0);
+    pcom_client_close(c);
+    pcom_client_close(h);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Timeout, foreign protocol and major version refused\n");
+}
+
+int main(void) {
+    test_unix();
+    test_caps();
+    test_tcp();
+    test_errors();
+    return 0;
+}
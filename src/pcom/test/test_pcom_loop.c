@@ -0,0 +1,153 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "../pcom_loop.h"
+
+#define TEST_NAME "pcomtest_loop"
+
+/* Client: send a request, expect the three echoed parts in order, hang up */
+static int
+run_client(void) {
+    char buf[64] = {0};
+    size_t got = 0;
+    int fd = pcom_client_open(TEST_NAME);
+    if (fd < 0) return 1;
+    if (pcom_client_send(fd, "Hello", 5) != 5) return 2;
+    while (got < 9) {
+        int r = pcom_client_recv(fd, buf + got, sizeof(buf) - got);
+        if (r <= 0) return 3;
+        got += (size_t)r;
+    }
+    pcom_client_close(fd);
+    return memcmp(buf, "one;two;3", 9) == 0 ? 0 : 4;
+}
+
+static void
+test_backend(int flags, int expected_backend) {
+    pcom_loop_t* p_loop;
+    pcom_event_t ev[16];
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+
+    assert(pcom_loop_create(&p_loop, sfd, flags) == 0);
+    if (expected_backend) assert(pcom_loop_backend(p_loop) == expected_backend);
+
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) _exit(run_client());
+
+    int client = -1, sends = 0, eof = 0;
+    while (!eof) {
+        int n = pcom_loop_wait(p_loop, ev, 16, 5000);
+        assert(n > 0);
+        for (int i = 0; i < n; ++i) {
+            switch (ev[i].type) {
+            case PCOM_EVENT_ACCEPT:
+                assert(ev[i].result == 0);
+                client = ev[i].handle;
+                assert(pcom_loop_add(p_loop, client) == 0);
+                break;
+            case PCOM_EVENT_RECV:
+                assert(ev[i].handle == client);
+                if (ev[i].result == 0) { eof = 1; break; }
+                assert(ev[i].result == 5 && memcmp(ev[i].data, "Hello", 5) == 0);
+                assert(ev[i].buf_id >= 0);
+                pcom_loop_release(p_loop, &ev[i]);
+                // Three sends gathered into one syscall, in order
+                assert(pcom_loop_send(p_loop, client, "one;", 4, (void*)1) == 0);
+                assert(pcom_loop_send(p_loop, client, "two;", 4, (void*)2) == 0);
+                assert(pcom_loop_send(p_loop, client, "3", 1, (void*)3) == 0);
+                break;
+            case PCOM_EVENT_SEND:
+                assert(ev[i].user == (void*)(long)(sends + 1));
+                assert(ev[i].result == (sends < 2 ? 4 : 1));
+                ++sends;
+                break;
+            }
+        }
+    }
+    assert(sends == 3);
+
+    int status;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    assert(pcom_loop_remove(p_loop, client) == 0);
+    pcom_client_close(client);
+    pcom_loop_destroy(p_loop);
+    pcom_server_close(sfd);
+}
+
+/* Out of handles the accept fails, once handles are free again it succeeds */
+static void
+test_accept_emfile(int flags) {
+    pcom_loop_t* p_loop;
+    pcom_event_t ev[16];
+    struct rlimit old, low;
+    int fill[64], n_fill = 0, failed = 0, accepted = 0;
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0 && pcom_loop_create(&p_loop, sfd, flags) == 0);
+    int c1 = pcom_client_open(TEST_NAME);
+    assert(c1 >= 0);
+
+    // No handle left for the accepted client
+    assert(getrlimit(RLIMIT_NOFILE, &old) == 0);
+    low = old;
+    low.rlim_cur = (rlim_t)(dup(0) + 1);
+    close((int)low.rlim_cur - 1);
+    assert(setrlimit(RLIMIT_NOFILE, &low) == 0);
+    while (n_fill < 64 && (fill[n_fill] = dup(0)) >= 0) ++n_fill;
+    assert(n_fill < 64 && errno == EMFILE);
+
+    while (!failed) {
+        int n = pcom_loop_wait(p_loop, ev, 16, 5000);
+        assert(n > 0);
+        for (int i = 0; i < n; ++i) {
+            assert(ev[i].type == PCOM_EVENT_ACCEPT && ev[i].result == -EMFILE);
+            failed = 1;
+        }
+    }
+    // The listener pauses instead of failing again on every wait
+    assert(pcom_loop_wait(p_loop, ev, 16, 20) == 0);
+
+    while (n_fill > 0) close(fill[--n_fill]);
+    assert(setrlimit(RLIMIT_NOFILE, &old) == 0);
+    int c2 = pcom_client_open(TEST_NAME);
+    assert(c2 >= 0);
+    // The io_uring backend retries after a pause, a wait may end on it alone
+    for (int waits = 0; accepted < 2; ++waits) {
+        assert(waits < 20);
+        int n = pcom_loop_wait(p_loop, ev, 16, 5000);
+        for (int i = 0; i < n; ++i) {
+            assert(ev[i].type == PCOM_EVENT_ACCEPT);
+            if (ev[i].result == -EMFILE) continue;
+            assert(ev[i].result == 0 && ev[i].handle >= 0);
+            pcom_client_close(ev[i].handle);
+            ++accepted;
+        }
+    }
+
+    pcom_client_close(c1);
+    pcom_client_close(c2);
+    pcom_loop_destroy(p_loop);
+    pcom_server_close(sfd);
+}
+
+int main(void) {
+    test_backend(PCOM_LOOP_EPOLL, PCOM_LOOP_BACKEND_EPOLL);
+    printf("✅ Test passed: epoll backend accept, recv, gathered send, EOF\n");
+
+    test_backend(PCOM_LOOP_DEFAULT, 0);
+    printf("✅ Test passed: default backend (%s) accept, recv, gathered send, EOF\n",
+           "io_uring or epoll fallback");
+
+    test_accept_emfile(PCOM_LOOP_EPOLL);
+    test_accept_emfile(PCOM_LOOP_DEFAULT);
+    printf("✅ Test passed: Accepting goes on after running out of handles\n");
+    return 0;
+}
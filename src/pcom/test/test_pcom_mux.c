@@ -0,0 +1,218 @@
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "../pcom_mux.h"
+
+#define TEST_NAME "@pcomtest_mux"
+#define BULK_LEN  (32 * 1024 * 1024)
+#define CONTROLS  (10)
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int messages;
+    int controls;             // Control messages received
+    int controls_at_bulk;     // ... when the bulk message completed
+    int bulk_ok;
+    int closed;
+    int bulk_done;
+    int tail_ok;              // Small message on the bulk channel, after the bulk one
+} sink_t;
+
+static void
+on_message(pcom_mux_t* p_mux, uint16_t channel, const void* data, size_t len, void* user) {
+    sink_t* p_s = user;
+    const uint8_t* p = data;
+    (void)p_mux;
+
+    pthread_mutex_lock(&p_s->lock);
+    if (channel == 0) {
+        assert(len == sizeof(int));
+        int seq;
+        memcpy(&seq, data, sizeof(seq));
+        assert(seq == p_s->controls);
+        p_s->controls++;
+    } else if (channel == 1 && len != BULK_LEN) {
+        p_s->tail_ok = p_s->bulk_done && len == 4 && memcmp(data, "tail", 4) == 0;
+    } else if (channel == 1) {
+        p_s->bulk_done = 1;
+        p_s->controls_at_bulk = p_s->controls;
+        p_s->bulk_ok = (len == BULK_LEN);
+        for (size_t i = 0; i < len && p_s->bulk_ok; i += 4093) p_s->bulk_ok = (p[i] == (uint8_t)(i * 13));
+    } else {
+        // Echo test: channel N carries N * 1000 + 1 bytes of N
+        assert(len == (size_t)channel * 1000 + 1);
+        for (size_t i = 0; i < len; ++i) assert(p[i] == (uint8_t)channel);
+    }
+    p_s->messages++;
+    pthread_cond_broadcast(&p_s->cond);
+    pthread_mutex_unlock(&p_s->lock);
+}
+
+static void
+on_close(pcom_mux_t* p_mux, int status, void* user) {
+    sink_t* p_s = user;
+    (void)p_mux; (void)status;
+    pthread_mutex_lock(&p_s->lock);
+    p_s->closed = 1;
+    pthread_cond_broadcast(&p_s->cond);
+    pthread_mutex_unlock(&p_s->lock);
+}
+
+static void
+wait_messages(sink_t* p_s, int count) {
+    pthread_mutex_lock(&p_s->lock);
+    while (p_s->messages < count) pthread_cond_wait(&p_s->cond, &p_s->lock);
+    pthread_mutex_unlock(&p_s->lock);
+}
+
+static void
+open_pair(pcom_mux_t** pp_tx, pcom_mux_t** pp_rx, sink_t* p_sink, size_t chunk) {
+    pcom_mux_opts_t tx_opts = { NULL, NULL, NULL, chunk, 0 };
+    pcom_mux_opts_t rx_opts = { on_message, on_close, p_sink, chunk, 0 };
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    pcom_server_close(sfd);
+    assert(pcom_set_bufsize(cfd, 64 * 1024, 0) == 0);
+    assert(pcom_set_bufsize(afd, 0, 64 * 1024) == 0);
+    assert(pcom_mux_create(pp_tx, cfd, &tx_opts) == 0);
+    assert(pcom_mux_create(pp_rx, afd, &rx_opts) == 0);
+}
+
+static void
+test_channels(void) {
+    pcom_mux_t *p_tx, *p_rx;
+    sink_t sink = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, 0, 0, 0 };
+    static uint8_t buf[8 * 1000 + 1];
+
+    open_pair(&p_tx, &p_rx, &sink, 1024);
+    for (int ch = 2; ch <= 8; ++ch) {
+        memset(buf, ch, sizeof(buf));
+        assert(pcom_mux_send(p_tx, (uint16_t)ch, buf, (size_t)ch * 1000 + 1) == 0);
+    }
+    wait_messages(&sink, 7);
+
+    pcom_mux_stats_t st;
+    assert(pcom_mux_stats(p_tx, &st) == 0);
+    assert(st.messages == 7 && st.preempted == 0);
+    pcom_mux_destroy(p_tx);
+    pthread_mutex_lock(&sink.lock);
+    while (!sink.closed) pthread_cond_wait(&sink.cond, &sink.lock);
+    pthread_mutex_unlock(&sink.lock);
+    pcom_mux_destroy(p_rx);
+    printf("✅ Test passed: Messages on 7 channels reassembled from %llu chunks\n", st.frames);
+}
+
+typedef struct {
+    pcom_mux_t* p_mux;
+    uint8_t* data;
+} bulk_t;
+
+static void*
+bulk_sender(void* arg) {
+    bulk_t* p_b = arg;
+    assert(pcom_mux_send(p_b->p_mux, 1, p_b->data, BULK_LEN) == 0);
+    return NULL;
+}
+
+static double
+now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void
+test_priority(void) {
+    pcom_mux_t *p_tx, *p_rx;
+    pcom_mux_stats_t st;
+    pthread_t tid;
+    sink_t sink = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, 0, 0, 0 };
+    bulk_t bulk;
+
+    bulk.data = malloc(BULK_LEN);
+    assert(bulk.data);
+    for (size_t i = 0; i < BULK_LEN; ++i) bulk.data[i] = (uint8_t)(i * 13);
+
+    open_pair(&p_tx, &p_rx, &sink, 0);
+    bulk.p_mux = p_tx;
+    assert(pcom_mux_set_priority(p_tx, 0, 0) == 0);
+    assert(pcom_mux_set_priority(p_tx, 1, PCOM_MUX_PRIORITIES - 1) == 0);
+    assert(pcom_mux_set_priority(p_tx, 1, PCOM_MUX_PRIORITIES) < 0);
+    assert(pthread_create(&tid, NULL, bulk_sender, &bulk) == 0);
+
+    // Control messages while the bulk transfer is under way
+    do {
+        usleep(100);
+        assert(pcom_mux_stats(p_tx, &st) == 0);
+    } while (st.frames == 0);
+    double worst = 0;
+    for (int i = 0; i < CONTROLS; ++i) {
+        double t0 = now_us();
+        assert(pcom_mux_send(p_tx, 0, &i, sizeof(i)) == 0);
+        if (now_us() - t0 > worst) worst = now_us() - t0;
+    }
+    pthread_join(tid, NULL);
+    wait_messages(&sink, CONTROLS + 1);
+
+    assert(sink.bulk_ok);
+    assert(sink.controls == CONTROLS && sink.controls_at_bulk == CONTROLS);
+    assert(pcom_mux_stats(p_tx, &st) == 0);
+    assert(st.preempted >= 1 && st.messages == CONTROLS + 1);
+
+    pcom_mux_destroy(p_tx);
+    pcom_mux_destroy(p_rx);
+    free(bulk.data);
+    printf("✅ Test passed: %d control messages overtook a %d MiB transfer (worst send %.0f us)\n",
+           CONTROLS, BULK_LEN >> 20, worst);
+}
+
+static void
+test_priority_change(void) {
+    pcom_mux_t *p_tx, *p_rx;
+    pcom_mux_stats_t st;
+    pthread_t tid;
+    sink_t sink = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, 0, 0, 0 };
+    bulk_t bulk;
+
+    bulk.data = malloc(BULK_LEN);
+    assert(bulk.data);
+    for (size_t i = 0; i < BULK_LEN; ++i) bulk.data[i] = (uint8_t)(i * 13);
+
+    open_pair(&p_tx, &p_rx, &sink, 0);
+    bulk.p_mux = p_tx;
+    assert(pcom_mux_set_priority(p_tx, 1, PCOM_MUX_PRIORITIES - 1) == 0);
+    assert(pthread_create(&tid, NULL, bulk_sender, &bulk) == 0);
+    do {
+        usleep(100);
+        assert(pcom_mux_stats(p_tx, &st) == 0);
+    } while (st.frames == 0);
+
+    // Raised mid transfer, the next message of the channel still waits for it
+    assert(pcom_mux_set_priority(p_tx, 1, 0) == 0);
+    assert(pcom_mux_send(p_tx, 1, "tail", 4) == 0);
+    pthread_join(tid, NULL);
+    wait_messages(&sink, 2);
+    assert(sink.bulk_ok && sink.tail_ok);
+
+    pcom_mux_destroy(p_tx);
+    pcom_mux_destroy(p_rx);
+    free(bulk.data);
+    printf("✅ Test passed: Priority change during a transfer keeps the channel in order\n");
+}
+
+int main(void) {
+    test_channels();
+    test_priority();
+    test_priority_change();
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../pcom_pool.h"
+#include "../pcom_loop.h"
+
+#define TEST_NAME "@pcomtest_pool"
+
+static int connects;
+
+static int
+on_connect(pcom_server_pool_t* p_pool, int handle, void* user)
+{
+    (void)p_pool; (void)handle; (void)user;
+    __atomic_fetch_add(&connects, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/* Echo everything back */
+static int
+on_data(pcom_server_pool_t* p_pool, int handle, const void* data, size_t len, void* user)
+{
+    (void)user;
+    return pcom_server_pool_send(p_pool, handle, data, len);
+}
+
+static int
+echo(int fd, const char* msg)
+{
+    char buf[256];
+    size_t len = strlen(msg), got = 0;
+    if (pcom_client_send(fd, msg, len) != (int)len) return -1;
+    while (got < len) {
+        int r = pcom_client_recv(fd, buf + got, sizeof(buf) - got);
+        if (r <= 0) return -1;
+        got += (size_t)r;
+    }
+    return memcmp(buf, msg, len) == 0 ? 0 : -1;
+}
+
+static void*
+client_main(void* arg)
+{
+    char msg[64];
+    long id = (long)arg;
+    int fd = pcom_client_open(TEST_NAME);
+    assert(fd >= 0);
+    for (int i = 0; i < 200; ++i) {
+        snprintf(msg, sizeof(msg), "client %ld message %d", id, i);
+        assert(echo(fd, msg) == 0);
+    }
+    pcom_client_close(fd);
+    return NULL;
+}
+
+static void
+totals(pcom_server_pool_t* p_pool, pcom_pool_stats_t* p_sum)
+{
+    pcom_pool_stats_t st;
+    memset(p_sum, 0, sizeof(*p_sum));
+    for (int i = 0; i < pcom_server_pool_workers(p_pool); ++i) {
+        assert(pcom_server_pool_stats(p_pool, i, &st) == 0);
+        p_sum->connections += st.connections;
+        p_sum->bytes_in += st.bytes_in;
+        p_sum->bytes_out += st.bytes_out;
+        p_sum->stolen += st.stolen;
+        p_sum->donated += st.donated;
+    }
+}
+
+static void
+test_echo(void)
+{
+    pcom_server_pool_t* p_pool;
+    pcom_pool_handlers_t h = { on_connect, on_data, NULL, NULL };
+    pcom_pool_stats_t sum;
+    pthread_t clients[8];
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    assert(pcom_server_pool_create(&p_pool, sfd, 4, &h, PCOM_LOOP_DEFAULT) == 0);
+    assert(pcom_server_pool_workers(p_pool) == 4);
+
+    for (long i = 0; i < 8; ++i) pthread_create(&clients[i], NULL, client_main, (void*)i);
+    for (int i = 0; i < 8; ++i) pthread_join(clients[i], NULL);
+
+    // Replies are counted when their send completes
+    for (int i = 0; i < 100; ++i) {
+        totals(p_pool, &sum);
+        if (sum.bytes_out == sum.bytes_in && sum.connections == 0) break;
+        usleep(10000);
+    }
+    assert(__atomic_load_n(&connects, __ATOMIC_RELAXED) == 8);
+    assert(sum.bytes_in > 0 && sum.bytes_out == sum.bytes_in);
+    assert(sum.connections == 0);
+
+    pcom_server_pool_destroy(p_pool);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: 8 clients echoed through 4 workers\n");
+}
+
+static void
+test_steal(void)
+{
+    pcom_server_pool_t* p_pool;
+    pcom_pool_handlers_t h = { on_connect, on_data, NULL, NULL };
+    pcom_pool_stats_t sum;
+
+    connects = 0;
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    assert(pcom_server_pool_create(&p_pool, sfd, 2, &h, PCOM_LOOP_DEFAULT) == 0);
+
+    // Placement alternates: hot and cold share worker 0, other sits alone on 1
+    int hot = pcom_client_open(TEST_NAME);
+    assert(hot >= 0 && echo(hot, "hot") == 0);
+    int other = pcom_client_open(TEST_NAME);
+    assert(other >= 0 && echo(other, "other") == 0);
+    int cold = pcom_client_open(TEST_NAME);
+    assert(cold >= 0 && echo(cold, "cold") == 0);
+
+    // Worker 1 goes idle and takes the cold client, the hot one stays put
+    pcom_client_close(other);
+    for (int i = 0; i < 5000; ++i) {
+        assert(echo(hot, "busy busy busy") == 0);
+        totals(p_pool, &sum);
+        if (sum.stolen > 0) break;
+        usleep(1000);
+    }
+    assert(sum.stolen >= 1 && sum.stolen == sum.donated);
+
+    // The migrated client keeps working without a second on_connect
+    assert(echo(cold, "still there") == 0);
+    assert(echo(hot, "and here") == 0);
+    assert(__atomic_load_n(&connects, __ATOMIC_RELAXED) == 3);
+
+    pcom_client_close(hot);
+    pcom_client_close(cold);
+    pcom_server_pool_destroy(p_pool);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: idle worker stole the cold connection\n");
+}
+
+int main(void) {
+    test_echo();
+    test_steal();
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <poll.h>
+#include "../pcom_pubsub.h"
+
+#define TEST_NAME "@pcomtest_pubsub"
+
+/* Next message that is not a sync probe */
+static int
+next_msg(int fd, pcom_frame_reader_t* p_r, pcom_pubsub_msg_t* p_msg)
+{
+    int result;
+    while ((result = pcom_pubsub_recv(fd, p_r, p_msg)) > 0)
+        if (p_msg->topic_len < 5 || memcmp(p_msg->topic, "sync.", 5) != 0) break;
+    return result;
+}
+
+/* Wait until the broker has seen the subscriptions sent on fd */
+static void
+sync_sub(pcom_broker_t* p_b, int fd, pcom_frame_reader_t* p_r, int id)
+{
+    char topic[32];
+    pcom_pubsub_msg_t msg;
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    snprintf(topic, sizeof(topic), "sync.%d", id);
+    assert(pcom_pubsub_subscribe(fd, topic, PCOM_PUBSUB_DEFAULT) == 0);
+    do assert(pcom_pubsub_publish(p_b, topic, 0, NULL, 0) == 0);
+    while (p_r->len == p_r->start && poll(&pfd, 1, 20) == 0);
+    assert(pcom_pubsub_recv(fd, p_r, &msg) == 1);
+    assert(msg.topic_len == strlen(topic) && memcmp(msg.topic, topic, msg.topic_len) == 0);
+}
+
+static void
+test_fan_out(void) {
+    pcom_broker_t* p_b;
+    pcom_pubsub_stats_t st;
+    pcom_pubsub_msg_t msg;
+    pcom_frame_reader_t r[3];
+    int fd[3];
+    char data[32];
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    assert(pcom_pubsub_create(&p_b, sfd, NULL) == 0);
+
+    const char* topics[3] = { "", "market.", "telemetry." };
+    for (int i = 0; i < 3; ++i) {
+        fd[i] = pcom_client_open(TEST_NAME);
+        assert(fd[i] >= 0);
+        pcom_frame_reader_init(&r[i]);
+        assert(pcom_pubsub_subscribe(fd[i], topics[i], PCOM_PUBSUB_DEFAULT) == 0);
+        sync_sub(p_b, fd[i], &r[i], i);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        snprintf(data, sizeof(data), "%d", i);
+        assert(pcom_pubsub_publish(p_b, "market.AAPL", 1, data, strlen(data)) == 0);
+        assert(pcom_pubsub_publish(p_b, "telemetry.cpu", 2, data, strlen(data)) == 0);
+    }
+
+    // Everything in order on the catch-all, one topic each on the others
+    for (int i = 0; i < 200; ++i) {
+        assert(next_msg(fd[0], &r[0], &msg) == 1);
+        snprintf(data, sizeof(data), "%d", i / 2);
+        assert(msg.len == strlen(data) && memcmp(msg.data, data, msg.len) == 0);
+        assert(msg.key == (uint64_t)(i % 2 + 1));
+    }
+    for (int s = 1; s < 3; ++s) {
+        for (int i = 0; i < 100; ++i) {
+            assert(next_msg(fd[s], &r[s], &msg) == 1);
+            assert(msg.topic_len > strlen(topics[s]) && memcmp(msg.topic, topics[s], strlen(topics[s])) == 0);
+            snprintf(data, sizeof(data), "%d", i);
+            assert(msg.len == strlen(data) && memcmp(msg.data, data, msg.len) == 0);
+        }
+    }
+
+    assert(pcom_pubsub_stats(p_b, &st) == 0);
+    assert(st.subscribers == 3 && st.dropped == 0 && st.disconnected == 0);
+    for (int i = 0; i < 3; ++i) {
+        pcom_frame_reader_free(&r[i]);
+        pcom_client_close(fd[i]);
+    }
+    pcom_pubsub_destroy(p_b);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Fan-out by topic prefix, in order\n");
+}
+
+#define SLOW_MSGS (2000)
+#define SLOW_SIZE (16 * 1024)
+
+static void
+test_slow_consumers(void) {
+    static char data[SLOW_SIZE];
+    pcom_broker_t* p_b;
+    pcom_pubsub_stats_t st;
+    pcom_pubsub_msg_t msg;
+    pcom_frame_reader_t r[4];
+    int fd[4], result;
+    pcom_pubsub_opts_t opts = { 8, PCOM_PUBSUB_DROP_OLDEST };
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    assert(pcom_pubsub_create(&p_b, sfd, &opts) == 0);
+
+    // 0 reads along, 1..3 stall with each policy
+    const int policy[4] = { PCOM_PUBSUB_DEFAULT, PCOM_PUBSUB_DROP_OLDEST,
+                            PCOM_PUBSUB_DISCONNECT, PCOM_PUBSUB_CONFLATE };
+    for (int i = 0; i < 4; ++i) {
+        fd[i] = pcom_client_open(TEST_NAME);
+        assert(fd[i] >= 0);
+        pcom_frame_reader_init(&r[i]);
+        assert(pcom_pubsub_subscribe(fd[i], "feed", policy[i]) == 0);
+        sync_sub(p_b, fd[i], &r[i], i);
+    }
+
+    for (int i = 0; i < SLOW_MSGS; ++i) {
+        memcpy(data, &i, sizeof(i));
+        assert(pcom_pubsub_publish(p_b, "feed", (uint64_t)(i % 4), data, sizeof(data)) == 0);
+        if (i % 16 == 0) {
+            // Keep the reader drained so only the stalled ones fall behind
+            while (r[0].len == r[0].start) {
+                struct pollfd pfd = { .fd = fd[0], .events = POLLIN };
+                if (poll(&pfd, 1, 0) == 0) break;
+                assert(pcom_pubsub_recv(fd[0], &r[0], &msg) == 1);
+            }
+        }
+    }
+    int last = -1;
+    while (last != SLOW_MSGS - 1) {
+        assert(next_msg(fd[0], &r[0], &msg) == 1);
+        memcpy(&last, msg.data, sizeof(last));
+    }
+
+    assert(pcom_pubsub_stats(p_b, &st) == 0);
+    assert(st.dropped > 0 && st.conflated > 0 && st.disconnected == 1);
+
+    // Drop oldest: increasing, gaps allowed, newest arrives
+    int prev = -1;
+    while (prev != SLOW_MSGS - 1) {
+        assert(next_msg(fd[1], &r[1], &msg) == 1);
+        int seq;
+        memcpy(&seq, msg.data, sizeof(seq));
+        assert(seq > prev);
+        prev = seq;
+    }
+
+    // Disconnect: whatever was in flight, then EOF
+    while ((result = next_msg(fd[2], &r[2], &msg)) == 1) {}
+    assert(result == 0 || result == -EPIPE || result == -ECONNRESET);
+
+    // Conflate: latest value per key survives
+    int latest[4] = { -1, -1, -1, -1 };
+    while (latest[0] != SLOW_MSGS - 4 || latest[1] != SLOW_MSGS - 3 ||
+           latest[2] != SLOW_MSGS - 2 || latest[3] != SLOW_MSGS - 1) {
+        assert(next_msg(fd[3], &r[3], &msg) == 1);
+        int seq;
+        memcpy(&seq, msg.data, sizeof(seq));
+        assert(msg.key == (uint64_t)(seq % 4) && seq > latest[seq % 4]);
+        latest[seq % 4] = seq;
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        pcom_frame_reader_free(&r[i]);
+        pcom_client_close(fd[i]);
+    }
+    pcom_pubsub_destroy(p_b);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Slow consumers (%llu dropped, %llu conflated, 1 disconnected)\n",
+           st.dropped, st.conflated);
+}
+
+int main(void) {
+    test_fan_out();
+    test_slow_consumers();
+    return 0;
+}
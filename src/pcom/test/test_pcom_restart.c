@@ -0,0 +1,119 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../pcom_restart.h"
+#include "../pcom_tcp.h"
+
+#define TEST_NAME "@pcomtest_restart"
+#define CTL_NAME  "@pcomtest_restart_ctl"
+#define CONNS     (300)          // More than one batch
+
+static void
+echo(int h) {
+    char c;
+    assert(pcom_recv_exact(h, &c, 1) == 1 && pcom_send_all(h, &c, 1) == 1);
+}
+
+static void
+assert_echo(int h, char c) {
+    char r = 0;
+    assert(pcom_send_all(h, &c, 1) == 1 && pcom_recv_exact(h, &r, 1) == 1 && r == c);
+}
+
+/** The new process: take over, serve the passed and one new client, restart-ready itself */
+static int
+successor(int give_up) {
+    pcom_restart_t rs;
+    int conns[CONNS];
+
+    if (pcom_restart_takeover(CTL_NAME, &rs, conns, CONNS, 2000) != 0) return 1;
+    if (rs.server_count != 2 || rs.conn_count != CONNS || rs.listen < 0) return 2;
+    if (pcom_tcp_local_handle(rs.servers[1]) < 0) return 3;
+    if (give_up) {
+        for (int i = 0; i < CONNS; ++i) pcom_client_close(conns[i]);
+        for (int i = 0; i < 2; ++i) pcom_server_close(rs.servers[i]);
+        pcom_server_close(rs.listen);
+        pcom_client_close(rs.control);
+        return 0;
+    }
+    if (pcom_restart_ready(&rs) != 0) return 4;
+
+    for (int i = 0; i < CONNS; ++i) echo(conns[i]);
+    int h = pcom_server_accept(rs.servers[0]);
+    if (h < 0) return 5;
+    echo(h);
+    pcom_client_close(h);
+    for (int i = 0; i < CONNS; ++i) pcom_client_close(conns[i]);
+    for (int i = 0; i < 2; ++i) pcom_server_close(rs.servers[i]);
+    pcom_server_close(rs.listen);
+    return 0;
+}
+
+static pid_t
+spawn(int give_up) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) _exit(successor(give_up));
+    return pid;
+}
+
+static void
+assert_exit(pid_t pid) {
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+int main(void) {
+    int clients[CONNS], accepted[CONNS];
+    pcom_restart_t rs;
+
+    // First start, nobody to take over from
+    assert(pcom_restart_takeover(CTL_NAME, &rs, NULL, 0, 100) == -ECONNREFUSED);
+
+    int servers[2];
+    servers[0] = pcom_server_open(TEST_NAME);
+    servers[1] = pcom_server_open("tcp://127.0.0.1:0");
+    int ctl = pcom_restart_listen(CTL_NAME);
+    assert(servers[0] >= 0 && servers[1] >= 0 && ctl >= 0);
+    assert(pcom_tcp_local_handle(servers[1]) >= 0);
+    for (int i = 0; i < CONNS; ++i) {
+        clients[i] = pcom_client_open(TEST_NAME);
+        accepted[i] = pcom_server_accept(servers[0]);
+        assert(clients[i] >= 0 && accepted[i] >= 0);
+    }
+    assert(pcom_restart_handoff(ctl, servers, 2, accepted, CONNS, 50) == -ETIMEDOUT);
+
+    // A successor that gives up changes nothing
+    pid_t pid = spawn(1);
+    assert(pcom_restart_handoff(ctl, servers, 2, accepted, CONNS, 2000) == -ECONNABORTED);
+    assert_exit(pid);
+    int c = pcom_client_open(TEST_NAME);
+    int h = pcom_server_accept(servers[0]);
+    char b;
+    assert(pcom_send_all(c, "a", 1) == 1 && pcom_recv_exact(h, &b, 1) == 1 && b == 'a');
+    pcom_client_close(c);
+    pcom_client_close(h);
+    printf("✅ Test passed: No predecessor, timeout, successor giving up\n");
+
+    // The real restart
+    pid = spawn(0);
+    assert(pcom_restart_handoff(ctl, servers, 2, accepted, CONNS, 2000) == CONNS);
+    pcom_server_close(ctl);
+    for (int i = 0; i < 2; ++i) pcom_server_close(servers[i]);
+    for (int i = 0; i < CONNS; ++i) pcom_client_close(accepted[i]);
+
+    // The old process is out, connections and the listener are still there
+    for (int i = 0; i < CONNS; ++i) assert_echo(clients[i], (char)i);
+    c = pcom_client_open(TEST_NAME);
+    assert(c >= 0);
+    assert_echo(c, 'z');
+    pcom_client_close(c);
+    for (int i = 0; i < CONNS; ++i) pcom_client_close(clients[i]);
+    assert_exit(pid);
+    printf("✅ Test passed: Listeners and %d connections handed to a new process\n", CONNS);
+    return 0;
+}
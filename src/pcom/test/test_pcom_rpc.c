@@ -0,0 +1,175 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../pcom_rpc.h"
+
+#define TEST_NAME "@pcomtest_rpc"
+
+#define M_ECHO     (1)  // Reply at once with the request body
+#define M_HELD     (2)  // Held until HELD_COUNT arrive, answered newest first
+#define M_SILENT   (4)  // Never answered
+#define HELD_COUNT (4)
+
+static pcom_rpc_req_t held[HELD_COUNT];
+static char held_body[HELD_COUNT][16];
+static int held_count;
+
+static int
+on_echo(pcom_rpc_server_t* p_srv, const pcom_rpc_req_t* p_req, const void* data, size_t len, void* user)
+{
+    (void)user;
+    return pcom_rpc_reply(p_srv, p_req, 7, data, len);
+}
+
+static int
+on_held(pcom_rpc_server_t* p_srv, const pcom_rpc_req_t* p_req, const void* data, size_t len, void* user)
+{
+    (void)user;
+    held[held_count] = *p_req;
+    memcpy(held_body[held_count], data, len);
+    if (++held_count < HELD_COUNT) return 0;
+    for (int i = HELD_COUNT - 1; i >= 0; --i)
+        if (pcom_rpc_reply(p_srv, &held[i], i, held_body[i], strlen(held_body[i])) < 0) return -1;
+    held_count = 0;
+    return 0;
+}
+
+static int
+on_silent(pcom_rpc_server_t* p_srv, const pcom_rpc_req_t* p_req, const void* data, size_t len, void* user)
+{
+    (void)p_srv; (void)p_req; (void)data; (void)len; (void)user;
+    return 0;
+}
+
+/* Blocking server: read whatever arrives and feed it */
+static void*
+server_main(void* arg)
+{
+    int afd = pcom_server_accept(*(int*)arg);
+    char buf[8192];
+    pcom_rpc_server_t* p_srv;
+
+    assert(afd >= 0);
+    assert(pcom_rpc_server_create(&p_srv, NULL, NULL) == 0);
+    assert(pcom_rpc_server_register(p_srv, M_ECHO, on_echo, NULL) == 0);
+    assert(pcom_rpc_server_register(p_srv, M_HELD, on_held, NULL) == 0);
+    assert(pcom_rpc_server_register(p_srv, M_SILENT, on_silent, NULL) == 0);
+    for (;;) {
+        int n = pcom_server_recv(afd, buf, sizeof(buf));
+        if (n <= 0) break;
+        assert(pcom_rpc_server_feed(p_srv, afd, buf, (size_t)n) >= 0);
+    }
+    pcom_rpc_server_drop(p_srv, afd);
+    pcom_rpc_server_destroy(p_srv);
+    pcom_client_close(afd);
+    return NULL;
+}
+
+static int async_done, async_bad;
+
+static void
+on_async(int status, const void* data, size_t len, void* user)
+{
+    char expect[32];
+    snprintf(expect, sizeof(expect), "req %ld", (long)user);
+    if (status != 7 || len != strlen(expect) || memcmp(data, expect, len) != 0)
+        __atomic_fetch_add(&async_bad, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&async_done, 1, __ATOMIC_RELEASE);
+}
+
+static int held_order[HELD_COUNT], held_seen;
+
+static void
+on_held_done(int status, const void* data, size_t len, void* user)
+{
+    char expect[16];
+    snprintf(expect, sizeof(expect), "held %ld", (long)user);
+    assert(status == (int)(long)user);
+    assert(len == strlen(expect) && memcmp(data, expect, len) == 0);
+    held_order[__atomic_fetch_add(&held_seen, 1, __ATOMIC_ACQ_REL)] = (int)(long)user;
+}
+
+static int cancelled, cancel_bad;
+
+static void
+on_cancelled(int status, const void* data, size_t len, void* user)
+{
+    (void)data; (void)user;
+    if (status != -ECANCELED || len != 0) ++cancel_bad;
+    ++cancelled;
+}
+
+static void*
+caller_main(void* arg)
+{
+    pcom_rpc_client_t* p_cl = arg;
+    char req[32], resp[32];
+    size_t len;
+    for (int i = 0; i < 500; ++i) {
+        snprintf(req, sizeof(req), "thread %lu %d", (unsigned long)pthread_self() % 1000, i);
+        assert(pcom_rpc_call(p_cl, M_ECHO, req, strlen(req), resp, sizeof(resp), &len, 5000) == 7);
+        assert(len == strlen(req) && memcmp(resp, req, len) == 0);
+    }
+    return NULL;
+}
+
+int main(void) {
+    pcom_rpc_client_t* p_cl;
+    pthread_t server, callers[8];
+    char req[32], resp[32];
+    size_t len;
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    pthread_create(&server, NULL, server_main, &sfd);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    assert(pcom_rpc_client_create(&p_cl, cfd) == 0);
+
+    // Plain call and unknown method
+    assert(pcom_rpc_call(p_cl, M_ECHO, "ping", 4, resp, sizeof(resp), &len, 5000) == 7);
+    assert(len == 4 && memcmp(resp, "ping", 4) == 0);
+    assert(pcom_rpc_call(p_cl, 99, NULL, 0, NULL, 0, NULL, 5000) == -ENOSYS);
+    printf("✅ Test passed: RPC call and unknown method\n");
+
+    // Thousands in flight on one connection
+    for (long i = 0; i < 5000; ++i) {
+        snprintf(req, sizeof(req), "req %ld", i);
+        assert(pcom_rpc_call_async(p_cl, M_ECHO, req, strlen(req), on_async, (void*)i) == 0);
+    }
+    for (int i = 0; i < 500 && __atomic_load_n(&async_done, __ATOMIC_ACQUIRE) < 5000; ++i) usleep(10000);
+    assert(async_done == 5000 && async_bad == 0);
+    assert(pcom_rpc_client_pending(p_cl) == 0);
+    printf("✅ Test passed: 5000 pipelined async calls matched\n");
+
+    // Concurrent blocking callers share the connection
+    for (int i = 0; i < 8; ++i) pthread_create(&callers[i], NULL, caller_main, p_cl);
+    for (int i = 0; i < 8; ++i) pthread_join(callers[i], NULL);
+    printf("✅ Test passed: 8 threads x 500 blocking calls\n");
+
+    // Responses in reverse order still reach the right caller
+    for (long i = 0; i < HELD_COUNT; ++i) {
+        snprintf(req, sizeof(req), "held %ld", i);
+        assert(pcom_rpc_call_async(p_cl, M_HELD, req, strlen(req), on_held_done, (void*)i) == 0);
+    }
+    for (int i = 0; i < 500 && __atomic_load_n(&held_seen, __ATOMIC_ACQUIRE) < HELD_COUNT; ++i) usleep(10000);
+    assert(held_seen == HELD_COUNT);
+    for (int i = 0; i < HELD_COUNT; ++i) assert(held_order[i] == HELD_COUNT - 1 - i);
+    printf("✅ Test passed: Out of order responses\n");
+
+    // Timeout withdraws the request, destroy cancels the rest
+    assert(pcom_rpc_call(p_cl, M_SILENT, NULL, 0, NULL, 0, NULL, 50) == -ETIMEDOUT);
+    assert(pcom_rpc_client_pending(p_cl) == 0);
+    for (int i = 0; i < 3; ++i)
+        assert(pcom_rpc_call_async(p_cl, M_SILENT, NULL, 0, on_cancelled, NULL) == 0);
+    assert(pcom_rpc_client_pending(p_cl) == 3);
+    pcom_rpc_client_destroy(p_cl);
+    assert(cancelled == 3 && cancel_bad == 0);
+    pthread_join(server, NULL);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Timeout and shutdown, pending requests cancelled\n");
+    return 0;
+}
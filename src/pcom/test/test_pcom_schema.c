@@ -0,0 +1,126 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include "../pcom_schema.h"
+#include "libcrc/crc32.h"
+#include "test_schema.h"    // Generated from test/test_schema.pcs
+
+#define TEST_NAME "@pcomtest_schema"
+
+static _Alignas(8) uint8_t g_buf[512];
+static _Alignas(8) uint8_t g_rx[512];
+
+static int64_t
+build_order(uint8_t* buf, size_t cap, int with_opts) {
+    pcom_schema_builder_t b;
+    test_order_begin(&b, buf, cap);
+    test_order_set_id(&b, 0x1122334455667788ull);
+    test_order_set_qty(&b, -250);
+    test_order_set_price(&b, 101.25);
+    test_order_set_symbol(&b, "ERIC-B", 6);
+    test_order_set_urgent(&b, 1);
+    test_order_set_note(&b, "fill or kill", 12);
+    test_order_set_blob(&b, "\x00\x01\x02", 3);
+    if (with_opts) {
+        test_order_set_trader(&b, "phs", 3);
+        test_order_set_expire(&b, 3600);
+    }
+    return test_order_finish(&b);
+}
+
+static void
+test_roundtrip(void) {
+    uint32_t len;
+    int64_t size = build_order(g_buf, sizeof(g_buf), 1);
+    assert(size > TEST_ORDER_FIXED_SIZE && size % 4 == 0);
+    assert(test_order_verify(g_buf, sizeof(g_buf)) == size);
+
+    // Send it and read the fields straight out of the receive buffer
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(pcom_send_all(cfd, g_buf, (size_t)size) == size);
+    assert(pcom_recv_exact(afd, g_rx, (size_t)size) == size);
+    assert(test_order_verify(g_rx, (size_t)size) == size);
+
+    assert(test_order_id(g_rx) == 0x1122334455667788ull);
+    assert(test_order_qty(g_rx) == -250);
+    assert(test_order_price(g_rx) == 101.25);
+    assert(memcmp(test_order_symbol(g_rx), "ERIC-B\0\0", TEST_ORDER_SYMBOL_LEN) == 0);
+    assert(test_order_urgent(g_rx));
+    const char* note = test_order_note(g_rx, &len);
+    assert(len == 12 && memcmp(note, "fill or kill", len) == 0);
+    assert((const uint8_t*)note > g_rx && (const uint8_t*)note < g_rx + size);
+    const uint8_t* blob = test_order_blob(g_rx, &len);
+    assert(len == 3 && blob[0] == 0 && blob[2] == 2);
+
+    assert(test_order_has_expire(g_rx) && test_order_expire(g_rx, 0) == 3600);
+    assert(test_order_has_trader(g_rx));
+    assert(memcmp(test_order_trader(g_rx, &len), "phs", 3) == 0 && len == 3);
+    assert(!test_order_has_venue(g_rx) && test_order_venue(g_rx, -1) == -1);
+
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: %lld byte Order read in place\n", (long long)size);
+}
+
+static void
+test_optional_absent(void) {
+    uint32_t len;
+    int64_t size = build_order(g_buf, sizeof(g_buf), 0);
+    assert(test_order_verify(g_buf, (size_t)size) == size);
+    assert(!test_order_has_expire(g_buf) && test_order_expire(g_buf, 7) == 7);
+    assert(test_order_trader(g_buf, &len) == NULL && len == 0);
+
+    // A message without a vtable entry for a field reads it as absent,
+    // as from an older writer
+    pcom_schema_builder_t b;
+    test_ping_begin(&b, g_buf, sizeof(g_buf));
+    test_ping_set_seq(&b, 42);
+    test_ping_set_cookie(&b, "\xde\xad\xbe\xef", 4);
+    size = test_ping_finish(&b);
+    assert(size == TEST_PING_FIXED_SIZE + 4);
+    assert(test_ping_verify(g_buf, (size_t)size) == size);
+    assert(test_ping_seq(g_buf) == 42 && test_ping_cookie(g_buf)[3] == 0xef);
+    assert(pcom_schema_opt(g_buf, 0) == 0);
+    printf("✅ Test passed: absent optional fields read as default\n");
+}
+
+static void
+test_rejects(void) {
+    int64_t size = build_order(g_buf, sizeof(g_buf), 1);
+
+    // Truncated, wrong id, flipped bit caught by the CRC
+    assert(test_order_verify(g_buf, (size_t)size - 1) == -EMSGSIZE);
+    assert(test_ping_verify(g_buf, (size_t)size) == -EBADMSG);
+    g_buf[TEST_ORDER_FIXED_SIZE + 9] ^= 0x10;
+    assert(test_order_verify(g_buf, (size_t)size) == -EBADMSG);
+    g_buf[TEST_ORDER_FIXED_SIZE + 9] ^= 0x10;
+    assert(test_order_verify(g_buf, (size_t)size) == size);
+
+    // Ref pointing past the end, with the CRC recomputed to reach the check
+    uint32_t note_off = pcom_schema_get_u32(g_buf, 52);
+    pcom_schema_put_u32(g_buf, 52, (uint32_t)size);
+    pcom_schema_put_u32(g_buf, (uint32_t)size - 4, crc32_calc(g_buf, (size_t)size - 4));
+    assert(test_order_verify(g_buf, (size_t)size) == -EBADMSG);
+    pcom_schema_put_u32(g_buf, 52, note_off);
+
+    // Too small a buffer fails at finish, whatever field ran out
+    assert(build_order(g_buf, TEST_ORDER_FIXED_SIZE, 1) == -ENOBUFS);
+    assert(build_order(g_buf, TEST_ORDER_FIXED_SIZE + 20, 1) == -ENOBUFS);
+    assert(build_order(g_buf, (size_t)size - 1, 1) == -ENOBUFS);
+    assert(build_order(g_buf, (size_t)size, 1) == size);
+    printf("✅ Test passed: truncated, corrupt and foreign messages rejected\n");
+}
+
+int main(void) {
+    test_roundtrip();
+    test_optional_absent();
+    test_rejects();
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "../pcom_stats.h"
+
+#define TEST_NAME "@pcomtest_stats"
+#define THREADS   (4)
+#define ROUNDS    (1000)
+#define BIG_LEN   (4 * 1024 * 1024)
+
+typedef struct {
+    int handle;
+    int peer;
+} pair_t;
+
+static void*
+pinger(void* arg) {
+    pair_t* p_p = arg;
+    char buf[64] = { 0 };
+    for (int i = 0; i < ROUNDS; ++i) {
+        assert(pcom_client_send(p_p->handle, buf, sizeof(buf)) == sizeof(buf));
+        assert(pcom_recv_exact(p_p->peer, buf, sizeof(buf)) == sizeof(buf));
+    }
+    return NULL;
+}
+
+static void
+test_counters(void) {
+    pcom_stats_t st;
+    pcom_conn_stats_t cst, sst;
+    pcom_user_info_t info;
+    pair_t pairs[THREADS];
+    pthread_t tids[THREADS];
+
+    pcom_stats_reset();
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    for (int i = 0; i < THREADS; ++i) {
+        pairs[i].handle = pcom_client_open(TEST_NAME);
+        assert(pairs[i].handle >= 0);
+        pairs[i].peer = pcom_server_accept(sfd);
+        assert(pairs[i].peer >= 0);
+        assert(pcom_server_check_user(pairs[i].peer, &info) == 0);
+    }
+    for (int i = 0; i < THREADS; ++i) assert(pthread_create(&tids[i], NULL, pinger, &pairs[i]) == 0);
+    for (int i = 0; i < THREADS; ++i) pthread_join(tids[i], NULL);
+
+    // Threads have exited, their counts live on in the totals
+    assert(pcom_stats_get(&st) == 0);
+    const pcom_stats_op_t* p_send = &st.op[PCOM_STATS_SEND];
+    const pcom_stats_op_t* p_recv = &st.op[PCOM_STATS_RECV];
+    assert(st.op[PCOM_STATS_ACCEPT].calls == THREADS && st.op[PCOM_STATS_ACCEPT].errors == 0);
+    assert(st.op[PCOM_STATS_CHECK_USER].calls == THREADS);
+    assert(p_send->messages == THREADS * ROUNDS && p_send->bytes == THREADS * ROUNDS * 64);
+    assert(p_recv->messages == THREADS * ROUNDS && p_recv->bytes == THREADS * ROUNDS * 64);
+    assert(p_send->syscalls >= p_send->calls && p_send->latency.count == p_send->calls);
+    assert(p_recv->latency.max_ns > 0 && p_recv->latency.sum_ns >= p_recv->latency.max_ns);
+    assert(pcom_stats_percentile(&p_recv->latency, 50) <= pcom_stats_percentile(&p_recv->latency, 99));
+    assert(pcom_stats_percentile(&p_recv->latency, 100) == p_recv->latency.max_ns);
+
+    assert(pcom_stats_conn(pairs[0].handle, &cst) == 0);
+    assert(cst.msgs_out == ROUNDS && cst.bytes_out == ROUNDS * 64 && cst.bytes_in == 0);
+    assert(pcom_stats_conn(pairs[0].peer, &cst) == 0);
+    assert(cst.msgs_in == ROUNDS && cst.bytes_in == ROUNDS * 64);
+    assert(pcom_stats_conn(sfd, &sst) == 0);
+    assert(sst.accepts == THREADS);
+    assert(pcom_stats_conn(-1, &cst) == -EBADF);
+    unsigned long long messages = p_send->messages;
+    unsigned long long p99 = pcom_stats_percentile(&p_recv->latency, 99);
+
+    pcom_stats_reset();
+    assert(pcom_stats_get(&st) == 0);
+    assert(st.op[PCOM_STATS_SEND].calls == 0 && st.op[PCOM_STATS_ACCEPT].calls == 0);
+
+    for (int i = 0; i < THREADS; ++i) {
+        pcom_client_close(pairs[i].handle);
+        pcom_client_close(pairs[i].peer);
+    }
+    pcom_server_close(sfd);
+    printf("✅ Test passed: %llu messages from %d threads counted, recv p99 <= %llu ns\n",
+           messages, THREADS, p99);
+}
+
+static void*
+drain(void* arg) {
+    static char buf[BIG_LEN];
+    assert(pcom_recv_exact(*(int*)arg, buf, BIG_LEN) == BIG_LEN);
+    return NULL;
+}
+
+static void
+test_short_writes(void) {
+    static char big[BIG_LEN];
+    pcom_conn_stats_t cst;
+    pcom_stats_t st;
+    pthread_t tid;
+
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    int cfd = pcom_client_open(TEST_NAME);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(pcom_set_bufsize(cfd, 64 * 1024, 0) == 0);
+    fcntl(cfd, F_SETFL, fcntl(cfd, F_GETFL) | O_NONBLOCK);
+
+    // A non-blocking send fills the socket: short write, then EAGAIN
+    assert(pcom_client_send(cfd, big, BIG_LEN) < BIG_LEN);
+    assert(pcom_client_send(cfd, big, BIG_LEN) == -EAGAIN);
+    assert(pcom_stats_get(&st) == 0);
+    assert(st.op[PCOM_STATS_SEND].partial >= 1 && st.op[PCOM_STATS_SEND].eagain >= 1);
+    assert(st.op[PCOM_STATS_SEND].errors == 0);
+
+    pcom_stats_enable(PCOM_STATS_COUNT);
+    assert(pthread_create(&tid, NULL, drain, &afd) == 0);
+    assert(pcom_stats_conn(cfd, &cst) == 0);
+    unsigned long long sent = cst.bytes_out;
+    assert(pcom_send_all(cfd, big, BIG_LEN - sent) == (int64_t)(BIG_LEN - sent));
+    pthread_join(tid, NULL);
+
+    assert(pcom_stats_conn(cfd, &cst) == 0);
+    assert(cst.bytes_out == BIG_LEN && cst.eagain >= 2 && cst.partial >= 2);
+    assert(cst.syscalls > cst.msgs_out);
+    assert(pcom_stats_get(&st) == 0);
+    unsigned long long timed = st.op[PCOM_STATS_SEND].latency.count;
+    assert(timed < st.op[PCOM_STATS_SEND].calls);
+
+    pcom_stats_enable(PCOM_STATS_ALL);
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: %llu short writes and %llu EAGAINs over %llu syscalls\n",
+           cst.partial, cst.eagain, cst.syscalls);
+}
+
+int main(void) {
+    test_counters();
+    test_short_writes();
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "../pcom_tcp.h"
+#include "../pcom_frame.h"
+#include "../pcom_loop.h"
+
+static int
+family_of(int fd) {
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    assert(getsockname(fd, (struct sockaddr*)&ss, &len) == 0);
+    return ss.ss_family;
+}
+
+/* Server on a free loopback port, name of it in client_name */
+static int
+open_server(char* client_name, size_t len) {
+    int sfd = pcom_server_open("tcp://127.0.0.1:0");
+    assert(sfd >= 0);
+    int port = pcom_tcp_port(sfd);
+    assert(port > 0);
+    snprintf(client_name, len, "tcp://127.0.0.1:%d", port);
+    return sfd;
+}
+
+static void
+test_names(void) {
+    pcom_tcp_opts_t o = { 1, -1, 0, 0, 0, 0 };
+    assert(pcom_tcp_set_opts(&o) == -EINVAL);
+    assert(pcom_server_open("tcp://127.0.0.1") == -EINVAL);
+    assert(pcom_server_open("tcp://127.0.0.1:99999") == -EINVAL);
+    assert(pcom_server_open_ex("tcp://127.0.0.1:0", PCOM_OPEN_DGRAM) == -EPROTONOSUPPORT);
+    assert(pcom_client_open("tcp://[::1") == -EINVAL);
+    printf("✅ Test passed: Malformed tcp:// names and options rejected\n");
+}
+
+static void
+test_tcp(void) {
+    pcom_tcp_opts_t o = PCOM_TCP_OPTS_DEFAULT;
+    pcom_frame_reader_t reader;
+    pcom_frame_hdr_t hdr = { 5, PCOM_FRAME_DATA, 0, 7 };
+    pcom_user_info_t info;
+    const void* payload;
+    char name[64], buf[16];
+    int on = 0;
+    socklen_t len = sizeof(on);
+
+    o.prefer_local = 0;
+    o.busy_poll_us = 50;
+    assert(pcom_tcp_set_opts(&o) == 0);
+    int sfd = open_server(name, sizeof(name));
+    assert(pcom_tcp_local_handle(sfd) == -1);
+
+    int cfd = pcom_client_open(name);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(family_of(cfd) == AF_INET && family_of(afd) == AF_INET);
+    assert(pcom_tcp_port(afd) == pcom_tcp_port(sfd));
+
+    // Options applied to both ends, accepted sockets inherit them
+    assert(getsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &on, &len) == 0 && on);
+    assert(getsockopt(afd, IPPROTO_TCP, TCP_NODELAY, &on, &len) == 0 && on);
+    assert(getsockopt(afd, SOL_SOCKET, SO_KEEPALIVE, &on, &len) == 0 && on);
+
+    assert(pcom_client_send(cfd, "ping", 4) == 4);
+    assert(pcom_server_recv(afd, buf, sizeof(buf)) == 4 && memcmp(buf, "ping", 4) == 0);
+
+    // Frames work over TCP unchanged
+    pcom_frame_reader_init(&reader);
+    assert(pcom_frame_send(afd, &hdr, "hello") == 0);
+    assert(pcom_frame_recv(cfd, &reader, &hdr, &payload) == 1);
+    assert(hdr.len == 5 && hdr.channel == 7 && memcmp(payload, "hello", 5) == 0);
+    pcom_frame_reader_free(&reader);
+
+    // No kernel credentials for TCP peers
+    assert(pcom_server_check_user(afd, &info) == -ENOTSUP);
+
+    pcom_client_close(cfd);
+    assert(pcom_server_recv(afd, buf, sizeof(buf)) == 0);
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: TCP connection with TCP_NODELAY and keepalive, frames across\n");
+}
+
+static void
+test_prefer_local(void) {
+    pcom_user_info_t info;
+    char name[64], buf[16];
+
+    assert(pcom_tcp_set_opts(NULL) == 0);
+    int sfd = open_server(name, sizeof(name));
+    int lfd = pcom_tcp_local_handle(sfd);
+    assert(lfd >= 0);
+
+    // Loopback name, so the client takes the UNIX socket beside the server
+    int cfd = pcom_client_open(name);
+    assert(cfd >= 0);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0);
+    assert(family_of(cfd) == AF_UNIX && family_of(afd) == AF_UNIX);
+    assert(pcom_server_check_user(afd, &info) == 0);
+
+    assert(pcom_client_send(cfd, "pong", 4) == 4);
+    assert(pcom_server_recv(afd, buf, sizeof(buf)) == 4 && memcmp(buf, "pong", 4) == 0);
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+
+    // Closing the server closes its UNIX listener too
+    pcom_server_close(sfd);
+    assert(pcom_tcp_local_handle(sfd) == -1);
+    assert(pcom_client_open(name) < 0);
+    printf("✅ Test passed: Local client connected over the UNIX socket, check_user works\n");
+}
+
+/* Abstract UNIX listener under the name a TCP server on 127.0.0.1:port would use */
+static int
+squat(int port) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    int n = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, PCOM_TCP_LOCAL_NAME, "127.0.0.1", (unsigned)port);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    assert(bind(fd, (struct sockaddr*)&addr, (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + n)) == 0);
+    assert(listen(fd, 8) == 0);
+    return fd;
+}
+
+static void
+test_squatter(void) {
+    pcom_tcp_opts_t o = PCOM_TCP_OPTS_DEFAULT;
+    char name[64], c;
+    int ready[2], done[2], status;
+
+    // A server without its UNIX listener does not open
+    o.prefer_local = 0;
+    assert(pcom_tcp_set_opts(&o) == 0);
+    int sfd = open_server(name, sizeof(name));
+    int port = pcom_tcp_port(sfd);
+    pcom_server_close(sfd);
+    int lfd = squat(port);
+    assert(pcom_tcp_set_opts(NULL) == 0);
+    assert(pcom_server_open(name) == -EADDRINUSE);
+    close(lfd);
+
+    // Another user holding the name of a TCP only server does not get its clients
+    if (geteuid() != 0) {
+        printf("Test skipped: Foreign listeners need root to run as another user\n");
+        return;
+    }
+    assert(pcom_tcp_set_opts(&o) == 0);
+    sfd = open_server(name, sizeof(name));
+    assert(pipe(ready) == 0 && pipe(done) == 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        port = pcom_tcp_port(sfd);
+        close(sfd);
+        if (setgid(65534) < 0 || setuid(65534) < 0) _exit(1);
+        lfd = squat(port);
+        if (write(ready[1], "r", 1) != 1 || read(done[0], &c, 1) != 1) _exit(1);
+        _exit(0);
+    }
+    assert(read(ready[0], &c, 1) == 1);
+    assert(pcom_tcp_set_opts(NULL) == 0);
+    int cfd = pcom_client_open(name);
+    assert(cfd >= 0 && family_of(cfd) == AF_INET);
+    int afd = pcom_server_accept(sfd);
+    assert(afd >= 0 && family_of(afd) == AF_INET);
+    assert(write(done[1], "d", 1) == 1);
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    for (int i = 0; i < 2; ++i) { close(ready[i]); close(done[i]); }
+    pcom_client_close(cfd);
+    pcom_client_close(afd);
+    pcom_server_close(sfd);
+    printf("✅ Test passed: Taken UNIX names fail the server, other users' listeners are not trusted\n");
+}
+
+static void
+test_loop(int flags) {
+    pcom_loop_t* p_loop;
+    pcom_event_t ev[8];
+    pcom_tcp_opts_t o = PCOM_TCP_OPTS_DEFAULT;
+    char name[64];
+    int accepted[2], n_accepted = 0;
+
+    assert(pcom_tcp_set_opts(NULL) == 0);
+    int sfd = open_server(name, sizeof(name));
+    assert(pcom_loop_create(&p_loop, sfd, flags) == 0);
+
+    // One client over the UNIX listener, one over TCP
+    int c_local = pcom_client_open(name);
+    o.prefer_local = 0;
+    assert(pcom_tcp_set_opts(&o) == 0);
+    int c_tcp = pcom_client_open(name);
+    assert(c_local >= 0 && c_tcp >= 0);
+
+    while (n_accepted < 2) {
+        int n = pcom_loop_wait(p_loop, ev, 8, 5000);
+        assert(n > 0);
+        for (int i = 0; i < n; ++i) {
+            assert(ev[i].type == PCOM_EVENT_ACCEPT && ev[i].result == 0);
+            accepted[n_accepted++] = ev[i].handle;
+        }
+    }
+    assert(family_of(accepted[0]) != family_of(accepted[1]));
+
+    for (int i = 0; i < 2; ++i) pcom_client_close(accepted[i]);
+    pcom_client_close(c_local);
+    pcom_client_close(c_tcp);
+    pcom_loop_destroy(p_loop);
+    pcom_server_close(sfd);
+}
+
+int main(void) {
+    test_names();
+    test_tcp();
+    test_prefer_local();
+    test_squatter();
+    test_loop(PCOM_LOOP_EPOLL);
+    printf("✅ Test passed: epoll backend accepts on the TCP and UNIX listeners\n");
+    test_loop(PCOM_LOOP_DEFAULT);
+    printf("✅ Test passed: default backend accepts on the TCP and UNIX listeners\n");
+    pcom_tcp_set_opts(NULL);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../pcom_trace.h"
+
+#define TEST_NAME  "@pcomtest_trace"
+#define TEST_FILE  "/tmp/pcomtest_trace.bin"
+#define RING       (64)
+#define ROUNDS     (100)
+
+typedef struct {
+    int handle;
+    int peer;
+} pair_t;
+
+static void*
+pinger(void* arg) {
+    pair_t* p_p = arg;
+    char buf[32] = { 0 };
+    for (int i = 0; i < ROUNDS; ++i) {
+        assert(pcom_client_send(p_p->handle, buf, sizeof(buf)) == sizeof(buf));
+        assert(pcom_recv_exact(p_p->peer, buf, sizeof(buf)) == sizeof(buf));
+    }
+    return NULL;
+}
+
+static void
+test_rings(void) {
+    pair_t pairs[2];
+    pthread_t tids[2];
+    char buf[8];
+
+    assert(pcom_trace_start(RING - 1) == 0);
+    int sfd = pcom_server_open(TEST_NAME);
+    assert(sfd >= 0);
+    for (int i = 0; i < 2; ++i) {
+        pairs[i].handle = pcom_client_open(TEST_NAME);
+        assert(pairs[i].handle >= 0);
+        pairs[i].peer = pcom_server_accept(sfd);
+        assert(pairs[i].peer >= 0);
+    }
+    for (int i = 0; i < 2; ++i) assert(pthread_create(&tids[i], NULL, pinger, &pairs[i]) == 0);
+    for (int i = 0; i < 2; ++i) pthread_join(tids[i], NULL);
+    assert(pcom_client_recv(-1, buf, sizeof(buf)) == -EBADF);
+    pcom_trace_stop();
+    assert(pcom_client_send(pairs[0].handle, buf, sizeof(buf)) == sizeof(buf));  // Not traced
+
+    // Main thread: 2 accepts and the failed recv, pingers: a full ring each
+    int64_t saved = pcom_trace_save(TEST_FILE);
+    assert(saved == 2 * RING + 3);
+
+    FILE* p_f = fopen(TEST_FILE, "rb");
+    pcom_trace_file_t hdr;
+    pcom_trace_ring_t ring;
+    pcom_trace_event_t ev[RING];
+    int full = 0, accepts = 0, failed = 0;
+
+    assert(p_f && fread(&hdr, sizeof(hdr), 1, p_f) == 1);
+    assert(memcmp(hdr.magic, PCOM_TRACE_MAGIC, 8) == 0 && hdr.pid == (uint32_t)getpid());
+    assert(hdr.rings == 3 && hdr.tick1 > hdr.tick0 && hdr.ns1 > hdr.ns0);
+    for (uint32_t r = 0; r < hdr.rings; ++r) {
+        assert(fread(&ring, sizeof(ring), 1, p_f) == 1);
+        assert(ring.count <= RING && fread(ev, sizeof(ev[0]), ring.count, p_f) == ring.count);
+        for (uint32_t i = 0; i < ring.count; ++i) {
+            if (i) assert(ev[i].start >= ev[i - 1].start);
+            if (ev[i].op == PCOM_TRACE_ACCEPT) {
+                assert(ev[i].handle == pairs[accepts].peer && ev[i].error == 0);
+                ++accepts;
+            } else if (ev[i].error) {
+                assert(ev[i].op == PCOM_TRACE_RECV && ev[i].error == EBADF && ev[i].handle == -1);
+                ++failed;
+            } else {
+                assert(ev[i].size == 32 && (ev[i].op == PCOM_TRACE_SEND || ev[i].op == PCOM_TRACE_RECV));
+            }
+        }
+        if (ring.count == RING) {
+            // Wrapped: the newest events are kept, ending with the last recv
+            assert(ev[RING - 1].op == PCOM_TRACE_RECV);
+            ++full;
+        }
+    }
+    assert(full == 2 && accepts == 2 && failed == 1);
+    fclose(p_f);
+    unlink(TEST_FILE);
+
+    for (int i = 0; i < 2; ++i) {
+        pcom_client_close(pairs[i].handle);
+        pcom_client_close(pairs[i].peer);
+    }
+    pcom_server_close(sfd);
+    printf("✅ Test passed: %lld events traced in %u thread rings\n", (long long)saved, hdr.rings);
+}
+
+static void
+test_restart(void) {
+    char buf[8];
+
+    // A new run drops the old events
+    assert(pcom_trace_start(0) == 0);
+    assert(pcom_client_recv(-1, buf, sizeof(buf)) == -EBADF);
+    pcom_trace_stop();
+    assert(pcom_trace_save(TEST_FILE) == 1);
+    assert(pcom_trace_save("") < 0);
+    unlink(TEST_FILE);
+    printf("✅ Test passed: Restart drops earlier events\n");
+}
+
+int main(void) {
+    test_rings();
+    test_restart();
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include "../pcom.hpp"
+#include "test_schema.hpp"  // Generated from test/test_schema.pcs
+
+#define TEST_NAME "@pcomtest_schema_cpp"
+
+static void
+test_view_builder() {
+    alignas(8) std::byte buf[256];
+    alignas(8) std::byte rx[256];
+    const std::byte blob[] = { std::byte{ 7 }, std::byte{ 9 } };
+
+    auto msg = test::order_builder(buf)
+        .id(7).qty(100).price(99.5).symbol("VOLV-B").urgent(false)
+        .note("limit").blob(blob).venue(-3)
+        .finish();
+
+    crow::pcom::server srv(TEST_NAME);
+    crow::pcom::connection client(TEST_NAME);
+    crow::pcom::connection peer = srv.accept();
+    client.send_all(msg);
+    assert(peer.recv_exact(std::span(rx, msg.size())) == msg.size());
+
+    auto view = test::order_view::verify(std::span(rx, msg.size()));
+    assert(view && view->data().size() == msg.size());
+    assert(view->id() == 7 && view->qty() == 100 && view->price() == 99.5);
+    assert(view->symbol() == "VOLV-B" && !view->urgent());
+    assert(view->note() == "limit" && view->blob().size() == 2 && view->blob()[1] == std::byte{ 9 });
+    assert(!view->expire() && !view->trader() && view->venue() == -3);
+    assert(!test::ping_view::verify(std::span(rx, msg.size())));
+
+    // Char arrays are truncated to their size and need no terminator
+    auto ping = test::ping_builder(buf).seq(1).cookie(blob).finish();
+    assert(test::ping_view::verify(ping)->cookie()[0] == std::byte{ 7 });
+    msg = test::order_builder(buf).symbol("ABCDEFGHIJ").finish();
+    assert(test::order_view(msg.data()).symbol() == "ABCDEFGH");
+
+    try {
+        test::order_builder(std::span(buf, 40)).finish();
+        assert(false);
+    } catch (const std::system_error& e) {
+        assert(e.code().value() == ENOBUFS);
+    }
+    printf("✅ Test passed: %zu byte Order built and viewed from C++\n", msg.size());
+}
+
+int main() {
+    test_view_builder();
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_replay.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Replay a pcom_capture file against a server and measure latency.
+ ****************************************************************************/
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "../bench/bench_common.h"
+#include "pcom_capture.h"
+#include "pcom_frame.h"
+
+/* Every captured handle is a session. Client k replays sessions k, k + clients, ...
+ * over one connection, or session k % sessions when there are fewer sessions
+ * than clients. Records keep their captured times relative to the first one. */
+
+typedef struct {
+    const char* name;
+    int clients;
+    double speed;          // 1 captured pace, 2 twice as fast, 0 as fast as possible
+    int dir;               // Records to send, PCOM_CAPTURE_*
+    int repeat;
+    int replies;           // Wait for one frame back per frame sent
+    const char* label;
+} opts_t;
+
+typedef struct {
+    int32_t handle;
+    uint64_t offset;       // Of the record in the capture
+} ref_t;
+
+typedef struct {
+    const opts_t* p_o;
+    const uint8_t* p_map;
+    const ref_t* refs;     // All records to send, by handle then file order
+    const uint64_t* sessions;   // Index of the first ref of each session, and the end
+    uint64_t session_count;
+    uint64_t t_first;      // Capture time of the first record sent
+    uint64_t span;         // Capture time from the first to the last record
+    pthread_barrier_t* p_barrier;
+    uint64_t* p_start;     // Replay start, set by one client after all connected
+    int index;
+    bench_hist_t* p_hist;
+    uint64_t sent;
+    uint64_t errors;
+} client_t;
+
+static void
+usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s -n NAME [options] CAPTURE_FILE\n"
+            "  -n, --name NAME        connection name of the server under test\n"
+            "  -k, --clients N        concurrent clients (default 1)\n"
+            "  -x, --speed X          1 captured pace (default), 2 twice as fast,\n"
+            "                         0 as fast as possible\n"
+            "  -d, --dir in|out       frames to send: received by the capturing\n"
+            "                         process (in, default) or sent by it (out)\n"
+            "  -r, --repeat N         play the capture N times (default 1)\n"
+            "  -R, --no-replies       do not wait for a reply frame per frame sent\n"
+            "  -l, --label TEXT       label copied to the JSON output\n",
+            prog);
+}
+
+static int
+ref_cmp(const void* a, const void* b)
+{
+    const ref_t* p_a = a;
+    const ref_t* p_b = b;
+    if (p_a->handle != p_b->handle) return p_a->handle < p_b->handle ? -1 : 1;
+    return (p_a->offset > p_b->offset) - (p_a->offset < p_b->offset);
+}
+
+static int
+u64_cmp(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void
+sleep_until(uint64_t ns)
+{
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+static void*
+client(void* arg)
+{
+    client_t* p_c = arg;
+    const opts_t* p_o = p_c->p_o;
+    pcom_frame_reader_t reader;
+    uint64_t* offsets = NULL;
+    uint64_t count = 0;
+
+    // This client's records in file order, which is capture time order
+    for (uint64_t s = (uint64_t)p_c->index % p_c->session_count; s < p_c->session_count; s += (uint64_t)p_o->clients) {
+        uint64_t n = p_c->sessions[s + 1] - p_c->sessions[s];
+        offsets = realloc(offsets, (count + n) * sizeof(*offsets));
+        if (!offsets) bench_die("records", -ENOMEM);
+        for (uint64_t i = 0; i < n; ++i) offsets[count + i] = p_c->refs[p_c->sessions[s] + i].offset;
+        count += n;
+        if ((uint64_t)p_o->clients > p_c->session_count) break;
+    }
+    qsort(offsets, count, sizeof(*offsets), u64_cmp);
+
+    pcom_frame_reader_init(&reader);
+    int fd = pcom_client_open(p_o->name);
+    if (fd < 0) { fprintf(stderr, "client %d: ", p_c->index); bench_die("open", fd); }
+
+    if (pthread_barrier_wait(p_c->p_barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+        *p_c->p_start = bench_now_ns() + 1000000;
+    pthread_barrier_wait(p_c->p_barrier);
+    uint64_t start = *p_c->p_start;
+
+    for (int rep = 0; rep < p_o->repeat; ++rep) {
+        for (uint64_t i = 0; i < count; ++i) {
+            const pcom_capture_rec_t* p_rec = (const pcom_capture_rec_t*)(p_c->p_map + offsets[i]);
+            pcom_frame_hdr_t hdr = { p_rec->len, p_rec->type, p_rec->flags, p_rec->channel }, reply;
+            const void* payload;
+            uint64_t t0;
+
+            // Paced sends are measured from when they were due, so a slow
+            // server is not hidden by the replay falling behind
+            if (p_o->speed > 0) {
+                uint64_t at = (uint64_t)rep * (p_c->span + 1) + p_rec->time_ns - p_c->t_first;
+                t0 = start + (uint64_t)((double)at / p_o->speed);
+                sleep_until(t0);
+            } else {
+                t0 = bench_now_ns();
+            }
+
+            int result = pcom_frame_send(fd, &hdr, p_rec + 1);
+            if (result == 0 && p_o->replies) result = pcom_frame_recv(fd, &reader, &reply, &payload) > 0 ? 0 : -1;
+            if (result < 0) { ++p_c->errors; goto done; }
+            bench_hist_record(p_c->p_hist, bench_now_ns() - t0);
+            ++p_c->sent;
+        }
+    }
+done:
+    pcom_client_close(fd);
+    pcom_frame_reader_free(&reader);
+    free(offsets);
+    return NULL;
+}
+
+int
+main(int argc, char** argv)
+{
+    static const struct option longopts[] = {
+        { "name", required_argument, NULL, 'n' },    { "clients", required_argument, NULL, 'k' },
+        { "speed", required_argument, NULL, 'x' },   { "dir", required_argument, NULL, 'd' },
+        { "repeat", required_argument, NULL, 'r' },  { "no-replies", no_argument, NULL, 'R' },
+        { "label", required_argument, NULL, 'l' },   { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    opts_t o = { NULL, 1, 1.0, PCOM_CAPTURE_IN, 1, 1, NULL };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:k:x:d:r:Rl:h", longopts, NULL)) != -1) {
+        switch (opt) {
+            case 'n': o.name = optarg; break;
+            case 'k': o.clients = atoi(optarg); break;
+            case 'x': o.speed = atof(optarg); break;
+            case 'd':
+                if (strcmp(optarg, "in") == 0) o.dir = PCOM_CAPTURE_IN;
+                else if (strcmp(optarg, "out") == 0) o.dir = PCOM_CAPTURE_OUT;
+                else { usage(argv[0]); return 2; }
+                break;
+            case 'r': o.repeat = atoi(optarg); break;
+            case 'R': o.replies = 0; break;
+            case 'l': o.label = optarg; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (!o.name || optind != argc - 1 || o.clients <= 0 || o.speed < 0 || o.repeat <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Map the capture, records are sent straight from the mapping
+    const char* path = argv[optind];
+    struct stat st;
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0 || fstat(file, &st) < 0) { perror(path); return 1; }
+    uint64_t size = (uint64_t)st.st_size;
+    const uint8_t* p_map = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, file, 0) : MAP_FAILED;
+    close(file);
+    if (p_map == MAP_FAILED || size < sizeof(pcom_capture_file_t) ||
+        memcmp(p_map, PCOM_CAPTURE_MAGIC, 8) != 0) {
+        fprintf(stderr, "%s: not a PCOM capture file\n", path);
+        return 1;
+    }
+    madvise((void*)p_map, size, MADV_SEQUENTIAL);
+
+    // Index the records to send, checking every CRC
+    ref_t* refs = NULL;
+    uint64_t records = 0, bad = 0, count = 0, cap = 0, t_first = UINT64_MAX, t_last = 0;
+    uint64_t at = sizeof(pcom_capture_file_t);
+    while (at + sizeof(pcom_capture_rec_t) <= size) {
+        const pcom_capture_rec_t* p_rec = (const pcom_capture_rec_t*)(p_map + at);
+        uint64_t rec_size = pcom_capture_rec_size(p_rec);
+        if (at + rec_size > size) { fprintf(stderr, "%s: truncated at %llu\n", path, (unsigned long long)at); break; }
+        ++records;
+        if (!pcom_capture_rec_valid(p_rec)) ++bad;
+        else if (p_rec->dir == o.dir) {
+            if (count == cap) {
+                cap = cap ? cap * 2 : 4096;
+                refs = realloc(refs, cap * sizeof(*refs));
+                if (!refs) bench_die("index", -ENOMEM);
+            }
+            refs[count++] = (ref_t){ p_rec->handle, at };
+            if (p_rec->time_ns < t_first) t_first = p_rec->time_ns;
+            if (p_rec->time_ns > t_last) t_last = p_rec->time_ns;
+        }
+        at += rec_size;
+    }
+    if (bad) fprintf(stderr, "%s: %llu records with a bad CRC skipped\n", path, (unsigned long long)bad);
+    if (count == 0) { fprintf(stderr, "%s: no frames to send\n", path); return 1; }
+
+    qsort(refs, count, sizeof(*refs), ref_cmp);
+    uint64_t* sessions = malloc((count + 1) * sizeof(*sessions));
+    uint64_t session_count = 0;
+    if (!sessions) bench_die("index", -ENOMEM);
+    for (uint64_t i = 0; i < count; ++i)
+        if (i == 0 || refs[i].handle != refs[i - 1].handle) sessions[session_count++] = i;
+    sessions[session_count] = count;
+
+    // Run the clients
+    pthread_barrier_t barrier;
+    uint64_t start = 0;
+    client_t* clients = calloc((size_t)o.clients, sizeof(*clients));
+    pthread_t* tids = calloc((size_t)o.clients, sizeof(*tids));
+    if (!clients || !tids) bench_die("clients", -ENOMEM);
+    pthread_barrier_init(&barrier, NULL, (unsigned)o.clients);
+    for (int i = 0; i < o.clients; ++i) {
+        client_t* p_c = &clients[i];
+        *p_c = (client_t){ &o, p_map, refs, sessions, session_count, t_first, t_last - t_first,
+                           &barrier, &start, i, malloc(sizeof(bench_hist_t)), 0, 0 };
+        if (!p_c->p_hist) bench_die("clients", -ENOMEM);
+        bench_hist_init(p_c->p_hist);
+        if (pthread_create(&tids[i], NULL, client, p_c) != 0) bench_die("thread", -errno);
+    }
+
+    static bench_hist_t hist;
+    uint64_t sent = 0, errors = 0;
+    bench_hist_init(&hist);
+    for (int i = 0; i < o.clients; ++i) {
+        pthread_join(tids[i], NULL);
+        const bench_hist_t* p_h = clients[i].p_hist;
+        for (int b = 0; b < BENCH_HIST_BUCKETS; ++b) hist.counts[b] += p_h->counts[b];
+        hist.total += p_h->total;
+        hist.sum += p_h->sum;
+        if (p_h->min < hist.min) hist.min = p_h->min;
+        if (p_h->max > hist.max) hist.max = p_h->max;
+        sent += clients[i].sent;
+        errors += clients[i].errors;
+        free(clients[i].p_hist);
+    }
+    double seconds = (double)(bench_now_ns() - start) / 1e9;
+
+    // Same JSON shape as the benchmarks
+    printf("{\n  \"benchmark\": \"replay\",\n  \"label\": \"");
+    for (const char* p = o.label ? o.label : ""; *p; ++p) {
+        if (*p == '"' || *p == '\\') putchar('\\');
+        if ((unsigned char)*p >= ' ') putchar(*p);
+    }
+    printf("\",\n  \"pcom_version\": \"%x\",\n  \"capture\": \"", pcom_version());
+    for (const char* p = path; *p; ++p) {
+        if (*p == '"' || *p == '\\') putchar('\\');
+        if ((unsigned char)*p >= ' ') putchar(*p);
+    }
+    printf("\",\n  \"records\": %llu,\n  \"bad_crc\": %llu,\n  \"sessions\": %llu,\n"
+           "  \"clients\": %d,\n  \"speed\": %g,\n  \"repeat\": %d,\n  \"replies\": %s,\n"
+           "  \"sent\": %llu,\n  \"errors\": %llu,\n  \"seconds\": %.3f,\n  \"frames_per_s\": %.0f,\n",
+           (unsigned long long)records, (unsigned long long)bad, (unsigned long long)session_count,
+           o.clients, o.speed, o.repeat, o.replies ? "true" : "false",
+           (unsigned long long)sent, (unsigned long long)errors, seconds,
+           seconds > 0 ? (double)sent / seconds : 0.0);
+    bench_hist_json(&hist, "  ");
+    printf("\n}\n");
+
+    pthread_barrier_destroy(&barrier);
+    munmap((void*)p_map, size);
+    free(clients);
+    free(tids);
+    free(sessions);
+    free(refs);
+    return errors ? 1 : 0;
+}
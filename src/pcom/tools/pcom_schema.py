@@ -0,0 +1,459 @@
+#!/usr/bin/env python3
+# #############################################################################
+## \\  __
+## \ \(o >
+## \/ ) |
+##  // /
+##   || CROW - Communicatio Retis Omni Via
+##
+## @file      pcom_schema.py
+## @author    phstream
+## @copyright -
+## @date      19 Oct 2026
+## @version   1.0
+##
+## @defgroup  PCOM_SCHEMA
+## @brief     Code generator for pcom_schema messages.
+## @details   Reads a schema and writes <schema>.h with C inline accessors
+##            and <schema>.hpp with C++ view and builder classes. The layout
+##            is described in pcom_schema.h.
+##
+##            Schema syntax, # and // start comments:
+##
+##                package trading;                # optional, C prefix and C++ namespace
+##                message Order 1 crc {           # name, id 0..65535, optional crc
+##                    u64 id;                     # fixed offset fields
+##                    char[8] symbol;             # fixed size arrays: char[N], u8[N]
+##                    string note;                # variable: string, bytes
+##                    optional u32 expire;        # vtable fields, append only
+##                }
+##
+##            Scalars: u8 i8 u16 i16 u32 i32 u64 i64 f32 f64 bool.
+##
+## @todo      -
+## @pre       Python 3.8
+## @bug       -
+## @warning   Only append optional fields to a deployed message. Changing
+##            or reordering fixed fields breaks existing readers.
+## @ingroup   Communication
+# #############################################################################
+import argparse
+import os
+import re
+import sys
+
+# name: (size, C type, C++ type, getter suffix)
+SCALARS = {
+    "u8":   (1, "uint8_t",  "uint8_t",  "u8"),
+    "i8":   (1, "int8_t",   "int8_t",   "u8"),
+    "bool": (1, "int",      "bool",     "u8"),
+    "u16":  (2, "uint16_t", "uint16_t", "u16"),
+    "i16":  (2, "int16_t",  "int16_t",  "u16"),
+    "u32":  (4, "uint32_t", "uint32_t", "u32"),
+    "i32":  (4, "int32_t",  "int32_t",  "u32"),
+    "f32":  (4, "float",    "float",    "f32"),
+    "u64":  (8, "uint64_t", "uint64_t", "u64"),
+    "i64":  (8, "int64_t",  "int64_t",  "u64"),
+    "f64":  (8, "double",   "double",   "f64"),
+}
+HDR_SIZE = 16
+REF_SIZE = 8
+
+TOKEN = re.compile(r"\s*(?:(#|//)[^\n]*|([A-Za-z_][A-Za-z0-9_]*)|(\d+)|(\S))")
+
+
+class SchemaError(Exception):
+    pass
+
+
+class Field:
+    def __init__(self, name, kind, count, optional, line):
+        self.name = name
+        self.kind = kind          # Scalar name, "array", "string" or "bytes"
+        self.elem = None          # char or u8 for arrays
+        self.count = count
+        self.optional = optional
+        self.line = line
+        self.offset = 0           # Fixed fields
+        self.index = 0            # Optional fields
+
+    @property
+    def size(self):
+        if self.kind in SCALARS:
+            return SCALARS[self.kind][0]
+        if self.kind == "array":
+            return self.count
+        return REF_SIZE
+
+    @property
+    def align(self):
+        if self.kind in SCALARS:
+            return SCALARS[self.kind][0]
+        return 1 if self.kind == "array" else 4
+
+
+class Message:
+    def __init__(self, name, msg_id, crc, line):
+        self.name = name
+        self.id = msg_id
+        self.crc = crc
+        self.line = line
+        self.fields = []
+        self.fixed_size = HDR_SIZE
+
+    @property
+    def fixed(self):
+        return [f for f in self.fields if not f.optional]
+
+    @property
+    def optional(self):
+        return [f for f in self.fields if f.optional]
+
+    def layout(self):
+        """ Natural alignment in declaration order, fixed part padded to 8 """
+        off = HDR_SIZE
+        for f in self.fixed:
+            off = (off + f.align - 1) & ~(f.align - 1)
+            f.offset = off
+            off += f.size
+        self.fixed_size = (off + 7) & ~7
+        for i, f in enumerate(self.optional):
+            f.index = i
+
+
+def tokenize(text):
+    """ (token, line) pairs, comments dropped """
+    for line_no, line in enumerate(text.splitlines(), 1):
+        for m in TOKEN.finditer(line):
+            if m.group(1):
+                break
+            tok = m.group(2) or m.group(3) or m.group(4)
+            if tok:
+                yield tok, line_no
+
+
+def parse(text):
+    """ Schema text to (package, [Message]) """
+    tokens = list(tokenize(text))
+    pos = 0
+    package = None
+    messages = []
+
+    def peek():
+        return tokens[pos][0] if pos < len(tokens) else None
+
+    def take(expected=None):
+        nonlocal pos
+        if pos >= len(tokens):
+            raise SchemaError(f"unexpected end of schema, expected {expected or 'more'}")
+        tok, line = tokens[pos]
+        if expected and tok != expected:
+            raise SchemaError(f"line {line}: expected '{expected}', got '{tok}'")
+        pos += 1
+        return tok, line
+
+    def ident(what):
+        tok, line = take()
+        if not re.match(r"[A-Za-z_][A-Za-z0-9_]*$", tok):
+            raise SchemaError(f"line {line}: expected {what}, got '{tok}'")
+        return tok, line
+
+    def number(what):
+        tok, line = take()
+        if not tok.isdigit():
+            raise SchemaError(f"line {line}: expected {what}, got '{tok}'")
+        return int(tok), line
+
+    while peek() is not None:
+        tok, line = take()
+        if tok == "package":
+            if package or messages:
+                raise SchemaError(f"line {line}: package must come first and only once")
+            package, _ = ident("package name")
+            take(";")
+        elif tok == "message":
+            name, line = ident("message name")
+            msg_id, id_line = number("message id")
+            if msg_id > 0xFFFF:
+                raise SchemaError(f"line {id_line}: message id {msg_id} out of range 0..65535")
+            crc = peek() == "crc"
+            if crc:
+                take("crc")
+            msg = Message(name, msg_id, crc, line)
+            take("{")
+            while peek() != "}":
+                optional = peek() == "optional"
+                if optional:
+                    take("optional")
+                kind, fline = ident("field type")
+                count = 0
+                if peek() == "[":
+                    take("[")
+                    count, _ = number("array length")
+                    take("]")
+                    if kind not in ("char", "u8") or count == 0:
+                        raise SchemaError(f"line {fline}: arrays are char[N] or u8[N] with N > 0")
+                    if optional:
+                        raise SchemaError(f"line {fline}: arrays can not be optional")
+                elif kind not in SCALARS and kind not in ("string", "bytes"):
+                    raise SchemaError(f"line {fline}: unknown type '{kind}'")
+                fname, _ = ident("field name")
+                take(";")
+                field = Field(fname, "array" if count else kind, count, optional, fline)
+                field.elem = kind if count else None
+                msg.fields.append(field)
+            take("}")
+            messages.append(msg)
+        else:
+            raise SchemaError(f"line {line}: expected 'package' or 'message', got '{tok}'")
+
+    names, ids = set(), set()
+    for msg in messages:
+        if msg.name in names or msg.id in ids:
+            raise SchemaError(f"line {msg.line}: duplicate message name or id '{msg.name}' {msg.id}")
+        names.add(msg.name)
+        ids.add(msg.id)
+        fields = set()
+        for f in msg.fields:
+            if f.name in fields:
+                raise SchemaError(f"line {f.line}: duplicate field '{f.name}' in {msg.name}")
+            fields.add(f.name)
+        msg.layout()
+    return package, messages
+
+
+def snake(name):
+    return re.sub(r"(?<=[a-z0-9])([A-Z])", r"_\1", name).lower()
+
+
+# ---- C ----------------------------------------------------------------------
+
+def c_message(msg, prefix):
+    p = f"{prefix}{snake(msg.name)}"
+    P = p.upper()
+    out = []
+    w = out.append
+
+    w(f"/* ---- {msg.name} " + "-" * max(4, 66 - len(msg.name)) + " */\n")
+    w(f"#define {P}_ID         ({msg.id})")
+    w(f"#define {P}_FIXED_SIZE ({msg.fixed_size})\n")
+    opt = msg.optional
+    refs = [f for f in msg.fixed if f.kind in ("string", "bytes")]
+    if opt:
+        sizes = ", ".join(str(f.size) if f.kind in SCALARS else "0" for f in opt)
+        w(f"static const uint32_t {p}_opt_size_[] = {{ {sizes} }};")
+    if refs:
+        w(f"static const uint32_t {p}_ref_off_[] = {{ {', '.join(str(f.offset) for f in refs)} }};")
+    w(f"static const pcom_schema_desc_t {p}_desc = {{")
+    w(f"    {P}_ID, {'PCOM_SCHEMA_CRC' if msg.crc else '0'}, {P}_FIXED_SIZE,")
+    w(f"    {len(opt)}, {p + '_opt_size_' if opt else 'NULL'}, {len(refs)}, {p + '_ref_off_' if refs else 'NULL'}")
+    w("};\n")
+
+    w(f"/** Check a received {msg.name} message, returns its size or a negative error code */")
+    w(f"static inline int64_t\n{p}_verify(const void* buf, size_t len) {{ return pcom_schema_verify(buf, len, &{p}_desc); }}\n")
+    w(f"/** Start building a message of type {msg.name} in buf */")
+    w(f"static inline void\n{p}_begin(pcom_schema_builder_t* p_b, void* buf, size_t cap) {{ pcom_schema_begin(p_b, buf, cap, &{p}_desc); }}\n")
+    w(f"/** Complete the {msg.name} message, returns its size or a negative error code */")
+    w(f"static inline int64_t\n{p}_finish(pcom_schema_builder_t* p_b) {{ return pcom_schema_finish(p_b); }}\n")
+
+    for f in msg.fields:
+        fn = f"{p}_{f.name}"
+        if f.kind in SCALARS:
+            size, ctype, _, get = SCALARS[f.kind]
+            put_val = "v != 0" if f.kind == "bool" else "v"
+            cast = f"({SCALARS[get][1]})" if ctype != SCALARS[get][1] and get not in ("f32", "f64") else ""
+            if not f.optional:
+                w(f"static inline {ctype}\n{fn}(const void* msg) {{ return ({ctype}){'(pcom_schema_get_u8(msg, %d) != 0)' % f.offset if f.kind == 'bool' else f'pcom_schema_get_{get}(msg, {f.offset})'}; }}\n")
+                w(f"static inline void\n{p}_set_{f.name}(pcom_schema_builder_t* p_b, {ctype} v) {{ pcom_schema_put_{get}(p_b->buf, {f.offset}, {cast}({put_val})); }}\n")
+            else:
+                val = "(pcom_schema_get_u8(msg, at) != 0)" if f.kind == "bool" else f"pcom_schema_get_{get}(msg, at)"
+                w(f"static inline int\n{p}_has_{f.name}(const void* msg) {{ return pcom_schema_opt(msg, {f.index}) != 0; }}\n")
+                w(f"static inline {ctype}\n{fn}(const void* msg, {ctype} dflt) {{")
+                w(f"    uint32_t at = pcom_schema_opt(msg, {f.index});")
+                w(f"    return at ? ({ctype}){val} : dflt;")
+                w("}\n")
+                w(f"static inline void\n{p}_set_{f.name}(pcom_schema_builder_t* p_b, {ctype} v) {{")
+                w(f"    uint8_t le[{size}];")
+                w(f"    pcom_schema_put_{get}(le, 0, {cast}({put_val}));")
+                w(f"    pcom_schema_put_opt(p_b, {f.index}, le, sizeof(le));")
+                w("}\n")
+        elif f.kind == "array":
+            ctype = "char" if f.elem == "char" else "uint8_t"
+            w(f"#define {P}_{f.name.upper()}_LEN ({f.count})")
+            w(f"static inline const {ctype}*\n{fn}(const void* msg) {{ return (const {ctype}*)msg + {f.offset}; }}\n")
+            w(f"/** Copy up to {f.count} bytes, the rest is zero filled */")
+            w(f"static inline void\n{p}_set_{f.name}(pcom_schema_builder_t* p_b, const void* data, size_t len) {{")
+            w(f"    if (len > {f.count}) len = {f.count};")
+            w(f"    memcpy(p_b->buf + {f.offset}, data, len);")
+            w(f"    memset(p_b->buf + {f.offset} + len, 0, {f.count} - len);")
+            w("}\n")
+        else:
+            ctype = "char" if f.kind == "string" else "uint8_t"
+            if not f.optional:
+                w(f"static inline const {ctype}*\n{fn}(const void* msg, uint32_t* p_len) {{ return (const {ctype}*)pcom_schema_ref(msg, {f.offset}, p_len); }}\n")
+                w(f"static inline void\n{p}_set_{f.name}(pcom_schema_builder_t* p_b, const void* data, size_t len) {{ pcom_schema_put_ref(p_b, {f.offset}, data, len); }}\n")
+            else:
+                w(f"static inline int\n{p}_has_{f.name}(const void* msg) {{ return pcom_schema_opt(msg, {f.index}) != 0; }}\n")
+                w(f"static inline const {ctype}*\n{fn}(const void* msg, uint32_t* p_len) {{ return (const {ctype}*)pcom_schema_opt_ref(msg, {f.index}, p_len); }}\n")
+                w(f"static inline void\n{p}_set_{f.name}(pcom_schema_builder_t* p_b, const void* data, size_t len) {{ pcom_schema_put_opt(p_b, {f.index}, data, len); }}\n")
+    return "\n".join(out)
+
+
+def c_header(base, source, package, messages):
+    guard = re.sub(r"\W", "_", base).upper() + "_H"
+    prefix = f"{package}_" if package else ""
+    out = [
+        f"/* Generated by tools/pcom_schema.py from {source}, do not edit. */",
+        f"#ifndef {guard}",
+        f"#define {guard}\n",
+        "#include <stdint.h>",
+        "#include <string.h>",
+        '#include "pcom_schema.h"\n',
+        "#ifdef __cplusplus",
+        'extern "C" {',
+        "#endif\n",
+    ]
+    out += [c_message(m, prefix) for m in messages]
+    out += ["#ifdef __cplusplus", "}", "#endif\n", f"#endif // {guard}\n"]
+    return "\n".join(out)
+
+
+# ---- C++ --------------------------------------------------------------------
+
+def cpp_message(msg, prefix):
+    p = f"{prefix}{snake(msg.name)}"
+    cls = snake(msg.name)
+    view, builder = [], []
+    v, b = view.append, builder.append
+
+    v(f"/// @brief Read only view of {msg.name} messages in a receive buffer.")
+    v(f"class {cls}_view {{")
+    v("public:")
+    v("    /// @brief Constructor. Wraps a message that was verified or built locally.")
+    v(f"    explicit {cls}_view(const void* msg) noexcept : _msg(static_cast<const std::byte*>(msg)) {{}}\n")
+    v("    /// @brief Verifies buf, empty if it does not hold a valid message.")
+    v(f"    static std::optional<{cls}_view> verify(std::span<const std::byte> buf) noexcept {{")
+    v(f"        if ({p}_verify(buf.data(), buf.size()) < 0) return std::nullopt;")
+    v(f"        return {cls}_view(buf.data());")
+    v("    }\n")
+    v("    /// @brief The whole message.")
+    v("    std::span<const std::byte> data() const noexcept { return { _msg, pcom_schema_size(_msg) }; }\n")
+
+    b(f"/// @brief Writes {msg.name} messages into a caller supplied buffer.")
+    b(f"class {cls}_builder {{")
+    b("public:")
+    b("    /// @brief Constructor.")
+    b("    /// @param buf output buffer, 8 byte aligned")
+    b(f"    explicit {cls}_builder(std::span<std::byte> buf) noexcept {{ {p}_begin(&_b, buf.data(), buf.size()); }}\n")
+
+    for f in msg.fields:
+        fn = f"{p}_{f.name}"
+        if f.kind in SCALARS:
+            t = SCALARS[f.kind][2]
+            ct = SCALARS[f.kind][1]
+            if not f.optional:
+                v(f"    {t} {f.name}() const noexcept {{ return static_cast<{t}>({fn}(_msg)); }}")
+            else:
+                v(f"    std::optional<{t}> {f.name}() const noexcept {{")
+                v(f"        if (!{p}_has_{f.name}(_msg)) return std::nullopt;")
+                v(f"        return static_cast<{t}>({fn}(_msg, {ct}{{}}));")
+                v("    }")
+            b(f"    {cls}_builder& {f.name}({t} v) noexcept {{ {p}_set_{f.name}(&_b, static_cast<{ct}>(v)); return *this; }}")
+        elif f.kind == "array":
+            if f.elem == "char":
+                v(f"    /// @brief Up to the first NUL, at most {f.count} chars.")
+                v(f"    std::string_view {f.name}() const noexcept {{")
+                v(f"        const char* p = {fn}(_msg);")
+                v(f"        return {{ p, strnlen(p, {f.count}) }};")
+                v("    }")
+                b(f"    {cls}_builder& {f.name}(std::string_view s) noexcept {{ {p}_set_{f.name}(&_b, s.data(), s.size()); return *this; }}")
+            else:
+                v(f"    std::span<const std::byte, {f.count}> {f.name}() const noexcept {{")
+                v(f"        return std::span<const std::byte, {f.count}>(reinterpret_cast<const std::byte*>({fn}(_msg)), {f.count});")
+                v("    }")
+                b(f"    {cls}_builder& {f.name}(std::span<const std::byte> d) noexcept {{ {p}_set_{f.name}(&_b, d.data(), d.size()); return *this; }}")
+        else:
+            if f.kind == "string":
+                t, ptr, arg, setp = "std::string_view", "const char*", "std::string_view d", "d.data(), d.size()"
+            else:
+                t, ptr, arg, setp = "std::span<const std::byte>", "const uint8_t*", "std::span<const std::byte> d", "d.data(), d.size()"
+            mk = "{ p, len }" if f.kind == "string" else "{ reinterpret_cast<const std::byte*>(p), len }"
+            if not f.optional:
+                v(f"    {t} {f.name}() const noexcept {{")
+                v(f"        uint32_t len;")
+                v(f"        {ptr} p = {fn}(_msg, &len);")
+                v(f"        return p ? {t}{mk} : {t}{{}};")
+                v("    }")
+            else:
+                v(f"    std::optional<{t}> {f.name}() const noexcept {{")
+                v(f"        uint32_t len;")
+                v(f"        {ptr} p = {fn}(_msg, &len);")
+                v(f"        if (!p) return std::nullopt;")
+                v(f"        return {t}{mk};")
+                v("    }")
+            b(f"    {cls}_builder& {f.name}({arg}) noexcept {{ {p}_set_{f.name}(&_b, {setp}); return *this; }}")
+
+    v("\nprivate:")
+    v("    const std::byte* _msg;")
+    v("};\n")
+
+    b("\n    /// @brief Completes the message.")
+    b("    /// @return the message in the buffer")
+    b("    std::span<const std::byte> finish() {")
+    b(f"        int64_t size = {p}_finish(&_b);")
+    b(f"        if (size < 0) throw std::system_error(static_cast<int>(-size), std::generic_category(), \"{cls}_builder\");")
+    b("        return { reinterpret_cast<const std::byte*>(_b.buf), static_cast<size_t>(size) };")
+    b("    }")
+    b("\nprivate:")
+    b("    pcom_schema_builder_t _b;")
+    b("};\n")
+    return "\n".join(view + builder)
+
+
+def cpp_header(base, source, package, messages):
+    prefix = f"{package}_" if package else ""
+    out = [
+        f"/* Generated by tools/pcom_schema.py from {source}, do not edit. */",
+        "#pragma once",
+        "#include <cstddef>",
+        "#include <cstdint>",
+        "#include <cstring>",
+        "#include <optional>",
+        "#include <span>",
+        "#include <string_view>",
+        "#include <system_error>\n",
+        f'#include "{base}.h"\n',
+    ]
+    if package:
+        out.append(f"namespace {package} {{\n")
+    out += [cpp_message(m, prefix) for m in messages]
+    if package:
+        out.append(f"}} // namespace {package}\n")
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate C and C++ accessors from a pcom schema.")
+    parser.add_argument("schema", help="schema file")
+    parser.add_argument("-o", "--out", default=".", help="output directory (default: .)")
+    args = parser.parse_args()
+
+    base = os.path.splitext(os.path.basename(args.schema))[0]
+    try:
+        with open(args.schema) as f:
+            package, messages = parse(f.read())
+    except (OSError, SchemaError) as e:
+        print(f"{args.schema}: {e}", file=sys.stderr)
+        return 1
+
+    os.makedirs(args.out, exist_ok=True)
+    source = os.path.basename(args.schema)
+    with open(os.path.join(args.out, base + ".h"), "w") as f:
+        f.write(c_header(base, source, package, messages))
+    with open(os.path.join(args.out, base + ".hpp"), "w") as f:
+        f.write(cpp_header(base, source, package, messages))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
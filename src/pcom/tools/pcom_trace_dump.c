@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * \\  __
+ * \ \(o >
+ * \/ ) |
+ *  // /
+ *   || CROW - Communicatio Retis Omni Via
+ *
+ * @file      pcom_trace_dump.c
+ * @version   1.0
+ * @author    phstream
+ * @copyright Copyright (c) 2025 phstream - MIT License
+ * @date      19 Oct 2026
+ * @brief     Convert a pcom_trace_save() file to Chrome trace JSON.
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "pcom_trace.h"
+
+static const char* op_names[] = { "accept", "check_user", "send", "recv" };
+
+static void
+usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-m MIN_US] TRACE_FILE [OUT_FILE]\n"
+            "  Writes Chrome trace JSON for chrome://tracing or ui.perfetto.dev,\n"
+            "  to stdout without OUT_FILE. -m keeps only calls of at least MIN_US.\n",
+            prog);
+}
+
+int
+main(int argc, char** argv)
+{
+    pcom_trace_file_t hdr;
+    pcom_trace_ring_t ring;
+    pcom_trace_event_t ev;
+    double min_us = 0;
+    int arg = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-m") == 0) { min_us = atof(argv[2]); arg = 3; }
+    if (argc - arg < 1 || argc - arg > 2) { usage(argv[0]); return 2; }
+
+    FILE* p_in = fopen(argv[arg], "rb");
+    if (!p_in) { perror(argv[arg]); return 1; }
+    FILE* p_out = (argc - arg == 2) ? fopen(argv[arg + 1], "w") : stdout;
+    if (!p_out) { perror(argv[arg + 1]); return 1; }
+
+    if (fread(&hdr, sizeof(hdr), 1, p_in) != 1 || memcmp(hdr.magic, PCOM_TRACE_MAGIC, sizeof(hdr.magic)) != 0) {
+        fprintf(stderr, "%s: not a PCOM trace file\n", argv[arg]);
+        return 1;
+    }
+
+    // Ticks to ns from the clock pairs taken at start and at save
+    double ns_per_tick = (hdr.tick1 > hdr.tick0) ? (double)(hdr.ns1 - hdr.ns0) / (double)(hdr.tick1 - hdr.tick0) : 1.0;
+    unsigned long long events = 0, kept = 0;
+
+    fprintf(p_out, "{\n  \"displayTimeUnit\": \"ns\",\n  \"traceEvents\": [");
+    fprintf(p_out, "\n    { \"name\": \"process_name\", \"ph\": \"M\", \"pid\": %u, \"args\": { \"name\": \"pcom %u\" } }",
+            hdr.pid, hdr.pid);
+    for (uint32_t r = 0; r < hdr.rings; ++r) {
+        if (fread(&ring, sizeof(ring), 1, p_in) != 1) { fprintf(stderr, "Truncated trace file\n"); break; }
+        fprintf(p_out, ",\n    { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %u, \"tid\": %u, "
+                "\"args\": { \"name\": \"thread %u\" } }", hdr.pid, ring.tid, ring.tid);
+        for (uint32_t i = 0; i < ring.count; ++i) {
+            if (fread(&ev, sizeof(ev), 1, p_in) != 1) { fprintf(stderr, "Truncated trace file\n"); r = hdr.rings; break; }
+            ++events;
+
+            double start_us = ((double)(int64_t)(ev.start - hdr.tick0) * ns_per_tick) / 1000.0;
+            double dur_us = (double)ev.duration * ns_per_tick / 1000.0;
+            if (dur_us < min_us) continue;
+            ++kept;
+
+            fprintf(p_out, ",\n    { \"name\": \"%s\", \"cat\": \"pcom\", \"ph\": \"X\", \"pid\": %u, \"tid\": %u, "
+                    "\"ts\": %.3f, \"dur\": %.3f, \"args\": { \"handle\": %d, \"size\": %u, \"errno\": %d } }",
+                    ev.op < sizeof(op_names) / sizeof(op_names[0]) ? op_names[ev.op] : "unknown",
+                    hdr.pid, ring.tid, start_us, dur_us, ev.handle, ev.size, ev.error);
+        }
+    }
+    fprintf(p_out, "\n  ]\n}\n");
+
+    fclose(p_in);
+    if (p_out != stdout) fclose(p_out);
+    fprintf(stderr, "%llu of %llu events from %u threads\n", kept, events, hdr.rings);
+    return 0;
+}